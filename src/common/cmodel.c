@@ -19,6 +19,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "common/q_common.h"
+#include <emmintrin.h>
 
 //
 // model loading
@@ -50,9 +51,26 @@ typedef struct
     int contents;
     int numsides;
     int firstbrushside;
-    int checkcount; // to avoid repeated testings
 } cbrush_t;
 
+// Node with its plane inlined, see CM_BuildTraceData.
+typedef struct
+{
+    vec3_t normal;
+    float dist;
+    int type;        // PLANE_X, PLANE_Y, PLANE_Z or 3+ if non-axial
+    int children[2]; // negative numbers are leafs
+    int pad;         // 32 bytes, two nodes per cache line
+} ctracenode_t;
+
+// Brush side planes in SoA form, same indexes as map_brushsides,
+// so the sides of a brush are contiguous in each array.
+typedef struct
+{
+    float normal[3][MAX_MAP_BRUSHSIDES];
+    float dist[MAX_MAP_BRUSHSIDES];
+} csideplanes_t;
+
 typedef struct
 {
     int numareaportals;
@@ -71,7 +89,6 @@ typedef struct
 int numtexinfo;
 mapsurface_t map_surfaces[MAX_MAP_TEXINFO];
 
-static int checkcount;
 static char map_name[MAX_QPATH];
 
 static int numbrushsides;
@@ -83,6 +100,10 @@ static cplane_t map_planes[MAX_MAP_PLANES + 6]; // extra for box hull
 static int numnodes;
 static cnode_t map_nodes[MAX_MAP_NODES + 6]; // extra for box hull
 
+// Trace copies of map_nodes and the map_brushsides planes.
+static ctracenode_t map_tracenodes[MAX_MAP_NODES + 6];
+static csideplanes_t map_sideplanes;
+
 static int numleafs = 1; // allow leaf funcs to be called without a map
 static cleaf_t map_leafs[MAX_MAP_LEAFS];
 static int emptyleaf, solidleaf;
@@ -124,6 +145,7 @@ int c_traces;
 int c_brush_traces;
 
 void CM_InitBoxHull(void);
+void CM_BuildTraceData(void);
 void FloodAreaConnections(void);
 
 /*
@@ -640,6 +662,7 @@ cmodel_t * CM_LoadMap(char * name, qboolean clientload, unsigned * checksum)
     FS_FreeFile(buf);
 
     CM_InitBoxHull();
+    CM_BuildTraceData();
 
     memset(portalopen, 0, sizeof(portalopen));
     FloodAreaConnections();
@@ -801,9 +824,55 @@ int CM_HeadnodeForBox(vec3_t mins, vec3_t maxs)
     box_planes[10].dist = mins[2];
     box_planes[11].dist = -mins[2];
 
+    // keep the trace copies of the box in sync
+    for (int i = 0; i < 6; i++)
+    {
+        map_tracenodes[box_headnode + i].dist = box_planes[i * 2].dist;
+        map_sideplanes.dist[box_brush->firstbrushside + i] = box_planes[i * 2 + (i & 1)].dist;
+    }
+
     return box_headnode;
 }
 
+/*
+===================
+CM_BuildTraceData
+
+Flattens the nodes and brush side planes for the trace code. Nodes keep
+their indexes, qbsp already writes them in depth first order, the plane
+is just copied into each node so a hull check reads one sequential
+array. Brush sides go to SoA arrays so clipping a brush walks contiguous
+floats. Includes the box hull, see CM_HeadnodeForBox.
+===================
+*/
+void CM_BuildTraceData(void)
+{
+    int i;
+
+    for (i = 0; i < numnodes + 6; i++)
+    {
+        const cnode_t * in = &map_nodes[i];
+        ctracenode_t * out = &map_tracenodes[i];
+
+        VectorCopy(in->plane->normal, out->normal);
+        out->dist = in->plane->dist;
+        out->type = in->plane->type;
+        out->children[0] = in->children[0];
+        out->children[1] = in->children[1];
+        out->pad = 0;
+    }
+
+    for (i = 0; i < numbrushsides + 6; i++)
+    {
+        const cplane_t * plane = map_brushsides[i].plane;
+
+        map_sideplanes.normal[0][i] = plane->normal[0];
+        map_sideplanes.normal[1][i] = plane->normal[1];
+        map_sideplanes.normal[2][i] = plane->normal[2];
+        map_sideplanes.dist[i] = plane->dist;
+    }
+}
+
 /*
 ==================
 CM_PointLeafnum_r
@@ -842,12 +911,17 @@ int CM_PointLeafnum(vec3_t p)
     return CM_PointLeafnum_r(p, 0);
 }
 
-static int leaf_topnode;
-static int leaf_count;
-static int leaf_maxcount;
-static int * leaf_list;
-static float * leaf_mins;
-static float * leaf_maxs;
+// Query state for CM_BoxLeafnums_r, kept on the
+// caller's stack so position tests are reentrant.
+typedef struct
+{
+    int topnode;
+    int count;
+    int maxcount;
+    int * list;
+    float * mins;
+    float * maxs;
+} boxleafs_t;
 
 /*
 =============
@@ -856,7 +930,7 @@ CM_BoxLeafnums_r
 Fills in a list of all the leafs touched
 =============
 */
-void CM_BoxLeafnums_r(int nodenum)
+static void CM_BoxLeafnums_r(boxleafs_t * q, int nodenum)
 {
     cplane_t * plane;
     cnode_t * node;
@@ -866,28 +940,28 @@ void CM_BoxLeafnums_r(int nodenum)
     {
         if (nodenum < 0)
         {
-            if (leaf_count >= leaf_maxcount)
+            if (q->count >= q->maxcount)
             {
                 //              Com_Printf ("CM_BoxLeafnums_r: overflow\n");
                 return;
             }
-            leaf_list[leaf_count++] = -1 - nodenum;
+            q->list[q->count++] = -1 - nodenum;
             return;
         }
 
         node = &map_nodes[nodenum];
         plane = node->plane;
-        //      s = BoxOnPlaneSide (leaf_mins, leaf_maxs, plane);
-        s = BOX_ON_PLANE_SIDE(leaf_mins, leaf_maxs, plane);
+        //      s = BoxOnPlaneSide (q->mins, q->maxs, plane);
+        s = BOX_ON_PLANE_SIDE(q->mins, q->maxs, plane);
         if (s == 1)
             nodenum = node->children[0];
         else if (s == 2)
             nodenum = node->children[1];
         else
         { // go down both
-            if (leaf_topnode == -1)
-                leaf_topnode = nodenum;
-            CM_BoxLeafnums_r(node->children[0]);
+            if (q->topnode == -1)
+                q->topnode = nodenum;
+            CM_BoxLeafnums_r(q, node->children[0]);
             nodenum = node->children[1];
         }
     }
@@ -895,20 +969,21 @@ void CM_BoxLeafnums_r(int nodenum)
 
 int CM_BoxLeafnums_headnode(vec3_t mins, vec3_t maxs, int * list, int listsize, int headnode, int * topnode)
 {
-    leaf_list = list;
-    leaf_count = 0;
-    leaf_maxcount = listsize;
-    leaf_mins = mins;
-    leaf_maxs = maxs;
+    boxleafs_t q;
 
-    leaf_topnode = -1;
+    q.list = list;
+    q.count = 0;
+    q.maxcount = listsize;
+    q.mins = mins;
+    q.maxs = maxs;
+    q.topnode = -1;
 
-    CM_BoxLeafnums_r(headnode);
+    CM_BoxLeafnums_r(&q, headnode);
 
     if (topnode)
-        *topnode = leaf_topnode;
+        *topnode = q.topnode;
 
-    return leaf_count;
+    return q.count;
 }
 
 int CM_BoxLeafnums(vec3_t mins, vec3_t maxs, int * list, int listsize, int * topnode)
@@ -979,54 +1054,97 @@ BOX TRACING
 // 1/32 epsilon to keep floating point happy
 #define DIST_EPSILON (0.03125)
 
-static vec3_t trace_start;
-static vec3_t trace_end;
-static vec3_t trace_mins;
-static vec3_t trace_maxs;
-static vec3_t trace_extents;
+/*
+All the state of a trace in progress. The shared cbrush_t data is never
+written during a trace, brushes already tested are stamped in the context
+instead, so several threads can trace at once as long as each one uses its
+own context (see CM_AllocTraceContext).
+*/
+struct cmtrace_context_s
+{
+    vec3_t start;
+    vec3_t end;
+    vec3_t mins;
+    vec3_t maxs;
+    vec3_t extents;
+
+    trace_t trace;
+    int contents;
+    qboolean ispoint; // optimized case
+
+    int checkcount;       // to avoid repeated testings
+    int num_brush_traces; // for statistics, see CM_BoxTrace
+    int brush_checkcounts[MAX_MAP_BRUSHES];
+    qbyte brush_lanes[MAX_MAP_BRUSHES]; // lanes of a batch that tested the brush, see CM_TraceToLeafBatch
+};
 
-static trace_t trace_trace;
-static int trace_contents;
-static qboolean trace_ispoint; // optimized case
+// Context used by CM_BoxTrace, main thread only.
+static cmtrace_context_t cm_main_trace_context;
+
+/*
+================
+CM_AllocTraceContext / CM_FreeTraceContext
+
+Call these from the main thread, Z_Malloc is not thread safe.
+================
+*/
+cmtrace_context_t * CM_AllocTraceContext(void)
+{
+    return (cmtrace_context_t *)Z_Malloc(sizeof(cmtrace_context_t));
+}
+
+void CM_FreeTraceContext(cmtrace_context_t * ctx)
+{
+    if (ctx && ctx != &cm_main_trace_context)
+        Z_Free(ctx);
+}
 
 /*
 ================
 CM_ClipBoxToBrush
 ================
 */
-void CM_ClipBoxToBrush(vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t * trace, cbrush_t * brush)
+static void CM_ClipBoxToBrush(cmtrace_context_t * ctx, vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t * trace, cbrush_t * brush)
 {
     int i, j;
-    cplane_t *plane, *clipplane;
+    const float *nx, *ny, *nz, *pd;
+    vec3_t normal;
     float dist;
     float enterfrac, leavefrac;
     vec3_t ofs;
     float d1, d2;
     qboolean getout, startout;
     float f;
-    cbrushside_t *side, *leadside;
+    int leadside;
+    cbrushside_t * side;
 
     enterfrac = -1;
     leavefrac = 1;
-    clipplane = NULL;
 
     if (!brush->numsides)
         return;
 
-    c_brush_traces++;
+    ctx->num_brush_traces++;
 
     getout = false;
     startout = false;
-    leadside = NULL;
+    leadside = -1;
+
+    // sides of the brush are contiguous in each array
+    nx = &map_sideplanes.normal[0][brush->firstbrushside];
+    ny = &map_sideplanes.normal[1][brush->firstbrushside];
+    nz = &map_sideplanes.normal[2][brush->firstbrushside];
+    pd = &map_sideplanes.dist[brush->firstbrushside];
 
     for (i = 0; i < brush->numsides; i++)
     {
-        side = &map_brushsides[brush->firstbrushside + i];
-        plane = side->plane;
+        normal[0] = nx[i];
+        normal[1] = ny[i];
+        normal[2] = nz[i];
 
         // FIXME: special case for axial
 
-        if (!trace_ispoint)
+        if (!ctx->ispoint)
         { // general box case
 
             // push the plane out apropriately for mins/maxs
@@ -1034,21 +1152,21 @@ void CM_ClipBoxToBrush(vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t *
             // FIXME: use signbits into 8 way lookup for each mins/maxs
             for (j = 0; j < 3; j++)
             {
-                if (plane->normal[j] < 0)
+                if (normal[j] < 0)
                     ofs[j] = maxs[j];
                 else
                     ofs[j] = mins[j];
             }
-            dist = DotProduct(ofs, plane->normal);
-            dist = plane->dist - dist;
+            dist = DotProduct(ofs, normal);
+            dist = pd[i] - dist;
         }
         else
         { // special point case
-            dist = plane->dist;
+            dist = pd[i];
         }
 
-        d1 = DotProduct(p1, plane->normal) - dist;
-        d2 = DotProduct(p2, plane->normal) - dist;
+        d1 = DotProduct(p1, normal) - dist;
+        d2 = DotProduct(p2, normal) - dist;
 
         if (d2 > 0)
             getout = true; // endpoint is not in solid
@@ -1069,8 +1187,7 @@ void CM_ClipBoxToBrush(vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t *
             if (f > enterfrac)
             {
                 enterfrac = f;
-                clipplane = plane;
-                leadside = side;
+                leadside = i;
             }
         }
         else
@@ -1092,11 +1209,12 @@ void CM_ClipBoxToBrush(vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t *
     {
         if (enterfrac > -1 && enterfrac < trace->fraction)
         {
+            side = &map_brushsides[brush->firstbrushside + leadside];
             if (enterfrac < 0)
                 enterfrac = 0;
             trace->fraction = enterfrac;
-            trace->plane = *clipplane;
-            trace->surface = &(leadside->surface->c);
+            trace->plane = *side->plane;
+            trace->surface = &(side->surface->c);
             trace->contents = brush->contents;
         }
     }
@@ -1107,22 +1225,28 @@ void CM_ClipBoxToBrush(vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2, trace_t *
 CM_TestBoxInBrush
 ================
 */
-void CM_TestBoxInBrush(vec3_t mins, vec3_t maxs, vec3_t p1, trace_t * trace, cbrush_t * brush)
+static void CM_TestBoxInBrush(vec3_t mins, vec3_t maxs, vec3_t p1, trace_t * trace, cbrush_t * brush)
 {
     int i, j;
-    cplane_t * plane;
+    const float *nx, *ny, *nz, *pd;
+    vec3_t normal;
     float dist;
     vec3_t ofs;
     float d1;
-    cbrushside_t * side;
 
     if (!brush->numsides)
         return;
 
+    nx = &map_sideplanes.normal[0][brush->firstbrushside];
+    ny = &map_sideplanes.normal[1][brush->firstbrushside];
+    nz = &map_sideplanes.normal[2][brush->firstbrushside];
+    pd = &map_sideplanes.dist[brush->firstbrushside];
+
     for (i = 0; i < brush->numsides; i++)
     {
-        side = &map_brushsides[brush->firstbrushside + i];
-        plane = side->plane;
+        normal[0] = nx[i];
+        normal[1] = ny[i];
+        normal[2] = nz[i];
 
         // FIXME: special case for axial
 
@@ -1133,15 +1257,15 @@ void CM_TestBoxInBrush(vec3_t mins, vec3_t maxs, vec3_t p1, trace_t * trace, cbr
         // FIXME: use signbits into 8 way lookup for each mins/maxs
         for (j = 0; j < 3; j++)
         {
-            if (plane->normal[j] < 0)
+            if (normal[j] < 0)
                 ofs[j] = maxs[j];
             else
                 ofs[j] = mins[j];
         }
-        dist = DotProduct(ofs, plane->normal);
-        dist = plane->dist - dist;
+        dist = DotProduct(ofs, normal);
+        dist = pd[i] - dist;
 
-        d1 = DotProduct(p1, plane->normal) - dist;
+        d1 = DotProduct(p1, normal) - dist;
 
         // if completely in front of face, no intersection
         if (d1 > 0)
@@ -1159,7 +1283,7 @@ void CM_TestBoxInBrush(vec3_t mins, vec3_t maxs, vec3_t p1, trace_t * trace, cbr
 CM_TraceToLeaf
 ================
 */
-void CM_TraceToLeaf(int leafnum)
+static void CM_TraceToLeaf(cmtrace_context_t * ctx, int leafnum)
 {
     int k;
     int brushnum;
@@ -1167,23 +1291,23 @@ void CM_TraceToLeaf(int leafnum)
     cbrush_t * b;
 
     leaf = &map_leafs[leafnum];
-    if (!(leaf->contents & trace_contents))
+    if (!(leaf->contents & ctx->contents))
         return;
     // trace line against all brushes in the leaf
     for (k = 0; k < leaf->numleafbrushes; k++)
     {
         brushnum = map_leafbrushes[leaf->firstleafbrush + k];
         b = &map_brushes[brushnum];
-        if (b->checkcount == checkcount)
+        if (ctx->brush_checkcounts[brushnum] == ctx->checkcount)
             continue; // already checked this brush in another leaf
 
-        b->checkcount = checkcount;
+        ctx->brush_checkcounts[brushnum] = ctx->checkcount;
 
-        if (!(b->contents & trace_contents))
+        if (!(b->contents & ctx->contents))
             continue;
 
-        CM_ClipBoxToBrush(trace_mins, trace_maxs, trace_start, trace_end, &trace_trace, b);
-        if (!trace_trace.fraction)
+        CM_ClipBoxToBrush(ctx, ctx->mins, ctx->maxs, ctx->start, ctx->end, &ctx->trace, b);
+        if (!ctx->trace.fraction)
             return;
     }
 }
@@ -1193,7 +1317,7 @@ void CM_TraceToLeaf(int leafnum)
 CM_TestInLeaf
 ================
 */
-void CM_TestInLeaf(int leafnum)
+static void CM_TestInLeaf(cmtrace_context_t * ctx, int leafnum)
 {
     int k;
     int brushnum;
@@ -1201,23 +1325,23 @@ void CM_TestInLeaf(int leafnum)
     cbrush_t * b;
 
     leaf = &map_leafs[leafnum];
-    if (!(leaf->contents & trace_contents))
+    if (!(leaf->contents & ctx->contents))
         return;
     // trace line against all brushes in the leaf
     for (k = 0; k < leaf->numleafbrushes; k++)
     {
         brushnum = map_leafbrushes[leaf->firstleafbrush + k];
         b = &map_brushes[brushnum];
-        if (b->checkcount == checkcount)
+        if (ctx->brush_checkcounts[brushnum] == ctx->checkcount)
             continue; // already checked this brush in another leaf
 
-        b->checkcount = checkcount;
+        ctx->brush_checkcounts[brushnum] = ctx->checkcount;
 
-        if (!(b->contents & trace_contents))
+        if (!(b->contents & ctx->contents))
             continue;
 
-        CM_TestBoxInBrush(trace_mins, trace_maxs, trace_start, &trace_trace, b);
-        if (!trace_trace.fraction)
+        CM_TestBoxInBrush(ctx->mins, ctx->maxs, ctx->start, &ctx->trace, b);
+        if (!ctx->trace.fraction)
             return;
     }
 }
@@ -1227,10 +1351,9 @@ void CM_TestInLeaf(int leafnum)
 CM_RecursiveHullCheck
 ==================
 */
-void CM_RecursiveHullCheck(int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
+static void CM_RecursiveHullCheck(cmtrace_context_t * ctx, int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
 {
-    cnode_t * node;
-    cplane_t * plane;
+    const ctracenode_t * node;
     float t1, t2, offset;
     float frac, frac2;
     float idist;
@@ -1239,13 +1362,13 @@ void CM_RecursiveHullCheck(int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
     int side;
     float midf;
 
-    if (trace_trace.fraction <= p1f)
+    if (ctx->trace.fraction <= p1f)
         return; // already hit something nearer
 
     // if < 0, we are in a leaf node
     if (num < 0)
     {
-        CM_TraceToLeaf(-1 - num);
+        CM_TraceToLeaf(ctx, -1 - num);
         return;
     }
 
@@ -1253,46 +1376,45 @@ void CM_RecursiveHullCheck(int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
     // find the point distances to the seperating plane
     // and the offset for the size of the box
     //
-    node = map_nodes + num;
-    plane = node->plane;
+    node = map_tracenodes + num;
 
-    if (plane->type < 3)
+    if (node->type < 3)
     {
-        t1 = p1[plane->type] - plane->dist;
-        t2 = p2[plane->type] - plane->dist;
-        offset = trace_extents[plane->type];
+        t1 = p1[node->type] - node->dist;
+        t2 = p2[node->type] - node->dist;
+        offset = ctx->extents[node->type];
     }
     else
     {
-        t1 = DotProduct(plane->normal, p1) - plane->dist;
-        t2 = DotProduct(plane->normal, p2) - plane->dist;
-        if (trace_ispoint)
+        t1 = DotProduct(node->normal, p1) - node->dist;
+        t2 = DotProduct(node->normal, p2) - node->dist;
+        if (ctx->ispoint)
         {
             offset = 0;
         }
         else
         {
-            offset = fabs(trace_extents[0] * plane->normal[0]) +
-                     fabs(trace_extents[1] * plane->normal[1]) +
-                     fabs(trace_extents[2] * plane->normal[2]);
+            offset = fabs(ctx->extents[0] * node->normal[0]) +
+                     fabs(ctx->extents[1] * node->normal[1]) +
+                     fabs(ctx->extents[2] * node->normal[2]);
         }
     }
 
 #if 0
-CM_RecursiveHullCheck (node->children[0], p1f, p2f, p1, p2);
-CM_RecursiveHullCheck (node->children[1], p1f, p2f, p1, p2);
+CM_RecursiveHullCheck (ctx, node->children[0], p1f, p2f, p1, p2);
+CM_RecursiveHullCheck (ctx, node->children[1], p1f, p2f, p1, p2);
 return;
 #endif
 
     // see which sides we need to consider
     if (t1 >= offset && t2 >= offset)
     {
-        CM_RecursiveHullCheck(node->children[0], p1f, p2f, p1, p2);
+        CM_RecursiveHullCheck(ctx, node->children[0], p1f, p2f, p1, p2);
         return;
     }
     if (t1 < -offset && t2 < -offset)
     {
-        CM_RecursiveHullCheck(node->children[1], p1f, p2f, p1, p2);
+        CM_RecursiveHullCheck(ctx, node->children[1], p1f, p2f, p1, p2);
         return;
     }
 
@@ -1328,7 +1450,7 @@ return;
     for (i = 0; i < 3; i++)
         mid[i] = p1[i] + frac * (p2[i] - p1[i]);
 
-    CM_RecursiveHullCheck(node->children[side], p1f, midf, p1, mid);
+    CM_RecursiveHullCheck(ctx, node->children[side], p1f, midf, p1, mid);
 
     // go past the node
     if (frac2 < 0)
@@ -1340,36 +1462,36 @@ return;
     for (i = 0; i < 3; i++)
         mid[i] = p1[i] + frac2 * (p2[i] - p1[i]);
 
-    CM_RecursiveHullCheck(node->children[side ^ 1], midf, p2f, mid, p2);
+    CM_RecursiveHullCheck(ctx, node->children[side ^ 1], midf, p2f, mid, p2);
 }
 
 //======================================================================
 
 /*
 ==================
-CM_BoxTrace
+CM_BoxTraceContext
 ==================
 */
-trace_t CM_BoxTrace(vec3_t start, vec3_t end,
-                    vec3_t mins, vec3_t maxs,
-                    int headnode, int brushmask)
+trace_t CM_BoxTraceContext(cmtrace_context_t * ctx,
+                           vec3_t start, vec3_t end,
+                           vec3_t mins, vec3_t maxs,
+                           int headnode, int brushmask)
 {
-    checkcount++; // for multi-check avoidance
-    c_traces++;   // for statistics, may be zeroed
+    ctx->checkcount++; // for multi-check avoidance
 
     // fill in a default trace
-    memset(&trace_trace, 0, sizeof(trace_trace));
-    trace_trace.fraction = 1;
-    trace_trace.surface = &(nullsurface.c);
+    memset(&ctx->trace, 0, sizeof(ctx->trace));
+    ctx->trace.fraction = 1;
+    ctx->trace.surface = &(nullsurface.c);
 
     if (!numnodes) // map not loaded
-        return trace_trace;
+        return ctx->trace;
 
-    trace_contents = brushmask;
-    VectorCopy(start, trace_start);
-    VectorCopy(end, trace_end);
-    VectorCopy(mins, trace_mins);
-    VectorCopy(maxs, trace_maxs);
+    ctx->contents = brushmask;
+    VectorCopy(start, ctx->start);
+    VectorCopy(end, ctx->end);
+    VectorCopy(mins, ctx->mins);
+    VectorCopy(maxs, ctx->maxs);
 
     //
     // check for position test special case
@@ -1392,12 +1514,12 @@ trace_t CM_BoxTrace(vec3_t start, vec3_t end,
         int num_leafs = CM_BoxLeafnums_headnode(c1, c2, leafs, 1024, headnode, &topnode);
         for (i = 0; i < num_leafs; i++)
         {
-            CM_TestInLeaf(leafs[i]);
-            if (trace_trace.allsolid)
+            CM_TestInLeaf(ctx, leafs[i]);
+            if (ctx->trace.allsolid)
                 break;
         }
-        VectorCopy(start, trace_trace.endpos);
-        return trace_trace;
+        VectorCopy(start, ctx->trace.endpos);
+        return ctx->trace;
     }
 
     //
@@ -1405,46 +1527,80 @@ trace_t CM_BoxTrace(vec3_t start, vec3_t end,
     //
     if (mins[0] == 0 && mins[1] == 0 && mins[2] == 0 && maxs[0] == 0 && maxs[1] == 0 && maxs[2] == 0)
     {
-        trace_ispoint = true;
-        VectorClear(trace_extents);
+        ctx->ispoint = true;
+        VectorClear(ctx->extents);
     }
     else
     {
-        trace_ispoint = false;
-        trace_extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
-        trace_extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
-        trace_extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
+        ctx->ispoint = false;
+        ctx->extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
+        ctx->extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
+        ctx->extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
     }
 
     //
     // general sweeping through world
     //
-    CM_RecursiveHullCheck(headnode, 0, 1, start, end);
+    CM_RecursiveHullCheck(ctx, headnode, 0, 1, start, end);
 
-    if (trace_trace.fraction == 1)
+    if (ctx->trace.fraction == 1)
     {
-        VectorCopy(end, trace_trace.endpos);
+        VectorCopy(end, ctx->trace.endpos);
     }
     else
     {
         for (int i = 0; i < 3; i++)
-            trace_trace.endpos[i] = start[i] + trace_trace.fraction * (end[i] - start[i]);
+            ctx->trace.endpos[i] = start[i] + ctx->trace.fraction * (end[i] - start[i]);
     }
-    return trace_trace;
+    return ctx->trace;
 }
 
 /*
 ==================
-CM_TransformedBoxTrace
+CM_UpdateTraceStats
+
+Only the main context feeds the global counters,
+other threads would race on them.
+==================
+*/
+static void CM_UpdateTraceStats(int num_traces)
+{
+    // for statistics, may be zeroed
+    c_traces += num_traces;
+    c_brush_traces += cm_main_trace_context.num_brush_traces;
+    cm_main_trace_context.num_brush_traces = 0;
+}
+
+/*
+==================
+CM_BoxTrace
+==================
+*/
+trace_t CM_BoxTrace(vec3_t start, vec3_t end,
+                    vec3_t mins, vec3_t maxs,
+                    int headnode, int brushmask)
+{
+    trace_t trace;
+
+    trace = CM_BoxTraceContext(&cm_main_trace_context, start, end, mins, maxs, headnode, brushmask);
+    CM_UpdateTraceStats(1);
+
+    return trace;
+}
+
+/*
+==================
+CM_TransformedBoxTraceContext
 
 Handles offseting and rotation of the end points for moving and
 rotating entities
 ==================
 */
-trace_t CM_TransformedBoxTrace(vec3_t start, vec3_t end,
-                               vec3_t mins, vec3_t maxs,
-                               int headnode, int brushmask,
-                               vec3_t origin, vec3_t angles)
+trace_t CM_TransformedBoxTraceContext(cmtrace_context_t * ctx,
+                                      vec3_t start, vec3_t end,
+                                      vec3_t mins, vec3_t maxs,
+                                      int headnode, int brushmask,
+                                      vec3_t origin, vec3_t angles)
 {
     trace_t trace;
     vec3_t start_l, end_l;
@@ -1484,7 +1640,7 @@ trace_t CM_TransformedBoxTrace(vec3_t start, vec3_t end,
     }
 
     // sweep the box through the model
-    trace = CM_BoxTrace(start_l, end_l, mins, maxs, headnode, brushmask);
+    trace = CM_BoxTraceContext(ctx, start_l, end_l, mins, maxs, headnode, brushmask);
 
     if (rotated && trace.fraction != 1.0)
     {
@@ -1505,6 +1661,765 @@ trace_t CM_TransformedBoxTrace(vec3_t start, vec3_t end,
     return trace;
 }
 
+/*
+==================
+CM_TransformedBoxTrace
+==================
+*/
+trace_t CM_TransformedBoxTrace(vec3_t start, vec3_t end,
+                               vec3_t mins, vec3_t maxs,
+                               int headnode, int brushmask,
+                               vec3_t origin, vec3_t angles)
+{
+    trace_t trace;
+
+    trace = CM_TransformedBoxTraceContext(&cm_main_trace_context, start, end, mins, maxs,
+                                          headnode, brushmask, origin, angles);
+    CM_UpdateTraceStats(1);
+
+    return trace;
+}
+
+/*
+===============================================================================
+
+BATCHED TRACING
+
+Sweeps up to four rays down the tree together, one per SSE lane. Every lane
+keeps its own segment, so the node plane tests and the brush side tests run
+four wide, while each ray still visits nodes and brushes in the same order as
+CM_RecursiveHullCheck and gets the exact same result. The float and double
+mix of the scalar code (DIST_EPSILON is a double) is reproduced as well.
+
+===============================================================================
+*/
+
+#define CM_BATCH_LANES 4
+
+typedef struct
+{
+    __m128 p1f;
+    __m128 p2f;
+    __m128 p1[3];
+    __m128 p2[3];
+} cmbatch_segment_t;
+
+typedef struct
+{
+    cmtrace_context_t * ctx;
+    __m128 start[3];
+    __m128 end[3];
+    __m128 mins[3];
+    __m128 maxs[3];
+    __m128 extents[3];
+    __m128 fraction; // mirrors traces[].fraction
+    trace_t traces[CM_BATCH_LANES];
+} cmbatch_t;
+
+static __m128 CM_LaneMask(int lanes)
+{
+    const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(lanes), bits), bits));
+}
+
+static __m128 CM_Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static __m128 CM_Dot(__m128 x0, __m128 x1, __m128 x2, __m128 n0, __m128 n1, __m128 n2)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, n0), _mm_mul_ps(x1, n1)), _mm_mul_ps(x2, n2));
+}
+
+// (float)(((double)a + add) * (double)b)
+static __m128 CM_AddMulDouble(__m128 a, double add, __m128 b)
+{
+    const __m128d d = _mm_set1_pd(add);
+    const __m128d lo = _mm_mul_pd(_mm_add_pd(_mm_cvtps_pd(a), d), _mm_cvtps_pd(b));
+    const __m128d hi = _mm_mul_pd(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), d), _mm_cvtps_pd(_mm_movehl_ps(b, b)));
+    return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+// (float)(((double)a + add) / (double)b)
+static __m128 CM_AddDivDouble(__m128 a, double add, __m128 b)
+{
+    const __m128d d = _mm_set1_pd(add);
+    const __m128d lo = _mm_div_pd(_mm_add_pd(_mm_cvtps_pd(a), d), _mm_cvtps_pd(b));
+    const __m128d hi = _mm_div_pd(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), d), _mm_cvtps_pd(_mm_movehl_ps(b, b)));
+    return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+// (float)(fabs(a) + fabs(b) + fabs(c)), summed in double
+static __m128 CM_SumAbsDouble(__m128 a, __m128 b, __m128 c)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128d lo, hi;
+
+    a = _mm_andnot_ps(sign, a);
+    b = _mm_andnot_ps(sign, b);
+    c = _mm_andnot_ps(sign, c);
+
+    lo = _mm_add_pd(_mm_add_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)), _mm_cvtps_pd(c));
+    hi = _mm_add_pd(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), _mm_cvtps_pd(_mm_movehl_ps(b, b))),
+                    _mm_cvtps_pd(_mm_movehl_ps(c, c)));
+    return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+static void CM_SelectSegment(cmbatch_segment_t * out, int lanes, const cmbatch_segment_t * a, const cmbatch_segment_t * b)
+{
+    const __m128 mask = CM_LaneMask(lanes);
+    int i;
+
+    out->p1f = CM_Select(mask, a->p1f, b->p1f);
+    out->p2f = CM_Select(mask, a->p2f, b->p2f);
+    for (i = 0; i < 3; i++)
+    {
+        out->p1[i] = CM_Select(mask, a->p1[i], b->p1[i]);
+        out->p2[i] = CM_Select(mask, a->p2[i], b->p2[i]);
+    }
+}
+
+static void CM_UpdateBatchFractions(cmbatch_t * b)
+{
+    b->fraction = _mm_setr_ps(b->traces[0].fraction, b->traces[1].fraction,
+                              b->traces[2].fraction, b->traces[3].fraction);
+}
+
+/*
+================
+CM_ClipBoxToBrushBatch
+
+CM_ClipBoxToBrush for the lanes set in the lanes bitmask.
+================
+*/
+static void CM_ClipBoxToBrushBatch(cmbatch_t * b, cbrush_t * brush, int lanes)
+{
+    int i, l;
+    const float *nx, *ny, *nz, *pd;
+    cbrushside_t * side;
+    __m128 active, getout, startout;
+    __m128 enterfrac, leavefrac;
+    __m128i leadside;
+    __m128 n0, n1, n2;
+    __m128 ofs[3];
+    __m128 dist, d1, d2;
+    __m128 out, cross, enter, leave, upd, f;
+    float enterfracs[CM_BATCH_LANES], leavefracs[CM_BATCH_LANES];
+    int leadsides[CM_BATCH_LANES];
+    int getouts, startouts;
+    const __m128 zero = _mm_setzero_ps();
+
+    if (!brush->numsides)
+        return;
+
+    for (l = 0; l < CM_BATCH_LANES; l++)
+    {
+        if (lanes & (1 << l))
+            b->ctx->num_brush_traces++;
+    }
+
+    active = CM_LaneMask(lanes);
+    getout = zero;
+    startout = zero;
+    enterfrac = _mm_set1_ps(-1);
+    leavefrac = _mm_set1_ps(1);
+    leadside = _mm_set1_epi32(-1);
+
+    nx = &map_sideplanes.normal[0][brush->firstbrushside];
+    ny = &map_sideplanes.normal[1][brush->firstbrushside];
+    nz = &map_sideplanes.normal[2][brush->firstbrushside];
+    pd = &map_sideplanes.dist[brush->firstbrushside];
+
+    for (i = 0; i < brush->numsides; i++)
+    {
+        n0 = _mm_set1_ps(nx[i]);
+        n1 = _mm_set1_ps(ny[i]);
+        n2 = _mm_set1_ps(nz[i]);
+
+        // push the plane out apropriately for mins/maxs,
+        // point lanes have zero mins/maxs so this is a no-op for them
+        ofs[0] = (nx[i] < 0) ? b->maxs[0] : b->mins[0];
+        ofs[1] = (ny[i] < 0) ? b->maxs[1] : b->mins[1];
+        ofs[2] = (nz[i] < 0) ? b->maxs[2] : b->mins[2];
+        dist = _mm_sub_ps(_mm_set1_ps(pd[i]), CM_Dot(ofs[0], ofs[1], ofs[2], n0, n1, n2));
+
+        d1 = _mm_sub_ps(CM_Dot(b->start[0], b->start[1], b->start[2], n0, n1, n2), dist);
+        d2 = _mm_sub_ps(CM_Dot(b->end[0], b->end[1], b->end[2], n0, n1, n2), dist);
+
+        getout = _mm_or_ps(getout, _mm_and_ps(active, _mm_cmpgt_ps(d2, zero)));
+        startout = _mm_or_ps(startout, _mm_and_ps(active, _mm_cmpgt_ps(d1, zero)));
+
+        // lanes completely in front of face have no intersection
+        out = _mm_and_ps(_mm_cmpgt_ps(d1, zero), _mm_cmpge_ps(d2, d1));
+        active = _mm_andnot_ps(out, active);
+        if (!_mm_movemask_ps(active))
+            return;
+
+        cross = _mm_andnot_ps(_mm_and_ps(_mm_cmple_ps(d1, zero), _mm_cmple_ps(d2, zero)), active);
+        if (!_mm_movemask_ps(cross))
+            continue;
+
+        enter = _mm_and_ps(cross, _mm_cmpgt_ps(d1, d2));
+        leave = _mm_andnot_ps(enter, cross);
+
+        f = CM_AddDivDouble(d1, -DIST_EPSILON, _mm_sub_ps(d1, d2));
+        upd = _mm_and_ps(enter, _mm_cmpgt_ps(f, enterfrac));
+        enterfrac = CM_Select(upd, f, enterfrac);
+        leadside = _mm_or_si128(_mm_and_si128(_mm_castps_si128(upd), _mm_set1_epi32(i)),
+                                _mm_andnot_si128(_mm_castps_si128(upd), leadside));
+
+        f = CM_AddDivDouble(d1, DIST_EPSILON, _mm_sub_ps(d1, d2));
+        upd = _mm_and_ps(leave, _mm_cmplt_ps(f, leavefrac));
+        leavefrac = CM_Select(upd, f, leavefrac);
+    }
+
+    lanes &= _mm_movemask_ps(active);
+    getouts = _mm_movemask_ps(getout);
+    startouts = _mm_movemask_ps(startout);
+    _mm_storeu_ps(enterfracs, enterfrac);
+    _mm_storeu_ps(leavefracs, leavefrac);
+    _mm_storeu_si128((__m128i *)leadsides, leadside);
+
+    for (l = 0; l < CM_BATCH_LANES; l++)
+    {
+        trace_t * trace = &b->traces[l];
+        float frac = enterfracs[l];
+
+        if (!(lanes & (1 << l)))
+            continue;
+
+        if (!(startouts & (1 << l)))
+        { // original point was inside brush
+            trace->startsolid = true;
+            if (!(getouts & (1 << l)))
+                trace->allsolid = true;
+            continue;
+        }
+        if (frac < leavefracs[l])
+        {
+            if (frac > -1 && frac < trace->fraction)
+            {
+                side = &map_brushsides[brush->firstbrushside + leadsides[l]];
+                if (frac < 0)
+                    frac = 0;
+                trace->fraction = frac;
+                trace->plane = *side->plane;
+                trace->surface = &(side->surface->c);
+                trace->contents = brush->contents;
+            }
+        }
+    }
+
+    CM_UpdateBatchFractions(b);
+}
+
+/*
+================
+CM_TraceToLeafBatch
+================
+*/
+static void CM_TraceToLeafBatch(cmbatch_t * b, int leafnum, int lanes)
+{
+    cmtrace_context_t * ctx = b->ctx;
+    int k;
+    int brushnum;
+    int brush_lanes;
+    cleaf_t * leaf;
+    cbrush_t * br;
+
+    leaf = &map_leafs[leafnum];
+    if (!(leaf->contents & ctx->contents))
+        return;
+    // trace lines against all brushes in the leaf
+    for (k = 0; k < leaf->numleafbrushes; k++)
+    {
+        brushnum = map_leafbrushes[leaf->firstleafbrush + k];
+        br = &map_brushes[brushnum];
+
+        // one stamp per batch plus the lanes that already checked this brush in another leaf
+        if (ctx->brush_checkcounts[brushnum] != ctx->checkcount)
+        {
+            ctx->brush_checkcounts[brushnum] = ctx->checkcount;
+            ctx->brush_lanes[brushnum] = 0;
+        }
+        brush_lanes = lanes & ~ctx->brush_lanes[brushnum];
+        if (!brush_lanes)
+            continue;
+
+        ctx->brush_lanes[brushnum] |= brush_lanes;
+
+        if (!(br->contents & ctx->contents))
+            continue;
+
+        CM_ClipBoxToBrushBatch(b, br, brush_lanes);
+
+        lanes &= ~_mm_movemask_ps(_mm_cmpeq_ps(b->fraction, _mm_setzero_ps()));
+        if (!lanes)
+            return;
+    }
+}
+
+/*
+==================
+CM_RecursiveHullCheckBatch
+==================
+*/
+static void CM_RecursiveHullCheckBatch(cmbatch_t * b, int num, int lanes, const cmbatch_segment_t * seg)
+{
+    const ctracenode_t * node;
+    __m128 t1, t2, offset, neg_offset, dist;
+    __m128 n0, n1, n2;
+    __m128 idist, frac, frac2, lt;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1);
+    cmbatch_segment_t near_seg, far_seg, child_seg;
+    int front, back, cross, side0, side1;
+    int i;
+
+    // already hit something nearer
+    lanes &= ~_mm_movemask_ps(_mm_cmple_ps(b->fraction, seg->p1f));
+    if (!lanes)
+        return;
+
+    // if < 0, we are in a leaf node
+    if (num < 0)
+    {
+        CM_TraceToLeafBatch(b, -1 - num, lanes);
+        return;
+    }
+
+    //
+    // find the point distances to the seperating plane
+    // and the offset for the size of the box
+    //
+    node = map_tracenodes + num;
+    dist = _mm_set1_ps(node->dist);
+
+    if (node->type < 3)
+    {
+        t1 = _mm_sub_ps(seg->p1[node->type], dist);
+        t2 = _mm_sub_ps(seg->p2[node->type], dist);
+        offset = b->extents[node->type];
+    }
+    else
+    {
+        n0 = _mm_set1_ps(node->normal[0]);
+        n1 = _mm_set1_ps(node->normal[1]);
+        n2 = _mm_set1_ps(node->normal[2]);
+        t1 = _mm_sub_ps(CM_Dot(seg->p1[0], seg->p1[1], seg->p1[2], n0, n1, n2), dist);
+        t2 = _mm_sub_ps(CM_Dot(seg->p2[0], seg->p2[1], seg->p2[2], n0, n1, n2), dist);
+        offset = CM_SumAbsDouble(_mm_mul_ps(b->extents[0], n0),
+                                 _mm_mul_ps(b->extents[1], n1),
+                                 _mm_mul_ps(b->extents[2], n2));
+    }
+
+    // see which sides we need to consider
+    neg_offset = _mm_xor_ps(offset, _mm_set1_ps(-0.0f));
+    front = lanes & _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(t1, offset), _mm_cmpge_ps(t2, offset)));
+    back = lanes & ~front & _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(t1, neg_offset), _mm_cmplt_ps(t2, neg_offset)));
+    cross = lanes & ~front & ~back;
+    side0 = 0;
+    side1 = 0;
+
+    if (cross)
+    {
+        // put the crosspoint DIST_EPSILON pixels on the near side
+        lt = _mm_cmplt_ps(t1, t2);
+        idist = CM_AddDivDouble(zero, 1.0, _mm_sub_ps(t1, t2));
+
+        frac = CM_Select(lt, CM_AddMulDouble(_mm_sub_ps(t1, offset), DIST_EPSILON, idist),
+                             CM_AddMulDouble(_mm_add_ps(t1, offset), DIST_EPSILON, idist));
+        frac2 = CM_Select(lt, CM_AddMulDouble(_mm_add_ps(t1, offset), DIST_EPSILON, idist),
+                              CM_AddMulDouble(_mm_sub_ps(t1, offset), -DIST_EPSILON, idist));
+
+        // t1 == t2
+        frac = CM_Select(_mm_cmpeq_ps(t1, t2), one, frac);
+        frac2 = CM_Select(_mm_cmpeq_ps(t1, t2), zero, frac2);
+
+        // move up to the node
+        frac = CM_Select(_mm_cmplt_ps(frac, zero), zero, frac);
+        frac = CM_Select(_mm_cmpgt_ps(frac, one), one, frac);
+
+        near_seg.p1f = seg->p1f;
+        near_seg.p2f = _mm_add_ps(seg->p1f, _mm_mul_ps(_mm_sub_ps(seg->p2f, seg->p1f), frac));
+        for (i = 0; i < 3; i++)
+        {
+            near_seg.p1[i] = seg->p1[i];
+            near_seg.p2[i] = _mm_add_ps(seg->p1[i], _mm_mul_ps(frac, _mm_sub_ps(seg->p2[i], seg->p1[i])));
+        }
+
+        // go past the node
+        frac2 = CM_Select(_mm_cmplt_ps(frac2, zero), zero, frac2);
+        frac2 = CM_Select(_mm_cmpgt_ps(frac2, one), one, frac2);
+
+        far_seg.p1f = _mm_add_ps(seg->p1f, _mm_mul_ps(_mm_sub_ps(seg->p2f, seg->p1f), frac2));
+        far_seg.p2f = seg->p2f;
+        for (i = 0; i < 3; i++)
+        {
+            far_seg.p1[i] = _mm_add_ps(seg->p1[i], _mm_mul_ps(frac2, _mm_sub_ps(seg->p2[i], seg->p1[i])));
+            far_seg.p2[i] = seg->p2[i];
+        }
+
+        side1 = cross & _mm_movemask_ps(lt);
+        side0 = cross & ~side1;
+    }
+
+    // Each lane sees its near side first, same as the scalar recursion:
+    // child 0 takes the front lanes and the near half of the side 0 lanes,
+    // child 1 the back lanes, the far half of side 0 and the near half of side 1,
+    // then child 0 again for the far half of the side 1 lanes.
+    if (front | side0)
+    {
+        CM_SelectSegment(&child_seg, side0, &near_seg, seg);
+        CM_RecursiveHullCheckBatch(b, node->children[0], front | side0, &child_seg);
+    }
+    if (back | cross)
+    {
+        CM_SelectSegment(&child_seg, side0, &far_seg, seg);
+        CM_SelectSegment(&child_seg, side1, &near_seg, &child_seg);
+        CM_RecursiveHullCheckBatch(b, node->children[1], back | cross, &child_seg);
+    }
+    if (side1)
+    {
+        CM_RecursiveHullCheckBatch(b, node->children[0], side1, &far_seg);
+    }
+}
+
+/*
+==================
+CM_BoxTraceLanes
+
+Sweeps num_lanes (at most CM_BATCH_LANES) rays at once.
+==================
+*/
+static void CM_BoxTraceLanes(cmtrace_context_t * ctx, const traceray_t * rays, const int * indexes, int num_lanes,
+                             int headnode, trace_t * results)
+{
+    cmbatch_t b;
+    cmbatch_segment_t seg;
+    float start[3][CM_BATCH_LANES], end[3][CM_BATCH_LANES];
+    float mins[3][CM_BATCH_LANES], maxs[3][CM_BATCH_LANES];
+    float extents[3][CM_BATCH_LANES];
+    int i, l;
+
+    ctx->checkcount++; // for multi-check avoidance, shared by all lanes
+
+    memset(start, 0, sizeof(start));
+    memset(end, 0, sizeof(end));
+    memset(mins, 0, sizeof(mins));
+    memset(maxs, 0, sizeof(maxs));
+    memset(extents, 0, sizeof(extents));
+
+    for (l = 0; l < CM_BATCH_LANES; l++)
+    {
+        // fill in a default trace
+        memset(&b.traces[l], 0, sizeof(trace_t));
+        b.traces[l].fraction = 1;
+        b.traces[l].surface = &(nullsurface.c);
+
+        if (l >= num_lanes)
+            continue;
+
+        const traceray_t * ray = &rays[indexes[l]];
+        const qboolean ispoint = VectorCompare((float *)ray->mins, vec3_origin) && VectorCompare((float *)ray->maxs, vec3_origin);
+
+        for (i = 0; i < 3; i++)
+        {
+            start[i][l] = ray->start[i];
+            end[i][l] = ray->end[i];
+            mins[i][l] = ray->mins[i];
+            maxs[i][l] = ray->maxs[i];
+            if (!ispoint)
+                extents[i][l] = -ray->mins[i] > ray->maxs[i] ? -ray->mins[i] : ray->maxs[i];
+        }
+    }
+
+    b.ctx = ctx;
+    b.fraction = _mm_set1_ps(1);
+    for (i = 0; i < 3; i++)
+    {
+        b.start[i] = _mm_loadu_ps(start[i]);
+        b.end[i] = _mm_loadu_ps(end[i]);
+        b.mins[i] = _mm_loadu_ps(mins[i]);
+        b.maxs[i] = _mm_loadu_ps(maxs[i]);
+        b.extents[i] = _mm_loadu_ps(extents[i]);
+        seg.p1[i] = b.start[i];
+        seg.p2[i] = b.end[i];
+    }
+    seg.p1f = _mm_setzero_ps();
+    seg.p2f = _mm_set1_ps(1);
+
+    //
+    // general sweeping through world
+    //
+    CM_RecursiveHullCheckBatch(&b, headnode, (1 << num_lanes) - 1, &seg);
+
+    for (l = 0; l < num_lanes; l++)
+    {
+        const traceray_t * ray = &rays[indexes[l]];
+        trace_t * trace = &b.traces[l];
+
+        if (trace->fraction == 1)
+        {
+            VectorCopy(ray->end, trace->endpos);
+        }
+        else
+        {
+            for (i = 0; i < 3; i++)
+                trace->endpos[i] = ray->start[i] + trace->fraction * (ray->end[i] - ray->start[i]);
+        }
+        results[indexes[l]] = *trace;
+    }
+}
+
+/*
+==================
+CM_BoxTraceBatchContext
+
+Same as calling CM_BoxTraceContext on each ray.
+==================
+*/
+void CM_BoxTraceBatchContext(cmtrace_context_t * ctx,
+                             const traceray_t * rays, int num_rays,
+                             int headnode, int brushmask,
+                             trace_t * results)
+{
+    int indexes[CM_BATCH_LANES];
+    int num_lanes = 0;
+    int i;
+
+    ctx->contents = brushmask;
+
+    for (i = 0; i < num_rays; i++)
+    {
+        const traceray_t * ray = &rays[i];
+
+        // map not loaded and position tests take the scalar path
+        if (!numnodes || VectorCompare((float *)ray->start, (float *)ray->end))
+        {
+            results[i] = CM_BoxTraceContext(ctx, (float *)ray->start, (float *)ray->end,
+                                            (float *)ray->mins, (float *)ray->maxs, headnode, brushmask);
+            continue;
+        }
+
+        indexes[num_lanes++] = i;
+        if (num_lanes == CM_BATCH_LANES)
+        {
+            CM_BoxTraceLanes(ctx, rays, indexes, num_lanes, headnode, results);
+            num_lanes = 0;
+        }
+    }
+
+    if (num_lanes)
+        CM_BoxTraceLanes(ctx, rays, indexes, num_lanes, headnode, results);
+}
+
+/*
+==================
+CM_BoxTraceBatch
+==================
+*/
+void CM_BoxTraceBatch(const traceray_t * rays, int num_rays,
+                      int headnode, int brushmask,
+                      trace_t * results)
+{
+    CM_BoxTraceBatchContext(&cm_main_trace_context, rays, num_rays, headnode, brushmask, results);
+    CM_UpdateTraceStats(num_rays);
+}
+
+/*
+===============================================================================
+
+TRACE BENCHMARK
+
+===============================================================================
+*/
+
+#define CM_BENCH_MAX_THREADS 32
+
+typedef struct
+{
+    const traceray_t * rays;
+    const float * fractions; // reference results from the single threaded run
+    int num_rays;
+    cmtrace_context_t * contexts[CM_BENCH_MAX_THREADS];
+    int mismatches[CM_BENCH_MAX_THREADS];
+} cmbench_t;
+
+static float CM_BenchRandom(unsigned * seed, float lo, float hi)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((*seed >> 8) * (1.0f / 16777216.0f));
+}
+
+static qboolean CM_BenchSameTrace(const trace_t * a, const trace_t * b)
+{
+    return a->fraction == b->fraction && a->allsolid == b->allsolid && a->startsolid == b->startsolid &&
+           a->contents == b->contents && a->surface == b->surface && a->plane.dist == b->plane.dist &&
+           VectorCompare((float *)a->plane.normal, (float *)b->plane.normal) &&
+           VectorCompare((float *)a->endpos, (float *)b->endpos);
+}
+
+static void CM_BenchThread(void * param, int thread_index)
+{
+    cmbench_t * bench = (cmbench_t *)param;
+    cmtrace_context_t * ctx = bench->contexts[thread_index];
+    int i;
+
+    for (i = 0; i < bench->num_rays; i++)
+    {
+        const traceray_t * r = &bench->rays[i];
+        trace_t tr = CM_BoxTraceContext(ctx, (float *)r->start, (float *)r->end,
+                                         (float *)r->mins, (float *)r->maxs,
+                                         map_cmodels[0].headnode, MASK_SOLID);
+        if (tr.fraction != bench->fractions[i])
+            bench->mismatches[thread_index]++;
+    }
+}
+
+/*
+==================
+CM_TraceBench_f
+
+trace_bench [num_threads] [num_traces]
+
+Traces the same random rays and boxes against the world on one thread,
+with CM_BoxTraceBatch, then on every thread at once, each with its own
+trace context. Prints the throughput of each run and checks that the
+batched and threaded results match the scalar ones.
+==================
+*/
+static void CM_TraceBench_f(void)
+{
+    static const vec3_t player_mins = { -16, -16, -24 };
+    static const vec3_t player_maxs = { 16, 16, 32 };
+
+    cmbench_t bench;
+    traceray_t * rays;
+    float * fractions;
+    trace_t * reference;
+    trace_t * batched;
+    unsigned seed = 1234;
+    int num_threads, num_rays, mismatches;
+    int i, t, time_start, time_single, time_batched, time_threaded;
+
+    if (!numnodes)
+    {
+        Com_Printf("trace_bench: no map loaded.\n");
+        return;
+    }
+
+    num_threads = (Cmd_Argc() > 1) ? atoi(Cmd_Argv(1)) : Sys_NumCPUs();
+    num_rays = (Cmd_Argc() > 2) ? atoi(Cmd_Argv(2)) : 100000;
+    num_threads = num_threads < 1 ? 1 : (num_threads > CM_BENCH_MAX_THREADS ? CM_BENCH_MAX_THREADS : num_threads);
+    num_rays = num_rays < 1 ? 1 : num_rays;
+
+    rays = (traceray_t *)Z_Malloc(num_rays * sizeof(traceray_t));
+    fractions = (float *)Z_Malloc(num_rays * sizeof(float));
+    reference = (trace_t *)Z_Malloc(num_rays * sizeof(trace_t));
+    batched = (trace_t *)Z_Malloc(num_rays * sizeof(trace_t));
+
+    // Mix of point traces, player sized box sweeps and position tests,
+    // in groups of 8 that share a start and a rough direction like shotgun
+    // pellets or AI probes do.
+    for (i = 0; i < num_rays; i++)
+    {
+        traceray_t * r = &rays[i];
+        if ((i & 7) == 0)
+        {
+            for (t = 0; t < 3; t++)
+            {
+                r->start[t] = CM_BenchRandom(&seed, map_cmodels[0].mins[t], map_cmodels[0].maxs[t]);
+                r->end[t] = r->start[t] + CM_BenchRandom(&seed, -512, 512);
+            }
+        }
+        else
+        {
+            VectorCopy(rays[i - 1].start, r->start);
+            for (t = 0; t < 3; t++)
+                r->end[t] = rays[i - 1].end[t] + CM_BenchRandom(&seed, -32, 32);
+        }
+        if ((i & 7) >= 4)
+        {
+            VectorCopy(player_mins, r->mins);
+            VectorCopy(player_maxs, r->maxs);
+        }
+        if ((i & 15) == 15)
+        {
+            VectorCopy(r->start, r->end);
+        }
+    }
+
+    memset(&bench, 0, sizeof(bench));
+    bench.rays = rays;
+    bench.num_rays = num_rays;
+
+    // Single threaded reference run.
+    time_start = Sys_Milliseconds();
+    for (i = 0; i < num_rays; i++)
+    {
+        reference[i] = CM_BoxTrace(rays[i].start, rays[i].end, rays[i].mins, rays[i].maxs,
+                                   map_cmodels[0].headnode, MASK_SOLID);
+    }
+    time_single = Sys_Milliseconds() - time_start;
+
+    time_start = Sys_Milliseconds();
+    CM_BoxTraceBatch(rays, num_rays, map_cmodels[0].headnode, MASK_SOLID, batched);
+    time_batched = Sys_Milliseconds() - time_start;
+
+    mismatches = 0;
+    for (i = 0; i < num_rays; i++)
+    {
+        fractions[i] = reference[i].fraction;
+        if (!CM_BenchSameTrace(&reference[i], &batched[i]))
+            mismatches++;
+    }
+    if (mismatches)
+        Com_Printf("trace_bench: WARNING: %i batched traces differ from the scalar run!\n", mismatches);
+
+    bench.fractions = fractions;
+
+    for (t = 0; t < num_threads; t++)
+        bench.contexts[t] = CM_AllocTraceContext();
+
+    time_start = Sys_Milliseconds();
+    Sys_RunThreads(num_threads, &CM_BenchThread, &bench);
+    time_threaded = Sys_Milliseconds() - time_start;
+
+    mismatches = 0;
+    for (t = 0; t < num_threads; t++)
+    {
+        mismatches += bench.mismatches[t];
+        CM_FreeTraceContext(bench.contexts[t]);
+    }
+
+    Com_Printf("trace_bench: %i traces, 1 thread: %i ms (%.0f traces/s)\n",
+               num_rays, time_single, num_rays * 1000.0 / (time_single > 0 ? time_single : 1));
+    Com_Printf("trace_bench: %i traces, batched: %i ms (%.0f traces/s)\n",
+               num_rays, time_batched, num_rays * 1000.0 / (time_batched > 0 ? time_batched : 1));
+    Com_Printf("trace_bench: %i traces, %i threads: %i ms (%.0f traces/s)\n",
+               num_rays * num_threads, num_threads, time_threaded,
+               num_rays * num_threads * 1000.0 / (time_threaded > 0 ? time_threaded : 1));
+    if (mismatches)
+        Com_Printf("trace_bench: WARNING: %i threaded traces differ from the single threaded run!\n", mismatches);
+
+    Z_Free(batched);
+    Z_Free(reference);
+    Z_Free(fractions);
+    Z_Free(rays);
+}
+
+/*
+==================
+CM_Init
+==================
+*/
+void CM_Init(void)
+{
+    Cmd_AddCommand("trace_bench", CM_TraceBench_f);
+}
+
 /*
 ===============================================================================
 
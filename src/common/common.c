@@ -1484,6 +1484,7 @@ void Qcommon_Init(int argc, char ** argv)
     }
 
     Sys_Init();
+    CM_Init();
     NET_Init();
     Netchan_Init();
     SV_Init();
@@ -1580,12 +1581,16 @@ void Qcommon_Frame(int msec)
     {
         extern int c_traces, c_brush_traces;
         extern int c_pointcontents;
+        extern int c_trace_cache_hits, c_trace_cache_misses;
 
-        Com_Printf("%4i traces  %4i points\n", c_traces, c_pointcontents);
+        Com_Printf("%4i traces  %4i points  %4i cache hits  %4i cache misses\n",
+                   c_traces, c_pointcontents, c_trace_cache_hits, c_trace_cache_misses);
 
         c_traces = 0;
         c_brush_traces = 0;
         c_pointcontents = 0;
+        c_trace_cache_hits = 0;
+        c_trace_cache_misses = 0;
     }
 
     // Consume console input first
@@ -601,6 +601,7 @@ CMODEL
 
 #include "common/q_files.h"
 
+void CM_Init(void);
 cmodel_t * CM_LoadMap(char * name, qboolean clientload, unsigned * checksum);
 cmodel_t * CM_InlineModel(char * name); // *1, *2, etc
 
@@ -624,6 +625,38 @@ trace_t CM_TransformedBoxTrace(vec3_t start, vec3_t end,
                                int headnode, int brushmask,
                                vec3_t origin, vec3_t angles);
 
+// CM_BoxTrace and CM_TransformedBoxTrace share one trace context and are main
+// thread only. Threads tracing at the same time must each use their own context.
+// The CM_HeadnodeForBox hull is shared as well, so only the world and inline
+// model headnodes can be traced from other threads.
+typedef struct cmtrace_context_s cmtrace_context_t;
+
+cmtrace_context_t * CM_AllocTraceContext(void);
+void CM_FreeTraceContext(cmtrace_context_t * ctx);
+
+trace_t CM_BoxTraceContext(cmtrace_context_t * ctx,
+                           vec3_t start, vec3_t end,
+                           vec3_t mins, vec3_t maxs,
+                           int headnode, int brushmask);
+
+trace_t CM_TransformedBoxTraceContext(cmtrace_context_t * ctx,
+                                      vec3_t start, vec3_t end,
+                                      vec3_t mins, vec3_t maxs,
+                                      int headnode, int brushmask,
+                                      vec3_t origin, vec3_t angles);
+
+// Same results as tracing each ray on its own, but sweeps the rays
+// through the tree four at a time with SSE2. All rays share headnode
+// and brushmask.
+void CM_BoxTraceBatch(const traceray_t * rays, int num_rays,
+                      int headnode, int brushmask,
+                      trace_t * results);
+
+void CM_BoxTraceBatchContext(cmtrace_context_t * ctx,
+                             const traceray_t * rays, int num_rays,
+                             int headnode, int brushmask,
+                             trace_t * results);
+
 qbyte * CM_ClusterPVS(int cluster);
 qbyte * CM_ClusterPHS(int cluster);
 
@@ -767,6 +800,11 @@ void Sys_Quit(void);
 
 char * Sys_GetClipboardData(void);
 
+int Sys_NumCPUs(void);
+
+// runs func(param, thread_index) on num_threads threads and waits for all of them
+void Sys_RunThreads(int num_threads, void (*func)(void * param, int thread_index), void * param);
+
 /*
 ==============================================================
 
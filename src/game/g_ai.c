@@ -904,6 +904,9 @@ void ai_run(edict_t * self, float dist)
     vec3_t v_forward, v_right;
     float left, center, right;
     vec3_t left_target, right_target;
+    traceray_t probes[2];
+    trace_t probe_results[2];
+    int i;
 
     // if we're going to a combat point, just proceed
     if (self->monsterinfo.aiflags & AI_COMBAT_POINT)
@@ -1042,13 +1045,21 @@ void ai_run(edict_t * self, float dist)
 
             VectorSet(v, d2, -16, 0);
             G_ProjectSource(self->s.origin, v, v_forward, v_right, left_target);
-            tr = gi.trace(self->s.origin, self->mins, self->maxs, left_target, self, MASK_PLAYERSOLID);
-            left = tr.fraction;
-
             VectorSet(v, d2, 16, 0);
             G_ProjectSource(self->s.origin, v, v_forward, v_right, right_target);
-            tr = gi.trace(self->s.origin, self->mins, self->maxs, right_target, self, MASK_PLAYERSOLID);
-            right = tr.fraction;
+
+            // probe both sides together
+            for (i = 0; i < 2; i++)
+            {
+                VectorCopy(self->s.origin, probes[i].start);
+                VectorCopy(self->mins, probes[i].mins);
+                VectorCopy(self->maxs, probes[i].maxs);
+            }
+            VectorCopy(left_target, probes[0].end);
+            VectorCopy(right_target, probes[1].end);
+            gi.tracebatch(probes, 2, self, MASK_PLAYERSOLID, probe_results);
+            left = probe_results[0].fraction;
+            right = probe_results[1].fraction;
 
             center = (d1 * center) / d2;
             if (left >= center && left > right)
@@ -123,94 +123,102 @@ qboolean fire_hit(edict_t * self, vec3_t aim, int damage, int kick)
 
 /*
 =================
-fire_lead
+fire_lead_aim
 
-This is an internal support routine used for bullet/pellet based weapons.
+Picks the end point of a bullet with a random spread.
 =================
 */
-static void fire_lead(edict_t * self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
+static void fire_lead_aim(vec3_t start, vec3_t aimdir, int hspread, int vspread, vec3_t end)
 {
-    trace_t tr;
     vec3_t dir;
     vec3_t forward, right, up;
-    vec3_t end;
     float r;
     float u;
-    vec3_t water_start;
-    qboolean water = false;
-    int content_mask = MASK_SHOT | MASK_WATER;
 
-    tr = gi.trace(self->s.origin, NULL, NULL, start, self, MASK_SHOT);
-    if (!(tr.fraction < 1.0))
-    {
-        vectoangles(aimdir, dir);
-        AngleVectors(dir, forward, right, up);
+    vectoangles(aimdir, dir);
+    AngleVectors(dir, forward, right, up);
 
-        r = crandom() * hspread;
-        u = crandom() * vspread;
-        VectorMA(start, 8192, forward, end);
-        VectorMA(end, r, right, end);
-        VectorMA(end, u, up, end);
+    r = crandom() * hspread;
+    u = crandom() * vspread;
+    VectorMA(start, 8192, forward, end);
+    VectorMA(end, r, right, end);
+    VectorMA(end, u, up, end);
+}
 
-        if (gi.pointcontents(start) & MASK_WATER)
+/*
+=================
+fire_lead_water
+
+Splashes and re-traces a bullet that hit water on its way from start to end.
+=================
+*/
+static void fire_lead_water(edict_t * self, vec3_t start, vec3_t end, int hspread, int vspread, trace_t * tr, qboolean * water, vec3_t water_start)
+{
+    vec3_t dir;
+    vec3_t forward, right, up;
+    float r;
+    float u;
+    int color;
+
+    // see if we hit water
+    if (!(tr->contents & MASK_WATER))
+        return;
+
+    *water = true;
+    VectorCopy(tr->endpos, water_start);
+
+    if (!VectorCompare(start, tr->endpos))
+    {
+        if (tr->contents & CONTENTS_WATER)
         {
-            water = true;
-            VectorCopy(start, water_start);
-            content_mask &= ~MASK_WATER;
+            if (strcmp(tr->surface->name, "*brwater") == 0)
+                color = SPLASH_BROWN_WATER;
+            else
+                color = SPLASH_BLUE_WATER;
         }
+        else if (tr->contents & CONTENTS_SLIME)
+            color = SPLASH_SLIME;
+        else if (tr->contents & CONTENTS_LAVA)
+            color = SPLASH_LAVA;
+        else
+            color = SPLASH_UNKNOWN;
 
-        tr = gi.trace(start, NULL, NULL, end, self, content_mask);
-
-        // see if we hit water
-        if (tr.contents & MASK_WATER)
+        if (color != SPLASH_UNKNOWN)
         {
-            int color;
+            gi.WriteByte(svc_temp_entity);
+            gi.WriteByte(TE_SPLASH);
+            gi.WriteByte(8);
+            gi.WritePosition(tr->endpos);
+            gi.WriteDir(tr->plane.normal);
+            gi.WriteByte(color);
+            gi.multicast(tr->endpos, MULTICAST_PVS);
+        }
 
-            water = true;
-            VectorCopy(tr.endpos, water_start);
+        // change bullet's course when it enters water
+        VectorSubtract(end, start, dir);
+        vectoangles(dir, dir);
+        AngleVectors(dir, forward, right, up);
+        r = crandom() * hspread * 2;
+        u = crandom() * vspread * 2;
+        VectorMA(water_start, 8192, forward, end);
+        VectorMA(end, r, right, end);
+        VectorMA(end, u, up, end);
+    }
 
-            if (!VectorCompare(start, tr.endpos))
-            {
-                if (tr.contents & CONTENTS_WATER)
-                {
-                    if (strcmp(tr.surface->name, "*brwater") == 0)
-                        color = SPLASH_BROWN_WATER;
-                    else
-                        color = SPLASH_BLUE_WATER;
-                }
-                else if (tr.contents & CONTENTS_SLIME)
-                    color = SPLASH_SLIME;
-                else if (tr.contents & CONTENTS_LAVA)
-                    color = SPLASH_LAVA;
-                else
-                    color = SPLASH_UNKNOWN;
-
-                if (color != SPLASH_UNKNOWN)
-                {
-                    gi.WriteByte(svc_temp_entity);
-                    gi.WriteByte(TE_SPLASH);
-                    gi.WriteByte(8);
-                    gi.WritePosition(tr.endpos);
-                    gi.WriteDir(tr.plane.normal);
-                    gi.WriteByte(color);
-                    gi.multicast(tr.endpos, MULTICAST_PVS);
-                }
+    // re-trace ignoring water this time
+    *tr = gi.trace(water_start, NULL, NULL, end, self, MASK_SHOT);
+}
 
-                // change bullet's course when it enters water
-                VectorSubtract(end, start, dir);
-                vectoangles(dir, dir);
-                AngleVectors(dir, forward, right, up);
-                r = crandom() * hspread * 2;
-                u = crandom() * vspread * 2;
-                VectorMA(water_start, 8192, forward, end);
-                VectorMA(end, r, right, end);
-                VectorMA(end, u, up, end);
-            }
+/*
+=================
+fire_lead_impact
 
-            // re-trace ignoring water this time
-            tr = gi.trace(water_start, NULL, NULL, end, self, MASK_SHOT);
-        }
-    }
+Damage, gun puff and bubble trail of a traced bullet.
+=================
+*/
+static void fire_lead_impact(edict_t * self, vec3_t aimdir, trace_t tr, qboolean water, vec3_t water_start, int damage, int kick, int te_impact, int mod)
+{
+    vec3_t dir;
 
     // send gun puff / flash
     if (!((tr.surface) && (tr.surface->flags & SURF_SKY)))
@@ -262,6 +270,40 @@ static void fire_lead(edict_t * self, vec3_t start, vec3_t aimdir, int damage, i
     }
 }
 
+/*
+=================
+fire_lead
+
+This is an internal support routine used for bullet/pellet based weapons.
+=================
+*/
+static void fire_lead(edict_t * self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
+{
+    trace_t tr;
+    vec3_t end;
+    vec3_t water_start;
+    qboolean water = false;
+    int content_mask = MASK_SHOT | MASK_WATER;
+
+    tr = gi.trace(self->s.origin, NULL, NULL, start, self, MASK_SHOT);
+    if (!(tr.fraction < 1.0))
+    {
+        fire_lead_aim(start, aimdir, hspread, vspread, end);
+
+        if (gi.pointcontents(start) & MASK_WATER)
+        {
+            water = true;
+            VectorCopy(start, water_start);
+            content_mask &= ~MASK_WATER;
+        }
+
+        tr = gi.trace(start, NULL, NULL, end, self, content_mask);
+        fire_lead_water(self, start, end, hspread, vspread, &tr, &water, water_start);
+    }
+
+    fire_lead_impact(self, aimdir, tr, water, water_start, damage, kick, te_impact, mod);
+}
+
 /*
 =================
 fire_bullet
@@ -282,12 +324,98 @@ fire_shotgun
 Shoots shotgun pellets.  Used by shotgun and super shotgun.
 =================
 */
+#define MAX_SHOTGUN_BATCH 32
+
+typedef struct
+{
+    int linkcount;
+    solid_t solid;
+    int takedamage;
+} pellethit_t;
+
+/*
+=================
+pellet_hit_changed
+
+True if an earlier pellet freed, moved, resized or unlinked the entity a
+batched trace hit, or made it non solid or not damageable.  Those pellets
+are traced again so they pass through to whatever is behind, as they did
+when each pellet was traced right before its damage.
+=================
+*/
+static qboolean pellet_hit_changed(const trace_t * tr, const pellethit_t * hit)
+{
+    if (tr->fraction >= 1.0 || !tr->ent)
+        return false;
+
+    return !tr->ent->inuse || tr->ent->linkcount != hit->linkcount ||
+           tr->ent->solid != hit->solid || tr->ent->takedamage != hit->takedamage;
+}
+
 void fire_shotgun(edict_t * self, vec3_t start, vec3_t aimdir, int damage, int kick, int hspread, int vspread, int count, int mod)
 {
-    int i;
+    traceray_t rays[MAX_SHOTGUN_BATCH];
+    trace_t results[MAX_SHOTGUN_BATCH];
+    pellethit_t hits[MAX_SHOTGUN_BATCH];
+    trace_t tr;
+    vec3_t water_start;
+    qboolean start_in_water;
+    qboolean water;
+    int content_mask = MASK_SHOT | MASK_WATER;
+    int i, num;
+
+    // a blocked muzzle keeps the per pellet path, an earlier pellet can kill or
+    // free the blocking entity and let the later ones through
+    tr = gi.trace(self->s.origin, NULL, NULL, start, self, MASK_SHOT);
+    if (tr.fraction < 1.0)
+    {
+        for (i = 0; i < count; i++)
+            fire_lead(self, start, aimdir, damage, kick, TE_SHOTGUN, hspread, vspread, mod);
+        return;
+    }
+
+    start_in_water = (gi.pointcontents(start) & MASK_WATER) != 0;
+    if (start_in_water)
+        content_mask &= ~MASK_WATER;
 
-    for (i = 0; i < count; i++)
-        fire_lead(self, start, aimdir, damage, kick, TE_SHOTGUN, hspread, vspread, mod);
+    // all pellets are traced together before any of them deals damage, so the
+    // spread of the whole batch is drawn from crandom() before the damage code
+    // gets to draw any random numbers of its own
+    for (; count > 0; count -= num)
+    {
+        num = (count < MAX_SHOTGUN_BATCH) ? count : MAX_SHOTGUN_BATCH;
+
+        memset(rays, 0, num * sizeof(traceray_t));
+        for (i = 0; i < num; i++)
+        {
+            VectorCopy(start, rays[i].start);
+            fire_lead_aim(start, aimdir, hspread, vspread, rays[i].end);
+        }
+
+        gi.tracebatch(rays, num, self, content_mask, results);
+
+        for (i = 0; i < num; i++)
+        {
+            if (results[i].ent)
+            {
+                hits[i].linkcount = results[i].ent->linkcount;
+                hits[i].solid = results[i].ent->solid;
+                hits[i].takedamage = results[i].ent->takedamage;
+            }
+        }
+
+        for (i = 0; i < num; i++)
+        {
+            if (pellet_hit_changed(&results[i], &hits[i]))
+                results[i] = gi.trace(start, NULL, NULL, rays[i].end, self, content_mask);
+
+            water = start_in_water;
+            VectorCopy(start, water_start);
+
+            fire_lead_water(self, start, rays[i].end, hspread, vspread, &results[i], &water, water_start);
+            fire_lead_impact(self, aimdir, results[i], water, water_start, damage, kick, TE_SHOTGUN, mod);
+        }
+    }
 }
 
 /*
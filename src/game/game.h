@@ -196,6 +196,10 @@ typedef struct
     void (*AddCommandString)(const char * text);
 
     void (*DebugGraph)(float value, int color);
+
+    // same as calling trace() on each ray, but the rays are clipped to the world
+    // together. Added at the end to keep the layout of the older entries.
+    void (*tracebatch)(const traceray_t * rays, int num_rays, edict_t * passent, int contentmask, trace_t * results);
 } game_import_t;
 
 //
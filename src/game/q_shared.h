@@ -449,6 +449,15 @@ typedef struct
     struct edict_s * ent; // not set by CM_*() functions
 } trace_t;
 
+// one ray or swept box of a batched trace
+typedef struct
+{
+    vec3_t start;
+    vec3_t mins;
+    vec3_t maxs;
+    vec3_t end;
+} traceray_t;
+
 // pmove_state_t is the information necessary for client side movement
 // prediction
 typedef enum
@@ -1170,6 +1179,7 @@ typedef enum
     VIDREF_D3D11,
     VIDREF_D3D12,
     VIDREF_VULKAN,
+    VIDREF_NULL,
 } vidref_type_t;
 
 extern vidref_type_t vidref_val;
@@ -78,6 +78,18 @@ void Sys_AppActivate(void)
 {
 }
 
+int Sys_NumCPUs(void)
+{
+    return 1;
+}
+
+void Sys_RunThreads(int num_threads, void (*func)(void * param, int thread_index), void * param)
+{
+    int i;
+    for (i = 0; i < num_threads; i++)
+        func(param, i);
+}
+
 void Sys_CopyProtect(void)
 {
 }
@@ -175,12 +175,12 @@ class FixedSizeArray final : public ArrayBase<T>
 public:
 
     using Base = ArrayBase<T>;
-    using Base::const_pointer;
-    using Base::const_reference;
-    using Base::pointer;
-    using Base::reference;
-    using Base::size_type;
-    using Base::value_type;
+    using typename Base::const_pointer;
+    using typename Base::const_reference;
+    using typename Base::pointer;
+    using typename Base::reference;
+    using typename Base::size_type;
+    using typename Base::value_type;
 
     FixedSizeArray()
         : Base{ m_array, 0u, kCapacity }
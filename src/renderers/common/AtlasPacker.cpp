@@ -0,0 +1,275 @@
+//
+// AtlasPacker.cpp
+//  Skyline rectangle packer shared by the lightmap and scrap texture atlases.
+//
+
+#include "AtlasPacker.hpp"
+#include <climits>
+
+namespace MrQ2
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// AtlasPacker
+///////////////////////////////////////////////////////////////////////////////
+
+void AtlasPacker::Reset(const int width, const int height, const Heuristic heuristic)
+{
+    MRQ2_ASSERT(width > 0 && width <= kMaxSize);
+    MRQ2_ASSERT(height > 0 && height <= kMaxSize);
+
+    m_width      = width;
+    m_height     = height;
+    m_heuristic  = heuristic;
+    m_num_allocs = 0;
+    m_used_area  = 0;
+    m_num_free_rects = 0;
+
+    // Start with a single flat level at the bottom.
+    m_nodes[0]  = { 0, 0, width };
+    m_num_nodes = 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+AtlasPacker::Heuristic AtlasPacker::DefaultHeuristic()
+{
+    return Config::r_atlas_packer.AsInt() == 0 ? Heuristic::kBottomLeft : Heuristic::kBestFit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AtlasPacker::Alloc(const int w, const int h, int * out_x, int * out_y)
+{
+    MRQ2_ASSERT(m_num_nodes > 0); // Reset first!
+    MRQ2_ASSERT(w > 0 && h > 0);
+    MRQ2_ASSERT(out_x != nullptr && out_y != nullptr);
+
+    if (m_heuristic == Heuristic::kBestFit && AllocFromFreeRects(w, h, out_x, out_y))
+    {
+        ++m_num_allocs;
+        m_used_area += w * h;
+        return true;
+    }
+
+    int best_node  = -1;
+    int best_top   = INT_MAX;
+    int best_waste = INT_MAX;
+
+    for (int n = 0; n < m_num_nodes; ++n)
+    {
+        int y, waste;
+        if (!Fit(n, w, h, &y, &waste))
+        {
+            continue;
+        }
+
+        bool better;
+        if (m_heuristic == Heuristic::kBestFit)
+        {
+            better = ((y + h) < best_top) || ((y + h) == best_top && waste < best_waste);
+        }
+        else
+        {
+            better = (y + h) < best_top; // Ties keep the leftmost spot.
+        }
+
+        if (better)
+        {
+            best_node  = n;
+            best_top   = y + h;
+            best_waste = waste;
+        }
+    }
+
+    if (best_node < 0)
+    {
+        return false;
+    }
+
+    *out_x = m_nodes[best_node].x;
+    *out_y = best_top - h;
+
+    AddSkylineLevel(best_node, *out_x, *out_y, w, h);
+
+    ++m_num_allocs;
+    m_used_area += w * h;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AtlasPacker::Fit(const int node_index, const int w, const int h, int * out_y, int * out_waste) const
+{
+    const int x = m_nodes[node_index].x;
+    if ((x + w) > m_width)
+    {
+        return false;
+    }
+
+    // The rectangle rests on the highest level it spans.
+    int y = 0;
+    int width_left = w;
+    for (int n = node_index; width_left > 0; ++n)
+    {
+        MRQ2_ASSERT(n < m_num_nodes);
+        y = std::max(y, m_nodes[n].y);
+        if ((y + h) > m_height)
+        {
+            return false;
+        }
+        width_left -= m_nodes[n].width;
+    }
+
+    // Area left unusable between the rectangle's bottom and the levels under it.
+    int waste = 0;
+    width_left = w;
+    for (int n = node_index; width_left > 0; ++n)
+    {
+        const int span = std::min(width_left, m_nodes[n].width);
+        waste += (y - m_nodes[n].y) * span;
+        width_left -= span;
+    }
+
+    *out_y = y;
+    *out_waste = waste;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AtlasPacker::AddSkylineLevel(const int node_index, const int x, const int y, const int w, const int h)
+{
+    MRQ2_ASSERT(m_num_nodes < int(ArrayLength(m_nodes)));
+
+    // Remember the gaps between the rectangle and the levels it covers.
+    if (m_heuristic == Heuristic::kBestFit)
+    {
+        for (int n = node_index; n < m_num_nodes && m_nodes[n].x < (x + w); ++n)
+        {
+            const SkylineNode & node = m_nodes[n];
+            if (node.y < y)
+            {
+                const int left  = std::max(node.x, x);
+                const int right = std::min(node.x + node.width, x + w);
+                AddFreeRect(left, node.y, right - left, y - node.y);
+            }
+        }
+    }
+
+    // Insert the new level on top of the rectangle.
+    for (int n = m_num_nodes; n > node_index; --n)
+    {
+        m_nodes[n] = m_nodes[n - 1];
+    }
+    m_nodes[node_index] = { x, y + h, w };
+    ++m_num_nodes;
+
+    // Shrink or remove the levels now covered by it.
+    for (int n = node_index + 1; n < m_num_nodes; )
+    {
+        const SkylineNode & prev = m_nodes[n - 1];
+        SkylineNode & node = m_nodes[n];
+
+        const int prev_right = prev.x + prev.width;
+        if (node.x >= prev_right)
+        {
+            break;
+        }
+
+        const int shrink = prev_right - node.x;
+        if (node.width > shrink)
+        {
+            node.x += shrink;
+            node.width -= shrink;
+            break;
+        }
+
+        for (int m = n; m < m_num_nodes - 1; ++m)
+        {
+            m_nodes[m] = m_nodes[m + 1];
+        }
+        --m_num_nodes;
+    }
+
+    // Merge neighboring levels of the same height.
+    for (int n = 0; n < m_num_nodes - 1; )
+    {
+        if (m_nodes[n].y == m_nodes[n + 1].y)
+        {
+            m_nodes[n].width += m_nodes[n + 1].width;
+            for (int m = n + 1; m < m_num_nodes - 1; ++m)
+            {
+                m_nodes[m] = m_nodes[m + 1];
+            }
+            --m_num_nodes;
+        }
+        else
+        {
+            ++n;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AtlasPacker::AllocFromFreeRects(const int w, const int h, int * out_x, int * out_y)
+{
+    // Best area fit.
+    int best_rect = -1;
+    int best_area = INT_MAX;
+    for (int r = 0; r < m_num_free_rects; ++r)
+    {
+        const FreeRect & rect = m_free_rects[r];
+        if (w <= rect.width && h <= rect.height)
+        {
+            const int area = rect.width * rect.height;
+            if (area < best_area)
+            {
+                best_rect = r;
+                best_area = area;
+            }
+        }
+    }
+
+    if (best_rect < 0)
+    {
+        return false;
+    }
+
+    const FreeRect rect = m_free_rects[best_rect];
+    m_free_rects[best_rect] = m_free_rects[--m_num_free_rects];
+
+    *out_x = rect.x;
+    *out_y = rect.y;
+
+    // Split the remaining L-shaped area along the shorter leftover axis.
+    const int leftover_w = rect.width  - w;
+    const int leftover_h = rect.height - h;
+    if (leftover_w <= leftover_h)
+    {
+        AddFreeRect(rect.x + w, rect.y, leftover_w, h);
+        AddFreeRect(rect.x, rect.y + h, rect.width, leftover_h);
+    }
+    else
+    {
+        AddFreeRect(rect.x + w, rect.y, leftover_w, rect.height);
+        AddFreeRect(rect.x, rect.y + h, w, leftover_h);
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AtlasPacker::AddFreeRect(const int x, const int y, const int w, const int h)
+{
+    if (w > 0 && h > 0 && m_num_free_rects < kMaxFreeRects)
+    {
+        m_free_rects[m_num_free_rects++] = { x, y, w, h };
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // MrQ2
@@ -0,0 +1,100 @@
+//
+// AtlasPacker.hpp
+//  Skyline rectangle packer shared by the lightmap and scrap texture atlases.
+//
+//  The page is described by its skyline, the top edge of the packed area.
+//  Rectangles are placed on top of the skyline; with kBestFit, the gaps left
+//  under a rectangle that rests on uneven levels are remembered and filled
+//  first by later allocations, guillotine style.
+//
+#pragma once
+
+#include "Common.hpp"
+
+namespace MrQ2
+{
+
+/*
+===============================================================================
+
+    AtlasPacker
+
+===============================================================================
+*/
+class AtlasPacker final
+{
+public:
+
+    // Largest page width/height supported.
+    static constexpr int kMaxSize = 2048;
+
+    // Gaps under the skyline that are tracked for reuse. Extra ones are just lost.
+    static constexpr int kMaxFreeRects = 1024;
+
+    enum class Heuristic : std::uint8_t
+    {
+        kBottomLeft, // Lowest top edge first; same placement as the classic Quake allocated[] scheme.
+        kBestFit,    // Fill gaps under the skyline first (best area fit), then lowest top edge with least waste.
+    };
+
+    AtlasPacker() = default;
+
+    // Disallow copy.
+    AtlasPacker(const AtlasPacker &) = delete;
+    AtlasPacker & operator=(const AtlasPacker &) = delete;
+
+    // Empties the atlas and sets the page size for the following allocations.
+    void Reset(int width, int height, Heuristic heuristic);
+
+    // Finds room for a w*h rectangle. Returns false if the page is full.
+    bool Alloc(int w, int h, int * out_x, int * out_y);
+
+    int Width()  const { return m_width;  }
+    int Height() const { return m_height; }
+
+    // Occupancy stats
+    int NumAllocs()   const { return m_num_allocs; }
+    int UsedArea()    const { return m_used_area;  }
+    float Occupancy() const { return (m_width > 0) ? float(m_used_area) / float(m_width * m_height) : 0.0f; }
+
+    // Heuristic selected by the r_atlas_packer cvar.
+    static Heuristic DefaultHeuristic();
+
+private:
+
+    // Top edge of the packed area over [x, x + width).
+    struct SkylineNode
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct FreeRect
+    {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    bool Fit(int node_index, int w, int h, int * out_y, int * out_waste) const;
+    void AddSkylineLevel(int node_index, int x, int y, int w, int h);
+    bool AllocFromFreeRects(int w, int h, int * out_x, int * out_y);
+    void AddFreeRect(int x, int y, int w, int h);
+
+    SkylineNode m_nodes[kMaxSize + 1];
+    int m_num_nodes{ 0 };
+
+    FreeRect m_free_rects[kMaxFreeRects];
+    int m_num_free_rects{ 0 };
+
+    int m_width{ 0 };
+    int m_height{ 0 };
+    Heuristic m_heuristic{ Heuristic::kBestFit };
+
+    int m_num_allocs{ 0 };
+    int m_used_area{ 0 };
+};
+
+} // MrQ2
@@ -4,11 +4,14 @@
 //
 
 #include "Common.hpp"
-#include "Win32Window.hpp"
+#if defined(_WIN32)
+    #include "Win32Window.hpp"
+#endif // _WIN32
 #include "Memory.hpp"
 
 #include <cstdarg>
 #include <cstdio>
+#include <chrono>
 
 // Quake includes
 #include "common/q_common.h"
@@ -21,12 +24,11 @@ namespace MrQ2
 // Utility functions
 ///////////////////////////////////////////////////////////////////////////////
 
-std::uint64_t FnvHash64(const std::uint8_t * const bytes, const std::size_t len)
+std::uint64_t FnvHash64(const std::uint8_t * const bytes, const std::size_t len, const std::uint64_t seed)
 {
-    constexpr std::uint64_t FNV_offset_basis = 14695981039346656037;
     constexpr std::uint64_t FNV_prime = 1099511628211;
 
-    std::uint64_t hash = FNV_offset_basis;
+    std::uint64_t hash = seed;
     for (std::size_t i = 0; i < len; ++i)
     {
         hash *= FNV_prime;
@@ -53,6 +55,14 @@ std::uint32_t FnvHash32(const std::uint8_t * const bytes, const std::size_t len)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+std::uint64_t HighResTimeMicroseconds()
+{
+    using namespace std::chrono;
+    return static_cast<std::uint64_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void VectorsFromAngles(const vec3_t angles, vec3_t forward, vec3_t right, vec3_t up)
 {
     float angle;
@@ -479,8 +489,8 @@ RenderMatrix RenderMatrix::RotationZ(const float angle_radians)
 
 RenderMatrix RenderMatrix::RotationAxis(const float angle_radians, const float x, const float y, const float z)
 {
-    const float s = std::sinf(angle_radians);
-    const float c = std::cosf(angle_radians);
+    const float s = std::sin(angle_radians);
+    const float c = std::cos(angle_radians);
 
     const float xy = x * y;
     const float yz = y * z;
@@ -687,7 +697,9 @@ void Errorf(const char * fmt, ...)
 
     g_refimport.Con_Printf(PRINT_ALL, "[%s] FATAL ERROR: %s\n", g_refname, msg);
 
+#if defined(_WIN32)
     MessageBox(nullptr, msg, "Fatal Error", MB_OK | MB_ICONERROR);
+#endif // _WIN32
     std::abort();
 }
 
@@ -1000,9 +1012,11 @@ CvarWrapper r_lightlevel;
 CvarWrapper r_hd_particles; 
 CvarWrapper r_hd_textures; // Wall textures
 CvarWrapper r_hd_skins;    // MD2 skins
+CvarWrapper r_worker_threads;
 
 // ViewRenderer configs
 CvarWrapper r_use_vertex_index_buffers;
+CvarWrapper r_world_merged_indexes;
 CvarWrapper r_force_null_entity_models;
 CvarWrapper r_lerp_entity_models;
 CvarWrapper r_skip_draw_alpha_surfs;
@@ -1016,7 +1030,20 @@ CvarWrapper r_water_hack;
 CvarWrapper r_draw_model_bounds; // MD2 and Brush models
 CvarWrapper r_draw_world_bounds; // World geometry
 CvarWrapper r_dynamic_lightmaps;
+CvarWrapper r_lightmap_simd;
+CvarWrapper r_atlas_packer;
+CvarWrapper r_lightmap_page_size;
+CvarWrapper r_async_texture_loads;
+CvarWrapper r_mipmap_filter;
+CvarWrapper r_texture_cache;
+CvarWrapper r_hd_texture_compression; // BC1/BC3 encode large HD replacement textures
+CvarWrapper r_texture_budget_mb;      // Evict least recently drawn textures above this (0 = no limit)
 CvarWrapper r_alias_shadows;
+CvarWrapper r_pvs_cache_size;
+CvarWrapper r_world_parallel;
+CvarWrapper r_entities_parallel;  // Cull, shade and lerp the alias models on the JobSystem
+CvarWrapper r_light_cache;        // Reuse the lightmap samples of alias models that stay in the same spot
+CvarWrapper r_instanced_entities; // Merge repeated alias models and back to back sprites into shared draws
 
 void Initialize()
 {
@@ -1050,8 +1077,10 @@ void Initialize()
     r_hd_particles = GameInterface::Cvar::Get("r_hd_particles", "1", CvarWrapper::kFlagArchive);
     r_hd_textures = GameInterface::Cvar::Get("r_hd_textures", "1", CvarWrapper::kFlagArchive);
     r_hd_skins = GameInterface::Cvar::Get("r_hd_skins", "1", CvarWrapper::kFlagArchive);
+    r_worker_threads = GameInterface::Cvar::Get("r_worker_threads", "-1", CvarWrapper::kFlagArchive);
 
     r_use_vertex_index_buffers = GameInterface::Cvar::Get("r_use_vertex_index_buffers", "1", CvarWrapper::kFlagArchive);
+    r_world_merged_indexes = GameInterface::Cvar::Get("r_world_merged_indexes", "1", CvarWrapper::kFlagArchive);
     r_force_null_entity_models = GameInterface::Cvar::Get("r_force_null_entity_models", "0", 0);
     r_lerp_entity_models = GameInterface::Cvar::Get("r_lerp_entity_models", "1", 0);
     r_skip_draw_alpha_surfs = GameInterface::Cvar::Get("r_skip_draw_alpha_surfs", "0", 0);
@@ -1065,7 +1094,20 @@ void Initialize()
     r_draw_model_bounds = GameInterface::Cvar::Get("r_draw_model_bounds", "0", 0);
     r_draw_world_bounds = GameInterface::Cvar::Get("r_draw_world_bounds", "0", 0);
     r_dynamic_lightmaps = GameInterface::Cvar::Get("r_dynamic_lightmaps", "1", CvarWrapper::kFlagArchive);
+    r_lightmap_simd = GameInterface::Cvar::Get("r_lightmap_simd", "1", CvarWrapper::kFlagArchive);
+    r_atlas_packer = GameInterface::Cvar::Get("r_atlas_packer", "1", CvarWrapper::kFlagArchive);
+    r_lightmap_page_size = GameInterface::Cvar::Get("r_lightmap_page_size", "0", CvarWrapper::kFlagArchive);
+    r_async_texture_loads = GameInterface::Cvar::Get("r_async_texture_loads", "1", CvarWrapper::kFlagArchive);
+    r_mipmap_filter = GameInterface::Cvar::Get("r_mipmap_filter", "1", CvarWrapper::kFlagArchive);
+    r_texture_cache = GameInterface::Cvar::Get("r_texture_cache", "0", CvarWrapper::kFlagArchive);
+    r_hd_texture_compression = GameInterface::Cvar::Get("r_hd_texture_compression", "0", CvarWrapper::kFlagArchive);
+    r_texture_budget_mb = GameInterface::Cvar::Get("r_texture_budget_mb", "0", CvarWrapper::kFlagArchive);
     r_alias_shadows = GameInterface::Cvar::Get("r_alias_shadows", "1", CvarWrapper::kFlagArchive);
+    r_pvs_cache_size = GameInterface::Cvar::Get("r_pvs_cache_size", "64", CvarWrapper::kFlagArchive);
+    r_world_parallel = GameInterface::Cvar::Get("r_world_parallel", "1", CvarWrapper::kFlagArchive);
+    r_entities_parallel = GameInterface::Cvar::Get("r_entities_parallel", "1", CvarWrapper::kFlagArchive);
+    r_light_cache = GameInterface::Cvar::Get("r_light_cache", "1", CvarWrapper::kFlagArchive);
+    r_instanced_entities = GameInterface::Cvar::Get("r_instanced_entities", "1", CvarWrapper::kFlagArchive);
 }
 
 } // Config
@@ -7,7 +7,15 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
-#include <intrin.h>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#else // !_MSC_VER
+    #include <cstdarg>
+    #include <cstdio>
+    #include <cerrno>
+    #include <csignal>
+#endif // _MSC_VER
 
 /*
 ===============================================================================
@@ -37,14 +45,21 @@ using vec4_t = float[4];
 ===============================================================================
 */
 
-// For marking GetRefAPI in each DLL.
-#define MRQ2_RENDERLIB_DLL_EXPORT __declspec(dllexport)
+#if defined(_MSC_VER)
+    // For marking GetRefAPI in each DLL.
+    #define MRQ2_RENDERLIB_DLL_EXPORT __declspec(dllexport)
 
-// For Errorf() which always aborts.
-#define MRQ2_RENDERLIB_NORETURN __declspec(noreturn)
+    // For Errorf() which always aborts.
+    #define MRQ2_RENDERLIB_NORETURN __declspec(noreturn)
 
-// Prevents an otherwise inlineable function from being inlined.
-#define MRQ2_RENDERLIB_NOINLINE __declspec(noinline)
+    // Prevents an otherwise inlineable function from being inlined.
+    #define MRQ2_RENDERLIB_NOINLINE __declspec(noinline)
+#else // GCC/Clang, for the headless null renderer builds
+    #define MRQ2_RENDERLIB_DLL_EXPORT __attribute__((visibility("default")))
+    #define MRQ2_RENDERLIB_NORETURN   __attribute__((noreturn))
+    #define MRQ2_RENDERLIB_NOINLINE   __attribute__((noinline))
+    #define __debugbreak()            std::raise(SIGTRAP)
+#endif // _MSC_VER
 
 // Debug-only assert that triggers an immediate debug break.
 // Also generates less code (no function calls emitted).
@@ -62,6 +77,61 @@ using vec4_t = float[4];
 #define MRQ2_CAT_TOKEN_IMPL(a, b)  a ## b
 #define MRQ2_CAT_TOKEN(a, b)       MRQ2_CAT_TOKEN_IMPL(a, b)
 
+/*
+===============================================================================
+
+    MSVC CRT & intrinsics shims
+
+    Only used by the GCC/Clang builds of the null renderer (see the
+    top-level CMakeLists.txt). Match the subset of the Microsoft
+    secure CRT and intrinsics the common code relies on.
+
+===============================================================================
+*/
+
+#if !defined(_MSC_VER)
+
+template<std::size_t kSize>
+inline int strcpy_s(char (&dest)[kSize], const char * const src)
+{
+    const std::size_t len = std::strlen(src);
+    if (len >= kSize)
+    {
+        dest[0] = '\0';
+        return ERANGE;
+    }
+    std::memcpy(dest, src, len + 1);
+    return 0;
+}
+
+template<std::size_t kSize>
+inline int sprintf_s(char (&dest)[kSize], const char * const fmt, ...)
+{
+    va_list argptr;
+    va_start(argptr, fmt);
+    const int result = std::vsnprintf(dest, kSize, fmt, argptr);
+    va_end(argptr);
+    return result;
+}
+
+inline int fopen_s(FILE ** out_file, const char * const filename, const char * const mode)
+{
+    *out_file = std::fopen(filename, mode);
+    return (*out_file != nullptr) ? 0 : errno;
+}
+
+inline unsigned char _BitScanForward(unsigned long * out_index, const unsigned long mask)
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *out_index = static_cast<unsigned long>(__builtin_ctzl(mask));
+    return 1;
+}
+
+#endif // !_MSC_VER
+
 namespace MrQ2
 {
 
@@ -73,9 +143,14 @@ namespace MrQ2
 ===============================================================================
 */
 
-std::uint64_t FnvHash64(const std::uint8_t * bytes, std::size_t len);
+// Pass the hash of a previous block as seed to continue hashing over several blocks.
+constexpr std::uint64_t kFnvHash64Seed = 14695981039346656037ull;
+std::uint64_t FnvHash64(const std::uint8_t * bytes, std::size_t len, std::uint64_t seed = kFnvHash64Seed);
 std::uint32_t FnvHash32(const std::uint8_t * bytes, std::size_t len);
 
+// High resolution monotonic clock for CPU timings (not tied to the game's Sys_Milliseconds).
+std::uint64_t HighResTimeMicroseconds();
+
 using Color8      = std::uint8_t;
 using ColorRGBA32 = std::uint32_t;
 using Bool32      = std::uint32_t;
@@ -612,9 +687,11 @@ namespace Config
     extern CvarWrapper r_hd_particles;
     extern CvarWrapper r_hd_textures;
     extern CvarWrapper r_hd_skins;
+    extern CvarWrapper r_worker_threads;
 
     // ViewRenderer configs
     extern CvarWrapper r_use_vertex_index_buffers;
+    extern CvarWrapper r_world_merged_indexes;
     extern CvarWrapper r_force_null_entity_models;
     extern CvarWrapper r_lerp_entity_models;
     extern CvarWrapper r_skip_draw_alpha_surfs;
@@ -628,7 +705,20 @@ namespace Config
     extern CvarWrapper r_draw_model_bounds;
     extern CvarWrapper r_draw_world_bounds;
     extern CvarWrapper r_dynamic_lightmaps;
+    extern CvarWrapper r_lightmap_simd;
+    extern CvarWrapper r_atlas_packer;
+    extern CvarWrapper r_lightmap_page_size;
+    extern CvarWrapper r_async_texture_loads;
+    extern CvarWrapper r_mipmap_filter;
+    extern CvarWrapper r_texture_cache;
+    extern CvarWrapper r_hd_texture_compression;
+    extern CvarWrapper r_texture_budget_mb;
     extern CvarWrapper r_alias_shadows;
+    extern CvarWrapper r_pvs_cache_size;
+    extern CvarWrapper r_world_parallel;
+    extern CvarWrapper r_entities_parallel;
+    extern CvarWrapper r_light_cache;
+    extern CvarWrapper r_instanced_entities;
 
     // Cache all the CVars above.
     void Initialize();
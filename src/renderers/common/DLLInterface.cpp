@@ -6,6 +6,7 @@
 #include "RenderDocUtils.hpp"
 #include "DebugDraw.hpp"
 #include "Lightmaps.hpp"
+#include "JobSystem.hpp"
 #include "OptickProfiler.hpp"
 
 namespace MrQ2
@@ -21,6 +22,11 @@ TextureStore    DLLInterface::sm_texture_store;
 ModelStore      DLLInterface::sm_model_store;
 ViewRenderer    DLLInterface::sm_view_renderer;
 
+ViewCaptureWriter DLLInterface::sm_view_capture;
+
+std::uint64_t DLLInterface::sm_registration_start_us{ 0 };
+double        DLLInterface::sm_last_level_load_ms{ 0.0 };
+
 // Constant buffers:
 ConstBuffers<DLLInterface::PerFrameShaderConstants> DLLInterface::sm_per_frame_shader_consts;
 ConstBuffers<DLLInterface::PerViewShaderConstants>  DLLInterface::sm_per_view_shader_consts;
@@ -49,6 +55,9 @@ int DLLInterface::Init(void * hInst, void * wndProc, int fullscreen)
     // 2D sprite/UI batch setup
     sm_sprite_batches.Init(sm_renderer.Device());
 
+    // Worker threads used by the stores/view:
+    JobSystem::Init(Config::r_worker_threads.AsInt());
+
     // Stores/view:
     sm_texture_store.Init(sm_renderer.Device());
     sm_model_store.Init(sm_texture_store);
@@ -65,6 +74,15 @@ int DLLInterface::Init(void * hInst, void * wndProc, int fullscreen)
 
     GameInterface::Cmd::RegisterCommand("set_tex_filer", &ChangeTextureFilterCmd);
     GameInterface::Cmd::RegisterCommand("dump_textures", &DumpAllTexturesCmd);
+    GameInterface::Cmd::RegisterCommand("view_capture", &ViewCaptureCmd);
+    GameInterface::Cmd::RegisterCommand("view_replay", &ViewReplayCmd);
+    GameInterface::Cmd::RegisterCommand("lightmap_bench", &LightmapBenchCmd);
+    GameInterface::Cmd::RegisterCommand("atlas_stats", &AtlasStatsCmd);
+    GameInterface::Cmd::RegisterCommand("find_bench", &FindBenchCmd);
+    GameInterface::Cmd::RegisterCommand("mipmap_bench", &MipMapBenchCmd);
+    GameInterface::Cmd::RegisterCommand("texcache_stats", &TextureCacheStatsCmd);
+    GameInterface::Cmd::RegisterCommand("texbudget_stats", &TextureBudgetStatsCmd);
+    GameInterface::Cmd::RegisterCommand("alias_bench", &AliasBenchCmd);
 
     return true;
 }
@@ -73,6 +91,17 @@ void DLLInterface::Shutdown()
 {
     GameInterface::Cmd::RemoveCommand("set_tex_filer");
     GameInterface::Cmd::RemoveCommand("dump_textures");
+    GameInterface::Cmd::RemoveCommand("view_capture");
+    GameInterface::Cmd::RemoveCommand("view_replay");
+    GameInterface::Cmd::RemoveCommand("lightmap_bench");
+    GameInterface::Cmd::RemoveCommand("atlas_stats");
+    GameInterface::Cmd::RemoveCommand("find_bench");
+    GameInterface::Cmd::RemoveCommand("mipmap_bench");
+    GameInterface::Cmd::RemoveCommand("texcache_stats");
+    GameInterface::Cmd::RemoveCommand("texbudget_stats");
+    GameInterface::Cmd::RemoveCommand("alias_bench");
+
+    sm_view_capture.Close();
 
     sm_renderer.WaitForGpu();
     DebugDraw::Shutdown();
@@ -81,6 +110,7 @@ void DLLInterface::Shutdown()
     sm_view_renderer.Shutdown();
     sm_model_store.Shutdown();
     sm_texture_store.Shutdown();
+    JobSystem::Shutdown();
     sm_sprite_batches.Shutdown();
     sm_renderer.Shutdown();
 
@@ -92,6 +122,8 @@ void DLLInterface::BeginRegistration(const char * const map_name)
 {
     GameInterface::Printf("**** DLLInterface::BeginRegistration ****");
 
+    sm_registration_start_us = HighResTimeMicroseconds();
+
     sm_view_renderer.BeginRegistration();
     sm_texture_store.BeginRegistration(map_name);
     sm_model_store.BeginRegistration(map_name);
@@ -107,6 +139,11 @@ void DLLInterface::EndRegistration()
     sm_texture_store.EndRegistration();
     sm_view_renderer.EndRegistration();
 
+    sm_last_level_load_ms = double(HighResTimeMicroseconds() - sm_registration_start_us) / 1000.0;
+    GameInterface::Printf("Level load took %.2f ms (%i textures queued: %.2f ms decoding, %.2f ms creating).",
+                          sm_last_level_load_ms, sm_texture_store.QueuedLoadCount(),
+                          sm_texture_store.QueuedDecodeMs(), sm_texture_store.QueuedUploadMs());
+
     MemTagsPrintAll();
 }
 
@@ -177,6 +214,9 @@ void DLLInterface::BeginFrame(float /*camera_separation*/)
         sm_texture_store.UploadScrapIfNeeded();
     }
 
+    // Reload textures drawn while evicted and evict down to r_texture_budget_mb.
+    sm_texture_store.UpdateResidency();
+
     sm_per_frame_shader_consts.data.screen_dimensions[0] = static_cast<float>(sm_renderer.RenderWidth());
     sm_per_frame_shader_consts.data.screen_dimensions[1] = static_cast<float>(sm_renderer.RenderHeight());
 
@@ -260,13 +300,24 @@ void DLLInterface::RenderView(refdef_t * const view_def)
         return;
 
     MRQ2_ASSERT(view_def != nullptr);
+
+    if (sm_view_capture.IsOpen())
+    {
+        sm_view_capture.WriteFrame(*view_def);
+    }
+
+    RenderViewImpl(*view_def, nullptr);
+}
+
+void DLLInterface::RenderViewImpl(const refdef_t & view_def, ViewRenderer::StageTimes * stage_times)
+{
     MRQ2_ASSERT(sm_renderer.IsFrameStarted());
 
     auto & context = sm_renderer.Device().GraphicsContext();
     MRQ2_SCOPED_GPU_MARKER(context, "RenderView");
 
     // A world map should have been loaded already by BeginRegistration().
-    if (sm_model_store.WorldModel() == nullptr && !(view_def->rdflags & RDF_NOWORLDMODEL))
+    if (sm_model_store.WorldModel() == nullptr && !(view_def.rdflags & RDF_NOWORLDMODEL))
     {
         GameInterface::Errorf("RenderView: Null world model!");
     }
@@ -277,7 +328,8 @@ void DLLInterface::RenderView(refdef_t * const view_def)
     cbuffers.push_back(&sm_per_frame_shader_consts.CurrentBuffer()); // slot(0)
     cbuffers.push_back(&sm_per_view_shader_consts.CurrentBuffer());  // slot(1)
 
-    ViewRenderer::FrameData frame_data{ sm_texture_store, *sm_model_store.WorldModel(), *view_def, context, cbuffers };
+    ViewRenderer::FrameData frame_data{ sm_texture_store, *sm_model_store.WorldModel(), view_def, context, cbuffers };
+    frame_data.stage_times = stage_times;
 
     // Set up camera/view (fills frame_data)
     sm_view_renderer.RenderViewSetup(frame_data);
@@ -305,16 +357,40 @@ void DLLInterface::RenderView(refdef_t * const view_def)
 
         sprintf_s(text, "World culled: %d", frame_data.world_nodes_culled);
         DrawAltString(10, 40, text);
+
+        sprintf_s(text, "World draws: %d (surfaces: %d)", frame_data.world_draw_calls, frame_data.world_surfaces_drawn);
+        DrawAltString(10, 70, text);
+
+        const ClusterPVSCache & pvs_cache = sm_view_renderer.PVSCache();
+        sprintf_s(text, "PVS cache: h:%d, m:%d, n:%d/%d, leafs:%d", pvs_cache.Hits(), pvs_cache.Misses(),
+                  pvs_cache.NumEntries(), pvs_cache.Capacity(), sm_view_renderer.LeafsMarked());
+        DrawAltString(10, 60, text);
+
+        sprintf_s(text, "Lightstyles changed: %d (surfaces: %d)", sm_view_renderer.LightstylesChanged(),
+                  sm_view_renderer.LightstyleSurfacesUpdated());
+        DrawAltString(10, 80, text);
+
+        const PointLightCache & light_cache = sm_view_renderer.LightCache();
+        const int light_lookups = frame_data.light_cache_hits + frame_data.light_cache_misses;
+        sprintf_s(text, "Light cache: h:%d, m:%d (%.0f%%), n:%d/%d", frame_data.light_cache_hits, frame_data.light_cache_misses,
+                  (light_lookups > 0) ? 100.0 * frame_data.light_cache_hits / light_lookups : 0.0,
+                  light_cache.NumEntries(), light_cache.Capacity());
+        DrawAltString(10, 90, text);
+
+        sprintf_s(text, "Draw cmds: %d (merged: %d, alias instances: %d)", sm_view_renderer.DrawCmdsSubmitted(),
+                  sm_view_renderer.DrawCmdsMerged(), frame_data.alias_instances_merged);
+        DrawAltString(10, 100, text);
     }
 
     // Debug visualization of the lightmap textures
     if (Config::r_show_lightmap_textures.IsSet())
     {
         char text[128];
-        sprintf_s(text, "LM updates: d:%d, s:%d, blk:%d",
+        sprintf_s(text, "LM updates: d:%d, s:%d, blk:%d, up:%.1fKB",
                   LightmapManager::sm_dynamic_lightmap_updates,
                   LightmapManager::sm_static_lightmap_updates,
-                  LightmapManager::sm_num_lightmaps_buffers);
+                  LightmapManager::sm_num_lightmaps_buffers,
+                  LightmapManager::sm_lightmap_upload_bytes / 1024.0f);
 
         DrawAltString(10, 50, text);
 
@@ -755,4 +831,313 @@ void DLLInterface::DumpAllTexturesCmd()
     sm_texture_store.DumpAllLoadedTexturesToFile(file_path, image_type, (dump_mipmaps[0] == 'y') ? true : false);
 }
 
+
+void DLLInterface::ViewCaptureCmd()
+{
+    const int arg_count = GameInterface::Cmd::Argc();
+    if (arg_count < 2)
+    {
+        GameInterface::Printf("Usage: view_capture <file_name|stop>");
+        return;
+    }
+
+    const char * const file_name = GameInterface::Cmd::Argv(1);
+    if (std::strcmp(file_name, "stop") == 0)
+    {
+        if (sm_view_capture.IsOpen())
+        {
+            GameInterface::Printf("View capture stopped after %u frames.", sm_view_capture.NumFrames());
+            sm_view_capture.Close();
+        }
+        return;
+    }
+
+    const ModelInstance * const world_mdl = sm_model_store.WorldModel();
+    const char * const map_name = (world_mdl != nullptr) ? world_mdl->name.CStr() : "";
+
+    char full_path[1024];
+    sprintf_s(full_path, "%s/%s", GameInterface::FS::GameDir(), file_name);
+
+    if (sm_view_capture.Open(full_path, map_name))
+    {
+        GameInterface::Printf("Capturing views to '%s'...", full_path);
+    }
+}
+
+void DLLInterface::ViewReplayCmd()
+{
+    const int arg_count = GameInterface::Cmd::Argc();
+    if (arg_count < 2)
+    {
+        GameInterface::Printf("Usage: view_replay <file_name> [loops]");
+        return;
+    }
+
+    if (sm_renderer.IsFrameStarted() || sm_view_capture.IsOpen())
+    {
+        GameInterface::Printf("view_replay: Can't replay while a frame or a view capture is in progress.");
+        return;
+    }
+
+    auto * reader = new(MemTag::kRenderer) ViewCaptureReader{};
+    if (!reader->Load(GameInterface::Cmd::Argv(1)))
+    {
+        DeleteObject(reader, MemTag::kRenderer);
+        return;
+    }
+
+    // The capture must be replayed on the same map it was recorded on (use the 'map' command first).
+    const ModelInstance * const world_mdl = sm_model_store.WorldModel();
+    if (reader->MapName()[0] != '\0' && (world_mdl == nullptr || std::strcmp(world_mdl->name.CStr(), reader->MapName()) != 0))
+    {
+        GameInterface::Printf("view_replay: Capture was recorded on '%s', load that map first.", reader->MapName());
+        DeleteObject(reader, MemTag::kRenderer);
+        return;
+    }
+
+    const int loops = (arg_count >= 3) ? std::max(std::atoi(GameInterface::Cmd::Argv(2)), 1) : 1;
+    const std::uint32_t num_samples = reader->NumFrames() * loops;
+
+    // Per stage timings plus the RenderView and whole frame totals for every replayed frame.
+    constexpr int kTotalRenderView = ViewRenderer::kTimedStageCount;
+    constexpr int kTotalFrame      = ViewRenderer::kTimedStageCount + 1;
+    constexpr int kNumTimings      = ViewRenderer::kTimedStageCount + 2;
+
+    auto * samples = new(MemTag::kRenderer) std::uint64_t[num_samples * kNumTimings];
+    auto * sorted  = new(MemTag::kRenderer) std::uint64_t[num_samples];
+
+#if defined(MRQ2_RENDERER_DLL_NULL)
+    std::uint64_t total_draws = 0, total_verts = 0, total_indexes = 0;
+#endif // MRQ2_RENDERER_DLL_NULL
+
+    refdef_t view_def;
+    std::uint32_t sample_index = 0;
+
+    for (int l = 0; l < loops; ++l)
+    {
+        for (std::uint32_t f = 0; f < reader->NumFrames(); ++f, ++sample_index)
+        {
+            reader->DecodeFrame(f, sm_model_store, sm_texture_store, &view_def);
+
+            ViewRenderer::StageTimes stage_times{};
+            const std::uint64_t frame_start = HighResTimeMicroseconds();
+
+            BeginFrame(0.0f);
+            const std::uint64_t view_start = HighResTimeMicroseconds();
+            RenderViewImpl(view_def, &stage_times);
+            const std::uint64_t view_end = HighResTimeMicroseconds();
+            EndFrame();
+
+            const std::uint64_t frame_end = HighResTimeMicroseconds();
+
+            std::uint64_t * sample = &samples[sample_index * kNumTimings];
+            std::memcpy(sample, stage_times.microseconds, sizeof(stage_times.microseconds));
+            sample[kTotalRenderView] = view_end - view_start;
+            sample[kTotalFrame] = frame_end - frame_start;
+
+#if defined(MRQ2_RENDERER_DLL_NULL)
+            const FrameStatsNull & stats = sm_renderer.LastFrameStats();
+            total_draws   += stats.draw_calls + stats.draw_indexed_calls;
+            total_verts   += stats.vertices_drawn;
+            total_indexes += stats.indices_drawn;
+#endif // MRQ2_RENDERER_DLL_NULL
+        }
+    }
+
+    GameInterface::Printf("==== view_replay '%s': %u frames x %i loops ====", GameInterface::Cmd::Argv(1), reader->NumFrames(), loops);
+    GameInterface::Printf("%-22s %8s %8s %8s %8s (microseconds)", "stage", "avg", "p50", "p95", "p99");
+
+    for (int t = 0; t < kNumTimings; ++t)
+    {
+        std::uint64_t sum = 0;
+        for (std::uint32_t s = 0; s < num_samples; ++s)
+        {
+            sorted[s] = samples[s * kNumTimings + t];
+            sum += sorted[s];
+        }
+        std::sort(sorted, sorted + num_samples);
+
+        const auto Percentile = [sorted, num_samples](const std::uint32_t p) {
+            return static_cast<unsigned>(sorted[std::min((num_samples * p) / 100, num_samples - 1)]);
+        };
+
+        const char * const name = (t == kTotalRenderView) ? "RenderView total" :
+                                  (t == kTotalFrame)      ? "Frame total" : ViewRenderer::TimedStageName(t);
+
+        GameInterface::Printf("%-22s %8u %8u %8u %8u", name, static_cast<unsigned>(sum / num_samples),
+                              Percentile(50), Percentile(95), Percentile(99));
+    }
+
+#if defined(MRQ2_RENDERER_DLL_NULL)
+    GameInterface::Printf("Per frame avg: draws %u, verts %u, indexes %u",
+                          static_cast<unsigned>(total_draws / num_samples),
+                          static_cast<unsigned>(total_verts / num_samples),
+                          static_cast<unsigned>(total_indexes / num_samples));
+#endif // MRQ2_RENDERER_DLL_NULL
+
+    DeleteArray(sorted, num_samples, MemTag::kRenderer);
+    DeleteArray(samples, num_samples * kNumTimings, MemTag::kRenderer);
+
+    DeleteObject(reader, MemTag::kRenderer);
+}
+
+void DLLInterface::LightmapBenchCmd()
+{
+    const ModelInstance * const world_mdl = sm_model_store.WorldModel();
+    if (world_mdl == nullptr)
+    {
+        GameInterface::Printf("lightmap_bench: No map loaded.");
+        return;
+    }
+
+    const int iterations = (GameInterface::Cmd::Argc() >= 2) ? std::max(std::atoi(GameInterface::Cmd::Argv(1)), 1) : 10;
+    LightmapManager::Benchmark(*world_mdl, iterations);
+}
+
+void DLLInterface::AtlasStatsCmd()
+{
+    const char * const heuristic = (AtlasPacker::DefaultHeuristic() == AtlasPacker::Heuristic::kBestFit) ? "best fit" : "bottom left";
+    GameInterface::Printf("Atlas packer: skyline %s (r_atlas_packer=%d)", heuristic, Config::r_atlas_packer.AsInt());
+
+    const int num_lightmaps = LightmapManager::NumLightmaps();
+    float total_occupancy = 0.0f;
+    for (int lmap = 0; lmap < num_lightmaps; ++lmap)
+    {
+        const float occupancy = LightmapManager::LightmapOccupancy(lmap);
+        GameInterface::Printf("  lightmap %2d: %5.1f%% used", lmap, occupancy * 100.0f);
+        total_occupancy += occupancy;
+    }
+    GameInterface::Printf("Lightmaps: %d pages of %dx%d, %.1f%% average occupancy", num_lightmaps,
+                          LightmapManager::PageSize(), LightmapManager::PageSize(),
+                          (num_lightmaps > 0) ? (total_occupancy / num_lightmaps) * 100.0f : 0.0f);
+
+    const AtlasPacker & scrap = sm_texture_store.ScrapPacker();
+    GameInterface::Printf("Scrap: %d images in %dx%d, %.1f%% occupancy", scrap.NumAllocs(),
+                          scrap.Width(), scrap.Height(), scrap.Occupancy() * 100.0f);
+}
+
+void DLLInterface::FindBenchCmd()
+{
+    // Lookup cost of a full cache of texture names, linear scan (the old TextureStore::Find)
+    // vs the HashIndex now used by the texture and model stores. Half the lookups are misses.
+    constexpr int kNumNames = TextureStore::kTexturePoolSize;
+    const int iterations = (GameInterface::Cmd::Argc() >= 2) ? std::max(std::atoi(GameInterface::Cmd::Argv(1)), 1) : 100;
+
+    auto * names = new(MemTag::kRenderer) PathName[kNumNames];
+    auto * index = new(MemTag::kRenderer) HashIndex<const PathName, kNumNames * 2>{};
+
+    char name[PathName::kNameMaxLen];
+    for (int n = 0; n < kNumNames; ++n)
+    {
+        sprintf_s(name, "textures/bench/tex_%04d.wal", n);
+        names[n] = PathName{ name };
+        index->Insert(names[n].Hash(), &names[n]);
+    }
+
+    std::uint32_t query_hashes[kNumNames * 2];
+    for (int n = 0; n < kNumNames * 2; ++n)
+    {
+        sprintf_s(name, (n < kNumNames) ? "textures/bench/tex_%04d.wal" : "textures/bench/missing_%04d.wal", n % kNumNames);
+        query_hashes[n] = PathName::CalcHash(name);
+    }
+
+    int found_linear = 0;
+    std::uint64_t start = HighResTimeMicroseconds();
+    for (int it = 0; it < iterations; ++it)
+    {
+        for (const std::uint32_t hash : query_hashes)
+        {
+            for (int n = 0; n < kNumNames; ++n)
+            {
+                if (names[n].Hash() == hash)
+                {
+                    ++found_linear;
+                    break;
+                }
+            }
+        }
+    }
+    const std::uint64_t linear_us = HighResTimeMicroseconds() - start;
+
+    int found_hashed = 0;
+    start = HighResTimeMicroseconds();
+    for (int it = 0; it < iterations; ++it)
+    {
+        for (const std::uint32_t hash : query_hashes)
+        {
+            if (index->Find(hash, [hash](const PathName & p) { return p.Hash() == hash; }) != nullptr)
+            {
+                ++found_hashed;
+            }
+        }
+    }
+    const std::uint64_t hashed_us = HighResTimeMicroseconds() - start;
+
+    DeleteObject(index, MemTag::kRenderer);
+    DeleteArray(names, kNumNames, MemTag::kRenderer);
+
+    const double num_lookups = double(iterations) * kNumNames * 2;
+    GameInterface::Printf("Find benchmark: %i names, %i iterations, %.0f lookups (ns per lookup):", kNumNames, iterations, num_lookups);
+    GameInterface::Printf("  linear scan: %.1f", linear_us * 1000.0 / num_lookups);
+    GameInterface::Printf("  hash index:  %.1f (%.1fx)", hashed_us * 1000.0 / num_lookups, double(linear_us) / std::max(hashed_us, std::uint64_t(1)));
+    GameInterface::Printf("  found: %i / %i", found_hashed, found_linear);
+}
+
+void DLLInterface::MipMapBenchCmd()
+{
+    const int iterations = (GameInterface::Cmd::Argc() >= 2) ? std::max(std::atoi(GameInterface::Cmd::Argv(1)), 1) : 10;
+    sm_texture_store.BenchmarkMipMaps(iterations);
+}
+
+void DLLInterface::TextureCacheStatsCmd()
+{
+    const TextureStore::TextureCacheStats & stats = sm_texture_store.CacheStats();
+    const int lookups = stats.hits + stats.misses;
+
+    GameInterface::Printf("Texture cache '%s' (r_texture_cache=%d):", TextureStore::TextureCacheFilename(), Config::r_texture_cache.AsInt());
+    GameInterface::Printf("  hits: %i / %i (%.1f%%), file written %i times", stats.hits, lookups,
+                          (lookups > 0) ? (stats.hits * 100.0 / lookups) : 0.0, stats.files_written);
+    GameInterface::Printf("  hits:   %.2f Mtexels in %.2f ms", stats.hit_texels / 1000000.0, stats.hit_us / 1000.0);
+    GameInterface::Printf("  misses: %.2f Mtexels in %.2f ms", stats.miss_texels / 1000000.0, stats.miss_us / 1000.0);
+
+    // Savings estimated from the decode cost per texel of the misses. Job time, so it is spread over the workers.
+    if (stats.miss_texels > 0)
+    {
+        const double miss_us_per_texel = double(stats.miss_us) / stats.miss_texels;
+        const double saved_ms = (stats.hit_texels * miss_us_per_texel - stats.hit_us) / 1000.0;
+        GameInterface::Printf("  estimated decode time saved: %.2f ms", saved_ms);
+    }
+
+    const TextureStore::TextureCompressionStats & bc_stats = sm_texture_store.CompressionStats();
+    GameInterface::Printf("HD texture compression (r_hd_texture_compression=%d, supported=%d):",
+                          Config::r_hd_texture_compression.AsInt(), int(sm_texture_store.BlockCompressionSupported()));
+    GameInterface::Printf("  %i textures, %.2f MB as RGBA -> %.2f MB compressed, %.2f ms encoding", bc_stats.textures,
+                          bc_stats.rgba_bytes / (1024.0 * 1024.0), bc_stats.compressed_bytes / (1024.0 * 1024.0), bc_stats.encode_us / 1000.0);
+    GameInterface::Printf("  round-trip check: %i failed blocks", ValidateBlockCompression());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DLLInterface::TextureBudgetStatsCmd()
+{
+    const TextureStore::TextureResidencyStats & stats = sm_texture_store.ResidencyStats();
+    constexpr double kMB = 1024.0 * 1024.0;
+
+    GameInterface::Printf("Texture budget (r_texture_budget_mb=%d):", Config::r_texture_budget_mb.AsInt());
+    GameInterface::Printf("  resident: %.2f MB, peak %.2f MB", sm_texture_store.ResidentMemory() / kMB, stats.peak_bytes / kMB);
+    GameInterface::Printf("  currently evicted: %i textures", sm_texture_store.NumEvictedTextures());
+    GameInterface::Printf("  evictions: %i (%.2f MB), reloads: %i, reload failures: %i",
+                          stats.evictions, stats.evicted_bytes / kMB, stats.reloads, stats.reload_failures);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DLLInterface::AliasBenchCmd()
+{
+    // alias_bench [instances] [iterations]
+    const int num_instances = (GameInterface::Cmd::Argc() >= 2) ? std::max(std::atoi(GameInterface::Cmd::Argv(1)), 1) : 128;
+    const int iterations    = (GameInterface::Cmd::Argc() >= 3) ? std::max(std::atoi(GameInterface::Cmd::Argv(2)), 1) : 100;
+    ViewRenderer::BenchmarkAliasMD2(sm_model_store, num_instances, iterations);
+}
+
 } // namespace MrQ2
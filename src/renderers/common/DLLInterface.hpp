@@ -7,6 +7,7 @@
 #include "TextureStore.hpp"
 #include "ModelStore.hpp"
 #include "ViewRenderer.hpp"
+#include "ViewCapture.hpp"
 
 // Quake includes
 #include "client/ref.h"
@@ -61,9 +62,20 @@ private:
     static void DrawNumberBig(int x, int y, int color, int width, int value);
     static void DrawFpsCounter();
 
+    static void RenderViewImpl(const refdef_t & view_def, ViewRenderer::StageTimes * stage_times);
+
     static void R_Flash(const float blend[4]);
     static void ChangeTextureFilterCmd();
     static void DumpAllTexturesCmd();
+    static void ViewCaptureCmd();
+    static void ViewReplayCmd();
+    static void LightmapBenchCmd();
+    static void AtlasStatsCmd();
+    static void FindBenchCmd();
+    static void MipMapBenchCmd();
+    static void TextureCacheStatsCmd();
+    static void TextureBudgetStatsCmd();
+    static void AliasBenchCmd();
 
     static RenderInterface sm_renderer;
     static SpriteBatches   sm_sprite_batches;
@@ -71,6 +83,13 @@ private:
     static ModelStore      sm_model_store;
     static ViewRenderer    sm_view_renderer;
 
+    // Recording of the refdefs passed to RenderView (view_capture command).
+    static ViewCaptureWriter sm_view_capture;
+
+    // Level load time, from BeginRegistration to the end of EndRegistration.
+    static std::uint64_t sm_registration_start_us;
+    static double        sm_last_level_load_ms;
+
     // These must match the shader equivalents!
     enum class DebugMode : std::uint32_t
     {
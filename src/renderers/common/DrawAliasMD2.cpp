@@ -4,6 +4,8 @@
 //
 
 #include "ViewRenderer.hpp"
+#include "JobSystem.hpp"
+#include <emmintrin.h>
 
 namespace MrQ2
 {
@@ -36,43 +38,192 @@ static const float s_vertex_normal_dots[kShadeDotQuant][256] = {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-struct LerpInputs final
+struct AliasLerpInputs final
 {
-    const entity_t    * entity;
-    const dtrivertx_t * frame_verts;
-    const dtrivertx_t * old_frame_verts;
-    int                 num_verts;
-    vec3_t              frontv;
-    vec3_t              backv;
-    vec3_t              move;
+    const AliasMD2Frame * frame;
+    const AliasMD2Frame * old_frame;
+    int                   num_verts_padded;
+    vec3_t                frontv;
+    vec3_t                backv;
+    vec3_t                move;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static void LerpEntityVerts(const LerpInputs & in, float * lerp)
+static void SetupAliasLerp(const entity_t & entity, const AliasMD2Mesh & mesh, const float backlerp, AliasLerpInputs & in)
 {
-    const int num_verts    = in.num_verts;
-    const dtrivertx_t * v  = in.frame_verts;
-    const dtrivertx_t * ov = in.old_frame_verts;
+    MRQ2_ASSERT(entity.frame    >= 0 && entity.frame    < mesh.num_frames);
+    MRQ2_ASSERT(entity.oldframe >= 0 && entity.oldframe < mesh.num_frames);
 
-    if (in.entity->flags & (RF_SHELL_RED | RF_SHELL_GREEN | RF_SHELL_BLUE | RF_SHELL_DOUBLE | RF_SHELL_HALF_DAM))
+    const AliasMD2Frame * frame     = &mesh.frames[entity.frame];
+    const AliasMD2Frame * old_frame = &mesh.frames[entity.oldframe];
+    const float frontlerp = 1.0f - backlerp;
+
+    vec3_t delta, move;
+    vec3_t vectors[3];
+
+    // move should be the delta back to the previous frame * backlerp
+    Vec3Sub(entity.oldorigin, entity.origin, delta);
+    VectorsFromAngles(entity.angles, vectors[0], vectors[1], vectors[2]);
+
+    move[0] =  Vec3Dot(delta, vectors[0]); // forward
+    move[1] = -Vec3Dot(delta, vectors[1]); // left
+    move[2] =  Vec3Dot(delta, vectors[2]); // up
+
+    Vec3Add(move, old_frame->translate, move);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        in.move[i]   = backlerp * move[i] + frontlerp * frame->translate[i];
+        in.frontv[i] = frontlerp * frame->scale[i];
+        in.backv[i]  = backlerp  * old_frame->scale[i];
+    }
+
+    in.frame            = frame;
+    in.old_frame        = old_frame;
+    in.num_verts_padded = mesh.num_verts_padded;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Reference version of LerpAliasVerts_SSE2, same results.
+static void LerpAliasVerts_Scalar(const AliasLerpInputs & in, float * const out[3])
+{
+    const int num_verts = in.num_verts_padded;
+
+    for (int c = 0; c < 3; ++c)
     {
-        for (int i = 0; i < num_verts; i++, v++, ov++, lerp += 3)
+        const std::uint8_t * const v  = in.frame->verts + c * num_verts;
+        const std::uint8_t * const ov = in.old_frame->verts + c * num_verts;
+        float * const dst = out[c];
+
+        for (int i = 0; i < num_verts; ++i)
         {
-            const float * const normal = s_vertex_normals[v->lightnormalindex];
-            lerp[0] = in.move[0] + ov->v[0] * in.backv[0] + v->v[0] * in.frontv[0] + normal[0] * POWERSUIT_SCALE;
-            lerp[1] = in.move[1] + ov->v[1] * in.backv[1] + v->v[1] * in.frontv[1] + normal[1] * POWERSUIT_SCALE;
-            lerp[2] = in.move[2] + ov->v[2] * in.backv[2] + v->v[2] * in.frontv[2] + normal[2] * POWERSUIT_SCALE;
+            dst[i] = in.move[c] + ov[i] * in.backv[c] + v[i] * in.frontv[c];
         }
     }
-    else
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// 16 vertexes per iteration for each axis: bytes are widened to 32-bit ints, converted to
+// floats and interpolated in the same order of operations as the scalar version.
+static void LerpAliasVerts_SSE2(const AliasLerpInputs & in, float * const out[3])
+{
+    const int num_verts = in.num_verts_padded;
+    MRQ2_ASSERT((num_verts % AliasMD2Mesh::kVertsAlignment) == 0);
+
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int c = 0; c < 3; ++c)
+    {
+        const std::uint8_t * const v  = in.frame->verts + c * num_verts;
+        const std::uint8_t * const ov = in.old_frame->verts + c * num_verts;
+        float * const dst = out[c];
+
+        const __m128 move  = _mm_set1_ps(in.move[c]);
+        const __m128 back  = _mm_set1_ps(in.backv[c]);
+        const __m128 front = _mm_set1_ps(in.frontv[c]);
+
+        for (int i = 0; i < num_verts; i += 16)
+        {
+            const __m128i v8  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v  + i));
+            const __m128i ov8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ov + i));
+
+            const __m128i v16[2]  = { _mm_unpacklo_epi8(v8,  zero), _mm_unpackhi_epi8(v8,  zero) };
+            const __m128i ov16[2] = { _mm_unpacklo_epi8(ov8, zero), _mm_unpackhi_epi8(ov8, zero) };
+
+            for (int h = 0; h < 2; ++h)
+            {
+                const __m128 vf_lo  = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v16[h],  zero));
+                const __m128 vf_hi  = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v16[h],  zero));
+                const __m128 ovf_lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(ov16[h], zero));
+                const __m128 ovf_hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(ov16[h], zero));
+
+                _mm_storeu_ps(dst + i + h * 8,     _mm_add_ps(_mm_add_ps(move, _mm_mul_ps(ovf_lo, back)), _mm_mul_ps(vf_lo, front)));
+                _mm_storeu_ps(dst + i + h * 8 + 4, _mm_add_ps(_mm_add_ps(move, _mm_mul_ps(ovf_hi, back)), _mm_mul_ps(vf_hi, front)));
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Powersuit shells are pushed out along the vertex normals.
+static void AddAliasShellOffset(const AliasLerpInputs & in, const int num_verts, float * const out[3])
+{
+    const std::uint8_t * const normal_indexes = in.frame->verts + in.num_verts_padded * 3;
+
+    for (int i = 0; i < num_verts; ++i)
+    {
+        const float * const normal = s_vertex_normals[normal_indexes[i]];
+        out[0][i] += normal[0] * POWERSUIT_SCALE;
+        out[1][i] += normal[1] * POWERSUIT_SCALE;
+        out[2][i] += normal[2] * POWERSUIT_SCALE;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Moves the lerped vertexes to world space for instanced draws (row vectors, same as the vertex shader).
+static void TransformAliasVerts_SSE2(const RenderMatrix & m, const int num_verts_padded, float * const positions[3])
+{
+    MRQ2_ASSERT((num_verts_padded % 4) == 0);
+
+    const __m128 m00 = _mm_set1_ps(m.m[0][0]), m01 = _mm_set1_ps(m.m[0][1]), m02 = _mm_set1_ps(m.m[0][2]);
+    const __m128 m10 = _mm_set1_ps(m.m[1][0]), m11 = _mm_set1_ps(m.m[1][1]), m12 = _mm_set1_ps(m.m[1][2]);
+    const __m128 m20 = _mm_set1_ps(m.m[2][0]), m21 = _mm_set1_ps(m.m[2][1]), m22 = _mm_set1_ps(m.m[2][2]);
+    const __m128 m30 = _mm_set1_ps(m.m[3][0]), m31 = _mm_set1_ps(m.m[3][1]), m32 = _mm_set1_ps(m.m[3][2]);
+
+    for (int i = 0; i < num_verts_padded; i += 4)
     {
-        for (int i = 0; i < num_verts; i++, v++, ov++, lerp += 3)
+        const __m128 x = _mm_loadu_ps(positions[0] + i);
+        const __m128 y = _mm_loadu_ps(positions[1] + i);
+        const __m128 z = _mm_loadu_ps(positions[2] + i);
+
+        _mm_storeu_ps(positions[0] + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_add_ps(_mm_mul_ps(z, m20), m30)));
+        _mm_storeu_ps(positions[1] + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_add_ps(_mm_mul_ps(z, m21), m31)));
+        _mm_storeu_ps(positions[2] + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)), _mm_add_ps(_mm_mul_ps(z, m22), m32)));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Expands the lerped frame vertexes to the draw vertexes of the mesh. Each vertex is written
+// whole and in order, since out_verts is usually the mapped (write-combined) vertex buffer.
+static void BuildAliasDrawVerts(const AliasMD2Mesh & mesh, const AliasLerpInputs & in, const float * const positions[3],
+                                const float * const shade_dots, const vec3_t shade_light, const float alpha,
+                                const bool shell, DrawVertex3D * out_verts)
+{
+    const std::uint8_t * const normal_indexes = in.frame->verts + in.num_verts_padded * 3;
+
+    for (int d = 0; d < mesh.num_draw_verts; ++d, ++out_verts)
+    {
+        const int xyz = mesh.draw_xyz_indexes[d];
+
+        // Shells are flat shaded and untextured, the rest use the normals of the current frame.
+        const float l = shell ? 1.0f : shade_dots[normal_indexes[xyz]];
+
+        DrawVertex3D dv;
+        dv.position[0] = positions[0][xyz];
+        dv.position[1] = positions[1][xyz];
+        dv.position[2] = positions[2][xyz];
+        if (shell)
+        {
+            Vec2Zero(dv.texture_uv);
+        }
+        else
         {
-            lerp[0] = in.move[0] + ov->v[0] * in.backv[0] + v->v[0] * in.frontv[0];
-            lerp[1] = in.move[1] + ov->v[1] * in.backv[1] + v->v[1] * in.frontv[1];
-            lerp[2] = in.move[2] + ov->v[2] * in.backv[2] + v->v[2] * in.frontv[2];
+            dv.texture_uv[0] = mesh.draw_uvs[d][0];
+            dv.texture_uv[1] = mesh.draw_uvs[d][1];
         }
+        Vec2Zero(dv.lightmap_uv);
+        dv.rgba[0] = l * shade_light[0];
+        dv.rgba[1] = l * shade_light[1];
+        dv.rgba[2] = l * shade_light[2];
+        dv.rgba[3] = alpha;
+
+        *out_verts = dv;
     }
 }
 
@@ -99,295 +250,332 @@ static inline const float * GetShadeDotsForEnt(const entity_t & entity)
     return s_vertex_normal_dots[index];
 }
 
-// This holds the last rendered frame of an MD2 model for a subsequent DrawAliasMD2Shadow.
-static vec3_t s_lerped_positions[MAX_VERTS] = {};
-
 ///////////////////////////////////////////////////////////////////////////////
 
-void ViewRenderer::DrawAliasMD2FrameLerp(const entity_t & entity, const dmdl_t * const alias_header, const float backlerp,
-                                         const vec3_t shade_light, const RenderMatrix & model_matrix,
-                                         const TextureImage * const model_skin)
+// Simple projected shadow: the lerped frame flattened on the ground below the model, following light_spot.
+// Vertexes are moved to world space if world_matrix is not null.
+static void BuildAliasShadowVerts(const AliasMD2Mesh & mesh, const entity_t & entity, const float * const positions[3],
+                                  const vec3_t light_spot, const RenderMatrix * const world_matrix, DrawVertex3D * out_verts)
 {
-    MRQ2_ASSERT(alias_header != nullptr);
-    MRQ2_ASSERT(alias_header->num_xyz <= MAX_VERTS);
+    constexpr float kShadowColorOpacity = 0.5f;
 
-    const std::int32_t  * order = GetAliasGLCmds(alias_header);
+    const float lheight = entity.origin[2] - light_spot[2];
+    const float height  = -lheight + 1.0f;
+    const float angle   = DegToRad(entity.angles[YAW]);
 
-    const daliasframe_t * frame = GetAliasFrame(alias_header, entity.frame);
-    const dtrivertx_t   * verts = frame->verts;
+    vec3_t shade_vector;
+    shade_vector[0] = std::cos(-angle);
+    shade_vector[1] = std::sin(-angle);
+    shade_vector[2] = 1.0f;
+    Vec3Normalize(shade_vector);
 
-    const daliasframe_t * old_frame = GetAliasFrame(alias_header, entity.oldframe);
-    const dtrivertx_t   * old_verts = old_frame->verts;
+    for (int d = 0; d < mesh.num_draw_verts; ++d, ++out_verts)
+    {
+        const int xyz = mesh.draw_xyz_indexes[d];
 
-    const float alpha        = (entity.flags & RF_TRANSLUCENT) ? entity.alpha : 1.0f;
-    const float frontlerp    = 1.0f - backlerp;
-    const float * shade_dots = GetShadeDotsForEnt(entity);
+        DrawVertex3D dv = {};
+        dv.rgba[3] = kShadowColorOpacity;
 
-    vec3_t delta, move;
-    vec3_t frontv, backv;
-    vec3_t vectors[3];
+        const float z = positions[2][xyz];
+        dv.position[0] = positions[0][xyz] - shade_vector[0] * (z + lheight);
+        dv.position[1] = positions[1][xyz] - shade_vector[1] * (z + lheight);
+        dv.position[2] = height;
 
-    // move should be the delta back to the previous frame * backlerp
-    Vec3Sub(entity.oldorigin, entity.origin, delta);
-    VectorsFromAngles(entity.angles, vectors[0], vectors[1], vectors[2]);
+        if (world_matrix != nullptr)
+        {
+            const RenderMatrix & m = *world_matrix;
+            const vec3_t p = { dv.position[0], dv.position[1], dv.position[2] };
+            for (int c = 0; c < 3; ++c)
+            {
+                dv.position[c] = p[0] * m.m[0][c] + p[1] * m.m[1][c] + p[2] * m.m[2][c] + m.m[3][c];
+            }
+        }
 
-    move[0] =  Vec3Dot(delta, vectors[0]); // forward
-    move[1] = -Vec3Dot(delta, vectors[1]); // left
-    move[2] =  Vec3Dot(delta, vectors[2]); // up
+        *out_verts = dv;
+    }
+}
 
-    Vec3Add(move, old_frame->translate, move);
+///////////////////////////////////////////////////////////////////////////////
 
-    for (int i = 0; i < 3; ++i)
+// Runs on the JobSystem threads. scratch_positions is the calling thread's own SoA buffer.
+void ViewRenderer::BuildAliasMD2Verts(const AliasMD2DrawItem & item, float * const scratch_positions[3])
+{
+    const entity_t & entity = *item.entity;
+    const AliasMD2Mesh * const mesh = item.model->data.alias_mesh;
+    MRQ2_ASSERT(mesh != nullptr);
+    MRQ2_ASSERT(mesh->num_verts_padded <= MAX_VERTS);
+    MRQ2_ASSERT(item.verts != nullptr);
+
+    const float alpha = (entity.flags & RF_TRANSLUCENT) ? entity.alpha : 1.0f;
+    const bool  shell = (entity.flags & (RF_SHELL_RED | RF_SHELL_GREEN | RF_SHELL_BLUE)) != 0;
+
+    // Interpolate the previous frame and the current:
+    AliasLerpInputs lerp_in;
+    SetupAliasLerp(entity, *mesh, item.backlerp, lerp_in);
+    LerpAliasVerts_SSE2(lerp_in, scratch_positions);
+
+    if (entity.flags & (RF_SHELL_RED | RF_SHELL_GREEN | RF_SHELL_BLUE | RF_SHELL_DOUBLE | RF_SHELL_HALF_DAM))
     {
-        move[i] = backlerp * move[i] + frontlerp * frame->translate[i];
+        AddAliasShellOffset(lerp_in, mesh->num_verts, scratch_positions);
     }
 
-    for (int i = 0; i < 3; ++i)
+    // The shadow is projected from the model space positions.
+    if (item.draw_shadow)
     {
-        frontv[i] = frontlerp * frame->scale[i];
-        backv[i]  = backlerp  * old_frame->scale[i];
+        BuildAliasShadowVerts(*mesh, entity, scratch_positions, item.light_spot,
+                              item.instanced ? &item.model_matrix : nullptr, item.verts + mesh->num_draw_verts);
     }
 
-    // Interpolate the previous frame and the current:
-    LerpInputs lerp_in;
-    lerp_in.entity = &entity;
-    lerp_in.frame_verts = verts;
-    lerp_in.old_frame_verts = old_verts;
-    lerp_in.num_verts = alias_header->num_xyz;
-    Vec3Copy(frontv, lerp_in.frontv);
-    Vec3Copy(backv, lerp_in.backv);
-    Vec3Copy(move, lerp_in.move);
-    LerpEntityVerts(lerp_in, s_lerped_positions[0]);
-
-    BeginBatchArgs batch_args;
-    batch_args.model_matrix = model_matrix;
-    batch_args.diffuse_tex  = model_skin;
-    batch_args.lightmap_tex = nullptr;
-    batch_args.depth_hack   = (entity.flags & RF_DEPTHHACK) != 0;
-
-    // Build the final model vertices:
+    if (item.instanced)
+    {
+        TransformAliasVerts_SSE2(item.model_matrix, mesh->num_verts_padded, scratch_positions);
+    }
+
+    // Build the final model vertices straight into the vertex buffer, drawn with the model's static indexes:
+    BuildAliasDrawVerts(*mesh, lerp_in, scratch_positions, GetShadeDotsForEnt(entity), item.shade_light, alpha, shell, item.verts);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// alias_bench:
+///////////////////////////////////////////////////////////////////////////////
+
+// The vertex generation used before the SoA meshes: AoS lerp one vertex at a time,
+// then the GL command strips and fans pushed through MiniImBatch. Only kept for comparison.
+static std::uint32_t BuildAliasVertsGLCmds(const dmdl_t * const alias_header, const entity_t & entity, const AliasLerpInputs & lerp_in,
+                                           const float * const shade_dots, const vec3_t shade_light,
+                                           DrawVertex3D * const out_verts, const std::uint32_t max_verts)
+{
+    static vec3_t s_aos_positions[MAX_VERTS];
+
+    const dtrivertx_t * verts = GetAliasFrame(alias_header, entity.frame)->verts;
+    const dtrivertx_t * v     = verts;
+    const dtrivertx_t * ov    = GetAliasFrame(alias_header, entity.oldframe)->verts;
+
+    for (int i = 0; i < alias_header->num_xyz; ++i, ++v, ++ov)
+    {
+        s_aos_positions[i][0] = lerp_in.move[0] + ov->v[0] * lerp_in.backv[0] + v->v[0] * lerp_in.frontv[0];
+        s_aos_positions[i][1] = lerp_in.move[1] + ov->v[1] * lerp_in.backv[1] + v->v[1] * lerp_in.frontv[1];
+        s_aos_positions[i][2] = lerp_in.move[2] + ov->v[2] * lerp_in.backv[2] + v->v[2] * lerp_in.frontv[2];
+    }
+
+    std::uint32_t num_out_verts = 0;
+    const std::int32_t * order = GetAliasGLCmds(alias_header);
+
     for (;;)
     {
-        // Get the vertex count and primitive type
         std::int32_t count = *order++;
         if (count == 0)
         {
             break; // done
         }
 
-        if (count < 0) // TriangleFan emulation:
-        {
-            count = -count;
-            MRQ2_ASSERT(count > 0);
+        const bool is_fan = (count < 0);
+        count = std::abs(count);
 
-            batch_args.topology = PrimitiveTopology::kTriangleFan;
-            MiniImBatch batch = BeginBatch(batch_args);
+        MiniImBatch batch{ out_verts + num_out_verts, max_verts - num_out_verts,
+                           is_fan ? PrimitiveTopology::kTriangleFan : PrimitiveTopology::kTriangleStrip };
 
-            if (entity.flags & (RF_SHELL_RED | RF_SHELL_GREEN | RF_SHELL_BLUE))
-            {
-                for (int i = 0; i < count; ++i)
-                {
-                    const std::size_t index_xyz = order[2];
-                    MRQ2_ASSERT(index_xyz < ArrayLength(s_lerped_positions));
-                    order += 3;
-
-                    DrawVertex3D dv;
-                    Vec3Copy(s_lerped_positions[index_xyz], dv.position);
-                    Vec2Zero(dv.texture_uv);
-                    Vec2Zero(dv.lightmap_uv);
-                    dv.rgba[0] = shade_light[0];
-                    dv.rgba[1] = shade_light[1];
-                    dv.rgba[2] = shade_light[2];
-                    dv.rgba[3] = alpha;
-
-                    if (i == 0)
-                        batch.SetTriangleFanFirstVertex(dv);
-                    else
-                        batch.PushVertex(dv);
-                }
-            }
-            else
-            {
-                for (int i = 0; i < count; ++i)
-                {
-                    // Texture coordinates come from the draw list
-                    const float u = reinterpret_cast<const float *>(order)[0];
-                    const float v = reinterpret_cast<const float *>(order)[1];
-
-                    const std::size_t index_xyz = order[2];
-                    MRQ2_ASSERT(index_xyz < ArrayLength(s_lerped_positions));
-                    order += 3;
-
-                    // Normals and vertexes come from the frame list
-                    const float l = shade_dots[verts[index_xyz].lightnormalindex];
-
-                    DrawVertex3D dv;
-                    Vec3Copy(s_lerped_positions[index_xyz], dv.position);
-                    dv.texture_uv[0] = u;
-                    dv.texture_uv[1] = v;
-                    Vec2Zero(dv.lightmap_uv);
-                    dv.rgba[0] = l * shade_light[0];
-                    dv.rgba[1] = l * shade_light[1];
-                    dv.rgba[2] = l * shade_light[2];
-                    dv.rgba[3] = alpha;
-
-                    if (i == 0)
-                        batch.SetTriangleFanFirstVertex(dv);
-                    else
-                        batch.PushVertex(dv);
-                }
-            }
-
-            EndBatch(batch);
-        }
-        else // TriangleStrip fast path:
+        for (int i = 0; i < count; ++i, order += 3)
         {
-            batch_args.topology = PrimitiveTopology::kTriangleStrip;
-            MiniImBatch batch = BeginBatch(batch_args);
-
-            MRQ2_ASSERT(count > 0);
-            DrawVertex3D * vertex_ptr = batch.Increment(count);
-
-            if (entity.flags & (RF_SHELL_RED | RF_SHELL_GREEN | RF_SHELL_BLUE))
-            {
-                for (int i = 0; i < count; ++i, ++vertex_ptr)
-                {
-                    const std::size_t index_xyz = order[2];
-                    MRQ2_ASSERT(index_xyz < ArrayLength(s_lerped_positions));
-                    order += 3;
-
-                    Vec3Copy(s_lerped_positions[index_xyz], vertex_ptr->position);
-                    Vec2Zero(vertex_ptr->texture_uv);
-                    Vec2Zero(vertex_ptr->lightmap_uv);
-                    vertex_ptr->rgba[0] = shade_light[0];
-                    vertex_ptr->rgba[1] = shade_light[1];
-                    vertex_ptr->rgba[2] = shade_light[2];
-                    vertex_ptr->rgba[3] = alpha;
-                }
-            }
+            const std::size_t index_xyz = order[2];
+            const float l = shade_dots[verts[index_xyz].lightnormalindex];
+
+            DrawVertex3D dv;
+            Vec3Copy(s_aos_positions[index_xyz], dv.position);
+            dv.texture_uv[0] = reinterpret_cast<const float *>(order)[0];
+            dv.texture_uv[1] = reinterpret_cast<const float *>(order)[1];
+            Vec2Zero(dv.lightmap_uv);
+            dv.rgba[0] = l * shade_light[0];
+            dv.rgba[1] = l * shade_light[1];
+            dv.rgba[2] = l * shade_light[2];
+            dv.rgba[3] = 1.0f;
+
+            if (is_fan && i == 0)
+                batch.SetTriangleFanFirstVertex(dv);
             else
-            {
-                for (int i = 0; i < count; ++i, ++vertex_ptr)
-                {
-                    // Texture coordinates come from the draw list
-                    const float u = reinterpret_cast<const float *>(order)[0];
-                    const float v = reinterpret_cast<const float *>(order)[1];
-
-                    const std::size_t index_xyz = order[2];
-                    MRQ2_ASSERT(index_xyz < ArrayLength(s_lerped_positions));
-                    order += 3;
-
-                    // Normals and vertexes come from the frame list
-                    const float l = shade_dots[verts[index_xyz].lightnormalindex];
-
-                    Vec3Copy(s_lerped_positions[index_xyz], vertex_ptr->position);
-                    vertex_ptr->texture_uv[0] = u;
-                    vertex_ptr->texture_uv[1] = v;
-                    Vec2Zero(vertex_ptr->lightmap_uv);
-                    vertex_ptr->rgba[0] = l * shade_light[0];
-                    vertex_ptr->rgba[1] = l * shade_light[1];
-                    vertex_ptr->rgba[2] = l * shade_light[2];
-                    vertex_ptr->rgba[3] = alpha;
-                }
-            }
-
-            EndBatch(batch);
+                batch.PushVertex(dv);
         }
+
+        num_out_verts += batch.UsedVerts();
     }
+
+    return num_out_verts;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void ViewRenderer::DrawAliasMD2Shadow(const entity_t & entity, const dmdl_t * const alias_header, const RenderMatrix & model_matrix, const vec3_t light_spot)
+void ViewRenderer::BenchmarkAliasMD2(const ModelStore & model_store, const int num_instances, const int iterations)
 {
-    constexpr float kShadowColorOpacity = 0.5f;
+    MRQ2_ASSERT(num_instances > 0 && iterations > 0);
 
-    const float lheight = entity.origin[2] - light_spot[2];
-    const float height  = -lheight + 1.0f;
-    const float angle   = DegToRad(entity.angles[YAW]);
+    FixedSizeArray<const ModelInstance *, ModelStore::kModelPoolSize> models;
+    std::uint32_t max_verts = 0;
 
-    vec3_t shade_vector;
-    shade_vector[0] = std::cosf(-angle);
-    shade_vector[1] = std::sinf(-angle);
-    shade_vector[2] = 1.0f;
-    Vec3Normalize(shade_vector);
-
-    BeginBatchArgs batch_args;
-    batch_args.model_matrix = model_matrix;
-    batch_args.diffuse_tex  = nullptr;
-    batch_args.lightmap_tex = nullptr;
-    batch_args.depth_hack   = false;
-
-    const std::int32_t * order = GetAliasGLCmds(alias_header);
-    for (;;)
+    for (const ModelInstance * mdl : model_store)
     {
-        // get the vertex count and primitive type
-        std::int32_t count = *order++;
-        if (count == 0)
+        if (mdl->type == ModelType::kAliasMD2 && mdl->data.alias_mesh != nullptr)
         {
-            break; // done
+            models.push_back(mdl);
+
+            // Fans and strips never emit more vertexes than the triangle list has indexes, plus any degenerate commands.
+            max_verts = std::max(max_verts, std::uint32_t(mdl->data.alias_mesh->num_indexes * 2));
         }
+    }
 
-        if (count < 0) // TriangleFan emulation:
-        {
-            count = -count;
-            MRQ2_ASSERT(count > 0);
+    if (models.empty())
+    {
+        GameInterface::Printf("alias_bench: No alias models loaded.");
+        return;
+    }
+
+    // Each instance of the scene animates a different frame pair and lerp fraction.
+    auto SetupInstance = [&models](const int instance, const int iteration, entity_t & entity) -> const ModelInstance *
+    {
+        const ModelInstance * mdl = models[instance % models.size()];
+        const int num_frames = mdl->data.alias_mesh->num_frames;
+
+        std::memset(&entity, 0, sizeof(entity));
+        entity.frame       = (instance * 7 + iteration) % num_frames;
+        entity.oldframe    = (entity.frame + num_frames - 1) % num_frames;
+        entity.backlerp    = float(instance % 8) / 8.0f;
+        entity.angles[YAW] = float((instance * 45) % 360);
+        return mdl;
+    };
+
+    // Written to system memory instead of the mapped vertex buffer. One output and scratch buffer per thread.
+    const int num_threads = JobSystem::NumThreads();
+    auto * out_verts = new(MemTag::kRenderer) DrawVertex3D[max_verts * num_threads];
+    auto * scratch   = new(MemTag::kRenderer) float[num_threads * 3 * MAX_VERTS];
+    const vec3_t shade_light = { 1.0f, 1.0f, 1.0f };
+
+    enum { kGLCmds, kSoAScalar, kSoASSE2, kSoASSE2Parallel, kNumVariants };
+    static const char * const variant_names[kNumVariants] = {
+        "GL cmds, AoS lerp   ",
+        "indexed, SoA scalar ",
+        "indexed, SoA SSE2   ",
+        "indexed, SSE2 + jobs",
+    };
+
+    std::uint64_t variant_us[kNumVariants] = {};
+    std::uint64_t variant_verts[kNumVariants] = {};
+    std::uint64_t num_indexes = 0;
+
+    // Same work as kSoASSE2, with the instances spread over the JobSystem like PrepareAliasMD2Models.
+    struct JobArgs
+    {
+        decltype(SetupInstance) * setup_instance;
+        DrawVertex3D *            out_verts;
+        float *                   scratch;
+        std::uint32_t             max_verts;
+        int                       iteration;
+        const float *             shade_light;
+    } job_args{ &SetupInstance, out_verts, scratch, max_verts, 0, shade_light };
+
+    const JobSystem::JobFunc parallel_job = [](void * user_data, const int job_index, const int thread_index)
+    {
+        const auto & args = *static_cast<const JobArgs *>(user_data);
+
+        entity_t entity;
+        const ModelInstance * mdl = (*args.setup_instance)(job_index, args.iteration, entity);
+        const AliasMD2Mesh & mesh = *mdl->data.alias_mesh;
 
-            batch_args.topology = PrimitiveTopology::kTriangleFan;
-            MiniImBatch batch = BeginBatch(batch_args);
+        float * const thread_scratch = args.scratch + std::size_t(thread_index) * 3 * MAX_VERTS;
+        float * const positions[3] = { thread_scratch, thread_scratch + MAX_VERTS, thread_scratch + MAX_VERTS * 2 };
 
-            for (int i = 0; i < count; ++i)
+        AliasLerpInputs lerp_in;
+        SetupAliasLerp(entity, mesh, entity.backlerp, lerp_in);
+        LerpAliasVerts_SSE2(lerp_in, positions);
+        BuildAliasDrawVerts(mesh, lerp_in, positions, GetShadeDotsForEnt(entity), args.shade_light, 1.0f, false,
+                            args.out_verts + std::size_t(thread_index) * args.max_verts);
+    };
+
+    for (int variant = 0; variant < kNumVariants; ++variant)
+    {
+        float * const positions[3] = { scratch, scratch + MAX_VERTS, scratch + MAX_VERTS * 2 };
+        const std::uint64_t start_us = HighResTimeMicroseconds();
+
+        for (int it = 0; it < iterations; ++it)
+        {
+            if (variant == kSoASSE2Parallel)
             {
-                const std::size_t index_xyz = order[2];
-                MRQ2_ASSERT(index_xyz < ArrayLength(s_lerped_positions));
-                order += 3;
+                job_args.iteration = it;
+                JobSystem::ParallelFor(num_instances, parallel_job, &job_args);
+                continue;
+            }
 
-                DrawVertex3D dv = {};
-                dv.rgba[3] = kShadowColorOpacity;
+            for (int instance = 0; instance < num_instances; ++instance)
+            {
+                entity_t entity;
+                const ModelInstance * mdl = SetupInstance(instance, it, entity);
+                const AliasMD2Mesh & mesh = *mdl->data.alias_mesh;
 
-                // Reuse s_lerped_positions[] from the previous DrawAliasMD2FrameLerp call.
-                Vec3Copy(s_lerped_positions[index_xyz], dv.position);
-                dv.position[0] -= shade_vector[0] * (dv.position[2] + lheight);
-                dv.position[1] -= shade_vector[1] * (dv.position[2] + lheight);
-                dv.position[2] = height;
+                AliasLerpInputs lerp_in;
+                SetupAliasLerp(entity, mesh, entity.backlerp, lerp_in);
 
-                if (i == 0)
-                    batch.SetTriangleFanFirstVertex(dv);
+                if (variant == kGLCmds)
+                {
+                    variant_verts[variant] += BuildAliasVertsGLCmds(mdl->hunk.ViewBaseAs<dmdl_t>(), entity, lerp_in,
+                                                                    GetShadeDotsForEnt(entity), shade_light, out_verts, max_verts);
+                }
                 else
-                    batch.PushVertex(dv);
-            }
+                {
+                    if (variant == kSoAScalar)
+                        LerpAliasVerts_Scalar(lerp_in, positions);
+                    else
+                        LerpAliasVerts_SSE2(lerp_in, positions);
 
-            EndBatch(batch);
+                    BuildAliasDrawVerts(mesh, lerp_in, positions, GetShadeDotsForEnt(entity), shade_light, 1.0f, false, out_verts);
+                    variant_verts[variant] += mesh.num_draw_verts;
+                    num_indexes += (variant == kSoASSE2) ? mesh.num_indexes : 0;
+                }
+            }
         }
-        else // TriangleStrip fast path:
-        {
-            batch_args.topology = PrimitiveTopology::kTriangleStrip;
-            MiniImBatch batch = BeginBatch(batch_args);
 
-            MRQ2_ASSERT(count > 0);
-            DrawVertex3D * vertex_ptr = batch.Increment(count);
+        variant_us[variant] = HighResTimeMicroseconds() - start_us;
+    }
+    variant_verts[kSoASSE2Parallel] = variant_verts[kSoASSE2];
 
-            for (int i = 0; i < count; ++i)
-            {
-                const std::size_t index_xyz = order[2];
-                MRQ2_ASSERT(index_xyz < ArrayLength(s_lerped_positions));
-                order += 3;
+    // The kernels must agree.
+    float max_difference = 0.0f;
+    for (const ModelInstance * mdl : models)
+    {
+        alignas(16) static float s_scalar_positions[3][MAX_VERTS];
+        float * const scalar_positions[3] = { s_scalar_positions[0], s_scalar_positions[1], s_scalar_positions[2] };
+        float * const simd_positions[3]   = { scratch, scratch + MAX_VERTS, scratch + MAX_VERTS * 2 };
 
-                DrawVertex3D dv = {};
-                dv.rgba[3] = kShadowColorOpacity;
+        entity_t entity;
+        SetupInstance(1, 0, entity);
+        entity.frame    = 0;
+        entity.oldframe = mdl->data.alias_mesh->num_frames - 1;
 
-                // Reuse s_lerped_positions[] from the previous DrawAliasMD2FrameLerp call.
-                Vec3Copy(s_lerped_positions[index_xyz], dv.position);
-                dv.position[0] -= shade_vector[0] * (dv.position[2] + lheight);
-                dv.position[1] -= shade_vector[1] * (dv.position[2] + lheight);
-                dv.position[2] = height;
+        AliasLerpInputs lerp_in;
+        SetupAliasLerp(entity, *mdl->data.alias_mesh, 0.5f, lerp_in);
+        LerpAliasVerts_Scalar(lerp_in, scalar_positions);
+        LerpAliasVerts_SSE2(lerp_in, simd_positions);
 
-                *vertex_ptr++ = dv;
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int i = 0; i < mdl->data.alias_mesh->num_verts; ++i)
+            {
+                max_difference = std::max(max_difference, std::fabs(scalar_positions[c][i] - simd_positions[c][i]));
             }
-
-            EndBatch(batch);
         }
     }
+
+    DeleteArray(out_verts, max_verts * num_threads, MemTag::kRenderer);
+    DeleteArray(scratch, num_threads * 3 * MAX_VERTS, MemTag::kRenderer);
+
+    GameInterface::Printf("alias_bench: %d instances of %d alias models, %d iterations, %d threads",
+                          num_instances, int(models.size()), iterations, num_threads);
+    for (int variant = 0; variant < kNumVariants; ++variant)
+    {
+        GameInterface::Printf("  %s: %.3f ms/frame, %.1fx, %llu verts/frame", variant_names[variant],
+                              variant_us[variant] / 1000.0 / iterations,
+                              double(variant_us[kGLCmds]) / std::max(variant_us[variant], std::uint64_t(1)),
+                              static_cast<unsigned long long>(variant_verts[variant] / iterations));
+    }
+    GameInterface::Printf("  indexed: %llu indexes/frame in static index buffers", static_cast<unsigned long long>(num_indexes / iterations));
+    GameInterface::Printf("  SSE2 vs scalar max difference: %g", double(max_difference));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
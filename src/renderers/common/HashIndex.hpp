@@ -0,0 +1,107 @@
+//
+// HashIndex.hpp
+//  Fixed size open-addressing hash table of pointers, used to index the
+//  texture and model caches by name hash.
+//
+#pragma once
+
+#include "Common.hpp"
+
+namespace MrQ2
+{
+
+//
+// Maps a 32-bit key to pointers owned elsewhere (linear probing).
+//
+// Items with the same key can coexist and are found in insertion order,
+// so a lookup returns the same item as a linear scan of the container the
+// index was built from. There is no single item removal; after erasing from
+// the source container, call Rebuild() to re-index the remaining items.
+//
+// kNumSlots must be a power of two and larger than the number of items.
+//
+template<typename T, std::uint32_t kNumSlots>
+class HashIndex final
+{
+    static_assert((kNumSlots & (kNumSlots - 1)) == 0, "HashIndex size must be a power of two!");
+
+public:
+
+    HashIndex() { Clear(); }
+
+    // Disallow copy.
+    HashIndex(const HashIndex &) = delete;
+    HashIndex & operator=(const HashIndex &) = delete;
+
+    void Clear()
+    {
+        std::memset(m_slots, 0, sizeof(m_slots));
+        m_count = 0;
+    }
+
+    void Insert(const std::uint32_t key, T * const item)
+    {
+        MRQ2_ASSERT(item != nullptr);
+        MRQ2_ASSERT(m_count < kNumSlots - 1); // Always keep an empty slot to end the probing.
+
+        std::uint32_t slot = SlotForKey(key);
+        while (m_slots[slot].item != nullptr)
+        {
+            slot = (slot + 1) & (kNumSlots - 1);
+        }
+
+        m_slots[slot].key  = key;
+        m_slots[slot].item = item;
+        ++m_count;
+    }
+
+    // First item inserted with this key that also satisfies predicate(const T &), null if none.
+    template<typename Pred>
+    T * Find(const std::uint32_t key, Pred && predicate) const
+    {
+        for (std::uint32_t slot = SlotForKey(key); m_slots[slot].item != nullptr; slot = (slot + 1) & (kNumSlots - 1))
+        {
+            if (m_slots[slot].key == key && predicate(*m_slots[slot].item))
+            {
+                return m_slots[slot].item;
+            }
+        }
+        return nullptr;
+    }
+
+    // Re-index all items of a container of T* in iteration order. key_func(const T &) returns the key.
+    template<typename Container, typename KeyFunc>
+    void Rebuild(const Container & items, KeyFunc && key_func)
+    {
+        Clear();
+        for (T * item : items)
+        {
+            Insert(key_func(*item), item);
+        }
+    }
+
+    std::uint32_t Size() const { return m_count; }
+    static constexpr std::uint32_t Capacity() { return kNumSlots; }
+
+private:
+
+    static std::uint32_t SlotForKey(std::uint32_t key)
+    {
+        // Keys are usually FNV hashes already; mix them a bit more so nearby keys spread out.
+        key ^= key >> 16;
+        key *= 0x85EBCA6B;
+        key ^= key >> 13;
+        return key & (kNumSlots - 1);
+    }
+
+    struct Slot
+    {
+        std::uint32_t key;
+        T *           item;
+    };
+
+    Slot          m_slots[kNumSlots];
+    std::uint32_t m_count;
+};
+
+} // MrQ2
@@ -206,6 +206,99 @@ private:
     VertexBuffer m_vertex_buffers[kNumBuffers] = {};
 };
 
+/*
+===============================================================================
+
+    IndexBuffers
+    - Multiple index buffers rewritten every frame.
+
+===============================================================================
+*/
+template<typename IndexType>
+class IndexBuffers final
+{
+public:
+
+    static_assert(sizeof(IndexType) == sizeof(uint16_t) || sizeof(IndexType) == sizeof(uint32_t), "Unsupported index type!");
+    static constexpr uint32_t kNumBuffers = RenderInterface::kNumFrameBuffers;
+
+    IndexBuffers() = default;
+
+    void Init(const RenderDevice & device, const uint32_t max_indexes)
+    {
+        MRQ2_ASSERT(max_indexes != 0);
+        m_max_indexes = max_indexes;
+
+        const uint32_t buffer_size_in_bytes = sizeof(IndexType) * m_max_indexes;
+        const auto format = (sizeof(IndexType) == sizeof(uint16_t)) ? IndexBuffer::kFormatUInt16 : IndexBuffer::kFormatUInt32;
+
+        for (uint32_t b = 0; b < kNumBuffers; ++b)
+        {
+            if (!m_index_buffers[b].Init(device, buffer_size_in_bytes, format))
+            {
+                GameInterface::Errorf("Failed to create index buffer %u", b);
+            }
+        }
+
+        MemTagsTrackAlloc(buffer_size_in_bytes * kNumBuffers, MemTag::kVertIndexBuffer);
+        GameInterface::Printf("IndexBuffers used memory: %s", FormatMemoryUnit(buffer_size_in_bytes * kNumBuffers));
+    }
+
+    void Shutdown()
+    {
+        m_max_indexes  = 0;
+        m_buffer_index = 0;
+        m_is_mapped    = false;
+
+        for (uint32_t b = 0; b < kNumBuffers; ++b)
+        {
+            MemTagsTrackFree(m_index_buffers[b].SizeInBytes(), MemTag::kVertIndexBuffer);
+            m_index_buffers[b].Shutdown();
+        }
+    }
+
+    uint32_t BufferSize() const
+    {
+        return m_max_indexes;
+    }
+
+    // Map the current buffer for writing up to BufferSize() indexes.
+    IndexType * Map()
+    {
+        MRQ2_ASSERT(!m_is_mapped); // Missing Unmap()?
+
+        void * const memory = m_index_buffers[m_buffer_index].Map();
+        if (memory == nullptr)
+        {
+            GameInterface::Errorf("Failed to map index buffer %u", m_buffer_index);
+        }
+
+        m_is_mapped = true;
+        return static_cast<IndexType *>(memory);
+    }
+
+    // Unmap the current buffer and move to the next one. Returns the buffer to draw with.
+    const IndexBuffer & Unmap()
+    {
+        MRQ2_ASSERT(m_is_mapped); // Missing Map()?
+
+        IndexBuffer & current_buffer = m_index_buffers[m_buffer_index];
+        current_buffer.Unmap();
+        m_is_mapped = false;
+
+        m_buffer_index = (m_buffer_index + 1) % kNumBuffers;
+        return current_buffer;
+    }
+
+private:
+
+    uint32_t m_max_indexes{ 0 };
+    uint32_t m_buffer_index{ 0 };
+    bool     m_is_mapped{ false };
+
+    IndexBuffer m_index_buffers[kNumBuffers] = {};
+};
+
 /*
 ===============================================================================
 
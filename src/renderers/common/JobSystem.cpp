@@ -0,0 +1,180 @@
+//
+// JobSystem.cpp
+//  Minimal pool of worker threads for data-parallel renderer work.
+//
+
+#include "JobSystem.hpp"
+#include "OptickProfiler.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace MrQ2
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// Shared state between the workers and the thread issuing the jobs:
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    std::thread             s_workers[JobSystem::kMaxThreads];
+    std::mutex              s_mutex;
+    std::condition_variable s_work_available;
+    std::condition_variable s_work_done;
+
+    // Protected by s_mutex:
+    std::uint32_t           s_batch_generation{ 0 };
+    int                     s_workers_busy{ 0 };
+    bool                    s_quit{ false };
+
+    // Current batch, published before bumping s_batch_generation:
+    JobSystem::JobFunc      s_job_func{ nullptr };
+    void *                  s_job_user_data{ nullptr };
+    int                     s_num_jobs{ 0 };
+    std::atomic<int>        s_next_job{ 0 };
+} // anonymous
+
+///////////////////////////////////////////////////////////////////////////////
+// JobSystem
+///////////////////////////////////////////////////////////////////////////////
+
+int JobSystem::sm_num_workers{ 0 };
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Init(int num_workers)
+{
+    MRQ2_ASSERT(sm_num_workers == 0);
+
+    if (num_workers < 0)
+    {
+        num_workers = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    }
+    num_workers = std::min(std::max(num_workers, 0), kMaxThreads - 1);
+
+    s_quit = false;
+    s_batch_generation = 0;
+    s_workers_busy = 0;
+
+    for (int w = 0; w < num_workers; ++w)
+    {
+        s_workers[w] = std::thread{ &JobSystem::WorkerThreadMain, w + 1 };
+    }
+    sm_num_workers = num_workers;
+
+    GameInterface::Printf("JobSystem initialized with %i worker threads.", num_workers);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock{ s_mutex };
+        s_quit = true;
+    }
+    s_work_available.notify_all();
+
+    for (int w = 0; w < sm_num_workers; ++w)
+    {
+        s_workers[w].join();
+    }
+    sm_num_workers = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::ParallelFor(const int num_jobs, JobFunc job_func, void * user_data)
+{
+    MRQ2_ASSERT(job_func != nullptr);
+
+    if (num_jobs <= 0)
+    {
+        return;
+    }
+
+    // Not worth waking up the workers for a single job.
+    if (sm_num_workers == 0 || num_jobs == 1)
+    {
+        for (int j = 0; j < num_jobs; ++j)
+        {
+            job_func(user_data, j, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ s_mutex };
+        MRQ2_ASSERT(s_workers_busy == 0); // Not reentrant.
+
+        s_job_func      = job_func;
+        s_job_user_data = user_data;
+        s_num_jobs      = num_jobs;
+        s_next_job.store(0, std::memory_order_relaxed);
+        s_workers_busy  = sm_num_workers;
+        ++s_batch_generation;
+    }
+    s_work_available.notify_all();
+
+    // Help out while waiting.
+    RunJobs(0);
+
+    std::unique_lock<std::mutex> lock{ s_mutex };
+    s_work_done.wait(lock, []() { return s_workers_busy == 0; });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::RunJobs(const int thread_index)
+{
+    for (;;)
+    {
+        const int job_index = s_next_job.fetch_add(1, std::memory_order_relaxed);
+        if (job_index >= s_num_jobs)
+        {
+            break;
+        }
+        s_job_func(s_job_user_data, job_index, thread_index);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::WorkerThreadMain(const int thread_index)
+{
+    OPTICK_THREAD("RendererWorker");
+
+    std::uint32_t last_generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ s_mutex };
+            s_work_available.wait(lock, [last_generation]() { return s_quit || s_batch_generation != last_generation; });
+
+            if (s_quit)
+            {
+                return;
+            }
+            last_generation = s_batch_generation;
+        }
+
+        RunJobs(thread_index);
+
+        bool last_one_done;
+        {
+            std::lock_guard<std::mutex> lock{ s_mutex };
+            last_one_done = (--s_workers_busy == 0);
+        }
+        if (last_one_done)
+        {
+            s_work_done.notify_one();
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // MrQ2
@@ -0,0 +1,49 @@
+//
+// JobSystem.hpp
+//  Minimal pool of worker threads for data-parallel renderer work.
+//
+#pragma once
+
+#include "Common.hpp"
+
+namespace MrQ2
+{
+
+/*
+===============================================================================
+
+    JobSystem
+
+===============================================================================
+*/
+class JobSystem final
+{
+public:
+
+    // Upper bound for the number of threads, including the calling (main) thread.
+    static constexpr int kMaxThreads = 16;
+
+    // Job callback. thread_index is in [0, NumThreads()), with the calling thread always being index 0,
+    // so it can be used to select per-thread scratch data without any locking.
+    using JobFunc = void (*)(void * user_data, int job_index, int thread_index);
+
+    // num_workers < 0 selects one worker per available hardware thread minus the calling thread.
+    static void Init(int num_workers);
+    static void Shutdown();
+
+    // Workers + the calling thread.
+    static int NumThreads() { return sm_num_workers + 1; }
+
+    // Runs job_func for every job index in [0, num_jobs). The calling thread takes part
+    // in the work and only returns after all jobs have completed. Not reentrant.
+    static void ParallelFor(int num_jobs, JobFunc job_func, void * user_data);
+
+private:
+
+    static void WorkerThreadMain(int thread_index);
+    static void RunJobs(int thread_index);
+
+    static int sm_num_workers;
+};
+
+} // MrQ2
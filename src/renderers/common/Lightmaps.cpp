@@ -8,6 +8,7 @@
 #include "ModelStructs.hpp"
 #include "ImmediateModeBatching.hpp"
 #include "OptickProfiler.hpp"
+#include <emmintrin.h>
 
 // Quake includes
 #include "common/q_common.h"
@@ -18,8 +19,149 @@ namespace MrQ2
 {
 
 ///////////////////////////////////////////////////////////////////////////////
+// Lightmap building kernels:
+//
+// The light block stores 3 floats (RGB) per luxel. The SSE2 versions process
+// 4 luxels (3 vectors) at a time and return the number of luxels consumed,
+// the caller finishes the remainder with the scalar version. Both paths
+// produce the exact same results (r_lightmap_simd 0 selects scalar only).
+///////////////////////////////////////////////////////////////////////////////
+
+// Splits 4 interleaved RGB luxels (x0=r0g0b0r1, x1=g1b1r2g2, x2=b2r3g3b3) into R, G and B vectors.
+static inline void DeinterleaveRGB(const __m128 x0, const __m128 x1, const __m128 x2, __m128 & r, __m128 & g, __m128 & b)
+{
+    const __m128 r23 = _mm_shuffle_ps(x1, x2, _MM_SHUFFLE(1, 1, 2, 2));
+    r = _mm_shuffle_ps(x0, r23, _MM_SHUFFLE(2, 0, 3, 0));
+
+    const __m128 g01 = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(0, 0, 1, 1));
+    const __m128 g23 = _mm_shuffle_ps(x1, x2, _MM_SHUFFLE(2, 2, 3, 3));
+    g = _mm_shuffle_ps(g01, g23, _MM_SHUFFLE(2, 0, 2, 0));
+
+    const __m128 b01 = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(1, 1, 2, 2));
+    const __m128 b23 = _mm_shuffle_ps(x2, x2, _MM_SHUFFLE(3, 3, 0, 0));
+    b = _mm_shuffle_ps(b01, b23, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void AddLightStyle(float * light_block_ptr, const std::uint8_t * lightmap, const int num_luxels, const vec3_t scale)
+{
+    for (int i = 0; i < num_luxels; i++, light_block_ptr += 3)
+    {
+        light_block_ptr[0] += lightmap[i * 3 + 0] * scale[0];
+        light_block_ptr[1] += lightmap[i * 3 + 1] * scale[1];
+        light_block_ptr[2] += lightmap[i * 3 + 2] * scale[2];
+    }
+}
+
+static int AddLightStyleSSE2(float * light_block_ptr, const std::uint8_t * lightmap, const int num_luxels, const vec3_t scale)
+{
+    const __m128 scale0 = _mm_setr_ps(scale[0], scale[1], scale[2], scale[0]);
+    const __m128 scale1 = _mm_setr_ps(scale[1], scale[2], scale[0], scale[1]);
+    const __m128 scale2 = _mm_setr_ps(scale[2], scale[0], scale[1], scale[2]);
+    const __m128i zero  = _mm_setzero_si128();
+
+    int i = 0;
+    for (; (i + 4) <= num_luxels; i += 4, lightmap += 12, light_block_ptr += 12)
+    {
+        // Load exactly 12 bytes, the samples are tightly packed in the BSP light data.
+        std::int32_t last_bytes;
+        std::memcpy(&last_bytes, lightmap + 8, sizeof(last_bytes));
+
+        const __m128i lo16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(lightmap)), zero);
+        const __m128i hi16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(last_bytes), zero);
+
+        const __m128 v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero));
+        const __m128 v1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero));
+        const __m128 v2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero));
+
+        _mm_storeu_ps(light_block_ptr + 0, _mm_add_ps(_mm_loadu_ps(light_block_ptr + 0), _mm_mul_ps(v0, scale0)));
+        _mm_storeu_ps(light_block_ptr + 4, _mm_add_ps(_mm_loadu_ps(light_block_ptr + 4), _mm_mul_ps(v1, scale1)));
+        _mm_storeu_ps(light_block_ptr + 8, _mm_add_ps(_mm_loadu_ps(light_block_ptr + 8), _mm_mul_ps(v2, scale2)));
+    }
+
+    return i;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// One row of luxels for a dynamic light, starting at fsacc.
+static void AddDynamicLightRow(float * light_block_ptr, const int num_luxels, float fsacc, const float local_s, const int td,
+                               const float frad, const float fminlight, const vec3_t color)
+{
+    for (int s = 0; s < num_luxels; s++, fsacc += 16, light_block_ptr += 3)
+    {
+        int sd = static_cast<int>(local_s - fsacc);
+
+        if (sd < 0)
+            sd = -sd;
+
+        float fdist;
+        if (sd > td)
+            fdist = sd + (td >> 1);
+        else
+            fdist = td + (sd >> 1);
+
+        if (fdist < fminlight)
+        {
+            light_block_ptr[0] += (frad - fdist) * color[0];
+            light_block_ptr[1] += (frad - fdist) * color[1];
+            light_block_ptr[2] += (frad - fdist) * color[2];
+        }
+    }
+}
+
+static int AddDynamicLightRowSSE2(float * light_block_ptr, const int num_luxels, const float local_s, const int td,
+                                  const float frad, const float fminlight, const vec3_t color)
+{
+    const __m128 sign_mask   = _mm_set1_ps(-0.0f);
+    const __m128 half        = _mm_set1_ps(0.5f);
+    const __m128 td_v        = _mm_set1_ps(static_cast<float>(td));
+    const __m128 td_half_v   = _mm_set1_ps(static_cast<float>(td >> 1));
+    const __m128 frad_v      = _mm_set1_ps(frad);
+    const __m128 fminlight_v = _mm_set1_ps(fminlight);
+    const __m128 color0      = _mm_setr_ps(color[0], color[1], color[2], color[0]);
+    const __m128 color1      = _mm_setr_ps(color[1], color[2], color[0], color[1]);
+    const __m128 color2      = _mm_setr_ps(color[2], color[0], color[1], color[2]);
+
+    __m128 fsacc = _mm_setr_ps(0.0f, 16.0f, 32.0f, 48.0f);
+    const __m128 fsacc_step = _mm_set1_ps(64.0f);
+
+    int s = 0;
+    for (; (s + 4) <= num_luxels; s += 4, light_block_ptr += 12)
+    {
+        // Integer math of the scalar version, done with floats since all values are small integers.
+        const __m128 sd      = _mm_andnot_ps(sign_mask, _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_sub_ps(_mm_set1_ps(local_s), fsacc))));
+        const __m128 sd_half = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(sd, half)));
+        const __m128 sd_gt   = _mm_cmpgt_ps(sd, td_v);
+        const __m128 fdist   = _mm_or_ps(_mm_and_ps(sd_gt, _mm_add_ps(sd, td_half_v)), _mm_andnot_ps(sd_gt, _mm_add_ps(td_v, sd_half)));
+
+        const __m128 in_range = _mm_cmplt_ps(fdist, fminlight_v);
+        fsacc = _mm_add_ps(fsacc, fsacc_step);
+
+        if (_mm_movemask_ps(in_range) == 0)
+        {
+            continue; // All 4 luxels out of range.
+        }
+
+        const __m128 amount = _mm_and_ps(in_range, _mm_sub_ps(frad_v, fdist));
+
+        const __m128 a0 = _mm_shuffle_ps(amount, amount, _MM_SHUFFLE(1, 0, 0, 0));
+        const __m128 a1 = _mm_shuffle_ps(amount, amount, _MM_SHUFFLE(2, 2, 1, 1));
+        const __m128 a2 = _mm_shuffle_ps(amount, amount, _MM_SHUFFLE(3, 3, 3, 2));
+
+        _mm_storeu_ps(light_block_ptr + 0, _mm_add_ps(_mm_loadu_ps(light_block_ptr + 0), _mm_mul_ps(a0, color0)));
+        _mm_storeu_ps(light_block_ptr + 4, _mm_add_ps(_mm_loadu_ps(light_block_ptr + 4), _mm_mul_ps(a1, color1)));
+        _mm_storeu_ps(light_block_ptr + 8, _mm_add_ps(_mm_loadu_ps(light_block_ptr + 8), _mm_mul_ps(a2, color2)));
+    }
+
+    return s;
+}
 
-static void AddDynamicLights(float dest_light_block[kLightBlockSize], const ModelSurface * surf, const int num_dlights, const dlight_t * dlights)
+///////////////////////////////////////////////////////////////////////////////
+
+static void AddDynamicLights(float dest_light_block[kLightBlockSize], const ModelSurface * surf, const int num_dlights,
+                             const dlight_t * dlights, const bool use_simd)
 {
     // Add dynamic lights contribution to the lightmaps.
 
@@ -37,7 +179,7 @@ static void AddDynamicLights(float dest_light_block[kLightBlockSize], const Mode
         const dlight_t * dl = &dlights[lnum];
         float frad  = dl->intensity;
         float fdist = Vec3Dot(dl->origin, surf->plane->normal) - surf->plane->dist;
-        frad -= std::fabsf(fdist); // rad is now the highest intensity on the plane
+        frad -= std::fabs(fdist); // rad is now the highest intensity on the plane
 
         float fminlight = kDLightCutoff; // make configurable?
         if (frad < fminlight)
@@ -57,94 +199,134 @@ static void AddDynamicLights(float dest_light_block[kLightBlockSize], const Mode
         local[0] = Vec3Dot(impact, tex->vecs[0]) + tex->vecs[0][3] - surf->texture_mins[0];
         local[1] = Vec3Dot(impact, tex->vecs[1]) + tex->vecs[1][3] - surf->texture_mins[1];
 
-        int t, s;
-        float fsacc, ftacc;
+        int t;
+        float ftacc;
         float * light_block_ptr = dest_light_block;
 
-        for (t = 0, ftacc = 0; t < tmax; t++, ftacc += 16)
+        for (t = 0, ftacc = 0; t < tmax; t++, ftacc += 16, light_block_ptr += smax * 3)
         {
             int td = local[1] - ftacc;
             if (td < 0)
                 td = -td;
 
-            for (s = 0, fsacc = 0; s < smax; s++, fsacc += 16, light_block_ptr += 3)
+            int s = 0;
+            if (use_simd)
             {
-                int sd = static_cast<int>(local[0] - fsacc);
-
-                if (sd < 0)
-                    sd = -sd;
+                s = AddDynamicLightRowSSE2(light_block_ptr, smax, local[0], td, frad, fminlight, dl->color);
+            }
+            AddDynamicLightRow(light_block_ptr + s * 3, smax - s, s * 16.0f, local[0], td, frad, fminlight, dl->color);
+        }
+    }
+}
 
-                if (sd > td)
-                    fdist = sd + (td >> 1);
-                else
-                    fdist = td + (sd >> 1);
+///////////////////////////////////////////////////////////////////////////////
 
-                if (fdist < fminlight)
-                {
-                    light_block_ptr[0] += (frad - fdist) * dl->color[0];
-                    light_block_ptr[1] += (frad - fdist) * dl->color[1];
-                    light_block_ptr[2] += (frad - fdist) * dl->color[2];
-                }
-            }
+static void StoreLightmapRow(std::uint8_t * dest, const float * light_block_ptr, const int num_luxels)
+{
+    for (int j = 0; j < num_luxels; j++)
+    {
+        int r = static_cast<int>(light_block_ptr[0]);
+        int g = static_cast<int>(light_block_ptr[1]);
+        int b = static_cast<int>(light_block_ptr[2]);
+
+        // catch negative lights
+        if (r < 0)
+            r = 0;
+        if (g < 0)
+            g = 0;
+        if (b < 0)
+            b = 0;
+
+        // determine the brightest of the three color components
+        int max;
+        if (r > g)
+            max = r;
+        else
+            max = g;
+        if (b > max)
+            max = b;
+
+        // alpha is ONLY used for the mono lightmap case. For this reason
+        // we set it to the brightest of the color components so that
+        // things don't get too dim.
+        int a = max;
+
+        // rescale all the color components if the intensity of the greatest
+        // channel exceeds 1.0
+        if (max > 255)
+        {
+            const float t = 255.0f / max;
+            r = r * t;
+            g = g * t;
+            b = b * t;
+            a = a * t;
         }
+
+        dest[0] = static_cast<std::uint8_t>(r);
+        dest[1] = static_cast<std::uint8_t>(g);
+        dest[2] = static_cast<std::uint8_t>(b);
+        dest[3] = static_cast<std::uint8_t>(a);
+
+        light_block_ptr += 3;
+        dest += 4;
+    }
+}
+
+static int StoreLightmapRowSSE2(std::uint8_t * dest, const float * light_block_ptr, const int num_luxels)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one  = _mm_set1_ps(1.0f);
+    const __m128 k255 = _mm_set1_ps(255.0f);
+
+    int j = 0;
+    for (; (j + 4) <= num_luxels; j += 4, light_block_ptr += 12, dest += 16)
+    {
+        __m128 r, g, b;
+        DeinterleaveRGB(_mm_loadu_ps(light_block_ptr), _mm_loadu_ps(light_block_ptr + 4), _mm_loadu_ps(light_block_ptr + 8), r, g, b);
+
+        // Truncate to integer and catch negative lights.
+        r = _mm_max_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(r)), zero);
+        g = _mm_max_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(g)), zero);
+        b = _mm_max_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(b)), zero);
+
+        // Rescale by the brightest component if it exceeds 1.0, alpha is the brightest component.
+        const __m128 max   = _mm_max_ps(_mm_max_ps(r, g), b);
+        const __m128 over  = _mm_cmpgt_ps(max, k255);
+        const __m128 scale = _mm_or_ps(_mm_and_ps(over, _mm_div_ps(k255, max)), _mm_andnot_ps(over, one));
+
+        const __m128i ri = _mm_cvttps_epi32(_mm_mul_ps(r, scale));
+        const __m128i gi = _mm_cvttps_epi32(_mm_mul_ps(g, scale));
+        const __m128i bi = _mm_cvttps_epi32(_mm_mul_ps(b, scale));
+        const __m128i ai = _mm_cvttps_epi32(_mm_mul_ps(max, scale));
+
+        // All components are in [0,255], so they can be packed with shifts.
+        const __m128i rgba = _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)),
+                                          _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_slli_epi32(ai, 24)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), rgba);
     }
+
+    return j;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static void StoreLightmap(std::uint8_t * dest, const int stride, const int smax, const int tmax, const float light_block[kLightBlockSize])
+static void StoreLightmap(std::uint8_t * dest, const int stride, const int smax, const int tmax, const float light_block[kLightBlockSize],
+                          const bool use_simd)
 {
     const float * light_block_ptr = light_block;
 
     for (int i = 0; i < tmax; i++, dest += stride)
     {
-        for (int j = 0; j < smax; j++)
+        int j = 0;
+        if (use_simd)
         {
-            int r = static_cast<int>(light_block_ptr[0]);
-            int g = static_cast<int>(light_block_ptr[1]);
-            int b = static_cast<int>(light_block_ptr[2]);
-
-            // catch negative lights
-            if (r < 0)
-                r = 0;
-            if (g < 0)
-                g = 0;
-            if (b < 0)
-                b = 0;
-
-            // determine the brightest of the three color components
-            int max;
-            if (r > g)
-                max = r;
-            else
-                max = g;
-            if (b > max)
-                max = b;
-
-            // alpha is ONLY used for the mono lightmap case. For this reason
-            // we set it to the brightest of the color components so that
-            // things don't get too dim.
-            int a = max;
-
-            // rescale all the color components if the intensity of the greatest
-            // channel exceeds 1.0
-            if (max > 255)
-            {
-                const float t = 255.0f / max;
-                r = r * t;
-                g = g * t;
-                b = b * t;
-                a = a * t;
-            }
-
-            dest[0] = static_cast<std::uint8_t>(r);
-            dest[1] = static_cast<std::uint8_t>(g);
-            dest[2] = static_cast<std::uint8_t>(b);
-            dest[3] = static_cast<std::uint8_t>(a);
-
-            light_block_ptr += 3;
-            dest += 4;
+            j = StoreLightmapRowSSE2(dest, light_block_ptr, smax);
         }
+        StoreLightmapRow(dest + j * 4, light_block_ptr + j * 3, smax - j);
+
+        light_block_ptr += smax * 3;
+        dest += smax * 4;
     }
 }
 
@@ -152,7 +334,8 @@ static void StoreLightmap(std::uint8_t * dest, const int stride, const int smax,
 
 static void BuildLightmap(std::uint8_t * dest, const int stride,
                           const int frame_num, const float lmap_modulate, const ModelSurface * surf,
-                          const int num_dlights, const dlight_t * dlights, const lightstyle_t * lightstyles)
+                          const int num_dlights, const dlight_t * dlights, const lightstyle_t * lightstyles,
+                          const bool use_simd)
 {
     // Combine and scale multiple lightmaps into the floating format in light_block[]
     // then store into the RGBA_U8 texture buffer.
@@ -167,7 +350,7 @@ static void BuildLightmap(std::uint8_t * dest, const int stride,
     const int size = smax * tmax;
 
     float light_block[kLightBlockSize] = {};
-    if (size > (sizeof(light_block) >> 4))
+    if (size > int(sizeof(light_block) >> 4))
     {
         GameInterface::Errorf("Bad lightmap block size!");
     }
@@ -180,7 +363,7 @@ static void BuildLightmap(std::uint8_t * dest, const int stride,
             light_block[i] = 255.0f;
         }
 
-        StoreLightmap(dest, stride - (smax << 2), smax, tmax, light_block);
+        StoreLightmap(dest, stride - (smax << 2), smax, tmax, light_block, use_simd);
     }
     else
     {
@@ -196,13 +379,12 @@ static void BuildLightmap(std::uint8_t * dest, const int stride,
                 scale[i] = lmap_modulate * lightstyles[surf->styles[lmap]].rgb[i];
             }
 
-            float * light_block_ptr = light_block;
-            for (int i = 0; i < size; i++, light_block_ptr += 3)
+            int i = 0;
+            if (use_simd)
             {
-                light_block_ptr[0] += lightmap[i * 3 + 0] * scale[0];
-                light_block_ptr[1] += lightmap[i * 3 + 1] * scale[1];
-                light_block_ptr[2] += lightmap[i * 3 + 2] * scale[2];
+                i = AddLightStyleSSE2(light_block, lightmap, size, scale);
             }
+            AddLightStyle(light_block + i * 3, lightmap + i * 3, size - i, scale);
 
             lightmap += size * 3; // Skip to next lightmap
         }
@@ -210,11 +392,11 @@ static void BuildLightmap(std::uint8_t * dest, const int stride,
         // Add all the dynamic lights
         if ((surf->dlight_frame == frame_num) && (num_dlights > 0))
         {
-            AddDynamicLights(light_block, surf, num_dlights, dlights);
+            AddDynamicLights(light_block, surf, num_dlights, dlights, use_simd);
         }
 
         // Put into texture format
-        StoreLightmap(dest, stride - (smax << 2), smax, tmax, light_block);
+        StoreLightmap(dest, stride - (smax << 2), smax, tmax, light_block, use_simd);
     }
 }
 
@@ -231,10 +413,10 @@ static inline void SetSurfaceCachedLightingInfo(ModelSurface * surf, const light
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline void ClearTexture(LmImageBuffer * buff)
+static inline void ClearTexture(ColorRGBA32 * buff, const int page_size)
 {
     // Clear to white
-    std::memset(buff, 0xFF, sizeof(LmImageBuffer));
+    std::memset(buff, 0xFF, page_size * page_size * sizeof(ColorRGBA32));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -245,16 +427,18 @@ static inline void ClearTexture(LmImageBuffer * buff)
 int                  LightmapManager::sm_static_lightmap_updates{ 0 };
 int                  LightmapManager::sm_dynamic_lightmap_updates{ 0 };
 int                  LightmapManager::sm_num_lightmaps_buffers{ 0 };
+int                  LightmapManager::sm_lightmap_upload_bytes{ 0 };
 int                  LightmapManager::sm_lightmap_count{ 0 };
+int                  LightmapManager::sm_page_size{ kMinLightmapTextureSize };
 TextureStore *       LightmapManager::sm_tex_store{ nullptr };
 const TextureImage * LightmapManager::sm_static_lightmaps[kMaxLightmapTextures] = {};
 const TextureImage * LightmapManager::sm_dynamic_lightmaps[kMaxLightmapTextures] = {};
-LmImageBuffer *      LightmapManager::sm_static_lightmap_buffers[kMaxLightmapTextures] = {};
-LmImageBuffer *      LightmapManager::sm_dynamic_lightmap_buffers[kMaxLightmapTextures] = {};
-bool                 LightmapManager::sm_dirtied_static_lightmaps[kMaxLightmapTextures] = {};
-bool                 LightmapManager::sm_dirtied_dynamic_lightmaps[kMaxLightmapTextures] = {};
-LmImageBufferPool    LightmapManager::sm_lightmap_buffer_pool{ MemTag::kLightmaps };
-int                  LightmapManager::sm_allocated_blocks[kLightmapTextureWidth] = {};
+ColorRGBA32 *        LightmapManager::sm_static_lightmap_buffers[kMaxLightmapTextures] = {};
+ColorRGBA32 *        LightmapManager::sm_dynamic_lightmap_buffers[kMaxLightmapTextures] = {};
+LmDirtyRect          LightmapManager::sm_dirtied_static_lightmaps[kMaxLightmapTextures] = {};
+LmDirtyRect          LightmapManager::sm_dirtied_dynamic_lightmaps[kMaxLightmapTextures] = {};
+AtlasPacker          LightmapManager::sm_block_packer;
+float                LightmapManager::sm_lightmap_occupancy[kMaxLightmapTextures] = {};
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -272,13 +456,17 @@ void LightmapManager::Shutdown()
         sm_static_lightmaps[lmap]  = nullptr;
         sm_dynamic_lightmaps[lmap] = nullptr;
 
+        FreeBuffer(sm_static_lightmap_buffers[lmap]);
+        FreeBuffer(sm_dynamic_lightmap_buffers[lmap]);
         sm_static_lightmap_buffers[lmap]  = nullptr;
         sm_dynamic_lightmap_buffers[lmap] = nullptr;
+
+        sm_dirtied_static_lightmaps[lmap].Clear();
+        sm_dirtied_dynamic_lightmaps[lmap].Clear();
     }
 
     sm_tex_store = nullptr;
     sm_lightmap_count = 0;
-    sm_lightmap_buffer_pool.Drain();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -287,7 +475,8 @@ void LightmapManager::Update()
 {
     OPTICK_EVENT();
 
-    auto UploadLightmap = [](const TextureImage * lightmap_tex)
+    // Uploads just the dirty rectangle; the backends read it out of the whole CPU-side image.
+    auto UploadLightmap = [](const TextureImage * lightmap_tex, LmDirtyRect & dirty_rect)
     {
         const ColorRGBA32 * pixels[] = { lightmap_tex->BasePixels() };
         const Vec2u16 dimensions = lightmap_tex->MipMapDimensions(0);
@@ -298,31 +487,35 @@ void LightmapManager::Update()
         upload_info.mipmaps.num_mip_levels = 1;
         upload_info.mipmaps.mip_init_data  = pixels;
         upload_info.mipmaps.mip_dimensions = &dimensions;
+        upload_info.region.x      = dirty_rect.x0;
+        upload_info.region.y      = dirty_rect.y0;
+        upload_info.region.width  = dirty_rect.Width();
+        upload_info.region.height = dirty_rect.Height();
         sm_tex_store->Device().UploadContext().UploadTexture(upload_info);
+
+        sm_lightmap_upload_bytes += dirty_rect.Width() * dirty_rect.Height() * kLightmapBytesPerPixel;
+        dirty_rect.Clear();
     };
 
     sm_dynamic_lightmap_updates = 0;
     sm_static_lightmap_updates  = 0;
-    sm_num_lightmaps_buffers    = sm_lightmap_buffer_pool.BlockCount() * sm_lightmap_buffer_pool.PoolGranularity();
+    sm_lightmap_upload_bytes    = 0;
+    sm_num_lightmaps_buffers    = sm_lightmap_count * 2;
 
     for (int lmap = 0; lmap < sm_lightmap_count; ++lmap)
     {
-        if (sm_dirtied_dynamic_lightmaps[lmap])
+        if (!sm_dirtied_dynamic_lightmaps[lmap].IsEmpty())
         {
-            sm_dirtied_dynamic_lightmaps[lmap] = false;
-
             auto * dynamic_lightmap_tex = sm_dynamic_lightmaps[lmap];
-            UploadLightmap(dynamic_lightmap_tex);
+            UploadLightmap(dynamic_lightmap_tex, sm_dirtied_dynamic_lightmaps[lmap]);
 
             ++sm_dynamic_lightmap_updates;
         }
 
-        if (sm_dirtied_static_lightmaps[lmap])
+        if (!sm_dirtied_static_lightmaps[lmap].IsEmpty())
         {
-            sm_dirtied_static_lightmaps[lmap] = false;
-
             auto * static_lightmap_tex = sm_static_lightmaps[lmap];
-            UploadLightmap(static_lightmap_tex);
+            UploadLightmap(static_lightmap_tex, sm_dirtied_static_lightmaps[lmap]);
 
             ++sm_static_lightmap_updates;
         }
@@ -352,17 +545,10 @@ void LightmapManager::BeginRegistration(const char * const map_name)
             sm_static_lightmaps[lmap]  = nullptr;
             sm_dynamic_lightmaps[lmap] = nullptr;
 
-            if (sm_static_lightmap_buffers[lmap] != nullptr)
-            {
-                sm_lightmap_buffer_pool.Deallocate(sm_static_lightmap_buffers[lmap]);
-                sm_static_lightmap_buffers[lmap] = nullptr;
-            }
-
-            if (sm_dynamic_lightmap_buffers[lmap] != nullptr)
-            {
-                sm_lightmap_buffer_pool.Deallocate(sm_dynamic_lightmap_buffers[lmap]);
-                sm_dynamic_lightmap_buffers[lmap] = nullptr;
-            }
+            FreeBuffer(sm_static_lightmap_buffers[lmap]);
+            FreeBuffer(sm_dynamic_lightmap_buffers[lmap]);
+            sm_static_lightmap_buffers[lmap]  = nullptr;
+            sm_dynamic_lightmap_buffers[lmap] = nullptr;
         }
 
         sm_lightmap_count = 0;
@@ -395,18 +581,46 @@ void LightmapManager::EndRegistration()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void LightmapManager::BeginBuildLightmaps()
+void LightmapManager::BeginBuildLightmaps(const int total_block_area)
 {
     MRQ2_ASSERT(sm_tex_store != nullptr);
 
+    // Buffers left by a map that failed to load.
+    for (int lmap = 0; lmap < kMaxLightmapTextures; ++lmap)
+    {
+        FreeBuffer(sm_static_lightmap_buffers[lmap]);
+        FreeBuffer(sm_dynamic_lightmap_buffers[lmap]);
+        sm_static_lightmap_buffers[lmap]  = nullptr;
+        sm_dynamic_lightmap_buffers[lmap] = nullptr;
+    }
+
     sm_lightmap_count = 0;
 
-    // Start lightmap[0]
-    sm_static_lightmap_buffers[0]  = sm_lightmap_buffer_pool.Allocate();
-    sm_dynamic_lightmap_buffers[0] = sm_lightmap_buffer_pool.Allocate();
+    // r_lightmap_page_size 0 picks the smallest page that fits all the light blocks
+    // with some slack for packing losses, so big maps use a few large pages instead
+    // of many small ones. Maps that don't fit even the largest page get several.
+    const int page_size_cvar = Config::r_lightmap_page_size.AsInt();
+    if (page_size_cvar > 0)
+    {
+        sm_page_size = kMinLightmapTextureSize;
+        while (sm_page_size < page_size_cvar && sm_page_size < kMaxLightmapTextureSize)
+        {
+            sm_page_size *= 2;
+        }
+    }
+    else
+    {
+        const std::int64_t needed_area = std::int64_t(total_block_area) * 9 / 8;
+        sm_page_size = kMinLightmapTextureSize;
+        while (std::int64_t(sm_page_size) * sm_page_size < needed_area && sm_page_size < kMaxLightmapTextureSize)
+        {
+            sm_page_size *= 2;
+        }
+    }
 
-    ClearTexture(sm_static_lightmap_buffers[0]);
-    ClearTexture(sm_dynamic_lightmap_buffers[0]);
+    // Start lightmap[0]
+    sm_static_lightmap_buffers[0]  = AllocBuffer();
+    sm_dynamic_lightmap_buffers[0] = AllocBuffer();
 
     ResetBlocks();
 }
@@ -423,49 +637,33 @@ void LightmapManager::FinishBuildLightmaps()
 
 void LightmapManager::ResetBlocks()
 {
-    std::memset(sm_allocated_blocks, 0, sizeof(sm_allocated_blocks));
+    sm_block_packer.Reset(sm_page_size, sm_page_size, AtlasPacker::DefaultHeuristic());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool LightmapManager::AllocBlock(const int w, const int h, int * x, int * y)
+ColorRGBA32 * LightmapManager::AllocBuffer()
 {
-    int best = kLightmapTextureHeight;
-
-    for (int i = 0; i < kLightmapTextureWidth - w; ++i)
-    {
-        int j, best2 = 0;
-
-        for (j = 0; j < w; ++j)
-        {
-            if (sm_allocated_blocks[i + j] >= best)
-            {
-                break;
-            }
-            if (sm_allocated_blocks[i + j] > best2)
-            {
-                best2 = sm_allocated_blocks[i + j];
-            }
-        }
+    auto * buffer = new(MemTag::kLightmaps) ColorRGBA32[sm_page_size * sm_page_size];
+    ClearTexture(buffer, sm_page_size);
+    return buffer;
+}
 
-        if (j == w) // This is a valid spot
-        {
-            *x = i;
-            *y = best = best2;
-        }
-    }
+///////////////////////////////////////////////////////////////////////////////
 
-    if ((best + h) > kLightmapTextureHeight)
+void LightmapManager::FreeBuffer(ColorRGBA32 * const buffer)
+{
+    if (buffer != nullptr)
     {
-        return false;
+        DeleteArray(buffer, sm_page_size * sm_page_size, MemTag::kLightmaps);
     }
+}
 
-    for (int i = 0; i < w; ++i)
-    {
-        sm_allocated_blocks[*x + i] = best + h;
-    }
+///////////////////////////////////////////////////////////////////////////////
 
-    return true;
+bool LightmapManager::AllocBlock(const int w, const int h, int * x, int * y)
+{
+    return sm_block_packer.Alloc(w, h, x, y);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -488,11 +686,13 @@ void LightmapManager::NextLightmapTexture(const bool new_buffers)
 
     // Static
     sprintf_s(name, "static_lightmap_%d", sm_lightmap_count);
-    sm_static_lightmaps[sm_lightmap_count] = sm_tex_store->AllocLightmap(sm_static_lightmap_buffers[sm_lightmap_count]->pixels, kLightmapTextureWidth, kLightmapTextureHeight, name);
+    sm_static_lightmaps[sm_lightmap_count] = sm_tex_store->AllocLightmap(sm_static_lightmap_buffers[sm_lightmap_count], sm_page_size, sm_page_size, name);
 
     // Dynamic
     sprintf_s(name, "dyn_lightmap_%d", sm_lightmap_count);
-    sm_dynamic_lightmaps[sm_lightmap_count] = sm_tex_store->AllocLightmap(sm_dynamic_lightmap_buffers[sm_lightmap_count]->pixels, kLightmapTextureWidth, kLightmapTextureHeight, name);
+    sm_dynamic_lightmaps[sm_lightmap_count] = sm_tex_store->AllocLightmap(sm_dynamic_lightmap_buffers[sm_lightmap_count], sm_page_size, sm_page_size, name);
+
+    sm_lightmap_occupancy[sm_lightmap_count] = sm_block_packer.Occupancy();
 
     // Current lightmap texture is full, start another one.
     if ((++sm_lightmap_count) == kMaxLightmapTextures)
@@ -502,11 +702,8 @@ void LightmapManager::NextLightmapTexture(const bool new_buffers)
 
     if (new_buffers)
     {
-        sm_static_lightmap_buffers[sm_lightmap_count]  = sm_lightmap_buffer_pool.Allocate();
-        sm_dynamic_lightmap_buffers[sm_lightmap_count] = sm_lightmap_buffer_pool.Allocate();
-
-        ClearTexture(sm_static_lightmap_buffers[sm_lightmap_count]);
-        ClearTexture(sm_dynamic_lightmap_buffers[sm_lightmap_count]);
+        sm_static_lightmap_buffers[sm_lightmap_count]  = AllocBuffer();
+        sm_dynamic_lightmap_buffers[sm_lightmap_count] = AllocBuffer();
     }
 }
 
@@ -535,11 +732,11 @@ void LightmapManager::CreateSurfaceLightmap(ModelSurface * surf)
 
     surf->lightmap_texture_num = sm_lightmap_count;
 
-    auto * lm_block = reinterpret_cast<std::uint8_t *>(sm_static_lightmap_buffers[sm_lightmap_count]->pixels);
+    auto * lm_block = reinterpret_cast<std::uint8_t *>(sm_static_lightmap_buffers[sm_lightmap_count]);
     MRQ2_ASSERT(lm_block != nullptr);
 
-    lm_block += (surf->light_t * kLightmapTextureWidth + surf->light_s) * kLightmapBytesPerPixel;
-    const int lm_stride = kLightmapTextureWidth * kLightmapBytesPerPixel;
+    lm_block += (surf->light_t * sm_page_size + surf->light_s) * kLightmapBytesPerPixel;
+    const int lm_stride = sm_page_size * kLightmapBytesPerPixel;
 
     const float lightmap_intensity = Config::r_lightmap_intensity.AsFloat();
 
@@ -558,7 +755,7 @@ void LightmapManager::CreateSurfaceLightmap(ModelSurface * surf)
         lightstyles[i].white  = 3.0f;
     }
 
-    BuildLightmap(lm_block, lm_stride, frame_num, lightmap_intensity, surf, num_dlights, dlights, lightstyles);
+    BuildLightmap(lm_block, lm_stride, frame_num, lightmap_intensity, surf, num_dlights, dlights, lightstyles, Config::r_lightmap_simd.IsSet());
     SetSurfaceCachedLightingInfo(surf, lightstyles);
 }
 
@@ -574,48 +771,166 @@ const TextureImage * LightmapManager::UpdateSurfaceLightmap(const ModelSurface *
     const int smax = (surf->extents[0] >> 4) + 1;
     const int tmax = (surf->extents[1] >> 4) + 1;
 
-    auto * lm_block = reinterpret_cast<std::uint8_t *>(dynamic_lightmap ? sm_dynamic_lightmap_buffers[lightmap_index]->pixels : sm_static_lightmap_buffers[lightmap_index]->pixels);
+    auto * lm_block = reinterpret_cast<std::uint8_t *>(dynamic_lightmap ? sm_dynamic_lightmap_buffers[lightmap_index] : sm_static_lightmap_buffers[lightmap_index]);
     MRQ2_ASSERT(lm_block != nullptr);
 
-    lm_block += (surf->light_t * kLightmapTextureWidth + surf->light_s) * kLightmapBytesPerPixel;
-    const int lm_stride = kLightmapTextureWidth * kLightmapBytesPerPixel;
+    lm_block += (surf->light_t * sm_page_size + surf->light_s) * kLightmapBytesPerPixel;
+    const int lm_stride = sm_page_size * kLightmapBytesPerPixel;
 
-    BuildLightmap(lm_block, lm_stride, frame_num, lightmap_intensity, surf, num_dlights, dlights, lightstyles);
+    BuildLightmap(lm_block, lm_stride, frame_num, lightmap_intensity, surf, num_dlights, dlights, lightstyles, Config::r_lightmap_simd.IsSet());
 
     if (update_surf_cache)
     {
+        // Cached lighting now matches all current styles.
         SetSurfaceCachedLightingInfo(const_cast<ModelSurface *>(surf), lightstyles);
+        const_cast<ModelSurface *>(surf)->dirty_style_slot = -1;
     }
 
     if (dynamic_lightmap)
     {
-        sm_dirtied_dynamic_lightmaps[lightmap_index] = true;
+        sm_dirtied_dynamic_lightmaps[lightmap_index].Add(surf->light_s, surf->light_t, smax, tmax);
         return sm_dynamic_lightmaps[lightmap_index];
     }
     else
     {
-        sm_dirtied_static_lightmaps[lightmap_index] = true;
+        sm_dirtied_static_lightmaps[lightmap_index].Add(surf->light_s, surf->light_t, smax, tmax);
         return sm_static_lightmaps[lightmap_index];
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void LightmapManager::Benchmark(const ModelInstance & world_mdl, const int iterations)
+{
+    MRQ2_ASSERT(iterations > 0);
+
+    // Non-trivial scales so every style layer is accumulated like in game.
+    lightstyle_t lightstyles[MAX_LIGHTSTYLES];
+    for (int i = 0; i < MAX_LIGHTSTYLES; ++i)
+    {
+        lightstyles[i].rgb[0] = 0.5f + (i % 8) * 0.125f;
+        lightstyles[i].rgb[1] = 0.5f + (i % 5) * 0.25f;
+        lightstyles[i].rgb[2] = 0.5f + (i % 3) * 0.5f;
+        lightstyles[i].white  = lightstyles[i].rgb[0] + lightstyles[i].rgb[1] + lightstyles[i].rgb[2];
+    }
+
+    // A single dlight is moved just above each surface for the dynamic pass.
+    dlight_t dlight{};
+    dlight.intensity = 300.0f;
+    dlight.color[0]  = 1.0f;
+    dlight.color[1]  = 0.75f;
+    dlight.color[2]  = 0.5f;
+
+    constexpr int kFrameNum = 1;
+    constexpr int kMaxBlockDim = 34;
+    constexpr int kOutStride = kMaxBlockDim * kLightmapBytesPerPixel;
+    constexpr int kOutSize = kOutStride * kMaxBlockDim;
+
+    const float lightmap_intensity = Config::r_lightmap_intensity.AsFloat();
+    auto * out_scalar = new(MemTag::kRenderer) std::uint8_t[kOutSize];
+    auto * out_simd   = new(MemTag::kRenderer) std::uint8_t[kOutSize];
+
+    auto BuildSurface = [&](const ModelSurface & surf, const bool with_dlight, const bool use_simd, std::uint8_t * out)
+    {
+        ModelSurface surf_copy = surf;
+        int num_dlights = 0;
+
+        if (with_dlight)
+        {
+            const PolyVertex & vert = surf.polys->vertexes[0];
+            for (int i = 0; i < 3; ++i)
+            {
+                dlight.origin[i] = vert.position[i] + surf.plane->normal[i] * 32.0f;
+            }
+            surf_copy.dlight_frame = kFrameNum;
+            surf_copy.dlight_bits  = 1;
+            num_dlights = 1;
+        }
+
+        BuildLightmap(out, kOutStride, kFrameNum, lightmap_intensity, &surf_copy, num_dlights, &dlight, lightstyles, use_simd);
+    };
+
+    auto IsLitSurface = [](const ModelSurface & surf)
+    {
+        return surf.lightmap_texture_num >= 0 && surf.polys != nullptr &&
+               !(surf.texinfo->flags & (SURF_SKY | SURF_TRANS33 | SURF_TRANS66 | SURF_WARP));
+    };
+
+    // Validate first: both paths must produce the same texels.
+    int num_surfaces = 0;
+    int mismatches   = 0;
+    for (int s = 0; s < world_mdl.data.num_surfaces; ++s)
+    {
+        const ModelSurface & surf = world_mdl.data.surfaces[s];
+        if (!IsLitSurface(surf))
+        {
+            continue;
+        }
+
+        for (int with_dlight = 0; with_dlight < 2; ++with_dlight)
+        {
+            std::memset(out_scalar, 0, kOutSize);
+            std::memset(out_simd, 0, kOutSize);
+            BuildSurface(surf, with_dlight != 0, false, out_scalar);
+            BuildSurface(surf, with_dlight != 0, true, out_simd);
+            mismatches += (std::memcmp(out_scalar, out_simd, kOutSize) != 0) ? 1 : 0;
+        }
+        ++num_surfaces;
+    }
+
+    // [with_dlight][use_simd]
+    std::uint64_t timings[2][2] = {};
+    for (int with_dlight = 0; with_dlight < 2; ++with_dlight)
+    {
+        for (int use_simd = 0; use_simd < 2; ++use_simd)
+        {
+            const std::uint64_t start = HighResTimeMicroseconds();
+            for (int it = 0; it < iterations; ++it)
+            {
+                for (int s = 0; s < world_mdl.data.num_surfaces; ++s)
+                {
+                    const ModelSurface & surf = world_mdl.data.surfaces[s];
+                    if (IsLitSurface(surf))
+                    {
+                        BuildSurface(surf, with_dlight != 0, use_simd != 0, use_simd ? out_simd : out_scalar);
+                    }
+                }
+            }
+            timings[with_dlight][use_simd] = HighResTimeMicroseconds() - start;
+        }
+    }
+
+    DeleteArray(out_scalar, kOutSize, MemTag::kRenderer);
+    DeleteArray(out_simd, kOutSize, MemTag::kRenderer);
+
+    auto Millis = [iterations](const std::uint64_t us) { return double(us) / 1000.0 / iterations; };
+    auto Speedup = [](const std::uint64_t scalar_us, const std::uint64_t simd_us) { return double(scalar_us) / std::max(simd_us, std::uint64_t(1)); };
+
+    GameInterface::Printf("Lightmap benchmark: %i surfaces, %i iterations (ms per iteration):", num_surfaces, iterations);
+    GameInterface::Printf("  styles:          scalar %.3f, sse2 %.3f (%.2fx)", Millis(timings[0][0]), Millis(timings[0][1]), Speedup(timings[0][0], timings[0][1]));
+    GameInterface::Printf("  styles + dlight: scalar %.3f, sse2 %.3f (%.2fx)", Millis(timings[1][0]), Millis(timings[1][1]), Speedup(timings[1][0], timings[1][1]));
+    GameInterface::Printf("  mismatching lightmaps: %i", mismatches);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void LightmapManager::DebugDisplayTextures(SpriteBatch & batch, const int scr_w, const int scr_h)
 {
-    const float scale = 1.0f;
+    // Large pages are drawn at the size of the smallest ones.
+    const float scale = float(kMinLightmapTextureSize) / float(sm_page_size);
     float x = 5.0f;
     float y = 65.0f;
 
     auto Background = [&]()
     {
-        batch.PushQuadTextured(x, y, (scr_w - 10.0f), (kLightmapTextureHeight + 5.0f) * scale,
+        batch.PushQuadTextured(x, y, (scr_w - 10.0f), (sm_page_size + 5.0f) * scale,
                                sm_tex_store->tex_white2x2, ColorRGBA32{ 0xFFFFFFFF });
         x += 5.0f;
         y += 5.0f;
     };
 
-    auto TexturedQuad = [&](const TextureImage * tex, const bool is_last)
+    // Returns false once the next row would be past the bottom of the screen.
+    auto TexturedQuad = [&](const TextureImage * tex, const bool is_last) -> bool
     {
         const float w = tex->Width()  * scale;
         const float h = tex->Height() * scale;
@@ -627,22 +942,28 @@ void LightmapManager::DebugDisplayTextures(SpriteBatch & batch, const int scr_w,
         {
             x = 5.0f;
             y += h + 6.0f;
+            if ((y + h + 5.0f) > scr_h)
+            {
+                return false;
+            }
             Background();
         }
+        return true;
     };
 
     Background();
 
-    for (int lmap = 0; lmap < sm_lightmap_count; ++lmap)
+    bool on_screen = true;
+    for (int lmap = 0; lmap < sm_lightmap_count && on_screen; ++lmap)
     {
         auto * tex = sm_dynamic_lightmaps[lmap];
-        TexturedQuad(tex, lmap == (sm_lightmap_count - 1));
+        on_screen = TexturedQuad(tex, lmap == (sm_lightmap_count - 1));
     }
 
-    for (int lmap = 0; lmap < sm_lightmap_count; ++lmap)
+    for (int lmap = 0; lmap < sm_lightmap_count && on_screen; ++lmap)
     {
         auto * tex = sm_static_lightmaps[lmap];
-        TexturedQuad(tex, lmap == (sm_lightmap_count - 1));
+        on_screen = TexturedQuad(tex, lmap == (sm_lightmap_count - 1));
     }
 }
 
@@ -5,7 +5,7 @@
 #pragma once
 
 #include "Common.hpp"
-#include "Pool.hpp"
+#include "AtlasPacker.hpp"
 
 // Quake includes
 #include "client/ref.h"
@@ -14,6 +14,7 @@ namespace MrQ2
 {
 
 struct ModelSurface;
+class ModelInstance;
 class TextureImage;
 class TextureStore;
 class SpriteBatch;
@@ -23,16 +24,33 @@ constexpr int kMaxLightmapTextures   = 32;
 constexpr int kLightBlockSize        = 34 * 34 * 3;
 constexpr float kDLightCutoff        = 64.0f;
 
-// Size in pixels of the lightmap atlases.
-constexpr int kLightmapTextureWidth  = 512;
-constexpr int kLightmapTextureHeight = 512;
+// Size in pixels of the square lightmap atlases. Picked per map between these,
+// see LightmapManager::BeginBuildLightmaps() and r_lightmap_page_size.
+constexpr int kMinLightmapTextureSize = 512;
+constexpr int kMaxLightmapTextureSize = AtlasPacker::kMaxSize;
 
-struct LmImageBuffer
+// Bounding rectangle of the light blocks modified in a lightmap since its last upload, in pixels.
+struct LmDirtyRect
 {
-    ColorRGBA32 pixels[kLightmapTextureWidth * kLightmapTextureHeight];
-};
+    int x0{ kMaxLightmapTextureSize };
+    int y0{ kMaxLightmapTextureSize };
+    int x1{ 0 };
+    int y1{ 0 };
+
+    bool IsEmpty() const { return x1 <= x0 || y1 <= y0; }
+    int  Width()   const { return x1 - x0; }
+    int  Height()  const { return y1 - y0; }
 
-using LmImageBufferPool = Pool<LmImageBuffer, 2>;
+    void Clear() { *this = LmDirtyRect{}; }
+
+    void Add(const int x, const int y, const int w, const int h)
+    {
+        x0 = std::min(x0, x);
+        y0 = std::min(y0, y);
+        x1 = std::max(x1, x + w);
+        y1 = std::max(y1, y + h);
+    }
+};
 
 /*
 ===============================================================================
@@ -52,8 +70,9 @@ public:
     static void BeginRegistration(const char * const map_name);
     static void EndRegistration();
 
-	// Build static surface lightmap.
-    static void BeginBuildLightmaps();
+	// Build static surface lightmap. total_block_area is the sum of the light block
+    // sizes of all the surfaces that will be passed to CreateSurfaceLightmap().
+    static void BeginBuildLightmaps(int total_block_area);
     static void CreateSurfaceLightmap(ModelSurface * surf);
     static void FinishBuildLightmaps();
 
@@ -65,6 +84,9 @@ public:
     // Render each lightmap on screen as an overlay for debugging.
     static void DebugDisplayTextures(SpriteBatch & batch, const int scr_w, const int scr_h);
 
+    // Times the scalar and SSE2 lightmap building paths over all lit surfaces of the world and checks that they match.
+    static void Benchmark(const ModelInstance & world_mdl, const int iterations);
+
     // Get static lightmap texture for rendering.
     static const TextureImage * LightmapAtIndex(const size_t index)
     {
@@ -73,38 +95,61 @@ public:
         return sm_static_lightmaps[index];
     }
 
+    // Get the dynamic lightmap texture paired with a static lightmap.
+    static const TextureImage * DynamicLightmapAtIndex(const size_t index)
+    {
+        MRQ2_ASSERT(index < ArrayLength(sm_dynamic_lightmaps));
+        MRQ2_ASSERT(sm_dynamic_lightmaps[index] != nullptr);
+        return sm_dynamic_lightmaps[index];
+    }
+
+    // Number of lightmap pages and fraction of each page's area covered by light blocks.
+    static int NumLightmaps() { return sm_lightmap_count; }
+    static int PageSize()     { return sm_page_size; }
+    static float LightmapOccupancy(const int index)
+    {
+        MRQ2_ASSERT(index >= 0 && index < sm_lightmap_count);
+        return sm_lightmap_occupancy[index];
+    }
+
     // Debug counters.
     static int sm_static_lightmap_updates;
     static int sm_dynamic_lightmap_updates;
     static int sm_num_lightmaps_buffers;
+    static int sm_lightmap_upload_bytes;
 
 private:
 
     //
     // Each static lightmap is paired with a dynamic lightmap.
     // Static lightmaps are created from an atlas of tiny light
-    // blocks allocated using the sm_allocated_blocks[] map.
+    // blocks allocated with the sm_block_packer.
     // Dynamic lightmaps are only update for dynamic lights.
     //
 
     static void ResetBlocks();
     static bool AllocBlock(const int w, const int h, int * x, int * y);
     static void NextLightmapTexture(const bool new_buffers);
+    static ColorRGBA32 * AllocBuffer();
+    static void FreeBuffer(ColorRGBA32 * buffer);
 
     static int sm_lightmap_count;
+    static int sm_page_size;
     static TextureStore * sm_tex_store;
 
     static const TextureImage * sm_static_lightmaps[kMaxLightmapTextures];
     static const TextureImage * sm_dynamic_lightmaps[kMaxLightmapTextures];
 
-    static LmImageBuffer * sm_static_lightmap_buffers[kMaxLightmapTextures];
-    static LmImageBuffer * sm_dynamic_lightmap_buffers[kMaxLightmapTextures];
+    // CPU-side images, sm_page_size * sm_page_size pixels each.
+    static ColorRGBA32 * sm_static_lightmap_buffers[kMaxLightmapTextures];
+    static ColorRGBA32 * sm_dynamic_lightmap_buffers[kMaxLightmapTextures];
 
-    static bool sm_dirtied_static_lightmaps[kMaxLightmapTextures];
-    static bool sm_dirtied_dynamic_lightmaps[kMaxLightmapTextures];
+    // Only the dirty region of each lightmap gets re-uploaded in Update().
+    static LmDirtyRect sm_dirtied_static_lightmaps[kMaxLightmapTextures];
+    static LmDirtyRect sm_dirtied_dynamic_lightmaps[kMaxLightmapTextures];
 
-    static LmImageBufferPool sm_lightmap_buffer_pool;
-    static int sm_allocated_blocks[kLightmapTextureWidth];
+    static AtlasPacker sm_block_packer;
+    static float sm_lightmap_occupancy[kMaxLightmapTextures];
 };
 
 } // MrQ2
@@ -9,6 +9,7 @@
 #include <cstdlib> // malloc/free
 #include <cstring> // memset/cpy
 #include <cstdio>
+#include <mutex>
 
 namespace MrQ2
 {
@@ -48,6 +49,9 @@ struct MemCounts
 // Current allocation counts for each memory tag
 static MemCounts MemTag_Counts[unsigned(MemTag::kCount)] = {};
 
+// Texture decoding jobs allocate from worker threads.
+static std::mutex MemTag_Mutex;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void MemTagsTrackAlloc(const std::size_t size_bytes, const MemTag tag)
@@ -55,6 +59,7 @@ void MemTagsTrackAlloc(const std::size_t size_bytes, const MemTag tag)
     const auto idx = unsigned(tag);
     MRQ2_ASSERT(idx < unsigned(MemTag::kCount));
 
+    std::lock_guard<std::mutex> lock{ MemTag_Mutex };
     MemTag_Counts[idx].total_bytes += size_bytes;
     MemTag_Counts[idx].total_allocs++;
 
@@ -75,6 +80,7 @@ void MemTagsTrackFree(const std::size_t size_bytes, const MemTag tag)
     const auto idx = unsigned(tag);
     MRQ2_ASSERT(idx < unsigned(MemTag::kCount));
 
+    std::lock_guard<std::mutex> lock{ MemTag_Mutex };
     MemTag_Counts[idx].total_bytes -= size_bytes;
     MemTag_Counts[idx].total_frees++;
 }
@@ -243,6 +243,44 @@ static void LoadTexInfo(TextureStore & tex_store, ModelInstance & mdl, const voi
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Assigns a small dense id to each unique texture referenced by the texinfos (used for the world draw keys).
+static void BuildTextureIds(ModelInstance & mdl)
+{
+    MRQ2_ASSERT(mdl.data.texinfos != nullptr); // load first!
+
+    const int count = mdl.data.num_texinfos;
+    const TextureImage ** textures = mdl.hunk.AllocBlockOfType<const TextureImage *>(std::max(count, 1));
+    int num_textures = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        ModelTexInfo & texinfo = mdl.data.texinfos[i];
+
+        // Texinfos sharing a texture are usually close together, so search backwards.
+        int id = num_textures - 1;
+        for (; id >= 0; --id)
+        {
+            if (textures[id] == texinfo.teximage)
+            {
+                break;
+            }
+        }
+
+        if (id < 0)
+        {
+            id = num_textures++;
+            textures[id] = texinfo.teximage;
+        }
+
+        texinfo.texture_id = id;
+    }
+
+    mdl.data.textures     = textures;
+    mdl.data.num_textures = num_textures;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static void CalcSurfaceExtents(const ModelInstance & mdl, ModelSurface & surf)
 {
     float mins[2];
@@ -647,13 +685,13 @@ static void BuildPolygonFromSurface(ModelInstance & mdl, ModelSurface & surf)
         s -= surf.texture_mins[0];
         s += surf.light_s * 16;
         s += 8;
-        s /= kLightmapTextureWidth * 16;
+        s /= LightmapManager::PageSize() * 16;
 
         t = Vec3Dot(vec, surf.texinfo->vecs[1]) + surf.texinfo->vecs[1][3];
         t -= surf.texture_mins[1];
         t += surf.light_t * 16;
         t += 8;
-        t /= kLightmapTextureHeight * 16;
+        t /= LightmapManager::PageSize() * 16;
 
         poly->vertexes[i].lightmap_s = s;
         poly->vertexes[i].lightmap_t = t;
@@ -843,7 +881,8 @@ static void LoadFaces(ModelInstance & mdl, const void * const mdl_data, const lu
     mdl.data.surfaces     = out;
     mdl.data.num_surfaces = count;
 
-    LightmapManager::BeginBuildLightmaps();
+    // Light block area of the whole map, used to size the lightmap pages.
+    int total_block_area = 0;
 
     for (int surf_num = 0; surf_num < count; ++surf_num, ++in, ++out)
     {
@@ -855,6 +894,7 @@ static void LoadFaces(ModelInstance & mdl, const void * const mdl_data, const lu
 
         // Default it to not ligthmapped.
         out->lightmap_texture_num = -1;
+        out->dirty_style_slot = -1;
 
         const int plane_num = in->planenum;
         const int side = in->side;
@@ -911,20 +951,33 @@ static void LoadFaces(ModelInstance & mdl, const void * const mdl_data, const lu
             SubdivideSurface(mdl, *out); // Cut up polygon for warps
         }
 
+        if (!(out->texinfo->flags & (SURF_SKY | SURF_TRANS33 | SURF_TRANS66 | SURF_WARP)))
+        {
+            total_block_area += ((out->extents[0] >> 4) + 1) * ((out->extents[1] >> 4) + 1);
+        }
+    }
+
+    LightmapManager::BeginBuildLightmaps(total_block_area);
+
+    // Lightmap coordinates are only known once the page size is picked.
+    for (int surf_num = 0; surf_num < count; ++surf_num)
+    {
+        ModelSurface * surf = &mdl.data.surfaces[surf_num];
+
         //
         // Create lightmaps:
         //
-        if (!(out->texinfo->flags & (SURF_SKY | SURF_TRANS33 | SURF_TRANS66 | SURF_WARP)))
+        if (!(surf->texinfo->flags & (SURF_SKY | SURF_TRANS33 | SURF_TRANS66 | SURF_WARP)))
         {
-            LightmapManager::CreateSurfaceLightmap(out);
+            LightmapManager::CreateSurfaceLightmap(surf);
         }
 
         //
         // Regular opaque surface:
         //
-        if (!(out->texinfo->flags & SURF_WARP))
+        if (!(surf->texinfo->flags & SURF_WARP))
         {
-            BuildPolygonFromSurface(mdl, *out);
+            BuildPolygonFromSurface(mdl, *surf);
         }
     }
 
@@ -1016,6 +1069,135 @@ static void LoadLeafs(ModelInstance & mdl, const void * const mdl_data, const lu
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Counting sort of the leafs by cluster, so MarkLeaves can go straight from a PVS bit to its leafs.
+static void BuildClusterLeafIndex(ModelInstance & mdl)
+{
+    MRQ2_ASSERT(mdl.data.leafs != nullptr); // load first!
+
+    if (mdl.data.vis == nullptr)
+    {
+        mdl.data.cluster_leaf_offsets = nullptr;
+        mdl.data.cluster_leafs = nullptr;
+        return;
+    }
+
+    const int num_clusters = mdl.data.vis->numclusters;
+    int * offsets = mdl.hunk.AllocBlockOfType<int>(num_clusters + 1);
+    std::memset(offsets, 0, sizeof(int) * (num_clusters + 1));
+
+    // Count leafs per cluster, then turn the counts into start offsets.
+    int num_clustered_leafs = 0;
+    for (int i = 0; i < mdl.data.num_leafs; ++i)
+    {
+        const int cluster = mdl.data.leafs[i].cluster;
+        if (cluster >= 0 && cluster < num_clusters)
+        {
+            ++offsets[cluster];
+            ++num_clustered_leafs;
+        }
+    }
+
+    for (int c = 0, start = 0; c <= num_clusters; ++c)
+    {
+        const int count = offsets[c];
+        offsets[c] = start;
+        start += count;
+    }
+
+    // Scatter the leafs. This advances each offset to the start of the next cluster...
+    auto ** leafs = mdl.hunk.AllocBlockOfType<ModelLeaf *>(std::max(num_clustered_leafs, 1));
+    for (int i = 0; i < mdl.data.num_leafs; ++i)
+    {
+        const int cluster = mdl.data.leafs[i].cluster;
+        if (cluster >= 0 && cluster < num_clusters)
+        {
+            leafs[offsets[cluster]++] = &mdl.data.leafs[i];
+        }
+    }
+
+    // ...so shift them back by one slot.
+    for (int c = num_clusters; c > 0; --c)
+    {
+        offsets[c] = offsets[c - 1];
+    }
+    offsets[0] = 0;
+
+    mdl.data.cluster_leaf_offsets = offsets;
+    mdl.data.cluster_leafs = leafs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Same counting sort, now of the surfaces by lightstyle. A surface is listed once under each distinct style it uses.
+static void BuildLightstyleSurfaceIndex(ModelInstance & mdl)
+{
+    MRQ2_ASSERT(mdl.data.surfaces != nullptr); // load first!
+
+    auto UsesStyle = [](const ModelSurface & surf, const int slot)
+    {
+        if (surf.styles[slot] == 255)
+        {
+            return false;
+        }
+        for (int prev = 0; prev < slot; ++prev)
+        {
+            if (surf.styles[prev] == surf.styles[slot])
+            {
+                return false; // Duplicate
+            }
+        }
+        return true;
+    };
+
+    int * offsets = mdl.hunk.AllocBlockOfType<int>(MAX_LIGHTSTYLES + 1);
+    std::memset(offsets, 0, sizeof(int) * (MAX_LIGHTSTYLES + 1));
+
+    int num_entries = 0;
+    for (int i = 0; i < mdl.data.num_surfaces; ++i)
+    {
+        const ModelSurface & surf = mdl.data.surfaces[i];
+        for (int slot = 0; slot < kMaxLightmaps && surf.styles[slot] != 255; ++slot)
+        {
+            if (UsesStyle(surf, slot))
+            {
+                ++offsets[surf.styles[slot]];
+                ++num_entries;
+            }
+        }
+    }
+
+    for (int s = 0, start = 0; s <= MAX_LIGHTSTYLES; ++s)
+    {
+        const int count = offsets[s];
+        offsets[s] = start;
+        start += count;
+    }
+
+    auto ** surfaces = mdl.hunk.AllocBlockOfType<ModelSurface *>(std::max(num_entries, 1));
+    for (int i = 0; i < mdl.data.num_surfaces; ++i)
+    {
+        ModelSurface & surf = mdl.data.surfaces[i];
+        for (int slot = 0; slot < kMaxLightmaps && surf.styles[slot] != 255; ++slot)
+        {
+            if (UsesStyle(surf, slot))
+            {
+                surfaces[offsets[surf.styles[slot]]++] = &surf;
+            }
+        }
+    }
+
+    for (int s = MAX_LIGHTSTYLES; s > 0; --s)
+    {
+        offsets[s] = offsets[s - 1];
+    }
+    offsets[0] = 0;
+
+    mdl.data.style_surface_offsets = offsets;
+    mdl.data.style_surfaces = surfaces;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static void SetParentRecursive(ModelNode * node, ModelNode * parent)
 {
     node->parent = parent;
@@ -1193,10 +1375,13 @@ void ModelStore::LoadBrushModel(TextureStore & tex_store, ModelInstance & mdl, c
     BMod::LoadLighting(mdl, mdl_data, header->lumps[LUMP_LIGHTING]);
     BMod::LoadPlanes(mdl, mdl_data, header->lumps[LUMP_PLANES]);
     BMod::LoadTexInfo(tex_store, mdl, mdl_data, header->lumps[LUMP_TEXINFO]);
+    BMod::BuildTextureIds(mdl);
     BMod::LoadFaces(mdl, mdl_data, header->lumps[LUMP_FACES]);
+    BMod::BuildLightstyleSurfaceIndex(mdl);
     BMod::LoadMarkSurfaces(mdl, mdl_data, header->lumps[LUMP_LEAFFACES]);
     BMod::LoadVisibility(mdl, mdl_data, header->lumps[LUMP_VISIBILITY]);
     BMod::LoadLeafs(mdl, mdl_data, header->lumps[LUMP_LEAFS]);
+    BMod::BuildClusterLeafIndex(mdl);
     BMod::LoadNodes(mdl, mdl_data, header->lumps[LUMP_NODES]);
     BMod::LoadSubModels(mdl, mdl_data, header->lumps[LUMP_MODELS]);
     BMod::SetUpSubModels(*this, mdl);
@@ -1257,11 +1442,15 @@ void ModelStore::LoadBrushModel(TextureStore & tex_store, ModelInstance & mdl, c
         MemTagsTrackAlloc(vertex_count * sizeof(DrawVertex3D),  MemTag::kVertIndexBuffer);
         MemTagsTrackAlloc(index_count  * sizeof(std::uint16_t), MemTag::kVertIndexBuffer);
 
+        // Indexes are kept in the hunk for the r_world_merged_indexes path, then copied to the GPU buffer.
+        std::uint16_t * const indexes = mdl.hunk.AllocBlockOfType<std::uint16_t>(index_count);
+
         auto * vertex_iter = static_cast<DrawVertex3D  *>(mdl.vb.Map());
-        auto * index_iter  = static_cast<std::uint16_t *>(mdl.ib.Map());
+        auto * index_iter  = indexes;
 
         int vertex_buffer_offset = 0;
         int index_buffer_offset  = 0;
+        int segment_base_vertex  = 0; // Start of the current 64K vertex segment (16 bits indexes)
 
         for (int s = 0; s < num_surfaces; ++s)
         {
@@ -1306,16 +1495,23 @@ void ModelStore::LoadBrushModel(TextureStore & tex_store, ModelInstance & mdl, c
                 const int num_triangles = (poly->num_verts - 2);
                 MRQ2_ASSERT(num_triangles > 0);
 
+                // Start a new segment if the polygon's vertexes can't be addressed from the current base.
+                if ((vertex_buffer_offset + poly->num_verts - segment_base_vertex) > UINT16_MAX)
+                {
+                    segment_base_vertex = vertex_buffer_offset;
+                }
+
                 poly->index_buffer.first_index = index_buffer_offset;
                 poly->index_buffer.index_count = num_triangles * 3;
-                poly->index_buffer.base_vertex = vertex_buffer_offset;
+                poly->index_buffer.base_vertex = segment_base_vertex;
 
+                const int segment_offset = vertex_buffer_offset - segment_base_vertex;
                 for (int t = 0; t < num_triangles; ++t)
                 {
                     const ModelTriangle & mdl_tri = poly->triangles[t];
                     for (int v = 0; v < 3; ++v)
                     {
-                        *index_iter++ = mdl_tri.vertexes[v];
+                        *index_iter++ = static_cast<std::uint16_t>(mdl_tri.vertexes[v] + segment_offset);
                     }
                 }
 
@@ -1327,8 +1523,12 @@ void ModelStore::LoadBrushModel(TextureStore & tex_store, ModelInstance & mdl, c
             }
         }
 
+        std::memcpy(mdl.ib.Map(), indexes, index_count * sizeof(std::uint16_t));
         mdl.ib.Unmap();
         mdl.vb.Unmap();
+
+        mdl.data.indexes     = indexes;
+        mdl.data.num_indexes = index_count;
     }
 
     if (kVerboseModelLoading)
@@ -1392,16 +1592,217 @@ void ModelStore::LoadSpriteModel(TextureStore & tex_store, ModelInstance & mdl,
 // ALIAS MD2 MODELS:
 ///////////////////////////////////////////////////////////////////////////////
 
+static inline const std::int32_t * GetAliasMD2GLCmds(const dmdl_t & header)
+{
+    return reinterpret_cast<const std::int32_t *>(reinterpret_cast<const std::uint8_t *>(&header) + header.ofs_glcmds);
+}
+
+static inline int AliasMD2PaddedVerts(const int num_verts)
+{
+    return (num_verts + AliasMD2Mesh::kVertsAlignment - 1) & ~(AliasMD2Mesh::kVertsAlignment - 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Vertexes referenced by the GL command strips and fans (upper bound for the unique draw vertexes)
+// and the number of triangle list indexes they expand to.
+static void CountAliasMD2GLCmds(const ModelInstance & mdl, const dmdl_t & header, int * out_num_cmd_verts, int * out_num_indexes)
+{
+    const std::int32_t * const cmds = GetAliasMD2GLCmds(header);
+    int num_cmd_verts = 0;
+    int num_indexes   = 0;
+    int pos = 0;
+    bool terminated = false;
+
+    while (pos < header.num_glcmds)
+    {
+        const int count = std::abs(cmds[pos++]);
+        if (count == 0)
+        {
+            terminated = true;
+            break; // done
+        }
+
+        pos += count * 3;
+        num_cmd_verts += count;
+        num_indexes   += (count >= 3) ? (count - 2) * 3 : 0;
+    }
+
+    // BuildAliasMD2Mesh() reads up to the 0 terminator, so it must be inside the list.
+    if (!terminated || num_indexes == 0)
+    {
+        GameInterface::Errorf("Model '%s' has invalid GL commands!", mdl.name.CStr());
+    }
+    if (num_cmd_verts > UINT16_MAX)
+    {
+        GameInterface::Errorf("Model '%s' has too many GL command vertices!", mdl.name.CStr());
+    }
+
+    *out_num_cmd_verts = num_cmd_verts;
+    *out_num_indexes   = num_indexes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Extra hunk memory needed by BuildAliasMD2Mesh().
+static unsigned AliasMD2MeshSize(const dmdl_t & header, const int num_cmd_verts, const int num_indexes)
+{
+    constexpr unsigned kBlockRounding = 32; // MemHunk::AllocBlock rounds every block up to this.
+    const unsigned padded_verts = AliasMD2PaddedVerts(header.num_xyz);
+
+    return sizeof(AliasMD2Mesh) +
+           header.num_frames * sizeof(AliasMD2Frame) +
+           header.num_frames * padded_verts * 4 +
+           num_cmd_verts * (sizeof(std::uint16_t) + sizeof(vec2_t)) +
+           num_indexes * sizeof(std::uint16_t) +
+           6 * kBlockRounding;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Converts the frames to SoA and the GL command strips and fans to an indexed triangle list.
+// The triangles keep the winding the strips and fans were drawn with.
+static const AliasMD2Mesh * BuildAliasMD2Mesh(ModelInstance & mdl, const dmdl_t & header, const int num_cmd_verts, const int num_indexes)
+{
+    const int num_verts    = header.num_xyz;
+    const int padded_verts = AliasMD2PaddedVerts(num_verts);
+
+    // Zero filled, so the padding vertexes are zero.
+    auto * mesh             = mdl.hunk.AllocBlockOfType<AliasMD2Mesh>(1);
+    auto * frames           = mdl.hunk.AllocBlockOfType<AliasMD2Frame>(header.num_frames);
+    auto * frame_verts      = mdl.hunk.AllocBlockOfType<std::uint8_t>(header.num_frames * padded_verts * 4);
+    auto * draw_xyz_indexes = mdl.hunk.AllocBlockOfType<std::uint16_t>(num_cmd_verts);
+    auto * draw_uvs         = mdl.hunk.AllocBlockOfType<vec2_t>(num_cmd_verts);
+    auto * indexes          = mdl.hunk.AllocBlockOfType<std::uint16_t>(num_indexes);
+
+    //
+    // Animation frames:
+    //
+    for (int f = 0; f < header.num_frames; ++f)
+    {
+        const auto * p_frame_in = reinterpret_cast<const daliasframe_t *>(reinterpret_cast<const std::uint8_t *>(&header) +
+                                                                          header.ofs_frames + f * header.framesize);
+        std::uint8_t * const verts = frame_verts + f * padded_verts * 4;
+
+        for (int v = 0; v < num_verts; ++v)
+        {
+            verts[v]                    = p_frame_in->verts[v].v[0];
+            verts[v + padded_verts]     = p_frame_in->verts[v].v[1];
+            verts[v + padded_verts * 2] = p_frame_in->verts[v].v[2];
+            verts[v + padded_verts * 3] = p_frame_in->verts[v].lightnormalindex;
+        }
+
+        Vec3Copy(p_frame_in->scale, frames[f].scale);
+        Vec3Copy(p_frame_in->translate, frames[f].translate);
+        frames[f].verts = verts;
+    }
+
+    //
+    // Unique draw vertexes, chained per frame vertex for the lookup:
+    //
+    auto * first_for_xyz = new(MemTag::kAliasModel) int[num_verts];
+    auto * next_same_xyz = new(MemTag::kAliasModel) int[num_cmd_verts];
+    auto * cmd_verts     = new(MemTag::kAliasModel) std::uint16_t[num_cmd_verts];
+    std::fill_n(first_for_xyz, num_verts, -1);
+
+    int num_draw_verts = 0;
+    auto FindOrAddDrawVert = [&](const std::int32_t * const cmd) -> std::uint16_t
+    {
+        const float u = reinterpret_cast<const float *>(cmd)[0];
+        const float v = reinterpret_cast<const float *>(cmd)[1];
+        const int xyz = cmd[2];
+
+        if (xyz < 0 || xyz >= num_verts)
+        {
+            GameInterface::Errorf("Model '%s' has an invalid vertex index in the GL commands!", mdl.name.CStr());
+        }
+
+        for (int d = first_for_xyz[xyz]; d >= 0; d = next_same_xyz[d])
+        {
+            if (draw_uvs[d][0] == u && draw_uvs[d][1] == v)
+            {
+                return static_cast<std::uint16_t>(d);
+            }
+        }
+
+        const int d = num_draw_verts++;
+        draw_xyz_indexes[d] = static_cast<std::uint16_t>(xyz);
+        draw_uvs[d][0] = u;
+        draw_uvs[d][1] = v;
+        next_same_xyz[d] = first_for_xyz[xyz];
+        first_for_xyz[xyz] = d;
+        return static_cast<std::uint16_t>(d);
+    };
+
+    //
+    // Strips and fans to a triangle list:
+    //
+    const std::int32_t * order = GetAliasMD2GLCmds(header);
+    std::uint16_t * index_iter = indexes;
+
+    for (;;)
+    {
+        std::int32_t count = *order++;
+        if (count == 0)
+        {
+            break; // done
+        }
+
+        const bool is_fan = (count < 0);
+        count = std::abs(count);
+
+        for (int i = 0; i < count; ++i, order += 3)
+        {
+            cmd_verts[i] = FindOrAddDrawVert(order);
+        }
+
+        for (int t = 0; t + 2 < count; ++t)
+        {
+            if (is_fan) // Same order as the MiniImBatch triangle fan emulation
+            {
+                *index_iter++ = cmd_verts[0];
+                *index_iter++ = cmd_verts[t + 1];
+                *index_iter++ = cmd_verts[t + 2];
+            }
+            else if (t & 1) // Odd strip triangles are flipped to keep the winding
+            {
+                *index_iter++ = cmd_verts[t];
+                *index_iter++ = cmd_verts[t + 2];
+                *index_iter++ = cmd_verts[t + 1];
+            }
+            else
+            {
+                *index_iter++ = cmd_verts[t];
+                *index_iter++ = cmd_verts[t + 1];
+                *index_iter++ = cmd_verts[t + 2];
+            }
+        }
+    }
+    MRQ2_ASSERT(index_iter == indexes + num_indexes);
+
+    DeleteArray(first_for_xyz, num_verts, MemTag::kAliasModel);
+    DeleteArray(next_same_xyz, num_cmd_verts, MemTag::kAliasModel);
+    DeleteArray(cmd_verts, num_cmd_verts, MemTag::kAliasModel);
+
+    mesh->num_verts        = num_verts;
+    mesh->num_verts_padded = padded_verts;
+    mesh->num_frames       = header.num_frames;
+    mesh->num_draw_verts   = num_draw_verts;
+    mesh->num_indexes      = num_indexes;
+    mesh->frames           = frames;
+    mesh->draw_xyz_indexes = draw_xyz_indexes;
+    mesh->draw_uvs         = draw_uvs;
+    mesh->indexes          = indexes;
+    return mesh;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void ModelStore::LoadAliasMD2Model(TextureStore & tex_store, ModelInstance & mdl, const void * const mdl_data, const int mdl_data_len)
 {
     MRQ2_ASSERT(mdl_data != nullptr);
     MRQ2_ASSERT(mdl_data_len > 0);
 
-    // Allocate the block we are going to expand the data into:
-    const unsigned hunk_size = RoundNextPoT(mdl_data_len);
-    MRQ2_ASSERT(hunk_size >= unsigned(mdl_data_len));
-    mdl.hunk.Init(hunk_size, MemTag::kAliasModel);
-
     const auto * p_mdl_data_in = static_cast<const dmdl_t *>(mdl_data);
     if (p_mdl_data_in->version != ALIAS_VERSION)
     {
@@ -1409,37 +1810,46 @@ void ModelStore::LoadAliasMD2Model(TextureStore & tex_store, ModelInstance & mdl
                               mdl.name.CStr(), p_mdl_data_in->version, ALIAS_VERSION);
     }
 
-    auto * p_header_out = static_cast<dmdl_t *>(mdl.hunk.AllocBlock(p_mdl_data_in->ofs_end));
-    *p_header_out = *p_mdl_data_in;
-
     //
     // Validate header fields:
     //
-    if (p_header_out->skinheight > kMaxMD2SkinHeight)
+    if (p_mdl_data_in->skinheight > kMaxMD2SkinHeight)
     {
         GameInterface::Errorf("Model '%s' has a skin taller than %i.", mdl.name.CStr(), kMaxMD2SkinHeight);
     }
-    if (p_header_out->num_xyz <= 0)
+    if (p_mdl_data_in->num_xyz <= 0)
     {
         GameInterface::Errorf("Model '%s' has no vertices!", mdl.name.CStr());
     }
-    if (p_header_out->num_xyz > MAX_VERTS)
+    if (p_mdl_data_in->num_xyz > MAX_VERTS)
     {
         GameInterface::Errorf("Model '%s' has too many vertices!", mdl.name.CStr());
     }
-    if (p_header_out->num_st <= 0)
+    if (p_mdl_data_in->num_st <= 0)
     {
         GameInterface::Errorf("Model '%s' has no st vertices!", mdl.name.CStr());
     }
-    if (p_header_out->num_tris <= 0)
+    if (p_mdl_data_in->num_tris <= 0)
     {
         GameInterface::Errorf("Model '%s' has no triangles!", mdl.name.CStr());
     }
-    if (p_header_out->num_frames <= 0)
+    if (p_mdl_data_in->num_frames <= 0)
     {
         GameInterface::Errorf("Model '%s' has no frames!", mdl.name.CStr());
     }
 
+    int num_cmd_verts = 0;
+    int num_indexes   = 0;
+    CountAliasMD2GLCmds(mdl, *p_mdl_data_in, &num_cmd_verts, &num_indexes);
+
+    // Allocate the block we are going to expand the data into, plus the converted mesh:
+    const unsigned hunk_size = RoundNextPoT(mdl_data_len + AliasMD2MeshSize(*p_mdl_data_in, num_cmd_verts, num_indexes));
+    MRQ2_ASSERT(hunk_size >= unsigned(mdl_data_len));
+    mdl.hunk.Init(hunk_size, MemTag::kAliasModel);
+
+    auto * p_header_out = static_cast<dmdl_t *>(mdl.hunk.AllocBlock(p_mdl_data_in->ofs_end));
+    *p_header_out = *p_mdl_data_in;
+
     //
     // S and T texture coordinates:
     //
@@ -1502,6 +1912,19 @@ void ModelStore::LoadAliasMD2Model(TextureStore & tex_store, ModelInstance & mdl
         p_cmds_out[i] = p_cmds_in[i];
     }
 
+    //
+    // SoA frames and indexed triangle list for rendering:
+    //
+    const AliasMD2Mesh * mesh = BuildAliasMD2Mesh(mdl, *p_header_out, num_cmd_verts, num_indexes);
+    mdl.data.alias_mesh = mesh;
+
+    auto & device = tex_store.Device();
+    mdl.ib.Init(device, mesh->num_indexes * sizeof(std::uint16_t), IndexBuffer::kFormatUInt16);
+    MemTagsTrackAlloc(mesh->num_indexes * sizeof(std::uint16_t), MemTag::kVertIndexBuffer);
+
+    std::memcpy(mdl.ib.Map(), mesh->indexes, mesh->num_indexes * sizeof(std::uint16_t));
+    mdl.ib.Unmap();
+
     // Set defaults for these:
     mdl.data.mins[0] = -32.0f;
     mdl.data.mins[1] = -32.0f;
@@ -43,7 +43,6 @@ void ModelStore::Init(TextureStore & tex_store)
 void ModelStore::Shutdown()
 {
     DestroyAllLoadedModels();
-    m_models_cache.clear();
     m_inline_models.clear();
     m_models_pool.Drain();
     m_registration_num = 0;
@@ -84,6 +83,14 @@ void ModelStore::DestroyAllLoadedModels()
         DestroyModel(mdl);
     }
     m_models_cache.clear();
+    m_models_index.Clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ModelStore::RebuildCacheIndex()
+{
+    m_models_index.Rebuild(m_models_cache, [](const ModelInstance & mdl) { return mdl.name.Hash(); });
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -117,6 +124,7 @@ void ModelStore::EndRegistration()
     };
 
     m_models_cache.erase_if(RemovePred);
+    RebuildCacheIndex();
 
     GameInterface::Printf("Freed %i unused models.", num_removed);
 }
@@ -136,24 +144,23 @@ const ModelInstance * ModelStore::Find(const char * const name, const ModelType
 
     // Search the currently loaded models; compare by hash.
     const std::uint32_t name_hash = PathName::CalcHash(name);
-    for (ModelInstance * mdl : m_models_cache)
-    {
+    ModelInstance * mdl = m_models_index.Find(name_hash, [name_hash, mt](const ModelInstance & m) {
         // If name and type match, we are done.
-        const bool type_match = (mt == ModelType::kAny) || (mdl->type == mt);
-        if (type_match && name_hash == mdl->name.Hash())
-        {
-            if (kVerboseModelStore)
-            {
-                GameInterface::Printf("Model '%s' already in cache.", name);
-            }
+        const bool type_match = (mt == ModelType::kAny) || (m.type == mt);
+        return type_match && name_hash == m.name.Hash();
+    });
 
-            mdl->reg_num = m_registration_num;
-            ReferenceAllTextures(*mdl); // Ensure textures have the most current registration number
-            return mdl;
+    if (mdl != nullptr)
+    {
+        if (kVerboseModelStore)
+        {
+            GameInterface::Printf("Model '%s' already in cache.", name);
         }
-    }
 
-    return nullptr;
+        mdl->reg_num = m_registration_num;
+        ReferenceAllTextures(*mdl); // Ensure textures have the most current registration number
+    }
+    return mdl;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -169,6 +176,7 @@ const ModelInstance * ModelStore::FindOrLoad(const char * const name, const Mode
         if (ModelInstance * new_mdl = LoadNewModel(name))
         {
             m_models_cache.push_back(new_mdl); // Put in the cache
+            m_models_index.Insert(new_mdl->name.Hash(), new_mdl);
             mdl = new_mdl;
 
             if (kVerboseModelStore)
@@ -199,6 +207,7 @@ void ModelStore::LoadWorldModel(const char * const map_name)
         auto erase_iter = std::find(m_models_cache.begin(), m_models_cache.end(), m_world_model);
         MRQ2_ASSERT(erase_iter != m_models_cache.end());
         m_models_cache.erase_swap(erase_iter);
+        RebuildCacheIndex();
 
         DestroyModel(m_world_model);
         m_world_model = nullptr;
@@ -7,6 +7,7 @@
 #include "ModelStructs.hpp"
 #include "Pool.hpp"
 #include "Array.hpp"
+#include "HashIndex.hpp"
 
 namespace MrQ2
 {
@@ -46,6 +47,10 @@ public:
     static void LoadSpriteModel(TextureStore & tex_store, ModelInstance & mdl, const void * const mdl_data, const int mdl_data_len);
     static void LoadAliasMD2Model(TextureStore & tex_store, ModelInstance & mdl, const void * const mdl_data, const int mdl_data_len);
 
+    // ModelStore iteration:
+    auto begin() const { return m_models_cache.begin(); }
+    auto end()   const { return m_models_cache.end();   }
+
 private:
 
     ModelInstance * CreateModel(const char * name, ModelType mt, std::uint32_t regn, bool inline_mdl);
@@ -56,6 +61,7 @@ private:
     ModelInstance * FindInlineModel(const char * name);
     ModelInstance * LoadNewModel(const char * name);
     void ReferenceAllTextures(ModelInstance & mdl);
+    void RebuildCacheIndex();
 
 private:
 
@@ -65,6 +71,7 @@ private:
 
     Pool<ModelInstance, kModelPoolSize> m_models_pool{ MemTag::kWorldModel };
     FixedSizeArray<ModelInstance *, kModelPoolSize> m_models_cache;
+    HashIndex<ModelInstance, kModelPoolSize * 2> m_models_index; // Keyed by name hash only, since Find() accepts ModelType::kAny
     FixedSizeArray<ModelInstance *, kModelPoolSize> m_inline_models;
 };
 
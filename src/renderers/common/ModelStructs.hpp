@@ -124,6 +124,7 @@ struct ModelTexInfo
     int num_frames;
     const TextureImage * teximage;
     const ModelTexInfo * next; // Texture animation chain
+    int texture_id;            // Index of teximage in the model's RenderData::textures[]
 };
 
 //
@@ -138,6 +139,8 @@ struct ModelPoly
     ModelPoly * next;
 
     // Range in the ModelInstance index buffer for this polygon (used if r_use_vertex_index_buffers is set).
+    // Polygons are packed in 64K vertex segments that share the same base_vertex, so ranges that
+    // are contiguous in the index buffer and have the same base_vertex can be merged into one draw.
     struct IbRange {
         int first_index;
         int index_count;
@@ -177,6 +180,7 @@ struct ModelSurface
     int lightmap_texture_num;          // -1 if not lightmapped
     std::uint8_t styles[kMaxLightmaps];
     float cached_light[kMaxLightmaps]; // values currently used in lightmap
+    std::int8_t dirty_style_slot;      // first styles[] slot not matching cached_light, -1 if none (see ViewRenderer::UpdateLightstyles)
     std::uint8_t * samples;            // [numstyles * surfsize]
 };
 
@@ -239,6 +243,37 @@ struct SubModelInfo
     int num_faces;
 };
 
+//
+// MD2 animation frame with the vertexes in SoA layout for the lerp kernels.
+//
+struct AliasMD2Frame
+{
+    vec3_t scale;
+    vec3_t translate;
+    const std::uint8_t * verts; // X, Y, Z then light normal index arrays, AliasMD2Mesh::num_verts_padded bytes each.
+};
+
+//
+// MD2 geometry converted at load time: SoA frames plus the GL command strips
+// and fans pre-triangulated into one indexed triangle list. Draw vertexes are
+// the unique (frame vertex, texture coordinate) pairs of the GL commands.
+//
+struct AliasMD2Mesh
+{
+    static constexpr int kVertsAlignment = 16; // One SSE register of bytes.
+
+    int num_verts;        // Frame vertexes (dmdl_t::num_xyz)
+    int num_verts_padded; // Rounded up to kVertsAlignment, padding vertexes are zero
+    int num_frames;
+    int num_draw_verts;
+    int num_indexes;      // 3 per triangle
+
+    const AliasMD2Frame * frames;
+    const std::uint16_t * draw_xyz_indexes; // Frame vertex of each draw vertex
+    const vec2_t *        draw_uvs;         // Texture coordinates of each draw vertex
+    const std::uint16_t * indexes;          // CPU copy of the ModelInstance index buffer
+};
+
 //
 // Whole model (world or entity/sprite).
 //
@@ -288,6 +323,14 @@ public:
         int num_texinfos;
         ModelTexInfo * texinfos;
 
+        // Unique TextureImages referenced by the texinfos (indexed by ModelTexInfo::texture_id).
+        int num_textures;
+        const TextureImage ** textures;
+
+        // CPU copy of the ModelInstance index buffer, source for the merged per-frame world indexes.
+        int num_indexes;
+        const std::uint16_t * indexes;
+
         int num_surfaces;
         ModelSurface * surfaces;
 
@@ -298,9 +341,22 @@ public:
         ModelSurface ** mark_surfaces;
 
         dvis_s * vis;
+
+        // Leafs grouped by PVS cluster, built at load time if the map has vis data.
+        // Leafs of cluster C are cluster_leafs[cluster_leaf_offsets[C] .. cluster_leaf_offsets[C + 1]).
+        int * cluster_leaf_offsets;
+        ModelLeaf ** cluster_leafs;
+
+        // Surfaces grouped by the lightstyles they use, so only the surfaces of a style that changed get revisited.
+        // Surfaces using style S are style_surfaces[style_surface_offsets[S] .. style_surface_offsets[S + 1]).
+        int * style_surface_offsets;
+        ModelSurface ** style_surfaces;
         std::uint8_t * light_data;
 
         const TextureImage * skins[kMaxMD2Skins]; // For alias models and skins.
+
+        // Alias models only, the ModelInstance index buffer holds its indexes.
+        const AliasMD2Mesh * alias_mesh;
     };
 
     // File name with path + hash (must be the first field - game code assumes this).
@@ -3,8 +3,15 @@
 //
 #pragma once
 
-// Toggle profiler on/off
-#define USE_OPTICK 1
+// Toggle profiler on/off. The prebuilt Optick library is Windows-only,
+// so other platforms (the headless null renderer builds) compile it out.
+#ifndef USE_OPTICK
+    #if defined(_WIN32)
+        #define USE_OPTICK 1
+    #else // !_WIN32
+        #define USE_OPTICK 0
+    #endif // _WIN32
+#endif // USE_OPTICK
 
 #include "external/optick/include/optick.config.h"
 #include "external/optick/include/optick.h"
@@ -5,10 +5,13 @@
 
 #include "RenderDocUtils.hpp"
 #include "Common.hpp"
-#include "Win32Window.hpp"
 
-// RenderDoc function pointers and structures:
-#include "external/renderdoc/renderdoc_app.h"
+#if defined(_WIN32)
+    #include "Win32Window.hpp"
+
+    // RenderDoc function pointers and structures:
+    #include "external/renderdoc/renderdoc_app.h"
+#endif // _WIN32
 
 // NOTES:
 // * renderdoc.dll and optionally dbghelp.dll have to be
@@ -21,6 +24,8 @@ namespace MrQ2
 namespace RenderDocUtils
 {
 
+#if defined(_WIN32)
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static RENDERDOC_API_1_4_1 * g_renderdoc_api = nullptr;
@@ -114,5 +119,21 @@ void TriggerCapture()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#else // !_WIN32
+
+// RenderDoc is only loaded on Windows. Other platforms only
+// build the headless null renderer, which has nothing to capture.
+bool Initialize()
+{
+    GameInterface::Printf("RenderDoc integration is only available on Windows.");
+    return false;
+}
+
+void Shutdown()       { }
+bool IsInitialized()  { return false; }
+void TriggerCapture() { }
+
+#endif // _WIN32
+
 } // RenderDocUtils
 } // MrQ2
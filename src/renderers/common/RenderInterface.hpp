@@ -10,6 +10,8 @@
     #include "../d3d11/RenderInterfaceD3D11.hpp"
 #elif defined(MRQ2_RENDERER_DLL_VULKAN)
     #include "../vulkan/RenderInterfaceVK.hpp"
+#elif defined(MRQ2_RENDERER_DLL_NULL)
+    #include "../null/RenderInterfaceNull.hpp"
 #else
     #error "Missing renderer DLL switch?"
 #endif
@@ -0,0 +1,308 @@
+//
+// TextureCache.cpp
+//  Pre-baked texture cache file: decoded images with their mipmaps,
+//  keyed by name and source file hash, so later runs skip the decoders.
+//
+
+#include "TextureCache.hpp"
+#include "TextureCompression.hpp"
+#include "Memory.hpp"
+#include <cstdio>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#endif // _WIN32
+
+namespace MrQ2
+{
+
+using namespace TextureCacheFormat;
+
+///////////////////////////////////////////////////////////////////////////////
+// TextureCache
+///////////////////////////////////////////////////////////////////////////////
+
+// Every level described by the entry must be inside the pixel data it points to,
+// since the record is copied as is into the TextureImage and uploaded from there.
+static bool IsValidEntry(const EntryRecord & entry, const std::uint64_t file_size)
+{
+    if (entry.data_offset > file_size || (entry.data_offset + entry.base_memory + entry.mip_memory) > file_size)
+    {
+        return false;
+    }
+
+    if (entry.num_levels < 1 || entry.num_levels > kMaxMipLevels || entry.format >= std::uint8_t(TextureFormat::kCount))
+    {
+        return false;
+    }
+
+    const TextureFormat format = TextureFormat(entry.format);
+    for (std::uint32_t i = 0; i < entry.num_levels; ++i)
+    {
+        const Vec2u16 dims = entry.dimensions[i];
+        if (dims.x == 0 || dims.y == 0)
+        {
+            return false;
+        }
+
+        // Level 0 is the base image, the others are in the mip memory.
+        const std::uint64_t level_size = TextureLevelSize(format, dims.x, dims.y);
+        const std::uint64_t level_end  = (i == 0) ? level_size : entry.offsets_to_mip_pixels[i] + level_size;
+        if (level_end > ((i == 0) ? entry.base_memory : entry.mip_memory))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureCache::Open(const char * const filename, const std::uint32_t mip_settings)
+{
+    MRQ2_ASSERT(filename != nullptr && filename[0] != '\0');
+
+    Close();
+    OpenMapping(filename);
+
+    if (m_file_data == nullptr)
+    {
+        return false;
+    }
+
+    auto * header = reinterpret_cast<const FileHeader *>(m_file_data);
+    if (m_file_size < sizeof(FileHeader) || header->magic != kMagic || header->version != kVersion)
+    {
+        GameInterface::Printf("WARNING: Ignoring invalid texture cache file '%s'.", filename);
+        Close();
+        return false;
+    }
+
+    if (header->mip_settings != mip_settings)
+    {
+        GameInterface::Printf("Texture cache '%s' was built with different mipmap settings, ignoring it.", filename);
+        Close();
+        return false;
+    }
+
+    const std::uint64_t table_end = sizeof(FileHeader) + std::uint64_t(header->num_entries) * sizeof(EntryRecord);
+    if (header->num_entries > std::uint32_t(kMaxEntries) || table_end > m_file_size)
+    {
+        GameInterface::Printf("WARNING: Ignoring truncated texture cache file '%s'.", filename);
+        Close();
+        return false;
+    }
+
+    m_header  = header;
+    m_entries = reinterpret_cast<const EntryRecord *>(m_file_data + sizeof(FileHeader));
+
+    int num_rejected = 0;
+    for (std::uint32_t e = 0; e < header->num_entries; ++e)
+    {
+        const EntryRecord & entry = m_entries[e];
+        if (IsValidEntry(entry, m_file_size))
+        {
+            m_index.Insert(entry.key, &entry);
+        }
+        else
+        {
+            ++num_rejected;
+        }
+    }
+
+    if (num_rejected != 0)
+    {
+        GameInterface::Printf("WARNING: Texture cache '%s' has %i damaged entries, they will be rebuilt.", filename, num_rejected);
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const EntryRecord * TextureCache::Find(const std::uint32_t key, const std::uint32_t name_hash, const std::uint64_t source_hash) const
+{
+    if (!IsOpen())
+    {
+        return nullptr;
+    }
+
+    return m_index.Find(key, [key, name_hash, source_hash](const EntryRecord & entry) {
+        return entry.key == key && entry.name_hash == name_hash && entry.source_hash == source_hash;
+    });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureCache::Write(const char * const filename, const std::uint32_t mip_settings, const WriteItem * const items, int num_items)
+{
+    MRQ2_ASSERT(filename != nullptr && filename[0] != '\0');
+
+    num_items = std::min(num_items, kMaxEntries);
+
+    GameInterface::FS::CreatePath(filename);
+
+    std::FILE * file = nullptr;
+    if (fopen_s(&file, filename, "wb") != 0 || file == nullptr)
+    {
+        GameInterface::Printf("WARNING: Failed to open texture cache file '%s' for writing.", filename);
+        return false;
+    }
+
+    FileHeader header{};
+    header.magic        = kMagic;
+    header.version      = kVersion;
+    header.num_entries  = std::uint32_t(num_items);
+    header.mip_settings = mip_settings;
+    bool ok = (std::fwrite(&header, sizeof(header), 1, file) == 1);
+
+    // Entry table first, then the pixels in the same order.
+    auto AlignOffset = [](const std::uint64_t offset) { return (offset + kDataAlignment - 1) & ~std::uint64_t(kDataAlignment - 1); };
+    std::uint64_t file_offset = sizeof(FileHeader) + std::uint64_t(num_items) * sizeof(EntryRecord);
+    std::uint64_t data_offset = AlignOffset(file_offset);
+
+    for (int i = 0; i < num_items && ok; ++i)
+    {
+        EntryRecord record = items[i].record;
+        record.data_offset = data_offset;
+        ok = (std::fwrite(&record, sizeof(record), 1, file) == 1);
+
+        data_offset = AlignOffset(data_offset + record.base_memory + record.mip_memory);
+    }
+
+    for (int i = 0; i < num_items && ok; ++i)
+    {
+        const EntryRecord & record = items[i].record;
+
+        const std::uint8_t zeros[kDataAlignment] = {};
+        const std::uint64_t padding = AlignOffset(file_offset) - file_offset;
+        ok = std::fwrite(zeros, 1, std::size_t(padding), file) == padding;
+        file_offset += padding + record.base_memory + record.mip_memory;
+
+        ok = ok && std::fwrite(items[i].base_pixels, 1, record.base_memory, file) == record.base_memory;
+        if (ok && record.mip_memory != 0)
+        {
+            ok = std::fwrite(items[i].mip_pixels, 1, record.mip_memory, file) == record.mip_memory;
+        }
+    }
+
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        GameInterface::Printf("WARNING: Failed to write texture cache file '%s'.", filename);
+        std::remove(filename);
+    }
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+void TextureCache::OpenMapping(const char * const filename)
+{
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    const void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return;
+    }
+
+    m_file_data      = static_cast<const std::uint8_t *>(view);
+    m_file_size      = std::uint64_t(size.QuadPart);
+    m_file_handle    = file;
+    m_mapping_handle = mapping;
+}
+
+void TextureCache::Close()
+{
+    if (m_file_data != nullptr)
+    {
+        UnmapViewOfFile(m_file_data);
+        CloseHandle(m_mapping_handle);
+        CloseHandle(m_file_handle);
+    }
+
+    m_file_data      = nullptr;
+    m_file_size      = 0;
+    m_header         = nullptr;
+    m_entries        = nullptr;
+    m_file_handle    = nullptr;
+    m_mapping_handle = nullptr;
+    m_index.Clear();
+}
+
+#else // !_WIN32
+
+// No file mapping, read the whole file in instead.
+void TextureCache::OpenMapping(const char * const filename)
+{
+    std::FILE * file = nullptr;
+    if (fopen_s(&file, filename, "rb") != 0 || file == nullptr)
+    {
+        return;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+
+    if (size > 0)
+    {
+        auto * data = static_cast<std::uint8_t *>(MemAllocTracked(std::size_t(size), MemTag::kTextures));
+        if (std::fread(data, 1, std::size_t(size), file) == std::size_t(size))
+        {
+            m_file_data = data;
+            m_file_size = std::uint64_t(size);
+        }
+        else
+        {
+            MemFreeTracked(data, std::size_t(size), MemTag::kTextures);
+        }
+    }
+
+    std::fclose(file);
+}
+
+void TextureCache::Close()
+{
+    if (m_file_data != nullptr)
+    {
+        MemFreeTracked(m_file_data, std::size_t(m_file_size), MemTag::kTextures);
+    }
+
+    m_file_data = nullptr;
+    m_file_size = 0;
+    m_header    = nullptr;
+    m_entries   = nullptr;
+    m_index.Clear();
+}
+
+#endif // _WIN32
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // MrQ2
@@ -0,0 +1,117 @@
+//
+// TextureCache.hpp
+//  Pre-baked texture cache file: decoded images with their mipmaps,
+//  keyed by name and source file hash, so later runs skip the decoders.
+//
+#pragma once
+
+#include "Common.hpp"
+#include "HashIndex.hpp"
+
+namespace MrQ2
+{
+
+/*
+===============================================================================
+
+    Texture cache file format
+
+===============================================================================
+*/
+namespace TextureCacheFormat
+{
+    constexpr std::uint32_t kMagic   = 0x48435854; // 'TXCH'
+    constexpr std::uint32_t kVersion = 3;
+    constexpr std::uint32_t kMaxMipLevels = 8;
+    constexpr std::uint32_t kDataAlignment = 16;
+
+    // FileHeader, EntryRecord[num_entries], then the pixel data of each entry
+    // (base image followed by the mipmaps) at data_offset, kDataAlignment aligned.
+    struct FileHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t num_entries;
+        std::uint32_t mip_settings; // Mipmap cvars the images were built with, see TextureStore::MipSettings()
+    };
+
+    struct EntryRecord
+    {
+        std::uint64_t source_hash;  // FnvHash64 of the source image file (or palette and palettized pixels for WAL/PCX)
+        std::uint64_t data_offset;  // From the start of the file
+        std::uint32_t key;          // TextureStore cache key (name hash and type)
+        std::uint32_t name_hash;
+        std::uint8_t  type;         // TextureType
+        std::uint8_t  is_hd_override;
+        std::uint8_t  num_levels;
+        std::uint8_t  format;       // TextureFormat of all the levels
+        Vec2u16       original_dimensions;
+        std::uint32_t base_memory;
+        std::uint32_t mip_memory;
+        Vec2u16       dimensions[kMaxMipLevels];
+        std::uint32_t offsets_to_mip_pixels[kMaxMipLevels];
+    };
+
+} // TextureCacheFormat
+
+/*
+===============================================================================
+
+    TextureCache
+
+===============================================================================
+*/
+class TextureCache final
+{
+public:
+
+    // Entries past this are not written.
+    static constexpr int kMaxEntries = 4096;
+
+    TextureCache() = default;
+    ~TextureCache() { Close(); }
+
+    // Disallow copy.
+    TextureCache(const TextureCache &) = delete;
+    TextureCache & operator=(const TextureCache &) = delete;
+
+    // Maps the file in memory. Fails if missing, invalid or built with other mip_settings.
+    bool Open(const char * filename, std::uint32_t mip_settings);
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    // Thread safe while open. Null if not cached or the source file changed.
+    const TextureCacheFormat::EntryRecord * Find(std::uint32_t key, std::uint32_t name_hash, std::uint64_t source_hash) const;
+
+    int NumEntries() const { return IsOpen() ? int(m_header->num_entries) : 0; }
+    const TextureCacheFormat::EntryRecord & Entry(const int index) const { MRQ2_ASSERT(index < NumEntries()); return m_entries[index]; }
+    const std::uint8_t * EntryPixels(const TextureCacheFormat::EntryRecord & entry) const { return m_file_data + entry.data_offset; }
+    std::uint64_t FileSize() const { return m_file_size; }
+
+    // Describes one image for Write().
+    struct WriteItem
+    {
+        TextureCacheFormat::EntryRecord record; // data_offset is filled in by Write()
+        const std::uint8_t * base_pixels;
+        const std::uint8_t * mip_pixels;
+    };
+
+    // Writes a new cache file. Items that don't fit in kMaxEntries are dropped.
+    static bool Write(const char * filename, std::uint32_t mip_settings, const WriteItem * items, int num_items);
+
+private:
+
+    void OpenMapping(const char * filename);
+
+    const std::uint8_t *                          m_file_data{ nullptr };
+    std::uint64_t                                 m_file_size{ 0 };
+    const TextureCacheFormat::FileHeader *        m_header{ nullptr };
+    const TextureCacheFormat::EntryRecord *       m_entries{ nullptr };
+    HashIndex<const TextureCacheFormat::EntryRecord, kMaxEntries * 2> m_index;
+
+    // Platform handles for the file mapping (or the memory holding the file).
+    void * m_file_handle{ nullptr };
+    void * m_mapping_handle{ nullptr };
+};
+
+} // MrQ2
@@ -0,0 +1,583 @@
+//
+// TextureCompression.cpp
+//  CPU encoder/decoder for the BC1 and BC3 block compressed texture formats.
+//
+//  Color endpoints are found along the principal axis of the block colors,
+//  then refined once with a least squares fit to the selected indices.
+//  Alpha uses the 8 value (min/max endpoint) mode of the BC3 alpha block.
+//
+
+#include "TextureCompression.hpp"
+#include <algorithm>
+#include <cfloat>
+
+namespace MrQ2
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// Block helpers
+///////////////////////////////////////////////////////////////////////////////
+
+static constexpr int kBlockPixels = kBCBlockDim * kBCBlockDim;
+
+struct BlockRGBA
+{
+    std::uint8_t px[kBlockPixels][4]; // R,G,B,A
+};
+
+// Fetches a 4x4 block, clamping to the image edges.
+static void FetchBlock(const ColorRGBA32 * const pixels, const int width, const int height, const int block_x, const int block_y, BlockRGBA * out_block)
+{
+    for (int y = 0; y < kBCBlockDim; ++y)
+    {
+        const int src_y = std::min(block_y * kBCBlockDim + y, height - 1);
+        for (int x = 0; x < kBCBlockDim; ++x)
+        {
+            const int src_x = std::min(block_x * kBCBlockDim + x, width - 1);
+            const ColorRGBA32 c = pixels[src_x + src_y * width];
+
+            std::uint8_t * p = out_block->px[x + y * kBCBlockDim];
+            p[0] = std::uint8_t(c & 0xFF);
+            p[1] = std::uint8_t((c >> 8)  & 0xFF);
+            p[2] = std::uint8_t((c >> 16) & 0xFF);
+            p[3] = std::uint8_t((c >> 24) & 0xFF);
+        }
+    }
+}
+
+static inline std::uint16_t PackRGB565(const float r, const float g, const float b)
+{
+    const int r5 = std::max(0, std::min(31, int(r * (31.0f / 255.0f) + 0.5f)));
+    const int g6 = std::max(0, std::min(63, int(g * (63.0f / 255.0f) + 0.5f)));
+    const int b5 = std::max(0, std::min(31, int(b * (31.0f / 255.0f) + 0.5f)));
+    return std::uint16_t((r5 << 11) | (g6 << 5) | b5);
+}
+
+static inline void UnpackRGB565(const std::uint16_t c, int rgb[3])
+{
+    const int r5 = (c >> 11) & 31;
+    const int g6 = (c >> 5)  & 63;
+    const int b5 =  c        & 31;
+    rgb[0] = (r5 << 3) | (r5 >> 2);
+    rgb[1] = (g6 << 2) | (g6 >> 4);
+    rgb[2] = (b5 << 3) | (b5 >> 2);
+}
+
+// Four color palette of a BC1 block in 4 color mode (c0 > c1).
+static void ColorPalette(const std::uint16_t c0, const std::uint16_t c1, int palette[4][3])
+{
+    UnpackRGB565(c0, palette[0]);
+    UnpackRGB565(c1, palette[1]);
+    for (int i = 0; i < 3; ++i)
+    {
+        palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+        palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+    }
+}
+
+// Picks the closest palette entry for each pixel. Returns the squared error.
+static int SelectColorIndices(const BlockRGBA & block, const int palette[4][3], std::uint8_t indices[kBlockPixels])
+{
+    int total_error = 0;
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        int best_index = 0;
+        int best_error = INT32_MAX;
+        for (int i = 0; i < 4; ++i)
+        {
+            const int dr = block.px[p][0] - palette[i][0];
+            const int dg = block.px[p][1] - palette[i][1];
+            const int db = block.px[p][2] - palette[i][2];
+            const int error = dr * dr + dg * dg + db * db;
+            if (error < best_error)
+            {
+                best_error = error;
+                best_index = i;
+            }
+        }
+        indices[p] = std::uint8_t(best_index);
+        total_error += best_error;
+    }
+    return total_error;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BC1 color block
+///////////////////////////////////////////////////////////////////////////////
+
+// Endpoints are the extreme colors along the principal axis of the block.
+static void PrincipalAxisEndpoints(const BlockRGBA & block, float end0[3], float end1[3])
+{
+    float mean[3] = {};
+    int box_min[3] = { 255, 255, 255 };
+    int box_max[3] = { 0, 0, 0 };
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            mean[i] += block.px[p][i];
+            box_min[i] = std::min(box_min[i], int(block.px[p][i]));
+            box_max[i] = std::max(box_max[i], int(block.px[p][i]));
+        }
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        mean[i] /= float(kBlockPixels);
+    }
+
+    float cov[6] = {}; // rr, rg, rb, gg, gb, bb
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        const float r = block.px[p][0] - mean[0];
+        const float g = block.px[p][1] - mean[1];
+        const float b = block.px[p][2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // Start from the covariance row with the largest variance. A fixed start like (1,1,1)
+    // is orthogonal to axes such as red-green and never leaves it.
+    float axis[3];
+    if (cov[0] >= cov[3] && cov[0] >= cov[5])
+    {
+        axis[0] = cov[0]; axis[1] = cov[1]; axis[2] = cov[2];
+    }
+    else if (cov[3] >= cov[5])
+    {
+        axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4];
+    }
+    else
+    {
+        axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5];
+    }
+
+    // A few power iterations are enough to converge on the dominant eigenvector.
+    for (int iter = 0; iter < 8; ++iter)
+    {
+        const float x = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+        const float y = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+        const float z = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+        const float len = std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z)));
+        if (len < 1e-6f)
+        {
+            break; // Flat block, keep the previous axis.
+        }
+        axis[0] = x / len;
+        axis[1] = y / len;
+        axis[2] = z / len;
+    }
+
+    float min_dot = FLT_MAX, max_dot = -FLT_MAX;
+    int min_p = 0, max_p = 0;
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        const float dot = block.px[p][0] * axis[0] + block.px[p][1] * axis[1] + block.px[p][2] * axis[2];
+        if (dot < min_dot) { min_dot = dot; min_p = p; }
+        if (dot > max_dot) { max_dot = dot; max_p = p; }
+    }
+
+    // The axis collapsed but the block isn't a single color: use the bounding box corners.
+    const bool same_color = (std::memcmp(block.px[min_p], block.px[max_p], 3) == 0);
+    const bool flat_block = (box_min[0] == box_max[0] && box_min[1] == box_max[1] && box_min[2] == box_max[2]);
+    if (same_color && !flat_block)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            end0[i] = float(box_max[i]);
+            end1[i] = float(box_min[i]);
+        }
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        end0[i] = block.px[max_p][i];
+        end1[i] = block.px[min_p][i];
+    }
+}
+
+// Least squares endpoints for the current indices. Returns false if the system is singular.
+static bool RefineEndpoints(const BlockRGBA & block, const std::uint8_t indices[kBlockPixels], float end0[3], float end1[3])
+{
+    static const float kWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[3] = {}, bx[3] = {};
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        const float a = kWeights[indices[p]];
+        const float b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int i = 0; i < 3; ++i)
+        {
+            ax[i] += a * block.px[p][i];
+            bx[i] += b * block.px[p][i];
+        }
+    }
+
+    const float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f)
+    {
+        return false;
+    }
+
+    const float inv_det = 1.0f / det;
+    for (int i = 0; i < 3; ++i)
+    {
+        end0[i] = (ax[i] * bb - bx[i] * ab) * inv_det;
+        end1[i] = (bx[i] * aa - ax[i] * ab) * inv_det;
+    }
+    return true;
+}
+
+// Writes c0, c1 and the indices in 4 color mode, which requires c0 > c1.
+static void WriteColorBlock(std::uint16_t c0, std::uint16_t c1, std::uint8_t indices[kBlockPixels], std::uint8_t * out)
+{
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+        for (int p = 0; p < kBlockPixels; ++p)
+        {
+            indices[p] ^= 1; // 0<->1 and 2<->3
+        }
+    }
+    else if (c0 == c1)
+    {
+        // Would be read as 3 color mode, but all pixels use c0 anyway.
+        std::memset(indices, 0, kBlockPixels);
+    }
+
+    std::uint32_t bits = 0;
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        bits |= std::uint32_t(indices[p]) << (p * 2);
+    }
+
+    out[0] = std::uint8_t(c0 & 0xFF);
+    out[1] = std::uint8_t(c0 >> 8);
+    out[2] = std::uint8_t(c1 & 0xFF);
+    out[3] = std::uint8_t(c1 >> 8);
+    out[4] = std::uint8_t(bits & 0xFF);
+    out[5] = std::uint8_t((bits >> 8)  & 0xFF);
+    out[6] = std::uint8_t((bits >> 16) & 0xFF);
+    out[7] = std::uint8_t((bits >> 24) & 0xFF);
+}
+
+static void EncodeColorBlock(const BlockRGBA & block, std::uint8_t * out)
+{
+    float end0[3], end1[3];
+    PrincipalAxisEndpoints(block, end0, end1);
+
+    std::uint16_t c0 = PackRGB565(end0[0], end0[1], end0[2]);
+    std::uint16_t c1 = PackRGB565(end1[0], end1[1], end1[2]);
+
+    int palette[4][3];
+    std::uint8_t indices[kBlockPixels];
+    ColorPalette(c0, c1, palette);
+    int error = SelectColorIndices(block, palette, indices);
+
+    // One refinement pass, kept only if it lowers the error.
+    if (error > 0 && c0 != c1 && RefineEndpoints(block, indices, end0, end1))
+    {
+        const std::uint16_t refined_c0 = PackRGB565(end0[0], end0[1], end0[2]);
+        const std::uint16_t refined_c1 = PackRGB565(end1[0], end1[1], end1[2]);
+
+        int refined_palette[4][3];
+        std::uint8_t refined_indices[kBlockPixels];
+        ColorPalette(refined_c0, refined_c1, refined_palette);
+        const int refined_error = SelectColorIndices(block, refined_palette, refined_indices);
+
+        if (refined_error < error && refined_c0 != refined_c1)
+        {
+            c0 = refined_c0;
+            c1 = refined_c1;
+            error = refined_error;
+            std::memcpy(indices, refined_indices, sizeof(indices));
+        }
+    }
+
+    WriteColorBlock(c0, c1, indices, out);
+}
+
+static void DecodeColorBlock(const std::uint8_t * const in, const bool allow_3_color_mode, std::uint8_t out[kBlockPixels][4])
+{
+    const std::uint16_t c0 = std::uint16_t(in[0] | (in[1] << 8));
+    const std::uint16_t c1 = std::uint16_t(in[2] | (in[3] << 8));
+    const std::uint32_t bits = std::uint32_t(in[4]) | (std::uint32_t(in[5]) << 8) | (std::uint32_t(in[6]) << 16) | (std::uint32_t(in[7]) << 24);
+
+    int palette[4][3];
+    int alpha[4] = { 255, 255, 255, 255 };
+    ColorPalette(c0, c1, palette);
+
+    if (allow_3_color_mode && c0 <= c1)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+            palette[3][i] = 0;
+        }
+        alpha[3] = 0;
+    }
+
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        const int index = (bits >> (p * 2)) & 3;
+        out[p][0] = std::uint8_t(palette[index][0]);
+        out[p][1] = std::uint8_t(palette[index][1]);
+        out[p][2] = std::uint8_t(palette[index][2]);
+        out[p][3] = std::uint8_t(alpha[index]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BC3 alpha block
+///////////////////////////////////////////////////////////////////////////////
+
+static void AlphaPalette(const int a0, const int a1, int palette[8])
+{
+    // 8 value mode (a0 > a1): 6 interpolated alphas between the endpoints.
+    palette[0] = a0;
+    palette[1] = a1;
+    for (int i = 2; i < 8; ++i)
+    {
+        palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+}
+
+static void EncodeAlphaBlock(const BlockRGBA & block, std::uint8_t * out)
+{
+    int a_min = 255, a_max = 0;
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        a_min = std::min(a_min, int(block.px[p][3]));
+        a_max = std::max(a_max, int(block.px[p][3]));
+    }
+
+    std::uint64_t bits = 0;
+    if (a_max != a_min)
+    {
+        int palette[8];
+        AlphaPalette(a_max, a_min, palette);
+
+        for (int p = 0; p < kBlockPixels; ++p)
+        {
+            int best_index = 0;
+            int best_error = INT32_MAX;
+            for (int i = 0; i < 8; ++i)
+            {
+                const int error = std::abs(int(block.px[p][3]) - palette[i]);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best_index = i;
+                }
+            }
+            bits |= std::uint64_t(best_index) << (p * 3);
+        }
+    }
+
+    out[0] = std::uint8_t(a_max);
+    out[1] = std::uint8_t(a_min);
+    for (int i = 0; i < 6; ++i)
+    {
+        out[2 + i] = std::uint8_t((bits >> (i * 8)) & 0xFF);
+    }
+}
+
+static void DecodeAlphaBlock(const std::uint8_t * const in, std::uint8_t out[kBlockPixels][4])
+{
+    const int a0 = in[0];
+    const int a1 = in[1];
+
+    int palette[8];
+    if (a0 > a1)
+    {
+        AlphaPalette(a0, a1, palette);
+    }
+    else // 6 value mode, plus 0 and 255.
+    {
+        palette[0] = a0;
+        palette[1] = a1;
+        for (int i = 2; i < 6; ++i)
+        {
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        bits |= std::uint64_t(in[2 + i]) << (i * 8);
+    }
+
+    for (int p = 0; p < kBlockPixels; ++p)
+    {
+        out[p][3] = std::uint8_t(palette[(bits >> (p * 3)) & 7]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Image level functions
+///////////////////////////////////////////////////////////////////////////////
+
+void CompressImageBC(const TextureFormat format, const ColorRGBA32 * const pixels, const int width, const int height, std::uint8_t * out_blocks)
+{
+    MRQ2_ASSERT(IsBlockCompressed(format));
+    MRQ2_ASSERT(pixels != nullptr && out_blocks != nullptr);
+    MRQ2_ASSERT(width > 0 && height > 0);
+
+    const int blocks_x = (width  + kBCBlockDim - 1) / kBCBlockDim;
+    const int blocks_y = (height + kBCBlockDim - 1) / kBCBlockDim;
+
+    BlockRGBA block;
+    for (int by = 0; by < blocks_y; ++by)
+    {
+        for (int bx = 0; bx < blocks_x; ++bx)
+        {
+            FetchBlock(pixels, width, height, bx, by, &block);
+
+            if (format == TextureFormat::kBC3)
+            {
+                EncodeAlphaBlock(block, out_blocks);
+                out_blocks += 8;
+            }
+
+            EncodeColorBlock(block, out_blocks);
+            out_blocks += 8;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DecompressImageBC(const TextureFormat format, const std::uint8_t * blocks, const int width, const int height, ColorRGBA32 * const out_pixels)
+{
+    MRQ2_ASSERT(IsBlockCompressed(format));
+    MRQ2_ASSERT(blocks != nullptr && out_pixels != nullptr);
+    MRQ2_ASSERT(width > 0 && height > 0);
+
+    const int blocks_x = (width  + kBCBlockDim - 1) / kBCBlockDim;
+    const int blocks_y = (height + kBCBlockDim - 1) / kBCBlockDim;
+
+    std::uint8_t decoded[kBlockPixels][4];
+    for (int by = 0; by < blocks_y; ++by)
+    {
+        for (int bx = 0; bx < blocks_x; ++bx)
+        {
+            if (format == TextureFormat::kBC3)
+            {
+                DecodeColorBlock(blocks + 8, /*allow_3_color_mode =*/false, decoded);
+                DecodeAlphaBlock(blocks, decoded);
+            }
+            else
+            {
+                DecodeColorBlock(blocks, /*allow_3_color_mode =*/true, decoded);
+            }
+            blocks += TextureBlockBytes(format);
+
+            for (int y = 0; y < kBCBlockDim; ++y)
+            {
+                const int dst_y = by * kBCBlockDim + y;
+                for (int x = 0; x < kBCBlockDim; ++x)
+                {
+                    const int dst_x = bx * kBCBlockDim + x;
+                    if (dst_x < width && dst_y < height)
+                    {
+                        const std::uint8_t * p = decoded[x + y * kBCBlockDim];
+                        out_pixels[dst_x + dst_y * width] = (ColorRGBA32(p[3]) << 24) | (ColorRGBA32(p[2]) << 16) | (ColorRGBA32(p[1]) << 8) | p[0];
+                    }
+                }
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureFormat BlockFormatForImage(const ColorRGBA32 * const pixels, const int width, const int height)
+{
+    const int num_pixels = width * height;
+    for (int p = 0; p < num_pixels; ++p)
+    {
+        if ((pixels[p] >> 24) != 0xFF)
+        {
+            return TextureFormat::kBC3;
+        }
+    }
+    return TextureFormat::kBC1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int ValidateBlockCompression()
+{
+    struct TestBlock
+    {
+        ColorRGBA32 a, b;  // Checkerboard colors, or the gradient ends.
+        bool gradient;     // Blend a to b over the 16 pixels instead.
+        int  tolerance;    // Max per channel round-trip error.
+    };
+
+    // Blocks whose main color axis is orthogonal to (1,1,1), plus a gray ramp for reference.
+    const TestBlock tests[] = {
+        { 0xFF0000FF, 0xFF00FF00, false, 8  }, // red/green
+        { 0xFF0000FF, 0xFFFF0000, false, 8  }, // red/blue
+        { 0xFF00FF00, 0xFFFF0000, false, 8  }, // green/blue
+        { 0xFFFF00FF, 0xFF00FFFF, false, 8  }, // magenta/yellow
+        { 0xFFFFFF00, 0xFFFF00FF, false, 8  }, // cyan/magenta
+        { 0xFF8000FF, 0xFF80FF00, false, 8  }, // red/green over a constant blue
+        { 0xFF0000F0, 0xFF00F000, true,  48 }, // red to green ramp
+        { 0xFF000000, 0xFFF0F0F0, true,  48 }, // gray ramp
+    };
+
+    int failures = 0;
+    for (const TestBlock & test : tests)
+    {
+        ColorRGBA32 pixels[kBlockPixels];
+        for (int p = 0; p < kBlockPixels; ++p)
+        {
+            if (test.gradient)
+            {
+                ColorRGBA32 c = 0;
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    const int ca = (test.a >> shift) & 0xFF;
+                    const int cb = (test.b >> shift) & 0xFF;
+                    c |= ColorRGBA32(ca + (cb - ca) * p / (kBlockPixels - 1)) << shift;
+                }
+                pixels[p] = c;
+            }
+            else
+            {
+                pixels[p] = (((p & 3) + (p >> 2)) & 1) ? test.b : test.a;
+            }
+        }
+
+        for (const TextureFormat format : { TextureFormat::kBC1, TextureFormat::kBC3 })
+        {
+            std::uint8_t blocks[16];
+            ColorRGBA32 decoded[kBlockPixels];
+            CompressImageBC(format, pixels, kBCBlockDim, kBCBlockDim, blocks);
+            DecompressImageBC(format, blocks, kBCBlockDim, kBCBlockDim, decoded);
+
+            int max_error = 0;
+            for (int p = 0; p < kBlockPixels; ++p)
+            {
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    max_error = std::max(max_error, std::abs(int((pixels[p] >> shift) & 0xFF) - int((decoded[p] >> shift) & 0xFF)));
+                }
+            }
+            failures += (max_error > test.tolerance) ? 1 : 0;
+        }
+    }
+    return failures;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // MrQ2
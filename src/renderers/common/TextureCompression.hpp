@@ -0,0 +1,77 @@
+//
+// TextureCompression.hpp
+//  CPU encoder/decoder for the BC1 and BC3 block compressed texture formats.
+//
+#pragma once
+
+#include "Common.hpp"
+
+namespace MrQ2
+{
+
+/*
+===============================================================================
+
+    TextureFormat - pixel format of the mip levels of a TextureImage
+
+===============================================================================
+*/
+enum class TextureFormat : std::uint8_t
+{
+    kRGBA8, // RGBA_U8, one ColorRGBA32 per pixel
+    kBC1,   // 4x4 blocks of 8 bytes: RGB565 endpoints + 2-bit indices (opaque)
+    kBC3,   // 4x4 blocks of 16 bytes: BC4 style alpha block + BC1 color block
+
+    // Number of items in the enum - not a valid texture format.
+    kCount
+};
+
+constexpr int kBCBlockDim = 4; // Block compressed formats encode 4x4 pixels per block.
+
+inline bool IsBlockCompressed(const TextureFormat format)
+{
+    return format == TextureFormat::kBC1 || format == TextureFormat::kBC3;
+}
+
+inline std::uint32_t TextureBlockBytes(const TextureFormat format)
+{
+    return (format == TextureFormat::kBC1) ? 8 : 16;
+}
+
+// Bytes from one row of pixels (or one row of 4x4 blocks) to the next.
+inline std::uint32_t TextureRowPitch(const TextureFormat format, const std::uint32_t width)
+{
+    if (IsBlockCompressed(format))
+    {
+        return ((width + kBCBlockDim - 1) / kBCBlockDim) * TextureBlockBytes(format);
+    }
+    return width * 4;
+}
+
+// Rows of pixels (or rows of 4x4 blocks) in an image.
+inline std::uint32_t TextureNumRows(const TextureFormat format, const std::uint32_t height)
+{
+    return IsBlockCompressed(format) ? (height + kBCBlockDim - 1) / kBCBlockDim : height;
+}
+
+// Memory used by a single mip level in the given format.
+inline std::uint32_t TextureLevelSize(const TextureFormat format, const std::uint32_t width, const std::uint32_t height)
+{
+    return TextureRowPitch(format, width) * TextureNumRows(format, height);
+}
+
+// Compresses a width*height RGBA image to kBC1 or kBC3. Blocks past the right/bottom
+// edges repeat the last column/row. out_blocks must have TextureLevelSize() bytes.
+void CompressImageBC(TextureFormat format, const ColorRGBA32 * pixels, int width, int height, std::uint8_t * out_blocks);
+
+// Expands a kBC1 or kBC3 image back to width*height RGBA pixels.
+void DecompressImageBC(TextureFormat format, const std::uint8_t * blocks, int width, int height, ColorRGBA32 * out_pixels);
+
+// kBC1 if every pixel is fully opaque, kBC3 otherwise.
+TextureFormat BlockFormatForImage(const ColorRGBA32 * pixels, int width, int height);
+
+// Round-trips a set of synthetic 4x4 blocks through both formats, including
+// colors whose main axis is orthogonal to gray. Returns the number that failed.
+int ValidateBlockCompression();
+
+} // MrQ2
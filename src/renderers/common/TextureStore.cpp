@@ -5,7 +5,11 @@
 
 #include "TextureStore.hpp"
 #include "Lightmaps.hpp"
+#include "JobSystem.hpp"
+#include "OptickProfiler.hpp"
 #include <random>
+#include <cmath>
+#include <emmintrin.h>
 
 // Quake includes
 #include "common/q_common.h"
@@ -175,56 +179,262 @@ static void MipDebugBorder(const uint32_t mip, const uint32_t w, const uint32_t
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Mipmap filters
 ///////////////////////////////////////////////////////////////////////////////
 
-void TextureImage::GenerateMipMaps()
+enum class MipFilter : std::uint8_t
 {
-    const bool no_mipmaps    = Config::r_no_mipmaps.IsSet();
-    const bool debug_mipmaps = Config::r_debug_mipmaps.IsSet();
+    kStbResize, // stbir_resize_uint8 from the base image for each level (r_mipmap_filter 0)
+    kBox,       // Box filter from the previous level (r_mipmap_filter 1)
+    kBoxGamma,  // Box filter in linear space (r_mipmap_filter 2)
+};
 
-    if (no_mipmaps)
+// Each mip level is built from the previous one with a box filter. Odd source
+// dimensions use the 3-tap polyphase box filter, so non-power-of-two textures
+// are filtered over their whole area instead of dropping the last row/column.
+// All weights are integers, so the box results are exact and the SSE2 path
+// matches the scalar one bit for bit.
+
+struct MipFilterTaps
+{
+    uint32_t first;
+    uint32_t count;
+    uint32_t weights[3];
+    uint32_t denominator;
+};
+
+static inline MipFilterTaps MipTapsForTexel(const uint32_t dst_index, const uint32_t src_size, const uint32_t dst_size)
+{
+    if (src_size == 1)
     {
-        return;
+        return { 0, 1, { 1, 0, 0 }, 1 };
     }
+    if ((src_size & 1) == 0)
+    {
+        return { dst_index * 2, 2, { 1, 1, 0 }, 2 };
+    }
+    // Odd: src_size = 2 * dst_size + 1
+    return { dst_index * 2, 3, { dst_size - dst_index, dst_size, dst_index + 1 }, src_size };
+}
 
-    if (Width() == 1 && Height() == 1)
+///////////////////////////////////////////////////////////////////////////////
+
+// Averages 2x2 blocks of two source rows into one destination row (even source width).
+static void MipBoxRow2x2_Scalar(const uint8_t * const row0, const uint8_t * const row1, uint8_t * const dst, const uint32_t first_texel, const uint32_t dst_width)
+{
+    for (uint32_t x = first_texel; x < dst_width; ++x)
     {
-        // If the base surface happens to be a 1x1 pixels image, then we can't subdivide it any further.
-        // A 2x2 image can still generate one 1x1 mipmap level.
-        return;
+        const uint8_t * const a = row0 + x * 8;
+        const uint8_t * const b = row1 + x * 8;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            dst[x * 4 + c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+        }
     }
+}
 
-    // All sub-surface mipmaps will be allocated in a contiguous
-    // block of memory. Align the start of each portion belonging
-    // to a surface to 16 bytes.
-    constexpr uint32_t alignment = 16;
+// Same as above, 4 destination texels at a time. Returns the number of texels written.
+static uint32_t MipBoxRow2x2_SSE2(const uint8_t * const row0, const uint8_t * const row1, uint8_t * const dst, const uint32_t dst_width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two  = _mm_set1_epi16(2);
 
-    // Initial image is the base surface (mipmap level = 0).
-    // Always use the initial image to generate all mipmaps
-    // to avoid propagating errors.
-    const uint32_t initial_width  = Width();
-    const uint32_t initial_height = Height();
-    const uint8_t * const base_image_pixels = m_mip_levels.base_pixels;
+    uint32_t x = 0;
+    for (; (x + 4) <= dst_width; x += 4)
+    {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8 + 16));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8 + 16));
 
-    if (debug_mipmaps)
+        // Vertical sums, two source texels per register: [s0 s1] [s2 s3] [s4 s5] [s6 s7]
+        const __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        const __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        const __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        const __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // Horizontal sums: [s0+s1 s2+s3] [s4+s5 s6+s7]
+        const __m128i d01 = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+        const __m128i d23 = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+
+        const __m128i r01 = _mm_srli_epi16(_mm_add_epi16(d01, two), 2);
+        const __m128i r23 = _mm_srli_epi16(_mm_add_epi16(d23, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), _mm_packus_epi16(r01, r23));
+    }
+    return x;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Any source size; dst_w/h must be max(1, src_w/h / 2).
+static void MipBoxFilterGeneric(const uint8_t * const src, const uint32_t src_w, const uint32_t src_h,
+                                uint8_t * const dst, const uint32_t dst_w, const uint32_t dst_h)
+{
+    for (uint32_t y = 0; y < dst_h; ++y)
+    {
+        const MipFilterTaps ty = MipTapsForTexel(y, src_h, dst_h);
+        for (uint32_t x = 0; x < dst_w; ++x)
+        {
+            const MipFilterTaps tx = MipTapsForTexel(x, src_w, dst_w);
+            const uint64_t denominator = uint64_t(tx.denominator) * ty.denominator;
+
+            uint64_t sums[4] = {};
+            for (uint32_t j = 0; j < ty.count; ++j)
+            {
+                const uint8_t * const src_row = src + (ty.first + j) * src_w * 4;
+                for (uint32_t i = 0; i < tx.count; ++i)
+                {
+                    const uint8_t * const texel = src_row + (tx.first + i) * 4;
+                    const uint64_t weight = uint64_t(tx.weights[i]) * ty.weights[j];
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        sums[c] += texel[c] * weight;
+                    }
+                }
+            }
+
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                dst[(x + y * dst_w) * 4 + c] = static_cast<uint8_t>((sums[c] + denominator / 2) / denominator);
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// sRGB <-> linear conversion tables for the gamma correct filter.
+struct MipGammaTables
+{
+    static constexpr int kLinearToSRGBSize = 16384; // Fine enough to keep the darkest sRGB steps
+
+    float   srgb_to_linear[256];
+    uint8_t linear_to_srgb[kLinearToSRGBSize];
+
+    MipGammaTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            const double c = i / 255.0;
+            srgb_to_linear[i] = float((c <= 0.04045) ? (c / 12.92) : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i < kLinearToSRGBSize; ++i)
+        {
+            const double l = double(i) / (kLinearToSRGBSize - 1);
+            const double c = (l <= 0.0031308) ? (l * 12.92) : (1.055 * std::pow(l, 1.0 / 2.4) - 0.055);
+            linear_to_srgb[i] = uint8_t(std::min(std::max(c * 255.0 + 0.5, 0.0), 255.0));
+        }
+    }
+
+    uint8_t ToSRGB(const float l) const
+    {
+        const int index = int(l * (kLinearToSRGBSize - 1) + 0.5f);
+        return linear_to_srgb[std::min(std::max(index, 0), kLinearToSRGBSize - 1)];
+    }
+};
+
+static const MipGammaTables & GetMipGammaTables()
+{
+    static const MipGammaTables s_tables; // Thread safe initialization, mipmaps are built by the job system.
+    return s_tables;
+}
+
+// Same filter as MipBoxFilterGeneric, but RGB is averaged in linear space. Alpha stays linear.
+static void MipBoxFilterGamma(const uint8_t * const src, const uint32_t src_w, const uint32_t src_h,
+                              uint8_t * const dst, const uint32_t dst_w, const uint32_t dst_h)
+{
+    const MipGammaTables & tables = GetMipGammaTables();
+
+    for (uint32_t y = 0; y < dst_h; ++y)
+    {
+        const MipFilterTaps ty = MipTapsForTexel(y, src_h, dst_h);
+        for (uint32_t x = 0; x < dst_w; ++x)
+        {
+            const MipFilterTaps tx = MipTapsForTexel(x, src_w, dst_w);
+            const float inv_denominator = 1.0f / float(tx.denominator * ty.denominator);
+
+            float sums[4] = {};
+            for (uint32_t j = 0; j < ty.count; ++j)
+            {
+                const uint8_t * const src_row = src + (ty.first + j) * src_w * 4;
+                for (uint32_t i = 0; i < tx.count; ++i)
+                {
+                    const uint8_t * const texel = src_row + (tx.first + i) * 4;
+                    const float weight = float(tx.weights[i] * ty.weights[j]);
+                    sums[0] += tables.srgb_to_linear[texel[0]] * weight;
+                    sums[1] += tables.srgb_to_linear[texel[1]] * weight;
+                    sums[2] += tables.srgb_to_linear[texel[2]] * weight;
+                    sums[3] += texel[3] * weight;
+                }
+            }
+
+            uint8_t * const out = dst + (x + y * dst_w) * 4;
+            out[0] = tables.ToSRGB(sums[0] * inv_denominator);
+            out[1] = tables.ToSRGB(sums[1] * inv_denominator);
+            out[2] = tables.ToSRGB(sums[2] * inv_denominator);
+            out[3] = uint8_t(std::min(sums[3] * inv_denominator + 0.5f, 255.0f));
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Builds mip level dst from src, the level above it.
+static void MipBoxFilter(const uint8_t * const src, const uint32_t src_w, const uint32_t src_h,
+                         uint8_t * const dst, const uint32_t dst_w, const uint32_t dst_h,
+                         const MipFilter filter, const bool use_simd)
+{
+    if (filter == MipFilter::kBoxGamma)
+    {
+        MipBoxFilterGamma(src, src_w, src_h, dst, dst_w, dst_h);
+    }
+    else if ((src_w & 1) != 0 || (src_h & 1) != 0)
+    {
+        MipBoxFilterGeneric(src, src_w, src_h, dst, dst_w, dst_h);
+    }
+    else
     {
-        // Add the debug border to the base texture as well.
-        MipDebugBorder(0, initial_width, initial_height, const_cast<uint8_t *>(base_image_pixels));
+        for (uint32_t y = 0; y < dst_h; ++y)
+        {
+            const uint8_t * const row0 = src + (y * 2) * src_w * 4;
+            const uint8_t * const row1 = row0 + src_w * 4;
+            uint8_t * const dst_row = dst + y * dst_w * 4;
+
+            const uint32_t done = use_simd ? MipBoxRow2x2_SSE2(row0, row1, dst_row, dst_w) : 0;
+            MipBoxRow2x2_Scalar(row0, row1, dst_row, done, dst_w);
+        }
     }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Fills in the dimensions and offsets of each mipmap level after the base one.
+// Returns the memory needed for all of them.
+static uint32_t ComputeMipLayout(const uint32_t initial_width, const uint32_t initial_height, uint32_t * out_num_levels,
+                                 Vec2u16 * dimensions, uint32_t * offsets_to_mip_pixels)
+{
+    // All sub-surface mipmaps will be allocated in a contiguous
+    // block of memory. Align the start of each portion belonging
+    // to a surface to 16 bytes.
+    constexpr uint32_t alignment = 16;
 
     uint32_t target_width  = initial_width;
     uint32_t target_height = initial_height;
     uint32_t mipmap_count  = 1; // Mip 0 is the initial image.
     uint32_t mipmap_memory = 0;
 
-    // First, figure out how much memory to allocate.
     // Stop when any of the dimensions reach 1.
-    while (mipmap_count != kMaxMipLevels)
+    while (mipmap_count != TextureImage::kMaxMipLevels)
     {
         target_width  = std::max(1u, target_width  / 2);
         target_height = std::max(1u, target_height / 2);
 
-        mipmap_memory += ((target_width * target_height * kBytesPerPixel) + alignment);
+        offsets_to_mip_pixels[mipmap_count] = mipmap_memory;
+        dimensions[mipmap_count].x = static_cast<uint16_t>(target_width);
+        dimensions[mipmap_count].y = static_cast<uint16_t>(target_height);
+
+        mipmap_memory += ((target_width * target_height * TextureImage::kBytesPerPixel) + alignment - 1) & ~(alignment - 1);
         mipmap_count++;
 
         if (target_width == 1 && target_height == 1)
@@ -233,50 +443,88 @@ void TextureImage::GenerateMipMaps()
         }
     }
 
-    // Allocate exact memory needed:
-    uint8_t * const mipmap_pixels = static_cast<uint8_t *>(MemAllocTracked(mipmap_memory, MemTag::kTextures));
+    *out_num_levels = mipmap_count;
+    return mipmap_memory;
+}
 
-    // Mipmap surface generation:
-    uint8_t * mip_data_start_ptr = mipmap_pixels;
-    target_width  = initial_width;
-    target_height = initial_height;
-    mipmap_count  = 1;
+///////////////////////////////////////////////////////////////////////////////
 
-    while (mipmap_count != kMaxMipLevels)
+// Generates mip levels [1, num_levels) into mip_pixels.
+static void BuildMipChain(const uint8_t * const base_pixels, const uint32_t num_levels, const Vec2u16 * const dimensions,
+                          const uint32_t * const offsets_to_mip_pixels, uint8_t * const mip_pixels,
+                          const MipFilter filter, const bool use_simd)
+{
+    for (uint32_t mip = 1; mip < num_levels; ++mip)
     {
-        target_width  = std::max(1u, target_width  / 2);
-        target_height = std::max(1u, target_height / 2);
+        uint8_t * const dst = mip_pixels + offsets_to_mip_pixels[mip];
 
-        stbir_resize_uint8(
-            // Source:
-            base_image_pixels,
-            initial_width,
-            initial_height,
-            0,
-            // Destination:
-            mip_data_start_ptr,
-            target_width,
-            target_height,
-            0,
-            // NumChannels (RGBA):
-            4);
-
-        if (debug_mipmaps) // Add a debug border to each mipmap
+        if (filter == MipFilter::kStbResize)
+        {
+            // Always use the initial image to generate all mipmaps to avoid propagating errors.
+            stbir_resize_uint8(base_pixels, dimensions[0].x, dimensions[0].y, 0,
+                               dst, dimensions[mip].x, dimensions[mip].y, 0,
+                               TextureImage::kBytesPerPixel);
+        }
+        else
         {
-            MipDebugBorder(mipmap_count, target_width, target_height, mip_data_start_ptr);
+            // Each level is filtered from the previous one, the box filter loses nothing by doing so.
+            const uint8_t * const src = (mip == 1) ? base_pixels : (mip_pixels + offsets_to_mip_pixels[mip - 1]);
+            MipBoxFilter(src, dimensions[mip - 1].x, dimensions[mip - 1].y,
+                         dst, dimensions[mip].x, dimensions[mip].y,
+                         filter, use_simd);
         }
+    }
+}
 
-        m_mip_levels.offsets_to_mip_pixels[mipmap_count] = static_cast<uint32_t>(mip_data_start_ptr - mipmap_pixels);
-        m_mip_levels.dimensions[mipmap_count].x = static_cast<uint16_t>(target_width);
-        m_mip_levels.dimensions[mipmap_count].y = static_cast<uint16_t>(target_height);
+///////////////////////////////////////////////////////////////////////////////
 
-        mip_data_start_ptr += (target_width * target_height * kBytesPerPixel);
-        mip_data_start_ptr = static_cast<uint8_t *>(AlignPtr(mip_data_start_ptr, alignment));
-        mipmap_count++;
+static MipFilter CurrentMipFilter()
+{
+    const int filter = Config::r_mipmap_filter.AsInt();
+    return (filter <= 0) ? MipFilter::kStbResize : (filter == 1) ? MipFilter::kBox : MipFilter::kBoxGamma;
+}
 
-        if (target_width == 1 && target_height == 1)
+///////////////////////////////////////////////////////////////////////////////
+
+std::uint32_t TextureImage::sm_current_frame = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureImage::GenerateMipMaps()
+{
+    const bool no_mipmaps    = Config::r_no_mipmaps.IsSet();
+    const bool debug_mipmaps = Config::r_debug_mipmaps.IsSet();
+
+    if (no_mipmaps)
+    {
+        return;
+    }
+
+    if (Width() == 1 && Height() == 1)
+    {
+        // If the base surface happens to be a 1x1 pixels image, then we can't subdivide it any further.
+        // A 2x2 image can still generate one 1x1 mipmap level.
+        return;
+    }
+
+    uint32_t mipmap_count = 0;
+    const uint32_t mipmap_memory = ComputeMipLayout(Width(), Height(), &mipmap_count,
+                                                    m_mip_levels.dimensions, m_mip_levels.offsets_to_mip_pixels);
+
+    // Allocate exact memory needed:
+    uint8_t * const mipmap_pixels = static_cast<uint8_t *>(MemAllocTracked(mipmap_memory, MemTag::kTextures));
+
+    BuildMipChain(m_mip_levels.base_pixels, mipmap_count, m_mip_levels.dimensions, m_mip_levels.offsets_to_mip_pixels,
+                  mipmap_pixels, CurrentMipFilter(), /*use_simd =*/true);
+
+    if (debug_mipmaps)
+    {
+        // Added last so the borders don't bleed into the levels filtered from the previous one.
+        MipDebugBorder(0, Width(), Height(), const_cast<uint8_t *>(m_mip_levels.base_pixels));
+        for (uint32_t mip = 1; mip < mipmap_count; ++mip)
         {
-            break;
+            MipDebugBorder(mip, m_mip_levels.dimensions[mip].x, m_mip_levels.dimensions[mip].y,
+                           mipmap_pixels + m_mip_levels.offsets_to_mip_pixels[mip]);
         }
     }
 
@@ -285,6 +533,58 @@ void TextureImage::GenerateMipMaps()
     m_mip_levels.mip_pixels = mipmap_pixels;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureImage::CompressMipMaps(const TextureFormat format)
+{
+    MRQ2_ASSERT(IsBlockCompressed(format));
+    MRQ2_ASSERT(!m_is_scrap_image && !IsCompressed());
+    MRQ2_ASSERT(m_mip_levels.base_pixels != nullptr);
+
+    // Backends require the base level to be made of whole blocks, the smaller mipmaps are padded.
+    MRQ2_ASSERT((Width() % kBCBlockDim) == 0 && (Height() % kBCBlockDim) == 0);
+
+    MipLevels & mips = m_mip_levels;
+    constexpr uint32_t alignment = 16;
+
+    // Same layout as ComputeMipLayout() with the compressed level sizes.
+    uint32_t offsets[kMaxMipLevels] = {};
+    uint32_t compressed_mip_memory = 0;
+    for (uint32_t mip = 1; mip < mips.num_levels; ++mip)
+    {
+        offsets[mip] = compressed_mip_memory;
+        compressed_mip_memory += (TextureLevelSize(format, mips.dimensions[mip].x, mips.dimensions[mip].y) + alignment - 1) & ~(alignment - 1);
+    }
+
+    const uint32_t compressed_base_memory = TextureLevelSize(format, Width(), Height());
+    auto * const base_blocks = static_cast<uint8_t *>(MemAllocTracked(compressed_base_memory, MemTag::kTextures));
+    CompressImageBC(format, BasePixels(), Width(), Height(), base_blocks);
+
+    uint8_t * mip_blocks = nullptr;
+    if (compressed_mip_memory != 0)
+    {
+        mip_blocks = static_cast<uint8_t *>(MemAllocTracked(compressed_mip_memory, MemTag::kTextures));
+        for (uint32_t mip = 1; mip < mips.num_levels; ++mip)
+        {
+            CompressImageBC(format, MipMapPixels(mip), Width(mip), Height(mip), mip_blocks + offsets[mip]);
+        }
+    }
+
+    // Replace the RGBA levels.
+    MemFreeTracked(mips.base_pixels, mips.base_memory, MemTag::kTextures);
+    if (mips.mip_pixels != nullptr)
+    {
+        MemFreeTracked(mips.mip_pixels, mips.mip_memory, MemTag::kTextures);
+    }
+
+    mips.format      = format;
+    mips.base_memory = compressed_base_memory;
+    mips.mip_memory  = compressed_mip_memory;
+    mips.base_pixels = base_blocks;
+    mips.mip_pixels  = mip_blocks;
+    std::memcpy(mips.offsets_to_mip_pixels, offsets, sizeof(offsets));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // TextureStore
 ///////////////////////////////////////////////////////////////////////////////
@@ -297,6 +597,7 @@ void TextureStore::Init(const RenderDevice & device)
 {
     MRQ2_ASSERT(m_device == nullptr);
     m_device = &device;
+    m_block_compression_supported = device.SupportsBlockCompression();
 
     // Load the default resident textures now
     TouchResidentTextures();
@@ -310,6 +611,10 @@ void TextureStore::Init(const RenderDevice & device)
 
 void TextureStore::Shutdown()
 {
+    FlushPendingTextureLoads();
+    m_texture_cache.Close();
+    m_registration_in_progress = false;
+
     LightmapManager::Shutdown();
 
     tex_scrap        = nullptr;
@@ -323,7 +628,6 @@ void TextureStore::Shutdown()
     tex_particle_hd  = nullptr;
 
     DestroyAllLoadedTextures();
-    m_teximages_cache.clear();
     m_teximages_pool.Drain();
     m_scrap.Shutdown();
 
@@ -373,8 +677,8 @@ const TextureImage * TextureStore::AllocLightmap(const ColorRGBA32* pixels, cons
     const ColorRGBA32 * mip_init_data[num_mip_levels]  = { new_lightmap->BasePixels() };
     const Vec2u16       mip_dimensions[num_mip_levels] = { new_lightmap->MipMapDimensions(0) };
 
-    new_lightmap->m_texture.Init(*m_device, TextureType::kLightmap, /*is_scrap =*/true, mip_init_data, mip_dimensions, num_mip_levels, new_lightmap->Name().CStr());
-    m_teximages_cache.push_back(new_lightmap);
+    new_lightmap->m_texture.Init(*m_device, TextureType::kLightmap, /*is_scrap =*/true, mip_init_data, mip_dimensions, num_mip_levels, TextureFormat::kRGBA8, new_lightmap->Name().CStr());
+    AddToCache(new_lightmap);
 
     return new_lightmap;
 }
@@ -397,7 +701,7 @@ TextureImage * TextureStore::CreateCinematicTexture()
     const ColorRGBA32 * mip_init_data[num_mip_levels]  = { new_cinframe->BasePixels() };
     const Vec2u16       mip_dimensions[num_mip_levels] = { new_cinframe->MipMapDimensions(0) };
 
-    new_cinframe->m_texture.Init(*m_device, TextureType::kPic, /*is_scrap =*/true, mip_init_data, mip_dimensions, num_mip_levels, new_cinframe->Name().CStr());
+    new_cinframe->m_texture.Init(*m_device, TextureType::kPic, /*is_scrap =*/true, mip_init_data, mip_dimensions, num_mip_levels, TextureFormat::kRGBA8, new_cinframe->Name().CStr());
     return new_cinframe;
 }
 
@@ -416,7 +720,7 @@ TextureImage * TextureStore::CreateScrapTexture(const uint32_t size, const Color
     const ColorRGBA32 * mip_init_data[num_mip_levels]  = { new_scrap->BasePixels() };
     const Vec2u16       mip_dimensions[num_mip_levels] = { new_scrap->MipMapDimensions(0) };
 
-    new_scrap->m_texture.Init(*m_device, TextureType::kPic, /*is_scrap =*/true, mip_init_data, mip_dimensions, num_mip_levels, new_scrap->Name().CStr());
+    new_scrap->m_texture.Init(*m_device, TextureType::kPic, /*is_scrap =*/true, mip_init_data, mip_dimensions, num_mip_levels, TextureFormat::kRGBA8, new_scrap->Name().CStr());
     return new_scrap;
 }
 
@@ -443,22 +747,143 @@ TextureImage * TextureStore::CreateTexture(const ColorRGBA32 * pixels, uint32_t
             new_tex->GenerateMipMaps();
         }
 
-        const uint32_t num_mip_levels = new_tex->NumMipMapLevels();
-        MRQ2_ASSERT(num_mip_levels >= 1 && num_mip_levels <= TextureImage::kMaxMipLevels);
+        InitBackendTexture(new_tex);
+    }
+
+    return new_tex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStore::InitBackendTexture(TextureImage * const tex)
+{
+    MRQ2_ASSERT(m_device != nullptr);
+    MRQ2_ASSERT(!tex->IsScrapImage());
+
+    const uint32_t num_mip_levels = tex->NumMipMapLevels();
+    MRQ2_ASSERT(num_mip_levels >= 1 && num_mip_levels <= TextureImage::kMaxMipLevels);
+
+    const ColorRGBA32 * mip_init_data[TextureImage::kMaxMipLevels] = {};
+    Vec2u16 mip_dimensions[TextureImage::kMaxMipLevels] = {};
+
+    for (uint32_t mip = 0; mip < num_mip_levels; ++mip)
+    {
+        mip_init_data[mip]  = tex->MipMapPixels(mip);
+        mip_dimensions[mip] = tex->MipMapDimensions(mip);
+    }
+
+    tex->m_texture.Init(*m_device, tex->Type(), /*is_scrap =*/false, mip_init_data, mip_dimensions, num_mip_levels, tex->Format(), tex->Name().CStr());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStore::BenchmarkMipMaps(const int iterations) const
+{
+    MRQ2_ASSERT(iterations > 0);
+
+    // Mipmapped textures currently loaded, classic and HD replacements measured separately.
+    enum { kClassic, kHD, kNumSets };
+    FixedSizeArray<const TextureImage *, kTexturePoolSize> textures[kNumSets];
+    std::uint64_t texels[kNumSets] = {};
+    uint32_t max_mip_memory = 0;
+
+    for (const TextureImage * tex : m_teximages_cache)
+    {
+        if (tex->IsScrapImage() || !tex->SupportsMipMaps() || tex->BasePixels() == nullptr || tex->IsCompressed() || (tex->Width() == 1 && tex->Height() == 1))
+        {
+            continue;
+        }
+
+        const int set = tex->m_is_hd_override ? kHD : kClassic;
+        textures[set].push_back(tex);
+        texels[set] += tex->Width() * tex->Height();
+
+        uint32_t num_levels;
+        Vec2u16 dimensions[TextureImage::kMaxMipLevels];
+        uint32_t offsets[TextureImage::kMaxMipLevels];
+        max_mip_memory = std::max(max_mip_memory, ComputeMipLayout(tex->Width(), tex->Height(), &num_levels, dimensions, offsets));
+    }
+
+    if (textures[kClassic].empty() && textures[kHD].empty())
+    {
+        GameInterface::Printf("mipmap_bench: No mipmapped textures loaded.");
+        return;
+    }
+
+    auto * out_scalar = static_cast<uint8_t *>(MemAllocTracked(max_mip_memory, MemTag::kRenderer));
+    auto * out_simd   = static_cast<uint8_t *>(MemAllocTracked(max_mip_memory, MemTag::kRenderer));
+
+    auto BuildChain = [](const TextureImage * tex, const MipFilter filter, const bool use_simd, uint8_t * out)
+    {
+        uint32_t num_levels;
+        Vec2u16 dimensions[TextureImage::kMaxMipLevels];
+        uint32_t offsets[TextureImage::kMaxMipLevels];
+        ComputeMipLayout(tex->Width(), tex->Height(), &num_levels, dimensions, offsets);
+        dimensions[0] = tex->MipMapDimensions(0);
+        BuildMipChain(tex->m_mip_levels.base_pixels, num_levels, dimensions, offsets, out, filter, use_simd);
+        return offsets[num_levels - 1] + dimensions[num_levels - 1].x * dimensions[num_levels - 1].y * TextureImage::kBytesPerPixel;
+    };
+
+    // Validate first: the SSE2 box filter must match the scalar one.
+    int mismatches = 0;
+    for (int set = 0; set < kNumSets; ++set)
+    {
+        for (const TextureImage * tex : textures[set])
+        {
+            const uint32_t size = BuildChain(tex, MipFilter::kBox, false, out_scalar);
+            BuildChain(tex, MipFilter::kBox, true, out_simd);
+            mismatches += (std::memcmp(out_scalar, out_simd, size) != 0) ? 1 : 0;
+        }
+    }
 
-        const ColorRGBA32 * mip_init_data[TextureImage::kMaxMipLevels] = {};
-        Vec2u16 mip_dimensions[TextureImage::kMaxMipLevels] = {};
+    struct Variant
+    {
+        const char * name;
+        MipFilter    filter;
+        bool         use_simd;
+    };
+    const Variant variants[] = {
+        { "stbir",        MipFilter::kStbResize, false },
+        { "box scalar",   MipFilter::kBox,       false },
+        { "box sse2",     MipFilter::kBox,       true  },
+        { "box gamma",    MipFilter::kBoxGamma,  true  },
+    };
 
-        for (uint32_t mip = 0; mip < num_mip_levels; ++mip)
+    for (int set = 0; set < kNumSets; ++set)
+    {
+        if (textures[set].empty())
         {
-            mip_init_data[mip]  = new_tex->MipMapPixels(mip);
-            mip_dimensions[mip] = new_tex->MipMapDimensions(mip);
+            continue;
         }
 
-        new_tex->m_texture.Init(*m_device, tt, /*is_scrap =*/false, mip_init_data, mip_dimensions, num_mip_levels, name);
+        GameInterface::Printf("Mipmap benchmark, %s textures: %i textures, %.2f Mtexels, %i iterations (ms per iteration):",
+                              (set == kHD) ? "HD" : "classic", int(textures[set].size()), double(texels[set]) / 1000000.0, iterations);
+
+        std::uint64_t stbir_us = 1;
+        for (const Variant & variant : variants)
+        {
+            const std::uint64_t start = HighResTimeMicroseconds();
+            for (int it = 0; it < iterations; ++it)
+            {
+                for (const TextureImage * tex : textures[set])
+                {
+                    BuildChain(tex, variant.filter, variant.use_simd, out_simd);
+                }
+            }
+            const std::uint64_t elapsed_us = std::max(HighResTimeMicroseconds() - start, std::uint64_t(1));
+
+            if (variant.filter == MipFilter::kStbResize)
+            {
+                stbir_us = elapsed_us;
+            }
+            GameInterface::Printf("  %-12s %8.3f (%.2fx)", variant.name, double(elapsed_us) / 1000.0 / iterations, double(stbir_us) / elapsed_us);
+        }
     }
 
-    return new_tex;
+    GameInterface::Printf("  mismatching mip chains (box scalar vs sse2): %i", mismatches);
+
+    MemFreeTracked(out_scalar, max_mip_memory, MemTag::kRenderer);
+    MemFreeTracked(out_simd, max_mip_memory, MemTag::kRenderer);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -479,36 +904,94 @@ void TextureStore::DestroyAllLoadedTextures()
         DestroyTexture(tex);
     }
     m_teximages_cache.clear();
+    m_teximages_index.Clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void TextureStore::DumpAllLoadedTexturesToFile(const char * const path, const char * const file_type, const bool dump_mipmaps) const
+void TextureStore::AddToCache(TextureImage * tex)
 {
-    MRQ2_ASSERT(path != nullptr && path[0] != '\0');
-    MRQ2_ASSERT(file_type != nullptr && file_type[0] != '\0');
+    MRQ2_ASSERT(tex != nullptr);
+    tex->m_last_used_frame = TextureImage::sm_current_frame;
+    m_teximages_cache.push_back(tex);
+    m_teximages_index.Insert(CacheKey(tex->Name().Hash(), tex->Type()), tex);
+}
 
-    char fullname[1024] = {};
-    char filename[512] = {};
+///////////////////////////////////////////////////////////////////////////////
 
-    if (std::strcmp(file_type, "tga") == 0)
-    {
-        for (const TextureImage * tex : m_teximages_cache)
-        {
-            sprintf_s(fullname, "%s/%s.tga", path, tex->Name().CStrNoExt(filename));
-            GameInterface::FS::CreatePath(fullname);
+void TextureStore::RebuildCacheIndex()
+{
+    m_teximages_index.Rebuild(m_teximages_cache, [](const TextureImage & tex) {
+        return CacheKey(tex.Name().Hash(), tex.Type());
+    });
+}
 
-            if (!TGASaveToFile(fullname, tex->Width(), tex->Height(), tex->BasePixels()))
-            {
-                GameInterface::Printf("Failed to write image '%s'", fullname);
-            }
+///////////////////////////////////////////////////////////////////////////////
+
+std::uint32_t TextureStore::CacheKey(const std::uint32_t name_hash, const TextureType tt)
+{
+    return name_hash ^ (std::uint32_t(tt) * 0x9E3779B9u);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Block compressed levels are expanded back to RGBA for saving.
+static bool SaveTextureLevel(const char * const filename, const TextureImage * const tex, const uint32_t mip, const bool as_png)
+{
+    const int width  = tex->Width(mip);
+    const int height = tex->Height(mip);
+    const ColorRGBA32 * pixels = tex->MipMapPixels(mip);
+    ColorRGBA32 * decompressed = nullptr;
+
+    if (tex->IsCompressed())
+    {
+        decompressed = new(MemTag::kRenderer) ColorRGBA32[width * height];
+        DecompressImageBC(tex->Format(), reinterpret_cast<const std::uint8_t *>(pixels), width, height, decompressed);
+        pixels = decompressed;
+    }
+
+    const bool saved = as_png ? PNGSaveToFile(filename, width, height, pixels) : TGASaveToFile(filename, width, height, pixels);
+
+    if (decompressed != nullptr)
+    {
+        DeleteArray(decompressed, width * height, MemTag::kRenderer);
+    }
+    return saved;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStore::DumpAllLoadedTexturesToFile(const char * const path, const char * const file_type, const bool dump_mipmaps) const
+{
+    MRQ2_ASSERT(path != nullptr && path[0] != '\0');
+    MRQ2_ASSERT(file_type != nullptr && file_type[0] != '\0');
+
+    char fullname[1024] = {};
+    char filename[512] = {};
+
+    if (std::strcmp(file_type, "tga") == 0)
+    {
+        for (const TextureImage * tex : m_teximages_cache)
+        {
+            if (tex->IsEvicted())
+            {
+                continue;
+            }
+
+            sprintf_s(fullname, "%s/%s.tga", path, tex->Name().CStrNoExt(filename));
+            GameInterface::FS::CreatePath(fullname);
+
+            if (!SaveTextureLevel(fullname, tex, 0, /*as_png =*/false))
+            {
+                GameInterface::Printf("Failed to write image '%s'", fullname);
+            }
 
             if (dump_mipmaps && tex->HasMipMaps())
             {
                 for (uint32_t mip = 1; mip < tex->NumMipMapLevels(); ++mip)
                 {
                     sprintf_s(fullname, "%s/%s_mip%u.tga", path, tex->Name().CStrNoExt(filename), mip);
-                    if (!TGASaveToFile(fullname, tex->Width(mip), tex->Height(mip), tex->MipMapPixels(mip)))
+                    if (!SaveTextureLevel(fullname, tex, mip, /*as_png =*/false))
                     {
                         GameInterface::Printf("Failed to write image '%s'", fullname);
                     }
@@ -520,10 +1003,15 @@ void TextureStore::DumpAllLoadedTexturesToFile(const char * const path, const ch
     {
         for (const TextureImage * tex : m_teximages_cache)
         {
+            if (tex->IsEvicted())
+            {
+                continue;
+            }
+
             sprintf_s(fullname, "%s/%s.png", path, tex->Name().CStrNoExt(filename));
             GameInterface::FS::CreatePath(fullname);
 
-            if (!PNGSaveToFile(fullname, tex->Width(), tex->Height(), tex->BasePixels()))
+            if (!SaveTextureLevel(fullname, tex, 0, /*as_png =*/true))
             {
                 GameInterface::Printf("Failed to write image '%s'", fullname);
             }
@@ -533,7 +1021,7 @@ void TextureStore::DumpAllLoadedTexturesToFile(const char * const path, const ch
                 for (uint32_t mip = 1; mip < tex->NumMipMapLevels(); ++mip)
                 {
                     sprintf_s(fullname, "%s/%s_mip%u.png", path, tex->Name().CStrNoExt(filename), mip);
-                    if (!PNGSaveToFile(fullname, tex->Width(mip), tex->Height(mip), tex->MipMapPixels(mip)))
+                    if (!SaveTextureLevel(fullname, tex, mip, /*as_png =*/true))
                     {
                         GameInterface::Printf("Failed to write image '%s'", fullname);
                     }
@@ -619,7 +1107,7 @@ void TextureStore::TouchResidentTextures()
     if (!m_scrap.IsInitialised())
     {
         m_scrap.Init();
-        m_teximages_cache.push_back(CreateScrapTexture(m_scrap.Size(), m_scrap.pixels));
+        AddToCache(CreateScrapTexture(m_scrap.Size(), m_scrap.pixels));
     }
 
     // This texture is generated at runtime
@@ -632,7 +1120,7 @@ void TextureStore::TouchResidentTextures()
 
         TextureImage * tex = CreateTexture(pixels, m_registration_num, TextureType::kPic, false,
                                            Dims, Dims, {}, {}, "pics/white2x2.pcx"); // with a fake filename
-        m_teximages_cache.push_back(tex);
+        AddToCache(tex);
         tex_white2x2 = tex;
     }
 
@@ -641,7 +1129,7 @@ void TextureStore::TouchResidentTextures()
     {
         TextureImage * tex = CreateTexture(MakeCheckerPattern(), m_registration_num, TextureType::kPic, false,
                                            kCheckerDim, kCheckerDim, {}, {}, "pics/debug.pcx"); // with a fake filename
-        m_teximages_cache.push_back(tex);
+        AddToCache(tex);
         tex_debug = tex;
     }
 
@@ -649,7 +1137,7 @@ void TextureStore::TouchResidentTextures()
     if (tex_cinframe == nullptr)
     {
         TextureImage * tex = CreateCinematicTexture();
-        m_teximages_cache.push_back(tex);
+        AddToCache(tex);
         tex_cinframe = tex;
     }
 
@@ -679,7 +1167,7 @@ void TextureStore::TouchResidentTextures()
         }
 
         TextureImage * tex = CreateTexture(pixels, m_registration_num, TextureType::kPic, false, Dims, Dims, {}, {}, "pics/particle_dot.pcx");
-        m_teximages_cache.push_back(tex);
+        AddToCache(tex);
         tex_particle_dot = tex;
     }
 
@@ -696,7 +1184,7 @@ void TextureStore::TouchResidentTextures()
         else
         {
             TextureImage * tex = CreateTexture(pixels, m_registration_num, TextureType::kPic, false, w, h, {}, {}, "pics/particle_hd.pcx");
-            m_teximages_cache.push_back(tex);
+            AddToCache(tex);
             tex_particle_hd = tex;
         }
     }
@@ -718,7 +1206,23 @@ void TextureStore::TouchResidentTextures()
 void TextureStore::BeginRegistration(const char * const map_name)
 {
     GameInterface::Printf("==== TextureStore::BeginRegistration ====");
+
+    // In case the previous registration was interrupted by an error.
+    FlushPendingTextureLoads();
+
     ++m_registration_num;
+    m_registration_in_progress = true;
+
+    // Only mapped while loading textures.
+    if (Config::r_texture_cache.IsSet())
+    {
+        m_texture_cache.Open(TextureCacheFilename(), MipSettings());
+    }
+    m_cache_dirty = false;
+
+    m_queued_load_count = 0;
+    m_queued_decode_ms  = 0.0;
+    m_queued_upload_ms  = 0.0;
 
     // Reference them on every BeginRegistration so they will always have the most current timestamp.
     TouchResidentTextures();
@@ -732,6 +1236,9 @@ void TextureStore::EndRegistration()
 {
     GameInterface::Printf("==== TextureStore::EndRegistration ====");
 
+    m_registration_in_progress = false;
+    FlushPendingTextureLoads();
+
     LightmapManager::EndRegistration();
 
     int num_textures_removed = 0;
@@ -752,6 +1259,15 @@ void TextureStore::EndRegistration()
     };
 
     m_teximages_cache.erase_if(RemovePred);
+    RebuildCacheIndex();
+
+    // Update the cache file with any textures that were not in it.
+    if (m_cache_dirty && Config::r_texture_cache.IsSet())
+    {
+        WriteTextureCache();
+    }
+    m_texture_cache.Close();
+    m_cache_dirty = false;
 
     GameInterface::Printf("Freed %i unused textures (%i lightmaps).", num_textures_removed, num_lmaps_removed);
 }
@@ -803,17 +1319,19 @@ const TextureImage * TextureStore::Find(const char * const name, const TextureTy
     // Compare by hash, much cheaper.
     const std::uint32_t name_hash = PathName::CalcHash(tex_name);
 
-    for (TextureImage * tex : m_teximages_cache)
+    // If name and type match, we are done.
+    TextureImage * tex = m_teximages_index.Find(CacheKey(name_hash, tt), [name_hash, tt](const TextureImage & t) {
+        return (name_hash == t.Name().Hash()) && (tt == t.Type());
+    });
+
+    if (tex != nullptr)
     {
-        // If name and type match, we are done.
-        if ((name_hash == tex->Name().Hash()) && (tt == tex->Type()))
-        {
-            tex->m_reg_num = m_registration_num;
-            return tex;
-        }
+        // Referenced by the level, so reload it if evicted and don't evict it again right away.
+        tex->m_reg_num = m_registration_num;
+        tex->m_last_used_frame = TextureImage::sm_current_frame;
+        tex->m_reload_requested |= tex->m_is_evicted;
     }
-
-    return nullptr;
+    return tex;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -827,7 +1345,6 @@ const TextureImage * TextureStore::FindOrLoad(const char * const name, const Tex
     if (tex == nullptr)
     {
         const char * tex_name = NameFixup(name, tt);
-        const auto name_len = std::strlen(tex_name);
 
         if (kLogLoadTextures)
         {
@@ -835,30 +1352,18 @@ const TextureImage * TextureStore::FindOrLoad(const char * const name, const Tex
                                   tex_name, TextureType_Strings[unsigned(tt)]);
         }
 
-        TextureImage * new_tex;
-        if (std::strcmp(tex_name + name_len - 4, ".pcx") == 0)
-        {
-            new_tex = LoadPCXImpl(tex_name, tt);
-        }
-        else if (std::strcmp(tex_name + name_len - 4, ".wal") == 0)
-        {
-            new_tex = LoadWALImpl(tex_name);
-        }
-        else if (std::strcmp(tex_name + name_len - 4, ".tga") == 0)
-        {
-            new_tex = LoadTGAImpl(tex_name, tt);
-        }
-        else
+        TextureImage * new_tex = LoadImpl(tex_name, tt);
+        if (new_tex != nullptr)
         {
-            GameInterface::Printf("WARNING: Unable to find image '%s' - unsupported file extension", tex_name);
-            new_tex = nullptr;
+            AddToCache(new_tex);
         }
+        tex = new_tex;
 
-        if (new_tex != nullptr)
+        // Outside registration (or with r_async_texture_loads 0) queued loads are resolved right away.
+        if (!DeferPendingLoads())
         {
-            m_teximages_cache.push_back(new_tex);
+            FlushPendingTextureLoads();
         }
-        tex = new_tex;
     }
 
     return tex;
@@ -866,6 +1371,29 @@ const TextureImage * TextureStore::FindOrLoad(const char * const name, const Tex
 
 ///////////////////////////////////////////////////////////////////////////////
 
+TextureImage * TextureStore::LoadImpl(const char * const tex_name, const TextureType tt)
+{
+    const auto name_len = std::strlen(tex_name);
+
+    if (std::strcmp(tex_name + name_len - 4, ".pcx") == 0)
+    {
+        return LoadPCXImpl(tex_name, tt);
+    }
+    else if (std::strcmp(tex_name + name_len - 4, ".wal") == 0)
+    {
+        return LoadWALImpl(tex_name);
+    }
+    else if (std::strcmp(tex_name + name_len - 4, ".tga") == 0)
+    {
+        return LoadTGAImpl(tex_name, tt);
+    }
+
+    GameInterface::Printf("WARNING: Unable to find image '%s' - unsupported file extension", tex_name);
+    return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static const char * GetHDTextureName(const char * const original_name, const char * const new_ext)
 {
     // E.g.:
@@ -917,253 +1445,821 @@ static inline bool GetWALImageDimensions(const char * const name, int * original
 
 ///////////////////////////////////////////////////////////////////////////////
 
-TextureImage * TextureStore::LoadPCXImpl(const char * const name, const TextureType tt)
+// Defined with the image loaders below.
+static bool TGAPeekDimensions(const std::uint8_t * buffer, int data_len, int * width, int * height);
+static bool Stb_PeekDimensions(const void * data, int data_len, int * width, int * height);
+static bool Stb_LoadFromMemoryCommon(const void * data, int data_len, ColorRGBA32 ** pic, int * width, int * height);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureImage * TextureStore::LoadPCXImpl(const char * const name, const TextureType tt)
+{
+    if (tt == TextureType::kSkin && Config::r_hd_skins.IsSet())
+    {
+        // First find the dimensions of the original low-res texture
+        int original_w, original_h;
+        if (GetPCXImageDimensions(name, &original_w, &original_h))
+        {
+            // .pcx changes to a .jpg
+            const char * const hd_texture_name = GetHDTextureName(name, "jpg");
+
+            PendingTextureLoad load{};
+            load.source = PendingTextureLoad::Source::kStb;
+            load.file_length = GameInterface::FS::LoadFile(hd_texture_name, &load.file_data);
+
+            int width, height;
+            if (load.file_data != nullptr && Stb_PeekDimensions(load.file_data, load.file_length, &width, &height))
+            {
+                auto * new_tex = QueueTextureLoad(load, width, height, TextureType::kSkin, name);
+                new_tex->SetHDOverrideOriginalSize(original_w, original_h);
+                return new_tex;
+            }
+
+            GameInterface::FS::FreeFile(load.file_data);
+        }
+
+        // fallback to the low-res classic texture.
+    }
+
+    TextureImage * tex = nullptr;
+    Color8 * pic8;
+    int width, height;
+
+    if (!PCXLoadFromFile(name, &pic8, &width, &height, nullptr))
+    {
+        GameInterface::Printf("WARNING: Can't load PCX pic for '%s'", name);
+        return nullptr;
+    }
+
+    // Expanded to RGBA and mipmapped by DecodeTextureJob. FlushPendingTextureLoads frees pic8 afterwards.
+    if (UsesLoadQueue(tt))
+    {
+        PendingTextureLoad load{};
+        load.source     = PendingTextureLoad::Source::kPalettized;
+        load.pic8       = pic8;
+        load.owned_pic8 = pic8;
+        return QueueTextureLoad(load, width, height, tt, name);
+    }
+
+    // Try placing small images in the scrap atlas:
+    if (tt == TextureType::kPic)
+    {
+        constexpr int kMaxSizeForScrapPlacement = 64; // in pixels, w & h
+        if (width <= kMaxSizeForScrapPlacement && height <= kMaxSizeForScrapPlacement)
+        {
+            tex = ScrapTryAlloc8Bit(pic8, width, height, name, tt);
+        }
+    }
+
+    // Atlas full or image too big, create a standalone texture:
+    if (tex == nullptr)
+    {
+        tex = Common8BitTexSetup(pic8, width, height, name, tt);
+    }
+
+    // The palettized pcx image is no longer needed.
+    MemFreeTracked(pic8, (width * height), MemTag::kTextures);
+    return tex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureImage * TextureStore::LoadTGAImpl(const char * const name, const TextureType tt)
+{
+    ColorRGBA32 * pic32;
+    int width, height;
+
+    if (UsesLoadQueue(tt))
+    {
+        PendingTextureLoad load{};
+        load.source = PendingTextureLoad::Source::kTGA;
+        load.file_length = GameInterface::FS::LoadFile(name, &load.file_data);
+
+        if (load.file_data != nullptr && TGAPeekDimensions(static_cast<const std::uint8_t *>(load.file_data), load.file_length, &width, &height))
+        {
+            return QueueTextureLoad(load, width, height, tt, name);
+        }
+
+        // Let the synchronous path below report the error.
+        GameInterface::FS::FreeFile(load.file_data);
+    }
+
+    if (!TGALoadFromFile(name, &pic32, &width, &height))
+    {
+        GameInterface::Printf("WARNING: Can't load TGA texture for '%s'", name);
+        return nullptr;
+    }
+
+    // TGAs are always expanded to RGBA, so no extra conversion is needed.
+    return CreateTexture(pic32, m_registration_num, tt, /*from_scrap =*/false, width, height, {}, {}, name);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureImage * TextureStore::LoadWALImpl(const char * const name)
+{
+    if (Config::r_hd_textures.IsSet())
+    {
+        // First find the dimensions of the original low-res texture
+        int original_w, original_h;
+        if (GetWALImageDimensions(name, &original_w, &original_h))
+        {
+            // .wall changes to a .tga
+            const char * const hd_texture_name = GetHDTextureName(name, "tga");
+
+            // Load the override
+            PendingTextureLoad load{};
+            load.source = PendingTextureLoad::Source::kTGA;
+            load.file_length = GameInterface::FS::LoadFile(hd_texture_name, &load.file_data);
+
+            int width, height;
+            if (load.file_data != nullptr && TGAPeekDimensions(static_cast<const std::uint8_t *>(load.file_data), load.file_length, &width, &height))
+            {
+                auto * new_tex = QueueTextureLoad(load, width, height, TextureType::kWall, name);
+
+                // Remember the original image size because the world surfaces require it to correctly compute UVs.
+                new_tex->SetHDOverrideOriginalSize(original_w, original_h);
+                return new_tex;
+            }
+
+            GameInterface::FS::FreeFile(load.file_data);
+        }
+
+        // fallback to the low-res classic texture.
+    }
+
+    void * file_data = nullptr;
+    const int file_length = GameInterface::FS::LoadFile(name, &file_data);
+    if (file_data == nullptr || file_length <= 0)
+    {
+        GameInterface::FS::FreeFile(file_data);
+        GameInterface::Printf("WARNING: Can't load WAL texture for '%s'", name);
+        return nullptr;
+    }
+
+    auto * wall = static_cast<const miptex_t *>(file_data);
+
+    const int width  = wall->width;
+    const int height = wall->height;
+    const int offset = wall->offsets[0];
+    auto * pic8 = reinterpret_cast<const Color8 *>(wall) + offset;
+
+    // The file stays loaded until DecodeTextureJob has expanded the pixels.
+    PendingTextureLoad load{};
+    load.source      = PendingTextureLoad::Source::kPalettized;
+    load.file_data   = file_data;
+    load.file_length = file_length;
+    load.pic8        = pic8;
+    return QueueTextureLoad(load, width, height, TextureType::kWall, name);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureImage * TextureStore::ScrapTryAlloc8Bit(const Color8 * const pic8, const int width, const int height, const char * const name, const TextureType tt)
+{
+    MRQ2_ASSERT(width > 0 && height > 0);
+    MRQ2_ASSERT(m_scrap.IsInitialised());
+
+    // Adding a 2 pixels padding border around each side to avoid sampling artifacts.
+    const int padded_width  = width  + 2;
+    const int padded_height = height + 2;
+
+    // Try to find a good fit in the atlas:
+    int sx = 0;
+    int sy = 0;
+    if (!m_scrap.packer.Alloc(padded_width, padded_height, &sx, &sy))
+    {
+        return nullptr; // No more room.
+    }
+
+    // Expand pic to RGBA:
+    auto * pic32 = new(MemTag::kTextures) ColorRGBA32[width * height];
+    UnPalettize8To32(width, height, pic8, sm_global_palette, pic32);
+
+    // Copy the pixels into the scrap block:
+    int k = 0;
+    for (int i = 0; i < height; ++i)
+    {
+        for (int j = 0; j < width; ++j, ++k)
+        {
+            m_scrap.pixels[(sy + i) * m_scrap.Size() + sx + j] = pic32[k];
+        }
+    }
+
+    Vec2u16 uv0, uv1;
+    uv0.x = std::uint16_t(sx);
+    uv0.y = std::uint16_t(sy);
+    uv1.x = std::uint16_t(sx + width);
+    uv1.y = std::uint16_t(sy + height);
+
+    // Pass ownership of the pixel data
+    return CreateTexture(pic32, m_registration_num, tt, /*from_scrap =*/true, width, height, uv0, uv1, name);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureImage * TextureStore::Common8BitTexSetup(const Color8 * const pic8, const int width, const int height, const char * const name, const TextureType tt)
+{
+    MRQ2_ASSERT(width > 0 && height > 0);
+
+    auto * pic32 = new(MemTag::kTextures) ColorRGBA32[width * height];
+    UnPalettize8To32(width, height, pic8, sm_global_palette, pic32);
+
+    // Pass ownership of the pixel data
+    return CreateTexture(pic32, m_registration_num, tt, /*from_scrap =*/false, width, height, {}, {}, name);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStore::UnPalettize8To32(const int width, const int height, const Color8 * const pic8in,
+                                    const ColorRGBA32 * const palette, ColorRGBA32 * const pic32out)
+{
+    const int pixel_count = width * height;
+    for (int i = 0; i < pixel_count; ++i)
+    {
+        int p = pic8in[i];
+        pic32out[i] = palette[p];
+
+        // Transparency algorithm adapted from GL_Upload8 in ref_gl/gl_image.c
+        if (p == 255)
+        {
+            // Transparent, so scan around for another
+            // color to avoid alpha fringes
+            if (i > width && pic8in[i - width] != 255)
+            {
+                p = pic8in[i - width];
+            }
+            else if (i < pixel_count - width && pic8in[i + width] != 255)
+            {
+                p = pic8in[i + width];
+            }
+            else if (i > 0 && pic8in[i - 1] != 255)
+            {
+                p = pic8in[i - 1];
+            }
+            else if (i < pixel_count - 1 && pic8in[i + 1] != 255)
+            {
+                p = pic8in[i + 1];
+            }
+            else
+            {
+                p = 0;
+            }
+
+            // Copy RGB components:
+            reinterpret_cast<Color8 *>(&pic32out[i])[0] = reinterpret_cast<const Color8 *>(&palette[p])[0];
+            reinterpret_cast<Color8 *>(&pic32out[i])[1] = reinterpret_cast<const Color8 *>(&palette[p])[1];
+            reinterpret_cast<Color8 *>(&pic32out[i])[2] = reinterpret_cast<const Color8 *>(&palette[p])[2];
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Asynchronous texture loading:
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStore::UsesLoadQueue(const TextureType tt)
+{
+    // Pics can go into the scrap and are usually drawn straight away (loading plaque, console),
+    // so only the mipmapped textures go through the queue.
+    return tt < TextureType::kPic;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStore::DeferPendingLoads() const
+{
+    return m_registration_in_progress && Config::r_async_texture_loads.IsSet();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureImage * TextureStore::QueueTextureLoad(const PendingTextureLoad & load, const int width, const int height, const TextureType tt, const char * const name)
+{
+    MRQ2_ASSERT(width > 0 && height > 0);
+
+    // Dimensions come from the file header; the pixels are filled in by DecodeTextureJob.
+    TextureImage * new_tex = m_reload_target;
+    if (new_tex != nullptr)
+    {
+        // Reloading an evicted texture: rebuilt in place so existing pointers to it stay valid.
+        MRQ2_ASSERT(new_tex->IsEvicted() && new_tex->Type() == tt);
+        m_reload_target = nullptr;
+        new_tex->~TextureImage();
+    }
+    else
+    {
+        new_tex = m_teximages_pool.Allocate();
+    }
+
+    ::new(new_tex) TextureImage{ nullptr, m_registration_num, tt, /*scrap =*/false, std::uint32_t(width), std::uint32_t(height), {}, {}, name };
+
+    m_pending_loads.push_back(load);
+    m_pending_loads.back().tex    = new_tex;
+    m_pending_loads.back().failed = false;
+
+    return new_tex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStore::DecodeTextureJob(void * const user_data, const int job_index, const int /*thread_index*/)
+{
+    // Runs on any thread. Must not touch the game filesystem or print.
+    const TextureStore & store = *static_cast<const TextureStore *>(user_data);
+    PendingTextureLoad & load = const_cast<PendingTextureLoad &>(store.m_pending_loads[job_index]);
+    TextureImage * const tex = load.tex;
+    const std::uint64_t start_us = HighResTimeMicroseconds();
+
+    // Identifies the source image in the texture cache. Palettized images also
+    // depend on the palette they are expanded with. Not needed without the cache.
+    if (!store.m_use_texture_cache)
+    {
+        tex->m_source_hash = 0;
+    }
+    else if (load.source == PendingTextureLoad::Source::kPalettized)
+    {
+        static const std::uint64_t s_palette_hash = FnvHash64(reinterpret_cast<const std::uint8_t *>(sm_global_palette), sizeof(sm_global_palette));
+        tex->m_source_hash = FnvHash64(load.pic8, tex->Width() * tex->Height(), s_palette_hash);
+    }
+    else
+    {
+        tex->m_source_hash = FnvHash64(static_cast<const std::uint8_t *>(load.file_data), load.file_length);
+    }
+
+    if (LoadFromTextureCache(store.m_texture_cache, tex))
+    {
+        load.from_cache = true;
+        load.decode_us  = HighResTimeMicroseconds() - start_us;
+        return;
+    }
+
+    ColorRGBA32 * pic32 = nullptr;
+    int width  = tex->Width();
+    int height = tex->Height();
+
+    switch (load.source)
+    {
+    case PendingTextureLoad::Source::kPalettized :
+        pic32 = new(MemTag::kTextures) ColorRGBA32[width * height];
+        UnPalettize8To32(width, height, load.pic8, sm_global_palette, pic32);
+        break;
+
+    case PendingTextureLoad::Source::kTGA :
+        TGALoadFromMemory(tex->Name().CStr(), static_cast<const std::uint8_t *>(load.file_data), load.file_length, &pic32, &width, &height);
+        break;
+
+    case PendingTextureLoad::Source::kStb :
+        Stb_LoadFromMemoryCommon(load.file_data, load.file_length, &pic32, &width, &height);
+        break;
+    } // switch
+
+    if (pic32 == nullptr || width != tex->Width() || height != tex->Height())
+    {
+        if (pic32 != nullptr)
+        {
+            MemFreeTracked(pic32, width * height * TextureImage::kBytesPerPixel, MemTag::kTextures);
+        }
+        tex->m_source_hash = 0;
+        load.failed = true;
+        return;
+    }
+
+    tex->m_mip_levels.base_pixels = reinterpret_cast<const uint8_t *>(pic32);
+    tex->GenerateMipMaps();
+
+    if (store.ShouldCompress(tex))
+    {
+        const std::uint64_t encode_start_us = HighResTimeMicroseconds();
+        tex->CompressMipMaps(BlockFormatForImage(pic32, width, height));
+        load.encode_us = HighResTimeMicroseconds() - encode_start_us;
+    }
+
+    load.decode_us = HighResTimeMicroseconds() - start_us;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStore::ShouldCompress(const TextureImage * const tex) const
+{
+    // Only the large HD replacements, the classic textures are small and lose too much detail.
+    return m_compress_hd_textures && tex->m_is_hd_override &&
+           tex->Width()  >= kMinCompressedTextureSize && (tex->Width()  % kBCBlockDim) == 0 &&
+           tex->Height() >= kMinCompressedTextureSize && (tex->Height() % kBCBlockDim) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStore::FlushPendingTextureLoads()
+{
+    if (m_pending_loads.empty())
+    {
+        return;
+    }
+
+    OPTICK_EVENT();
+
+    const int num_loads = m_pending_loads.size();
+    const std::uint64_t decode_start_us = HighResTimeMicroseconds();
+
+    // Read once here so all the jobs agree.
+    m_compress_hd_textures = m_block_compression_supported && Config::r_hd_texture_compression.IsSet();
+    m_use_texture_cache    = Config::r_texture_cache.IsSet();
+
+    // Each job only touches its own TextureImage.
+    JobSystem::ParallelFor(num_loads, &TextureStore::DecodeTextureJob, this);
+
+    const std::uint64_t upload_start_us = HighResTimeMicroseconds();
+
+    // Create the backend textures and release the source data from the main thread.
+    for (PendingTextureLoad & load : m_pending_loads)
+    {
+        TextureImage * const tex = load.tex;
+        const int pic8_size = tex->Width() * tex->Height();
+
+        if (load.failed)
+        {
+            GameInterface::Printf("WARNING: Failed to decode texture '%s'", tex->Name().CStr());
+
+            // Keep the handle valid with the debug checker pattern.
+            tex->m_mip_levels = {};
+            tex->m_mip_levels.num_levels      = 1;
+            tex->m_mip_levels.base_memory     = kCheckerDim * kCheckerDim * TextureImage::kBytesPerPixel;
+            tex->m_mip_levels.base_pixels     = reinterpret_cast<const uint8_t *>(MakeCheckerPattern());
+            tex->m_mip_levels.dimensions[0].x = kCheckerDim;
+            tex->m_mip_levels.dimensions[0].y = kCheckerDim;
+            tex->GenerateMipMaps();
+        }
+
+        else if (Config::r_texture_cache.IsSet())
+        {
+            const std::uint64_t texels = tex->Width() * tex->Height();
+            if (load.from_cache)
+            {
+                m_cache_stats.hits++;
+                m_cache_stats.hit_texels += texels;
+                m_cache_stats.hit_us     += load.decode_us;
+            }
+            else
+            {
+                m_cache_stats.misses++;
+                m_cache_stats.miss_texels += texels;
+                m_cache_stats.miss_us     += load.decode_us;
+                m_cache_dirty = true;
+            }
+        }
+
+        if (tex->IsCompressed())
+        {
+            std::uint64_t rgba_bytes = 0;
+            for (uint32_t mip = 0; mip < tex->NumMipMapLevels(); ++mip)
+            {
+                rgba_bytes += TextureLevelSize(TextureFormat::kRGBA8, tex->Width(mip), tex->Height(mip));
+            }
+
+            m_compression_stats.textures++;
+            m_compression_stats.rgba_bytes       += rgba_bytes;
+            m_compression_stats.compressed_bytes += tex->m_mip_levels.base_memory + tex->m_mip_levels.mip_memory;
+            m_compression_stats.encode_us        += load.encode_us;
+        }
+
+        InitBackendTexture(tex);
+
+        GameInterface::FS::FreeFile(load.file_data);
+        if (load.owned_pic8 != nullptr)
+        {
+            MemFreeTracked(load.owned_pic8, pic8_size, MemTag::kTextures);
+        }
+    }
+
+    m_pending_loads.clear();
+
+    const std::uint64_t end_us = HighResTimeMicroseconds();
+    m_queued_load_count += num_loads;
+    m_queued_decode_ms  += double(upload_start_us - decode_start_us) / 1000.0;
+    m_queued_upload_ms  += double(end_us - upload_start_us) / 1000.0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Texture cache file:
+///////////////////////////////////////////////////////////////////////////////
+
+std::uint32_t TextureStore::MipSettings() const
+{
+    // Cached images are only valid for the mipmap and compression settings they were built with.
+    const bool compress = m_block_compression_supported && Config::r_hd_texture_compression.IsSet();
+    return std::uint32_t(CurrentMipFilter()) |
+           (Config::r_no_mipmaps.IsSet()    ? (1u << 8)  : 0u) |
+           (Config::r_debug_mipmaps.IsSet() ? (1u << 9)  : 0u) |
+           (compress                        ? (1u << 10) : 0u);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char * TextureStore::TextureCacheFilename()
+{
+    static char s_cache_filename[1024];
+    sprintf_s(s_cache_filename, "%s/mrq2/texture_cache.bin", GameInterface::FS::GameDir());
+    return s_cache_filename;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStore::LoadFromTextureCache(const TextureCache & cache, TextureImage * const tex)
+{
+    const std::uint32_t name_hash = tex->Name().Hash();
+    const TextureCacheFormat::EntryRecord * entry = cache.Find(CacheKey(name_hash, tex->Type()), name_hash, tex->m_source_hash);
+
+    if (entry == nullptr || entry->dimensions[0].x != tex->Width() || entry->dimensions[0].y != tex->Height() ||
+        entry->format >= std::uint8_t(TextureFormat::kCount) ||
+        entry->base_memory != TextureLevelSize(TextureFormat(entry->format), tex->Width(), tex->Height()))
+    {
+        return false;
+    }
+
+    // Copied out so the mapping doesn't have to outlive the registration.
+    const std::uint8_t * const cached_pixels = cache.EntryPixels(*entry);
+
+    auto * base_pixels = static_cast<uint8_t *>(MemAllocTracked(entry->base_memory, MemTag::kTextures));
+    std::memcpy(base_pixels, cached_pixels, entry->base_memory);
+
+    uint8_t * mip_pixels = nullptr;
+    if (entry->mip_memory != 0)
+    {
+        mip_pixels = static_cast<uint8_t *>(MemAllocTracked(entry->mip_memory, MemTag::kTextures));
+        std::memcpy(mip_pixels, cached_pixels + entry->base_memory, entry->mip_memory);
+    }
+
+    TextureImage::MipLevels & mips = tex->m_mip_levels;
+    mips.num_levels  = entry->num_levels;
+    mips.format      = TextureFormat(entry->format);
+    mips.base_memory = entry->base_memory;
+    mips.mip_memory  = entry->mip_memory;
+    mips.base_pixels = base_pixels;
+    mips.mip_pixels  = mip_pixels;
+    std::memcpy(mips.dimensions, entry->dimensions, sizeof(mips.dimensions));
+    std::memcpy(mips.offsets_to_mip_pixels, entry->offsets_to_mip_pixels, sizeof(mips.offsets_to_mip_pixels));
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStore::WriteTextureCache()
 {
-    if (tt == TextureType::kSkin && Config::r_hd_skins.IsSet())
+    OPTICK_EVENT();
+
+    const std::uint64_t start_us = HighResTimeMicroseconds();
+    auto * items = new(MemTag::kRenderer) TextureCache::WriteItem[TextureCache::kMaxEntries];
+    int num_items = 0;
+
+    // Everything currently loaded from a source image...
+    for (const TextureImage * tex : m_teximages_cache)
     {
-        // First find the dimensions of the original low-res texture
-        int original_w, original_h;
-        if (GetPCXImageDimensions(name, &original_w, &original_h))
+        if (tex->m_source_hash == 0 || tex->IsScrapImage() || tex->BasePixels() == nullptr || num_items == TextureCache::kMaxEntries)
         {
-            // .pcx changes to a .jpg
-            const char * const hd_texture_name = GetHDTextureName(name, "jpg");
-
-            ColorRGBA32 * pic32;
-            int width, height;
-            if (JPGLoadFromFile(hd_texture_name, &pic32, &width, &height))
-            {
-                auto * new_tex = CreateTexture(pic32, m_registration_num, TextureType::kSkin, /*from_scrap =*/false, width, height, {}, {}, name);
-                new_tex->SetHDOverrideOriginalSize(original_w, original_h);
-                return new_tex;
-            }
+            continue;
         }
 
-        // fallback to the low-res classic texture.
+        const TextureImage::MipLevels & mips = tex->m_mip_levels;
+        TextureCache::WriteItem & item = items[num_items++];
+
+        item.record = {};
+        item.record.source_hash         = tex->m_source_hash;
+        item.record.key                 = CacheKey(tex->Name().Hash(), tex->Type());
+        item.record.name_hash           = tex->Name().Hash();
+        item.record.type                = std::uint8_t(tex->Type());
+        item.record.is_hd_override      = tex->m_is_hd_override;
+        item.record.num_levels          = std::uint8_t(mips.num_levels);
+        item.record.format              = std::uint8_t(mips.format);
+        item.record.original_dimensions = tex->m_original_dimensions;
+        item.record.base_memory         = mips.base_memory;
+        item.record.mip_memory          = mips.mip_memory;
+        std::memcpy(item.record.dimensions, mips.dimensions, sizeof(item.record.dimensions));
+        std::memcpy(item.record.offsets_to_mip_pixels, mips.offsets_to_mip_pixels, sizeof(item.record.offsets_to_mip_pixels));
+        item.base_pixels = mips.base_pixels;
+        item.mip_pixels  = mips.mip_pixels;
+    }
+
+    // ...plus the entries of the previous cache file that are not, so textures of other maps are kept.
+    for (int e = 0; e < m_texture_cache.NumEntries() && num_items < TextureCache::kMaxEntries; ++e)
+    {
+        const TextureCacheFormat::EntryRecord & entry = m_texture_cache.Entry(e);
+        const TextureImage * loaded = m_teximages_index.Find(entry.key, [&entry](const TextureImage & t) {
+            return t.Name().Hash() == entry.name_hash && std::uint8_t(t.Type()) == entry.type && t.m_source_hash != 0 && !t.IsEvicted();
+        });
+
+        if (loaded == nullptr)
+        {
+            TextureCache::WriteItem & item = items[num_items++];
+            item.record      = entry;
+            item.base_pixels = m_texture_cache.EntryPixels(entry);
+            item.mip_pixels  = item.base_pixels + entry.base_memory;
+        }
     }
 
-    TextureImage * tex = nullptr;
-    Color8 * pic8;
-    int width, height;
+    // Written next to the old file, which is still mapped, then swapped in.
+    const char * const filename = TextureCacheFilename();
+    char temp_filename[1024];
+    sprintf_s(temp_filename, "%s.tmp", filename);
 
-    if (!PCXLoadFromFile(name, &pic8, &width, &height, nullptr))
+    const bool written = TextureCache::Write(temp_filename, MipSettings(), items, num_items);
+    DeleteArray(items, TextureCache::kMaxEntries, MemTag::kRenderer);
+    m_texture_cache.Close();
+
+    if (written)
     {
-        GameInterface::Printf("WARNING: Can't load PCX pic for '%s'", name);
-        return nullptr;
+        std::remove(filename);
+        if (std::rename(temp_filename, filename) == 0)
+        {
+            m_cache_stats.files_written++;
+            GameInterface::Printf("Wrote texture cache '%s' (%i textures) in %.2f ms.", filename, num_items,
+                                  double(HighResTimeMicroseconds() - start_us) / 1000.0);
+        }
+        else
+        {
+            GameInterface::Printf("WARNING: Failed to replace texture cache file '%s'.", filename);
+            std::remove(temp_filename);
+        }
     }
+}
 
-    // Try placing small images in the scrap atlas:
-    if (tt == TextureType::kPic)
+///////////////////////////////////////////////////////////////////////////////
+// Texture residency:
+///////////////////////////////////////////////////////////////////////////////
+
+std::uint64_t TextureStore::ResidentMemory() const
+{
+    std::uint64_t total_bytes = 0;
+    for (const TextureImage * tex : m_teximages_cache)
     {
-        constexpr int kMaxSizeForScrapPlacement = 64; // in pixels, w & h
-        if (width <= kMaxSizeForScrapPlacement && height <= kMaxSizeForScrapPlacement)
+        if (!tex->IsEvicted())
         {
-            tex = ScrapTryAlloc8Bit(pic8, width, height, name, tt);
+            total_bytes += tex->MemoryUsed();
         }
     }
+    return total_bytes;
+}
 
-    // Atlas full or image too big, create a standalone texture:
-    if (tex == nullptr)
+///////////////////////////////////////////////////////////////////////////////
+
+int TextureStore::NumEvictedTextures() const
+{
+    int num_evicted = 0;
+    for (const TextureImage * tex : m_teximages_cache)
     {
-        tex = Common8BitTexSetup(pic8, width, height, name, tt);
+        num_evicted += tex->IsEvicted() ? 1 : 0;
     }
+    return num_evicted;
+}
 
-    // The palettized pcx image is no longer needed.
-    MemFreeTracked(pic8, (width * height), MemTag::kTextures);
-    return tex;
+///////////////////////////////////////////////////////////////////////////////
+
+bool TextureStore::CanEvict(const TextureImage * const tex) const
+{
+    // Only the mipmapped textures can be reloaded through the load queue. Pics are small and
+    // drawn by the 2D overlays, so they always stay. The idle period also covers the frames
+    // the GPU may still be reading the texture from.
+    return UsesLoadQueue(tex->Type()) && !tex->IsScrapImage() && !tex->IsEvicted() &&
+           tex->BasePixels() != nullptr && !tex->m_reload_failed &&
+           (TextureImage::sm_current_frame - tex->m_last_used_frame) >= kMinIdleFramesBeforeEviction;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-TextureImage * TextureStore::LoadTGAImpl(const char * const name, const TextureType tt)
+void TextureStore::EvictTexture(TextureImage * const tex)
 {
-    ColorRGBA32 * pic32;
-    int width, height;
+    MRQ2_ASSERT(CanEvict(tex));
+    MRQ2_ASSERT(tex_white2x2 != nullptr);
 
-    if (!TGALoadFromFile(name, &pic32, &width, &height))
+    tex->m_texture.Shutdown();
+
+    TextureImage::MipLevels & mips = tex->m_mip_levels;
+    m_residency_stats.evictions++;
+    m_residency_stats.evicted_bytes += mips.base_memory + mips.mip_memory;
+
+    MemFreeTracked(mips.base_pixels, mips.base_memory, MemTag::kTextures);
+    if (mips.mip_pixels != nullptr)
     {
-        GameInterface::Printf("WARNING: Can't load TGA texture for '%s'", name);
-        return nullptr;
+        MemFreeTracked(mips.mip_pixels, mips.mip_memory, MemTag::kTextures);
     }
 
-    // TGAs are always expanded to RGBA, so no extra conversion is needed.
-    return CreateTexture(pic32, m_registration_num, tt, /*from_scrap =*/false, width, height, {}, {}, name);
+    // Keep the base dimensions, the UVs of world surfaces and models depend on them.
+    const Vec2u16 base_dimensions = mips.dimensions[0];
+    mips = {};
+    mips.num_levels    = 1;
+    mips.dimensions[0] = base_dimensions;
+
+    // Shares the backend texture like the scrap images do.
+    tex->m_texture.Init(tex_white2x2->m_texture);
+    tex->m_is_evicted = true;
+    tex->m_reload_requested = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-TextureImage * TextureStore::LoadWALImpl(const char * const name)
+bool TextureStore::QueueTextureReload(TextureImage * const tex)
 {
-    if (Config::r_hd_textures.IsSet())
-    {
-        // First find the dimensions of the original low-res texture
-        int original_w, original_h;
-        if (GetWALImageDimensions(name, &original_w, &original_h))
-        {
-            // .wall changes to a .tga
-            const char * const hd_texture_name = GetHDTextureName(name, "tga");
+    MRQ2_ASSERT(tex->IsEvicted());
 
-            // Load the override
-            ColorRGBA32 * pic32;
-            int width, height;
-            if (TGALoadFromFile(hd_texture_name, &pic32, &width, &height))
-            {
-                auto * new_tex = CreateTexture(pic32, m_registration_num, TextureType::kWall, /*from_scrap =*/false, width, height, {}, {}, name);
+    // QueueTextureLoad() rebuilds the TextureImage in place, so copy out what we need first.
+    char tex_name[PathName::kNameMaxLen];
+    strcpy_s(tex_name, tex->Name().CStr());
+    const std::uint32_t reg_num = tex->m_reg_num;
 
-                // Remember the original image size because the world surfaces require it to correctly compute UVs.
-                new_tex->SetHDOverrideOriginalSize(original_w, original_h);
-                return new_tex;
-            }
-        }
+    m_reload_target = tex;
+    TextureImage * const reloaded = LoadImpl(tex_name, tex->Type());
+    m_reload_target = nullptr;
 
-        // fallback to the low-res classic texture.
+    if (reloaded == tex)
+    {
+        tex->m_reg_num = reg_num;
+        tex->m_last_used_frame = TextureImage::sm_current_frame;
+        m_residency_stats.reloads++;
+        return true;
     }
 
-    GameInterface::FS::ScopedFile file{ name };
-    if (!file.IsLoaded())
+    // The source is gone or didn't go through the load queue, keep drawing the placeholder.
+    MRQ2_ASSERT(tex->IsEvicted());
+    if (reloaded != nullptr)
     {
-        GameInterface::Printf("WARNING: Can't load WAL texture for '%s'", name);
-        return nullptr;
+        DestroyTexture(reloaded);
     }
 
-    auto * wall = static_cast<const miptex_t *>(file.data_ptr);
-
-    const int width  = wall->width;
-    const int height = wall->height;
-    const int offset = wall->offsets[0];
-    auto * pic8 = reinterpret_cast<const Color8 *>(wall) + offset;
-
-    return Common8BitTexSetup(pic8, width, height, name, TextureType::kWall);
+    tex->m_reload_failed = true;
+    m_residency_stats.reload_failures++;
+    GameInterface::Printf("WARNING: Failed to reload evicted texture '%s'", tex_name);
+    return false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-TextureImage * TextureStore::ScrapTryAlloc8Bit(const Color8 * const pic8, const int width, const int height, const char * const name, const TextureType tt)
+void TextureStore::UpdateResidency()
 {
-    MRQ2_ASSERT(width > 0 && height > 0);
-    MRQ2_ASSERT(m_scrap.IsInitialised());
+    // Registration references and loads textures in bulk, wait for it to end.
+    if (m_registration_in_progress)
+    {
+        return;
+    }
 
-    // Adding a 2 pixels padding border around each side to avoid sampling artifacts.
-    const int padded_width  = width  + 2;
-    const int padded_height = height + 2;
+    OPTICK_EVENT();
 
-    int sx = 0;
-    int sy = 0;
-    int best = m_scrap.Size();
+    ++TextureImage::sm_current_frame;
 
-    // Try to find a good fit in the atlas:
-    for (int i = 0; i < m_scrap.Size() - padded_width; ++i)
+    // Reload whatever was drawn while evicted, all in one batch through the load queue.
+    bool reloading = false;
+    for (TextureImage * tex : m_teximages_cache)
     {
-        int j, best2 = 0;
-        for (j = 0; j < padded_width; ++j)
+        if (tex->m_reload_requested && !tex->m_reload_failed)
         {
-            if (m_scrap.allocated[i + j] >= best)
+            if (!reloading && Config::r_texture_cache.IsSet())
             {
-                break;
+                m_texture_cache.Open(TextureCacheFilename(), MipSettings());
             }
-            if (m_scrap.allocated[i + j] > best2)
-            {
-                best2 = m_scrap.allocated[i + j];
-            }
-        }
-
-        if (j == padded_width) // This is a valid spot
-        {
-            sx = i;
-            sy = best = best2;
+            reloading = true;
+            QueueTextureReload(tex);
         }
+        tex->m_reload_requested = false;
     }
 
-    // No more room.
-    if ((best + padded_height) > m_scrap.Size())
+    if (reloading)
     {
-        return nullptr;
+        FlushPendingTextureLoads();
+        m_texture_cache.Close();
     }
 
-    // Managed to allocate, update the scrap:
-    for (int i = 0; i < padded_width; ++i)
+    std::uint64_t resident_bytes = ResidentMemory();
+    m_residency_stats.peak_bytes = std::max(m_residency_stats.peak_bytes, resident_bytes);
+
+    const std::uint64_t budget_bytes = std::uint64_t(std::max(Config::r_texture_budget_mb.AsInt(), 0)) * 1024 * 1024;
+    if (budget_bytes == 0 || resident_bytes <= budget_bytes)
     {
-        m_scrap.allocated[sx + i] = best + padded_height;
+        return;
     }
 
-    // Expand pic to RGBA:
-    auto * pic32 = new(MemTag::kTextures) ColorRGBA32[width * height];
-    UnPalettize8To32(width, height, pic8, sm_global_palette, pic32);
-
-    // Copy the pixels into the scrap block:
-    int k = 0;
-    for (int i = 0; i < height; ++i)
+    // Least recently drawn first.
+    FixedSizeArray<TextureImage *, kTexturePoolSize> candidates;
+    for (TextureImage * tex : m_teximages_cache)
     {
-        for (int j = 0; j < width; ++j, ++k)
+        if (CanEvict(tex))
         {
-            m_scrap.pixels[(sy + i) * m_scrap.Size() + sx + j] = pic32[k];
+            candidates.push_back(tex);
         }
     }
 
-    Vec2u16 uv0, uv1;
-    uv0.x = std::uint16_t(sx);
-    uv0.y = std::uint16_t(sy);
-    uv1.x = std::uint16_t(sx + width);
-    uv1.y = std::uint16_t(sy + height);
-
-    // Pass ownership of the pixel data
-    return CreateTexture(pic32, m_registration_num, tt, /*from_scrap =*/true, width, height, uv0, uv1, name);
-}
-
-///////////////////////////////////////////////////////////////////////////////
-
-TextureImage * TextureStore::Common8BitTexSetup(const Color8 * const pic8, const int width, const int height, const char * const name, const TextureType tt)
-{
-    MRQ2_ASSERT(width > 0 && height > 0);
-
-    auto * pic32 = new(MemTag::kTextures) ColorRGBA32[width * height];
-    UnPalettize8To32(width, height, pic8, sm_global_palette, pic32);
-
-    // Pass ownership of the pixel data
-    return CreateTexture(pic32, m_registration_num, tt, /*from_scrap =*/false, width, height, {}, {}, name);
-}
-
-///////////////////////////////////////////////////////////////////////////////
+    std::sort(candidates.begin(), candidates.end(), [](const TextureImage * a, const TextureImage * b) {
+        return a->m_last_used_frame < b->m_last_used_frame;
+    });
 
-void TextureStore::UnPalettize8To32(const int width, const int height, const Color8 * const pic8in,
-                                    const ColorRGBA32 * const palette, ColorRGBA32 * const pic32out)
-{
-    const int pixel_count = width * height;
-    for (int i = 0; i < pixel_count; ++i)
+    for (TextureImage * tex : candidates)
     {
-        int p = pic8in[i];
-        pic32out[i] = palette[p];
-
-        // Transparency algorithm adapted from GL_Upload8 in ref_gl/gl_image.c
-        if (p == 255)
+        if (resident_bytes <= budget_bytes)
         {
-            // Transparent, so scan around for another
-            // color to avoid alpha fringes
-            if (i > width && pic8in[i - width] != 255)
-            {
-                p = pic8in[i - width];
-            }
-            else if (i < pixel_count - width && pic8in[i + width] != 255)
-            {
-                p = pic8in[i + width];
-            }
-            else if (i > 0 && pic8in[i - 1] != 255)
-            {
-                p = pic8in[i - 1];
-            }
-            else if (i < pixel_count - 1 && pic8in[i + 1] != 255)
-            {
-                p = pic8in[i + 1];
-            }
-            else
-            {
-                p = 0;
-            }
-
-            // Copy RGB components:
-            reinterpret_cast<Color8 *>(&pic32out[i])[0] = reinterpret_cast<const Color8 *>(&palette[p])[0];
-            reinterpret_cast<Color8 *>(&pic32out[i])[1] = reinterpret_cast<const Color8 *>(&palette[p])[1];
-            reinterpret_cast<Color8 *>(&pic32out[i])[2] = reinterpret_cast<const Color8 *>(&palette[p])[2];
+            break;
         }
+
+        resident_bytes -= tex->MemoryUsed();
+        EvictTexture(tex);
     }
 }
 
@@ -1314,9 +2410,13 @@ struct TGAFileHeader
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Size of the TGA header in the file (TGAFileHeader is padded).
+constexpr int kTGAFileHeaderSize = 18;
+
 // Mostly adapted from LoadTGA, ref_gl/gl_image.c
 // Note: Output image is always RGBA 32bits.
-bool TGALoadFromFile(const char * const filename, ColorRGBA32 ** pic, int * width, int * height)
+bool TGALoadFromMemory(const char * const filename, const std::uint8_t * const buffer, const int data_len,
+                       ColorRGBA32 ** pic, int * width, int * height)
 {
     TGAFileHeader targa_header;
     int column, row;
@@ -1325,15 +2425,12 @@ bool TGALoadFromFile(const char * const filename, ColorRGBA32 ** pic, int * widt
 
     *pic = nullptr;
 
-    GameInterface::FS::ScopedFile file{ filename };
-    if (!file.IsLoaded())
+    if (data_len < kTGAFileHeaderSize)
     {
         GameInterface::Printf("Bad TGA file '%s'", filename);
         return false;
     }
 
-    auto * buffer = static_cast<const std::uint8_t *>(file.data_ptr);
-
     const std::uint8_t * buf_p = buffer;
     targa_header.id_length     = *buf_p++;
     targa_header.colormap_type = *buf_p++;
@@ -1546,28 +2643,60 @@ bool TGALoadFromFile(const char * const filename, ColorRGBA32 ** pic, int * widt
     return true;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// PNG/JPEG loaders using STBI
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline bool Stb_LoadFromFileCommon(const char * filename, ColorRGBA32 ** pic, int * width, int * height)
+bool TGALoadFromFile(const char * const filename, ColorRGBA32 ** pic, int * width, int * height)
 {
-    *pic    = nullptr;
-    *width  = 0;
-    *height = 0;
-
     GameInterface::FS::ScopedFile file{ filename };
     if (!file.IsLoaded())
     {
-        GameInterface::Printf("Can't open image file '%s'", filename);
+        *pic = nullptr;
+        GameInterface::Printf("Bad TGA file '%s'", filename);
+        return false;
+    }
+
+    return TGALoadFromMemory(filename, static_cast<const std::uint8_t *>(file.data_ptr), file.length, pic, width, height);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Validates the header of a TGA image in memory without decoding it. Same restrictions as TGALoadFromMemory.
+static bool TGAPeekDimensions(const std::uint8_t * const buffer, const int data_len, int * width, int * height)
+{
+    if (data_len < kTGAFileHeaderSize)
+    {
+        return false;
+    }
+
+    const int image_type    = buffer[2];
+    const int colormap_type = buffer[1];
+    const int pixel_size    = buffer[16];
+
+    if ((image_type != 2 && image_type != 10) || colormap_type != 0 || (pixel_size != 32 && pixel_size != 24))
+    {
         return false;
     }
 
+    *width  = buffer[12] | (buffer[13] << 8);
+    *height = buffer[14] | (buffer[15] << 8);
+    return (*width > 0 && *height > 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PNG/JPEG loaders using STBI
+///////////////////////////////////////////////////////////////////////////////
+
+// Safe to call from any thread; doesn't print.
+static bool Stb_LoadFromMemoryCommon(const void * data, const int data_len, ColorRGBA32 ** pic, int * width, int * height)
+{
+    *pic    = nullptr;
+    *width  = 0;
+    *height = 0;
+
     int n = 0;
-    stbi_uc * img_data = stbi_load_from_memory(reinterpret_cast<stbi_uc const *>(file.data_ptr), file.length, width, height, &n, TextureImage::kBytesPerPixel);
+    stbi_uc * img_data = stbi_load_from_memory(static_cast<stbi_uc const *>(data), data_len, width, height, &n, TextureImage::kBytesPerPixel);
     if (img_data == nullptr)
     {
-        GameInterface::Printf("stbi_load_from_memory('%s') failed!", filename);
         return false;
     }
 
@@ -1582,6 +2711,37 @@ static inline bool Stb_LoadFromFileCommon(const char * filename, ColorRGBA32 **
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static bool Stb_PeekDimensions(const void * data, const int data_len, int * width, int * height)
+{
+    int n = 0;
+    return stbi_info_from_memory(static_cast<stbi_uc const *>(data), data_len, width, height, &n) != 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline bool Stb_LoadFromFileCommon(const char * filename, ColorRGBA32 ** pic, int * width, int * height)
+{
+    GameInterface::FS::ScopedFile file{ filename };
+    if (!file.IsLoaded())
+    {
+        *pic    = nullptr;
+        *width  = 0;
+        *height = 0;
+        GameInterface::Printf("Can't open image file '%s'", filename);
+        return false;
+    }
+
+    if (!Stb_LoadFromMemoryCommon(file.data_ptr, file.length, pic, width, height))
+    {
+        GameInterface::Printf("stbi_load_from_memory('%s') failed!", filename);
+        return false;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool PNGLoadFromFile(const char * filename, ColorRGBA32 ** pic, int * width, int * height)
 {
     return Stb_LoadFromFileCommon(filename, pic, width, height);
@@ -7,6 +7,10 @@
 #include "Common.hpp"
 #include "Pool.hpp"
 #include "Array.hpp"
+#include "AtlasPacker.hpp"
+#include "HashIndex.hpp"
+#include "TextureCache.hpp"
+#include "TextureCompression.hpp"
 #include "RenderInterface.hpp"
 
 namespace MrQ2
@@ -18,9 +22,6 @@ constexpr int kQuakeCinematicImgSize = 256;
 // Size in entries (u32s) of the game palettes.
 constexpr int kQuakePaletteSize = 256;
 
-// Defined by ModelStructs.hpp, but we only need a forward decl here.
-struct ModelSurface;
-
 /*
 ===============================================================================
 
@@ -57,7 +58,7 @@ class TextureImage final
 public:
 
     static constexpr int kMaxMipLevels  = 8; // Level 0 is the base texture, 7 mipmaps in total.
-    static constexpr int kBytesPerPixel = 4; // All textures are RGBA_U8
+    static constexpr int kBytesPerPixel = 4; // Uncompressed textures are RGBA_U8
 
     // Disallow copy.
     TextureImage(const TextureImage &) = delete;
@@ -83,23 +84,37 @@ public:
     }
 
     const PathName & Name() const { return m_name; }
-    const Texture  & BackendTexture() const { return m_texture; }
     TextureType Type() const { return m_type; }
 
+    // Called when binding the texture for drawing (main thread only), which also
+    // counts as a use for the residency LRU. Evicted textures return a placeholder
+    // and get reloaded by TextureStore::UpdateResidency() on the next frame.
+    const Texture & BackendTexture() const
+    {
+        m_last_used_frame = sm_current_frame;
+        m_reload_requested |= m_is_evicted;
+        return m_texture;
+    }
+
+    // Residency (r_texture_budget_mb)
+    bool IsEvicted() const { return m_is_evicted; }
+    std::uint32_t LastUsedFrame() const { return m_last_used_frame; }
+    std::uint32_t MemoryUsed() const { return m_is_scrap_image ? 0 : (m_mip_levels.base_memory + m_mip_levels.mip_memory); }
+
     // Scrap atlas
     bool IsScrapImage() const { return m_is_scrap_image; }
     Vec2u16 ScrapUV0()  const { return m_scrap_coords.uv0; }
     Vec2u16 ScrapUV1()  const { return m_scrap_coords.uv1; }
 
-    // Draw by texture linked list used by the world renderer
-    void SetDrawChainPtr(const ModelSurface * p) const { m_draw_chain = p; }
-    const ModelSurface * DrawChainPtr() const { return m_draw_chain; }
-
     // Mipmaps
     bool SupportsMipMaps() const { return m_type < TextureType::kPic; }
     bool HasMipMaps() const { return m_mip_levels.num_levels > 1; }
     uint32_t NumMipMapLevels() const { return m_mip_levels.num_levels; }
 
+    // Pixel format. If block compressed, the pixel pointers below point to the raw 4x4 blocks.
+    TextureFormat Format() const { return m_mip_levels.format; }
+    bool IsCompressed() const { return IsBlockCompressed(m_mip_levels.format); }
+
     const ColorRGBA32 * BasePixels() const
     {
         return reinterpret_cast<const ColorRGBA32 *>(m_mip_levels.base_pixels);
@@ -190,12 +205,14 @@ private:
     }
 
     void GenerateMipMaps();
+    void CompressMipMaps(TextureFormat format);
 
 private:
 
     struct MipLevels
     {
         uint32_t        num_levels;
+        TextureFormat   format;      // Same for all levels. kRGBA8 unless compressed by CompressMipMaps().
         uint32_t        base_memory;
         uint32_t        mip_memory;
         const uint8_t * base_pixels; // Pixels for mip level 0 (the base level / original image)
@@ -212,16 +229,22 @@ private:
 
     const PathName               m_name;                    // Texture filename/unique id (must be the first field - game code assumes this).
     MipLevels                    m_mip_levels{};            // Dimensions and offsets for each mipmap level. Always at least one.
-    mutable const ModelSurface * m_draw_chain{ nullptr };   // For sort-by-texture world drawing.
     uint32_t                     m_reg_num{ 0 };            // Registration number, so we know if currently referenced by the level being played.
     const TextureType            m_type;                    // Types of textures used by Quake.
     const bool                   m_is_scrap_image;          // True if allocated from the scrap atlas.
     bool                         m_is_hd_override{ false }; // True if this texture was replaced by a higher quality override (m_original_dimensions contain the size of the original low-res image).
+    std::uint64_t                m_source_hash{ 0 };        // FnvHash64 of the source image, used by the texture cache. Zero if not loaded through the load queue or r_texture_cache is off.
+    mutable std::uint32_t        m_last_used_frame{ 0 };    // sm_current_frame when last bound for drawing or referenced by registration.
+    mutable bool                 m_reload_requested{ false }; // Drawn while evicted.
+    bool                         m_is_evicted{ false };     // Pixels and backend texture released to stay under the budget. m_texture is a placeholder.
+    bool                         m_reload_failed{ false };  // Source could not be reloaded after eviction, stays a placeholder.
     union {
         Vec2u16                  m_original_dimensions;     // If not a scrap image reuse this to store the original mip0 width/height in case this image is an HD replacement.
         ScrapCoords              m_scrap_coords;            // Offsets into the scrap if this is allocate from the scrap, zero otherwise.
     };
     Texture                      m_texture;                 // Back-end renderer low-level texture object.
+
+    static std::uint32_t         sm_current_frame;          // Advanced by TextureStore::UpdateResidency().
 };
 
 /*
@@ -243,6 +266,7 @@ public:
 
     void UploadScrapIfNeeded();
     bool ScrapIsDirty() const { return m_scrap_dirty; }
+    const AtlasPacker & ScrapPacker() const { return m_scrap.packer; }
     const RenderDevice & Device() const { return *m_device; }
 
     // Registration sequence:
@@ -250,6 +274,67 @@ public:
     void EndRegistration();
     std::uint32_t RegistrationNum() const { return m_registration_num; }
 
+    // Mipmapped textures are loaded in two steps: the file is read and a handle created, then the
+    // decoding and mipmapping run on the JobSystem when the pending loads are flushed and the backend
+    // textures are all created in one batch. During registration with r_async_texture_loads set,
+    // the loads are only flushed by EndRegistration, otherwise right away.
+    void FlushPendingTextureLoads();
+    int NumPendingTextureLoads() const { return m_pending_loads.size(); }
+
+    // Stats for the loads flushed since BeginRegistration.
+    int QueuedLoadCount() const { return m_queued_load_count; }
+    double QueuedDecodeMs() const { return m_queued_decode_ms; }
+    double QueuedUploadMs() const { return m_queued_upload_ms; }
+
+    // Texture cache file (r_texture_cache), session totals.
+    struct TextureCacheStats
+    {
+        int           hits;
+        int           misses;
+        int           files_written;
+        std::uint64_t hit_texels;
+        std::uint64_t miss_texels;
+        std::uint64_t hit_us;  // Job time spent copying cached images
+        std::uint64_t miss_us; // Job time spent decoding and mipmapping
+    };
+    const TextureCacheStats & CacheStats() const { return m_cache_stats; }
+    static const char * TextureCacheFilename();
+
+    // HD replacement textures at least this big in both dimensions are block compressed (r_hd_texture_compression).
+    static constexpr int kMinCompressedTextureSize = 128;
+
+    // Block compressed textures, session totals.
+    struct TextureCompressionStats
+    {
+        int           textures;
+        std::uint64_t rgba_bytes;       // Memory the textures would use as RGBA, all mip levels
+        std::uint64_t compressed_bytes; // Memory actually used, all mip levels
+        std::uint64_t encode_us;        // Job time spent encoding (textures from the cache file are free)
+    };
+    const TextureCompressionStats & CompressionStats() const { return m_compression_stats; }
+    bool BlockCompressionSupported() const { return m_block_compression_supported; }
+
+    // Texture memory budget (r_texture_budget_mb), called once per frame. Reloads the evicted textures
+    // drawn since the last call, then evicts the least recently drawn mipmapped textures while over
+    // budget. Evicted textures keep their handles and draw with a placeholder until reloaded.
+    void UpdateResidency();
+
+    // Textures drawn within this many frames are never evicted, even if over budget.
+    static constexpr std::uint32_t kMinIdleFramesBeforeEviction = 30;
+
+    // Residency stats, session totals.
+    struct TextureResidencyStats
+    {
+        int           evictions;
+        int           reloads;
+        int           reload_failures;
+        std::uint64_t evicted_bytes;
+        std::uint64_t peak_bytes;
+    };
+    const TextureResidencyStats & ResidencyStats() const { return m_residency_stats; }
+    std::uint64_t ResidentMemory() const; // Pixel memory of all loaded textures, not counting scrap images.
+    int NumEvictedTextures() const;
+
     // Texture cache:
     const TextureImage * Find(const char * name, TextureType tt);       // Must be in cache, null otherwise
     const TextureImage * FindOrLoad(const char * name, TextureType tt); // Load if necessary
@@ -260,6 +345,9 @@ public:
     // Dumps all loaded textures to the correct paths, creating dirs as needed.
     void DumpAllLoadedTexturesToFile(const char * path, const char * file_type, bool dump_mipmaps) const;
 
+    // Times each mipmap filter over the loaded mipmapped textures (mipmap_bench command).
+    void BenchmarkMipMaps(int iterations) const;
+
     // TextureStore iteration:
     auto begin() { return m_teximages_cache.begin(); }
     auto end()   { return m_teximages_cache.end();   }
@@ -289,15 +377,24 @@ private:
     TextureImage * CreateScrapTexture(const uint32_t size, const ColorRGBA32 * pixels);
     TextureImage * CreateTexture(const ColorRGBA32 * pixels, uint32_t reg_num, TextureType tt, bool from_scrap,
                                  uint32_t w, uint32_t h, Vec2u16 scrap0, Vec2u16 scrap1, const char * name);
+    void InitBackendTexture(TextureImage * tex);
 
     void DestroyTexture(TextureImage * tex);
     void DestroyAllLoadedTextures();
 
+    // Adds to m_teximages_cache and its hash index.
+    void AddToCache(TextureImage * tex);
+    void RebuildCacheIndex();
+    static std::uint32_t CacheKey(std::uint32_t name_hash, TextureType tt);
+
     // Reference all the default 'tex_' TextureImages and create the scrap (if needed).
     void TouchResidentTextures();
 
     static const char * NameFixup(const char * in, TextureType tt);
 
+    // Picks the loader from the file extension.
+    TextureImage * LoadImpl(const char * tex_name, TextureType tt);
+
     TextureImage * LoadPCXImpl(const char * name, TextureType tt);
     TextureImage * LoadTGAImpl(const char * name, TextureType tt);
     TextureImage * LoadWALImpl(const char * name);
@@ -311,6 +408,44 @@ private:
     static void UnPalettize8To32(int width, int height, const Color8 * pic8in,
                                  const ColorRGBA32 * palette, ColorRGBA32 * pic32out);
 
+    // Asynchronous decoding (r_async_texture_loads):
+    struct PendingTextureLoad
+    {
+        enum class Source : std::uint8_t
+        {
+            kPalettized, // pic8 is expanded with the global palette
+            kTGA,        // file_data is a TGA image
+            kStb,        // file_data is a PNG/JPG image
+        };
+
+        TextureImage * tex;
+        void *         file_data;   // From FS::LoadFile, freed once the load is resolved. May be null for kPalettized.
+        int            file_length;
+        const Color8 * pic8;        // kPalettized only, points into file_data or owned_pic8.
+        Color8 *       owned_pic8;  // Decoded PCX image, freed once the load is resolved.
+        Source         source;
+        bool           failed;      // Set by the decoding job.
+        bool           from_cache;  // Set by the decoding job.
+        std::uint64_t  decode_us;   // Set by the decoding job.
+        std::uint64_t  encode_us;   // Set by the decoding job, part of decode_us.
+    };
+
+    static bool UsesLoadQueue(TextureType tt);
+    bool DeferPendingLoads() const;
+    TextureImage * QueueTextureLoad(const PendingTextureLoad & load, int width, int height, TextureType tt, const char * name);
+    static void DecodeTextureJob(void * user_data, int job_index, int thread_index);
+    bool ShouldCompress(const TextureImage * tex) const;
+
+    // Texture residency:
+    bool CanEvict(const TextureImage * tex) const;
+    void EvictTexture(TextureImage * tex);
+    bool QueueTextureReload(TextureImage * tex);
+
+    // Texture cache file:
+    std::uint32_t MipSettings() const;
+    static bool LoadFromTextureCache(const TextureCache & cache, TextureImage * tex);
+    void WriteTextureCache();
+
 private:
 
     // Palette used to expand the 8bits textures to RGBA32.
@@ -325,34 +460,27 @@ private:
     // reducing the number of texture switches when rendering.
     struct ScrapAtlas
     {
-        int * allocated{ nullptr };      // Allocated space map
+        AtlasPacker packer;              // Allocated space map
         ColorRGBA32 * pixels{ nullptr }; // RGBA pixels
 
         void Init()
         {
-            // Allocate zero-initialized arrays
+            packer.Reset(kScrapSize, kScrapSize, AtlasPacker::DefaultHeuristic());
 
-            size_t size = sizeof(int) * kScrapSize;
-            allocated = (int *)MemAllocTracked(size, MemTag::kTextures);
-            std::memset(allocated, 0, size);
-
-            size = sizeof(ColorRGBA32) * (kScrapSize * kScrapSize);
+            // Allocate zero-initialized pixels
+            const size_t size = sizeof(ColorRGBA32) * (kScrapSize * kScrapSize);
             pixels = (ColorRGBA32 *)MemAllocTracked(size, MemTag::kTextures);
             std::memset(pixels, 0, size);
         }
 
         void Shutdown()
         {
-            size_t size = sizeof(int) * kScrapSize;
-            MemFreeTracked(allocated, size, MemTag::kTextures);
-            allocated = nullptr;
-
-            size = sizeof(ColorRGBA32) * (kScrapSize * kScrapSize);
+            const size_t size = sizeof(ColorRGBA32) * (kScrapSize * kScrapSize);
             MemFreeTracked(pixels, size, MemTag::kTextures);
             pixels = nullptr;
         }
 
-        bool IsInitialised() const  { return allocated != nullptr; }
+        bool IsInitialised() const  { return pixels != nullptr; }
         constexpr static int Size() { return kScrapSize; }
     };
 
@@ -366,11 +494,35 @@ private:
     std::uint32_t m_registration_num{ 0 };
     Pool<TextureImage, kTexturePoolSize> m_teximages_pool{ MemTag::kTextures };
     FixedSizeArray<TextureImage *, kTexturePoolSize> m_teximages_cache;
+    HashIndex<TextureImage, kTexturePoolSize * 2> m_teximages_index; // Keyed by CacheKey(name hash, type)
+
+    // Loads waiting for FlushPendingTextureLoads()
+    FixedSizeArray<PendingTextureLoad, kTexturePoolSize> m_pending_loads;
+    bool m_registration_in_progress{ false };
+    int m_queued_load_count{ 0 };
+    double m_queued_decode_ms{ 0.0 };
+    double m_queued_upload_ms{ 0.0 };
+
+    // Mapped from BeginRegistration to EndRegistration, rewritten if any queued texture was not found in it.
+    TextureCache m_texture_cache;
+    TextureCacheStats m_cache_stats{};
+    bool m_cache_dirty{ false };
+    bool m_use_texture_cache{ false }; // r_texture_cache, sampled when the pending loads are flushed.
+
+    // r_hd_texture_compression, sampled when the pending loads are flushed.
+    TextureCompressionStats m_compression_stats{};
+    bool m_block_compression_supported{ false };
+    bool m_compress_hd_textures{ false };
+
+    // Evicted texture being reloaded, reused by QueueTextureLoad() so its handle stays valid.
+    TextureImage * m_reload_target{ nullptr };
+    TextureResidencyStats m_residency_stats{};
 };
 
 // ============================================================================
 
 bool TGALoadFromFile(const char * filename, ColorRGBA32 ** pic, int * width, int * height);
+bool TGALoadFromMemory(const char * filename, const std::uint8_t * data, int data_len, ColorRGBA32 ** pic, int * width, int * height);
 bool PNGLoadFromFile(const char * filename, ColorRGBA32 ** pic, int * width, int * height);
 bool JPGLoadFromFile(const char * filename, ColorRGBA32 ** pic, int * width, int * height);
 bool PCXLoadFromFile(const char * filename, Color8 ** pic, int * width, int * height, ColorRGBA32 * palette);
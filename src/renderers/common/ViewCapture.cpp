@@ -0,0 +1,323 @@
+//
+// ViewCapture.cpp
+//  Recording of the refdef_t stream sent to DLLInterface::RenderView into
+//  a binary file that can later be replayed for CPU benchmarking.
+//
+
+#include "ViewCapture.hpp"
+#include "ModelStore.hpp"
+#include "TextureStore.hpp"
+#include <cstddef>
+
+namespace MrQ2
+{
+
+using namespace ViewCaptureFormat;
+
+///////////////////////////////////////////////////////////////////////////////
+// ViewCaptureWriter
+///////////////////////////////////////////////////////////////////////////////
+
+bool ViewCaptureWriter::Open(const char * filename, const char * map_name)
+{
+    MRQ2_ASSERT(filename != nullptr && filename[0] != '\0');
+    MRQ2_ASSERT(map_name != nullptr);
+
+    Close();
+
+    GameInterface::FS::CreatePath(filename);
+
+    std::FILE * file = nullptr;
+    if (fopen_s(&file, filename, "wb") != 0 || file == nullptr)
+    {
+        GameInterface::Printf("WARNING: Failed to open view capture file '%s' for writing.", filename);
+        return false;
+    }
+
+    FileHeader header{};
+    header.magic      = kMagic;
+    header.version    = kVersion;
+    header.num_frames = 0;
+    strcpy_s(header.map_name, map_name);
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    m_file = file;
+    m_num_frames = 0;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewCaptureWriter::Close()
+{
+    if (m_file == nullptr)
+    {
+        return;
+    }
+
+    // Patch the frame count in the header.
+    std::fseek(m_file, offsetof(FileHeader, num_frames), SEEK_SET);
+    std::fwrite(&m_num_frames, sizeof(m_num_frames), 1, m_file);
+
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewCaptureWriter::WriteFrame(const refdef_t & view_def)
+{
+    MRQ2_ASSERT(m_file != nullptr);
+
+    FrameRecord frame{};
+    frame.x               = view_def.x;
+    frame.y               = view_def.y;
+    frame.width           = view_def.width;
+    frame.height          = view_def.height;
+    frame.fov_x           = view_def.fov_x;
+    frame.fov_y           = view_def.fov_y;
+    frame.time            = view_def.time;
+    frame.rdflags         = view_def.rdflags;
+    frame.has_areabits    = (view_def.areabits != nullptr);
+    frame.has_lightstyles = (view_def.lightstyles != nullptr);
+    frame.num_entities    = static_cast<std::uint16_t>(view_def.num_entities);
+    frame.num_dlights     = static_cast<std::uint16_t>(view_def.num_dlights);
+    frame.num_particles   = static_cast<std::uint16_t>(view_def.num_particles);
+    Vec3Copy(view_def.vieworg, frame.vieworg);
+    Vec3Copy(view_def.viewangles, frame.viewangles);
+    std::memcpy(frame.blend, view_def.blend, sizeof(frame.blend));
+
+    std::fwrite(&frame, sizeof(frame), 1, m_file);
+
+    if (frame.has_areabits)
+    {
+        std::fwrite(view_def.areabits, kAreaBitsSize, 1, m_file);
+    }
+    if (frame.has_lightstyles)
+    {
+        std::fwrite(view_def.lightstyles, sizeof(lightstyle_t), MAX_LIGHTSTYLES, m_file);
+    }
+
+    for (int e = 0; e < view_def.num_entities; ++e)
+    {
+        const entity_t & entity = view_def.entities[e];
+
+        EntityRecord record{};
+        if (entity.model != nullptr)
+        {
+            const auto * model = reinterpret_cast<const ModelInstance *>(entity.model);
+            if (model->is_inline)
+            {
+                // Name is "inline_model_N", game refers to them as "*N".
+                const char * const number = std::strrchr(model->name.CStr(), '_');
+                MRQ2_ASSERT(number != nullptr);
+                sprintf_s(record.model_name, "*%s", number + 1);
+            }
+            else
+            {
+                strcpy_s(record.model_name, model->name.CStr());
+            }
+        }
+        if (entity.skin != nullptr)
+        {
+            const auto * skin = reinterpret_cast<const TextureImage *>(entity.skin);
+            strcpy_s(record.skin_name, skin->Name().CStr());
+        }
+
+        Vec3Copy(entity.angles, record.angles);
+        Vec3Copy(entity.origin, record.origin);
+        Vec3Copy(entity.oldorigin, record.oldorigin);
+        record.frame      = entity.frame;
+        record.oldframe   = entity.oldframe;
+        record.backlerp   = entity.backlerp;
+        record.skinnum    = entity.skinnum;
+        record.lightstyle = entity.lightstyle;
+        record.alpha      = entity.alpha;
+        record.flags      = entity.flags;
+
+        std::fwrite(&record, sizeof(record), 1, m_file);
+    }
+
+    if (view_def.num_dlights > 0)
+    {
+        std::fwrite(view_def.dlights, sizeof(dlight_t), view_def.num_dlights, m_file);
+    }
+    if (view_def.num_particles > 0)
+    {
+        std::fwrite(view_def.particles, sizeof(particle_t), view_def.num_particles, m_file);
+    }
+
+    ++m_num_frames;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ViewCaptureReader
+///////////////////////////////////////////////////////////////////////////////
+
+bool ViewCaptureReader::Load(const char * filename)
+{
+    MRQ2_ASSERT(filename != nullptr && filename[0] != '\0');
+
+    Unload();
+
+    GameInterface::FS::ScopedFile file{ filename };
+    if (!file.IsLoaded() || std::size_t(file.length) < sizeof(FileHeader))
+    {
+        GameInterface::Printf("WARNING: Failed to load view capture file '%s'.", filename);
+        return false;
+    }
+
+    std::memcpy(&m_header, file.data_ptr, sizeof(FileHeader));
+    if (m_header.magic != kMagic || m_header.version != kVersion)
+    {
+        GameInterface::Printf("WARNING: '%s' is not a valid view capture file (version %u, expected %u).",
+                              filename, m_header.version, kVersion);
+        return false;
+    }
+    if (m_header.num_frames == 0)
+    {
+        GameInterface::Printf("WARNING: View capture file '%s' has no frames.", filename);
+        return false;
+    }
+
+    m_file_size = static_cast<std::uint32_t>(file.length);
+    m_file_data = new(MemTag::kRenderer) std::uint8_t[m_file_size];
+    std::memcpy(m_file_data, file.data_ptr, m_file_size);
+
+    // Index the frames so DecodeFrame can seek directly.
+    m_frame_offsets = new(MemTag::kRenderer) std::uint32_t[m_header.num_frames];
+
+    std::uint32_t offset = sizeof(FileHeader);
+    for (std::uint32_t f = 0; f < m_header.num_frames; ++f)
+    {
+        if (offset + sizeof(FrameRecord) > m_file_size)
+        {
+            GameInterface::Printf("WARNING: View capture '%s' is truncated at frame %u.", filename, f);
+            break;
+        }
+
+        FrameRecord frame;
+        std::memcpy(&frame, m_file_data + offset, sizeof(FrameRecord));
+
+        std::uint32_t frame_size = sizeof(FrameRecord);
+        frame_size += frame.has_areabits    ? kAreaBitsSize : 0;
+        frame_size += frame.has_lightstyles ? sizeof(lightstyle_t) * MAX_LIGHTSTYLES : 0;
+        frame_size += sizeof(EntityRecord) * frame.num_entities;
+        frame_size += sizeof(dlight_t)     * frame.num_dlights;
+        frame_size += sizeof(particle_t)   * frame.num_particles;
+
+        if (frame.num_entities > MAX_ENTITIES || frame.num_dlights > MAX_DLIGHTS ||
+            frame.num_particles > MAX_PARTICLES || offset + frame_size > m_file_size)
+        {
+            GameInterface::Printf("WARNING: View capture '%s' has a corrupted frame %u.", filename, f);
+            break;
+        }
+
+        m_frame_offsets[m_num_frames++] = offset;
+        offset += frame_size;
+    }
+
+    GameInterface::Printf("Loaded view capture '%s': %u frames, map '%s'.", filename, m_num_frames, m_header.map_name);
+    return m_num_frames > 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewCaptureReader::Unload()
+{
+    DeleteArray(m_frame_offsets, m_header.num_frames, MemTag::kRenderer);
+    DeleteArray(m_file_data, m_file_size, MemTag::kRenderer);
+
+    m_frame_offsets = nullptr;
+    m_file_data     = nullptr;
+    m_file_size     = 0;
+    m_num_frames    = 0;
+    m_header        = {};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewCaptureReader::DecodeFrame(std::uint32_t frame_index, ModelStore & mdl_store, TextureStore & tex_store, refdef_t * out_view_def)
+{
+    MRQ2_ASSERT(frame_index < m_num_frames);
+    MRQ2_ASSERT(out_view_def != nullptr);
+
+    const std::uint8_t * ptr = m_file_data + m_frame_offsets[frame_index];
+
+    FrameRecord frame;
+    std::memcpy(&frame, ptr, sizeof(FrameRecord));
+    ptr += sizeof(FrameRecord);
+
+    refdef_t & view_def = *out_view_def;
+    std::memset(&view_def, 0, sizeof(refdef_t));
+
+    view_def.x       = frame.x;
+    view_def.y       = frame.y;
+    view_def.width   = frame.width;
+    view_def.height  = frame.height;
+    view_def.fov_x   = frame.fov_x;
+    view_def.fov_y   = frame.fov_y;
+    view_def.time    = frame.time;
+    view_def.rdflags = frame.rdflags;
+    Vec3Copy(frame.vieworg, view_def.vieworg);
+    Vec3Copy(frame.viewangles, view_def.viewangles);
+    std::memcpy(view_def.blend, frame.blend, sizeof(view_def.blend));
+
+    if (frame.has_areabits)
+    {
+        std::memcpy(m_areabits, ptr, kAreaBitsSize);
+        view_def.areabits = m_areabits;
+        ptr += kAreaBitsSize;
+    }
+    if (frame.has_lightstyles)
+    {
+        std::memcpy(m_lightstyles, ptr, sizeof(lightstyle_t) * MAX_LIGHTSTYLES);
+        view_def.lightstyles = m_lightstyles;
+        ptr += sizeof(lightstyle_t) * MAX_LIGHTSTYLES;
+    }
+
+    for (int e = 0; e < frame.num_entities; ++e)
+    {
+        EntityRecord record;
+        std::memcpy(&record, ptr, sizeof(EntityRecord));
+        ptr += sizeof(EntityRecord);
+
+        entity_t & entity = m_entities[e];
+        std::memset(&entity, 0, sizeof(entity_t));
+
+        if (record.model_name[0] != '\0')
+        {
+            entity.model = (model_s *)mdl_store.FindOrLoad(record.model_name, ModelType::kAny);
+        }
+        if (record.skin_name[0] != '\0')
+        {
+            entity.skin = (image_s *)tex_store.FindOrLoad(record.skin_name, TextureType::kSkin);
+        }
+
+        Vec3Copy(record.angles, entity.angles);
+        Vec3Copy(record.origin, entity.origin);
+        Vec3Copy(record.oldorigin, entity.oldorigin);
+        entity.frame      = record.frame;
+        entity.oldframe   = record.oldframe;
+        entity.backlerp   = record.backlerp;
+        entity.skinnum    = record.skinnum;
+        entity.lightstyle = record.lightstyle;
+        entity.alpha      = record.alpha;
+        entity.flags      = record.flags;
+    }
+    view_def.num_entities = frame.num_entities;
+    view_def.entities     = m_entities;
+
+    std::memcpy(m_dlights, ptr, sizeof(dlight_t) * frame.num_dlights);
+    ptr += sizeof(dlight_t) * frame.num_dlights;
+    view_def.num_dlights = frame.num_dlights;
+    view_def.dlights     = m_dlights;
+
+    std::memcpy(m_particles, ptr, sizeof(particle_t) * frame.num_particles);
+    view_def.num_particles = frame.num_particles;
+    view_def.particles     = m_particles;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // MrQ2
@@ -0,0 +1,160 @@
+//
+// ViewCapture.hpp
+//  Recording of the refdef_t stream sent to DLLInterface::RenderView into
+//  a binary file that can later be replayed for CPU benchmarking.
+//
+#pragma once
+
+#include "Common.hpp"
+#include <cstdio>
+
+// Quake includes
+#include "client/ref.h"
+#include "common/q_files.h"
+
+namespace MrQ2
+{
+
+class ModelStore;
+class TextureStore;
+
+/*
+===============================================================================
+
+    View capture file format
+
+===============================================================================
+*/
+namespace ViewCaptureFormat
+{
+    constexpr std::uint32_t kMagic   = 0x50414356; // 'VCAP'
+    constexpr std::uint32_t kVersion = 1;
+
+    struct FileHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t num_frames;     // Patched when the capture is closed.
+        char          map_name[PathName::kNameMaxLen];
+    };
+
+    // Fixed part of the refdef_t, followed by the variable length arrays in this order:
+    // areabits[kAreaBitsSize] (if has_areabits), lightstyle_t[MAX_LIGHTSTYLES] (if has_lightstyles),
+    // EntityRecord[num_entities], dlight_t[num_dlights], particle_t[num_particles].
+    struct FrameRecord
+    {
+        std::int32_t  x, y, width, height;
+        float         fov_x, fov_y;
+        float         vieworg[3];
+        float         viewangles[3];
+        float         blend[4];
+        float         time;
+        std::int32_t  rdflags;
+        std::uint8_t  has_areabits;
+        std::uint8_t  has_lightstyles;
+        std::uint16_t num_entities;
+        std::uint16_t num_dlights;
+        std::uint16_t num_particles;
+    };
+
+    // entity_t with the model/skin pointers replaced by their names.
+    // Inline brush models are saved as "*N", like the game registers them.
+    struct EntityRecord
+    {
+        char          model_name[PathName::kNameMaxLen]; // Empty if null (beams)
+        char          skin_name[PathName::kNameMaxLen];  // Empty if null (inline skin)
+        float         angles[3];
+        float         origin[3];
+        std::int32_t  frame;
+        float         oldorigin[3];
+        std::int32_t  oldframe;
+        float         backlerp;
+        std::int32_t  skinnum;
+        std::int32_t  lightstyle;
+        float         alpha;
+        std::int32_t  flags;
+    };
+
+    constexpr std::uint32_t kAreaBitsSize = MAX_MAP_AREAS / 8;
+
+} // ViewCaptureFormat
+
+/*
+===============================================================================
+
+    ViewCaptureWriter
+
+===============================================================================
+*/
+class ViewCaptureWriter final
+{
+public:
+
+    ViewCaptureWriter() = default;
+    ~ViewCaptureWriter() { Close(); }
+
+    // Disallow copy.
+    ViewCaptureWriter(const ViewCaptureWriter &) = delete;
+    ViewCaptureWriter & operator=(const ViewCaptureWriter &) = delete;
+
+    bool Open(const char * filename, const char * map_name);
+    void Close();
+
+    void WriteFrame(const refdef_t & view_def);
+
+    bool IsOpen() const { return m_file != nullptr; }
+    std::uint32_t NumFrames() const { return m_num_frames; }
+
+private:
+
+    std::FILE *   m_file{ nullptr };
+    std::uint32_t m_num_frames{ 0 };
+};
+
+/*
+===============================================================================
+
+    ViewCaptureReader
+
+===============================================================================
+*/
+class ViewCaptureReader final
+{
+public:
+
+    ViewCaptureReader() = default;
+    ~ViewCaptureReader() { Unload(); }
+
+    // Disallow copy.
+    ViewCaptureReader(const ViewCaptureReader &) = delete;
+    ViewCaptureReader & operator=(const ViewCaptureReader &) = delete;
+
+    // Reads the whole file into memory and indexes the frames.
+    bool Load(const char * filename);
+    void Unload();
+
+    // Rebuilds the refdef_t for a frame, resolving model and skin names with the stores (loading if needed).
+    // Pointers in the returned refdef_t reference scratch memory owned by the reader, valid until the next call.
+    void DecodeFrame(std::uint32_t frame_index, ModelStore & mdl_store, TextureStore & tex_store, refdef_t * out_view_def);
+
+    std::uint32_t NumFrames() const { return m_num_frames; }
+    const char * MapName() const { return m_header.map_name; }
+
+private:
+
+    std::uint8_t *  m_file_data{ nullptr };
+    std::uint32_t   m_file_size{ 0 };
+    std::uint32_t * m_frame_offsets{ nullptr };
+    std::uint32_t   m_num_frames{ 0 };
+
+    ViewCaptureFormat::FileHeader m_header{};
+
+    // Scratch arrays for DecodeFrame().
+    qbyte        m_areabits[ViewCaptureFormat::kAreaBitsSize];
+    lightstyle_t m_lightstyles[MAX_LIGHTSTYLES];
+    entity_t     m_entities[MAX_ENTITIES];
+    dlight_t     m_dlights[MAX_DLIGHTS];
+    particle_t   m_particles[MAX_PARTICLES];
+};
+
+} // MrQ2
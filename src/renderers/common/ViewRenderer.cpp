@@ -6,7 +6,9 @@
 #include "ViewRenderer.hpp"
 #include "Lightmaps.hpp"
 #include "DebugDraw.hpp"
+#include "JobSystem.hpp"
 #include "OptickProfiler.hpp"
+#include <atomic>
 
 namespace MrQ2
 {
@@ -43,6 +45,146 @@ static const TextureImage * TextureAnimation(const ModelTexInfo * tex, const int
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Same as TextureAnimation but returns the texinfo of the current frame.
+static const ModelTexInfo * TextureAnimationFrame(const ModelTexInfo * tex, const int frame_num)
+{
+    MRQ2_ASSERT(tex != nullptr);
+
+    if (tex->next != nullptr)
+    {
+        int c = frame_num % tex->num_frames;
+        while (c)
+        {
+            tex = tex->next;
+            --c;
+        }
+    }
+
+    return tex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+//
+// World draw keys, sorted in ascending order:
+//  [63..51] texture id (ModelTexInfo::texture_id)
+//  [50..44] lightmap page (see LightmapPage)
+//  [43..32] unused
+//  [31..0]  first index of the surface in the world index buffer
+//
+constexpr int kWorldKeyTextureShift  = 51;
+constexpr int kWorldKeyLightmapShift = 44;
+constexpr std::uint64_t kWorldKeyStateMask = ~std::uint64_t(0) << kWorldKeyLightmapShift;
+
+static_assert(MAX_MAP_TEXINFO <= (1 << (64 - kWorldKeyTextureShift)), "Texture id doesn't fit in the key!");
+static_assert((kMaxLightmapTextures * 2) + 1 <= (1 << (kWorldKeyTextureShift - kWorldKeyLightmapShift)), "Lightmap page doesn't fit in the key!");
+
+static inline std::uint64_t MakeWorldDrawKey(const int texture_id, const int lightmap_page, const int first_index)
+{
+    MRQ2_ASSERT(texture_id >= 0 && lightmap_page >= 0 && first_index >= 0);
+    return (std::uint64_t(texture_id) << kWorldKeyTextureShift) |
+           (std::uint64_t(lightmap_page) << kWorldKeyLightmapShift) |
+            std::uint64_t(std::uint32_t(first_index));
+}
+
+static inline std::uint64_t WorldDrawKeyState(const std::uint64_t key)
+{
+    return key & kWorldKeyStateMask;
+}
+
+static inline int WorldDrawKeyTextureId(const std::uint64_t key)
+{
+    return static_cast<int>(key >> kWorldKeyTextureShift);
+}
+
+static inline int WorldDrawKeyLightmapPage(const std::uint64_t key)
+{
+    return static_cast<int>((key >> kWorldKeyLightmapShift) & ((1 << (kWorldKeyTextureShift - kWorldKeyLightmapShift)) - 1));
+}
+
+// Lightmap pages: 0 = no lightmap (white texture), [1, kMaxLightmapTextures] = static lightmaps,
+// followed by the dynamic lightmaps in the same order.
+static int LightmapPage(const ModelSurface & surf, const TextureImage * lightmap_tex, const TextureImage * tex_white)
+{
+    if (surf.lightmap_texture_num < 0 || lightmap_tex == tex_white)
+    {
+        return 0;
+    }
+    if (lightmap_tex == LightmapManager::LightmapAtIndex(surf.lightmap_texture_num))
+    {
+        return 1 + surf.lightmap_texture_num;
+    }
+    MRQ2_ASSERT(lightmap_tex == LightmapManager::DynamicLightmapAtIndex(surf.lightmap_texture_num));
+    return 1 + kMaxLightmapTextures + surf.lightmap_texture_num;
+}
+
+static const TextureImage * LightmapForPage(const int page, const TextureImage * tex_white)
+{
+    if (page == 0)
+    {
+        return tex_white;
+    }
+    if (page <= kMaxLightmapTextures)
+    {
+        return LightmapManager::LightmapAtIndex(page - 1);
+    }
+    return LightmapManager::DynamicLightmapAtIndex(page - 1 - kMaxLightmapTextures);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// LSD radix sort of the items by their 64 bits key, 8 bits per pass. Passes where all
+// the keys share the same digit are skipped. Returns the buffer holding the sorted items
+// (either items or temp).
+template<typename T>
+static T * RadixSortByKey(T * items, T * temp, const int count)
+{
+    constexpr int kNumPasses = 8;
+    std::uint32_t histograms[kNumPasses][256] = {};
+
+    for (int i = 0; i < count; ++i)
+    {
+        const std::uint64_t key = items[i].key;
+        for (int pass = 0; pass < kNumPasses; ++pass)
+        {
+            ++histograms[pass][(key >> (pass * 8)) & 0xFF];
+        }
+    }
+
+    T * src = items;
+    T * dst = temp;
+
+    for (int pass = 0; pass < kNumPasses; ++pass)
+    {
+        std::uint32_t * const counts = histograms[pass];
+        const int shift = pass * 8;
+
+        if (count == 0 || counts[(src[0].key >> shift) & 0xFF] == std::uint32_t(count))
+        {
+            continue; // Same digit for all keys.
+        }
+
+        std::uint32_t offset = 0;
+        for (int d = 0; d < 256; ++d)
+        {
+            const std::uint32_t n = counts[d];
+            counts[d] = offset;
+            offset += n;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    return src;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static const ModelLeaf * FindLeafNodeForPoint(const vec3_t p, const ModelInstance & model)
 {
     MRQ2_ASSERT(model.data.nodes != nullptr);
@@ -109,18 +251,159 @@ static const std::uint8_t * DecompressModelVis(std::uint8_t * const out_pvs,
     return out_pvs;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// ClusterPVSCache
 ///////////////////////////////////////////////////////////////////////////////
 
-static const std::uint8_t * GetClusterPVS(std::uint8_t * const out_pvs, const int cluster, const ModelInstance & model)
+void ClusterPVSCache::Reset()
 {
-    if (cluster == -1 || model.data.vis == nullptr)
+    if (m_bitsets != nullptr)
     {
-        std::memset(out_pvs, 0xFF, (MAX_MAP_LEAFS / 8)); // All visible.
-        return out_pvs;
+        MemFreeTracked(m_bitsets, std::size_t(m_row_bytes) * (m_capacity + 1), MemTag::kRenderer);
+        MemFreeTracked(m_cluster_to_entry, sizeof(std::int16_t) * m_num_clusters, MemTag::kRenderer);
+    }
+
+    m_bitsets          = nullptr;
+    m_cluster_to_entry = nullptr;
+    m_use_counter      = 0;
+    m_num_clusters     = 0;
+    m_row_bytes        = 0;
+    m_capacity         = 0;
+    m_num_entries      = 0;
+    m_hits             = 0;
+    m_misses           = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ClusterPVSCache::Allocate(const ModelInstance & world_mdl)
+{
+    MRQ2_ASSERT(m_bitsets == nullptr);
+    MRQ2_ASSERT(world_mdl.data.vis != nullptr);
+
+    m_num_clusters = world_mdl.data.vis->numclusters;
+    m_row_bytes    = ((m_num_clusters + 31) / 32) * 4; // Whole words so MarkLeaves can scan 32 clusters at a time.
+    m_capacity     = std::min(std::max(Config::r_pvs_cache_size.AsInt(), 1), kMaxEntries);
+
+    m_bitsets = static_cast<std::uint8_t *>(MemAllocTracked(std::size_t(m_row_bytes) * (m_capacity + 1), MemTag::kRenderer));
+    m_cluster_to_entry = static_cast<std::int16_t *>(MemAllocTracked(sizeof(std::int16_t) * m_num_clusters, MemTag::kRenderer));
+
+    std::memset(m_bitsets, 0, std::size_t(m_row_bytes) * m_capacity);
+    std::memset(m_bitsets + std::size_t(m_row_bytes) * m_capacity, 0xFF, m_row_bytes);
+    std::memset(m_cluster_to_entry, -1, sizeof(std::int16_t) * m_num_clusters);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const std::uint8_t * ClusterPVSCache::Get(const int cluster, const ModelInstance & world_mdl)
+{
+    if (m_bitsets == nullptr)
+    {
+        Allocate(world_mdl);
+    }
+
+    // Outside the map or in a solid leaf, everything is visible.
+    if (cluster < 0 || cluster >= m_num_clusters)
+    {
+        return m_bitsets + std::size_t(m_row_bytes) * m_capacity;
+    }
+
+    int entry_index = m_cluster_to_entry[cluster];
+    if (entry_index >= 0)
+    {
+        ++m_hits;
+    }
+    else
+    {
+        ++m_misses;
+
+        if (m_num_entries < m_capacity)
+        {
+            entry_index = m_num_entries++;
+        }
+        else // Evict the least recently used.
+        {
+            entry_index = 0;
+            for (int i = 1; i < m_num_entries; ++i)
+            {
+                if (m_entries[i].last_used < m_entries[entry_index].last_used)
+                {
+                    entry_index = i;
+                }
+            }
+            m_cluster_to_entry[m_entries[entry_index].cluster] = -1;
+        }
+
+        m_entries[entry_index].cluster = cluster;
+        m_cluster_to_entry[cluster] = static_cast<std::int16_t>(entry_index);
+
+        auto * vis_data = reinterpret_cast<const std::uint8_t *>(world_mdl.data.vis) + world_mdl.data.vis->bitofs[cluster][DVIS_PVS];
+        DecompressModelVis(m_bitsets + std::size_t(m_row_bytes) * entry_index, vis_data, world_mdl);
+    }
+
+    m_entries[entry_index].last_used = ++m_use_counter;
+    return m_bitsets + std::size_t(m_row_bytes) * entry_index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PointLightCache
+///////////////////////////////////////////////////////////////////////////////
+
+void PointLightCache::Reset()
+{
+    for (Entry & entry : m_entries)
+    {
+        entry.valid = false;
+    }
+    m_num_entries = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PointLightCache::Key PointLightCache::MakeKey(const vec3_t point)
+{
+    Key key;
+    for (int i = 0; i < 3; ++i)
+    {
+        key.cell[i] = static_cast<std::int32_t>(std::floor(point[i] * (1.0f / kCellSize)));
+    }
+
+    const std::uint32_t hash = (std::uint32_t(key.cell[0]) * 73856093u) ^
+                               (std::uint32_t(key.cell[1]) * 19349663u) ^
+                               (std::uint32_t(key.cell[2]) * 83492791u);
+    key.slot = hash & (kNumEntries - 1);
+    return key;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool PointLightCache::Find(const Key & key, PointLightSample & out_sample) const
+{
+    const Entry & entry = m_entries[key.slot];
+    if (!entry.valid || entry.cell[0] != key.cell[0] || entry.cell[1] != key.cell[1] || entry.cell[2] != key.cell[2])
+    {
+        return false;
+    }
+
+    out_sample = entry.sample;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void PointLightCache::Insert(const Key & key, const PointLightSample & sample)
+{
+    Entry & entry = m_entries[key.slot];
+    if (!entry.valid)
+    {
+        ++m_num_entries;
     }
 
-    auto * vid_data = reinterpret_cast<const std::uint8_t *>(model.data.vis) + model.data.vis->bitofs[cluster][DVIS_PVS];
-    return DecompressModelVis(out_pvs, vid_data, model);
+    entry.sample  = sample;
+    entry.cell[0] = key.cell[0];
+    entry.cell[1] = key.cell[1];
+    entry.cell[2] = key.cell[2];
+    entry.valid   = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -136,6 +419,30 @@ static RenderMatrix MakeEntityModelMatrix(const entity_t & entity, const bool fl
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Accumulates the time spent in scope into one of the FrameData::stage_times. No-op when times is null.
+struct ScopedStageTimer final
+{
+    ViewRenderer::StageTimes * const m_times;
+    const int                        m_stage;
+    const std::uint64_t              m_start;
+
+    ScopedStageTimer(ViewRenderer::StageTimes * times, const int stage)
+        : m_times{ times }
+        , m_stage{ stage }
+        , m_start{ (times != nullptr) ? HighResTimeMicroseconds() : 0 }
+    { }
+
+    ~ScopedStageTimer()
+    {
+        if (m_times != nullptr)
+        {
+            m_times->microseconds[m_stage] += HighResTimeMicroseconds() - m_start;
+        }
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 constexpr int kDiffuseTextureSlot  = 0;
 constexpr int kLightmapTextureSlot = 1;
 
@@ -147,8 +454,22 @@ void ViewRenderer::Init(const RenderDevice & device, const TextureStore & tex_st
 {
     m_tex_white2x2 = tex_store.tex_white2x2;
 
+    // Per-thread scratch data for the parallel world traversal. Requires the JobSystem to be initialized first.
+    m_num_world_contexts = JobSystem::NumThreads();
+    m_world_contexts = new(MemTag::kRenderer) WorldTraversalContext[m_num_world_contexts];
+    for (int t = 0; t < m_num_world_contexts; ++t)
+    {
+        m_world_contexts[t].opaque_surfaces = nullptr;
+        m_world_contexts[t].Reset();
+    }
+
+    m_num_alias_scratch_threads = JobSystem::NumThreads();
+    m_alias_scratch_positions = new(MemTag::kRenderer) float[m_num_alias_scratch_threads * 3 * MAX_VERTS];
+
     constexpr uint32_t kViewDrawBatchSize = 38000; // max vertices * num buffers
     m_vertex_buffers.Init(device, kViewDrawBatchSize);
+    m_world_index_buffers.Init(device, kWorldMergedIndexBufferSize);
+    m_entity_index_buffers.Init(device, kEntityIndexBufferSize);
 
     m_per_draw_shader_consts.Init(device, sizeof(PerDrawShaderConstants), ConstantBuffer::kOptimizeForSingleDraw);
 
@@ -215,6 +536,16 @@ void ViewRenderer::Shutdown()
 {
     m_skybox = {};
     m_alpha_world_surfaces = nullptr;
+    m_pvs_cache.Reset();
+
+    FreeWorldSurfaceLists();
+    DeleteArray(m_world_contexts, m_num_world_contexts, MemTag::kRenderer);
+    m_world_contexts = nullptr;
+    m_num_world_contexts = 0;
+    DeleteArray(m_alias_scratch_positions, m_num_alias_scratch_threads * 3 * MAX_VERTS, MemTag::kRenderer);
+    m_alias_scratch_positions = nullptr;
+    m_num_alias_scratch_threads = 0;
+    m_alias_draw_items.clear();
     m_tex_white2x2 = nullptr;
 
     for (int pass = 0; pass < kRenderPassCount; ++pass)
@@ -229,6 +560,8 @@ void ViewRenderer::Shutdown()
     m_render3d_shader.Shutdown();
     m_per_draw_shader_consts.Shutdown();
     m_vertex_buffers.Shutdown();
+    m_world_index_buffers.Shutdown();
+    m_entity_index_buffers.Shutdown();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -245,6 +578,11 @@ MiniImBatch ViewRenderer::BeginBatch(const BeginBatchArgs & args)
     m_current_draw_cmd.depth_hack   = args.depth_hack;
     m_current_draw_cmd.first_vert   = 0;
     m_current_draw_cmd.vertex_count = 0;
+    m_current_draw_cmd.index_buffer = args.index_buffer;
+    m_current_draw_cmd.first_index  = args.first_index;
+    m_current_draw_cmd.index_count  = args.index_count;
+
+    MRQ2_ASSERT(args.index_buffer == nullptr || args.topology == PrimitiveTopology::kTriangleList);
 
     m_batch_open = true;
 
@@ -267,16 +605,7 @@ void ViewRenderer::EndBatch(MiniImBatch & batch)
 
         m_vertex_buffers.Increment(batch_size);
 
-        MRQ2_ASSERT(m_current_pass < kRenderPassCount);
-        DrawCmdList & cmd_list = m_draw_cmds[m_current_pass];
-
-        if (cmd_list.size() == cmd_list.capacity())
-        {
-            GameInterface::Errorf("DrawCmdList for pass[%u] is full! Increase size. %u",
-                                  unsigned(m_current_pass), unsigned(cmd_list.size()));
-        }
-
-        cmd_list.push_back(m_current_draw_cmd);
+        PushDrawCmd(m_current_draw_cmd);
     }
 
     batch.Clear();
@@ -286,6 +615,69 @@ void ViewRenderer::EndBatch(MiniImBatch & batch)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void ViewRenderer::AddDrawCmd(const BeginBatchArgs & args, const uint32_t first_vert, const uint32_t vertex_count)
+{
+    MRQ2_ASSERT(m_batch_open == false);
+    MRQ2_ASSERT_ALIGN16(args.model_matrix.floats);
+    MRQ2_ASSERT(args.index_buffer == nullptr || args.topology == PrimitiveTopology::kTriangleList);
+    MRQ2_ASSERT(vertex_count > 0);
+
+    DrawCmd cmd;
+    cmd.consts.model_matrix = args.model_matrix;
+    cmd.diffuse_tex  = (args.diffuse_tex  != nullptr) ? args.diffuse_tex  : m_tex_white2x2;
+    cmd.lightmap_tex = (args.lightmap_tex != nullptr) ? args.lightmap_tex : m_tex_white2x2;
+    cmd.topology     = args.topology;
+    cmd.depth_hack   = args.depth_hack;
+    cmd.first_vert   = first_vert;
+    cmd.vertex_count = vertex_count;
+    cmd.index_buffer = args.index_buffer;
+    cmd.first_index  = args.first_index;
+    cmd.index_count  = args.index_count;
+
+    PushDrawCmd(cmd);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::PushDrawCmd(const DrawCmd & cmd)
+{
+    MRQ2_ASSERT(m_current_pass < kRenderPassCount);
+    DrawCmdList & cmd_list = m_draw_cmds[m_current_pass];
+
+    if (cmd_list.size() == cmd_list.capacity())
+    {
+        GameInterface::Errorf("DrawCmdList for pass[%u] is full! Increase size. %u",
+                              unsigned(m_current_pass), unsigned(cmd_list.size()));
+    }
+
+    // Back to back draws of the same state, such as sprites of one frame, are submitted as one.
+    if (Config::r_instanced_entities.IsSet() && !cmd_list.empty() && CanMergeDrawCmds(cmd_list.back(), cmd))
+    {
+        cmd_list.back().vertex_count += cmd.vertex_count;
+        ++m_draw_cmds_merged;
+        return;
+    }
+
+    cmd_list.push_back(cmd);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Only non-indexed triangle lists can be concatenated, and the vertexes must follow each other in the buffer.
+bool ViewRenderer::CanMergeDrawCmds(const DrawCmd & prev, const DrawCmd & next)
+{
+    return prev.topology == PrimitiveTopology::kTriangleList &&
+           next.topology == PrimitiveTopology::kTriangleList &&
+           prev.index_buffer == nullptr && next.index_buffer == nullptr &&
+           prev.first_vert + prev.vertex_count == next.first_vert &&
+           prev.diffuse_tex  == next.diffuse_tex  &&
+           prev.lightmap_tex == next.lightmap_tex &&
+           prev.depth_hack   == next.depth_hack   &&
+           std::memcmp(&prev.consts, &next.consts, sizeof(PerDrawShaderConstants)) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void ViewRenderer::BeginRegistration()
 {
     // New map loaded, clear the view clusters.
@@ -293,6 +685,14 @@ void ViewRenderer::BeginRegistration()
     m_view_cluster2     = -1;
     m_old_view_cluster  = -1;
     m_old_view_cluster2 = -1;
+
+    // Cached PVS and light samples are only valid for the previous map.
+    m_pvs_cache.Reset();
+    m_light_cache.Reset();
+    m_leafs_marked = 0;
+
+    // Surfaces of the new map need their dirty_style_slot computed from scratch.
+    m_lightstyles_valid = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -373,6 +773,9 @@ void ViewRenderer::BatchImmediateModeDrawCmds()
         MRQ2_ASSERT(m_draw_cmds[pass].empty());
     }
 
+    m_draw_cmds_submitted = 0;
+    m_draw_cmds_merged = 0;
+
     m_vertex_buffers.BeginFrame();
 }
 
@@ -436,13 +839,22 @@ void ViewRenderer::FlushImmediateModeDrawCmds(FrameData & frame_data)
             context.SetTexture(cmd.diffuse_tex->BackendTexture(),  kDiffuseTextureSlot);
             context.SetTexture(cmd.lightmap_tex->BackendTexture(), kLightmapTextureSlot);
 
-            context.Draw(cmd.first_vert, cmd.vertex_count);
+            if (cmd.index_buffer != nullptr)
+            {
+                context.SetIndexBuffer(*cmd.index_buffer);
+                context.DrawIndexed(cmd.first_index, cmd.index_count, cmd.first_vert);
+            }
+            else
+            {
+                context.Draw(cmd.first_vert, cmd.vertex_count);
+            }
 
             // Restore to default if we did a depth-hacked draw.
             context.RestoreDepthRange();
         }
 
         MRQ2_POP_GPU_MARKER(context);
+        m_draw_cmds_submitted += int(m_draw_cmds[pass].size());
         m_draw_cmds[pass].clear();
     }
 
@@ -461,31 +873,80 @@ void ViewRenderer::DoRenderView(FrameData & frame_data)
     // Opaque/solid geometry pass
     //
     m_current_pass = kPass_SolidGeometry;
-    RenderWorldModel(frame_data);
-    RenderSkyBox(frame_data);
-    RenderSolidEntities(frame_data);
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_WorldModel };
+        RenderWorldModel(frame_data);
+    }
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_SkyBox };
+        RenderSkyBox(frame_data);
+    }
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_SolidEntities };
+        RenderSolidEntities(frame_data);
+    }
 
     //
     // Transparencies/alpha passes
     //
     m_current_pass = kPass_TranslucentSurfaces; // Color Blend ON for static world geometry
-    RenderTranslucentSurfaces(frame_data);
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_TranslucentSurfaces };
+        RenderTranslucentSurfaces(frame_data);
+    }
 
     m_current_pass = kPass_TranslucentEntities; // Disable Z writes in case entities stack up
-    RenderTranslucentEntities(frame_data);
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_TranslucentEntities };
+        RenderTranslucentEntities(frame_data);
+    }
 
     m_current_pass = kPass_TranslucentEntities; // Also with Z writes disabled
-    RenderParticles(frame_data);
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_Particles };
+        RenderParticles(frame_data);
+    }
 
     m_current_pass = kPass_DLights; // Simulated light sources use additive blending
-    RenderDLights(frame_data);
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_DLights };
+        RenderDLights(frame_data);
+    }
 
-    FlushImmediateModeDrawCmds(frame_data);
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_FlushDrawCmds };
+        FlushImmediateModeDrawCmds(frame_data);
+    }
 
     SetLightLevel(frame_data);
 
     // Update dynamic lightmaps.
-    LightmapManager::Update();
+    {
+        ScopedStageTimer timer{ frame_data.stage_times, kStage_Lightmaps };
+        LightmapManager::Update();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char * ViewRenderer::TimedStageName(const int stage)
+{
+    static const char * const s_stage_names[] = {
+        "ViewSetup",
+        "WorldModel",
+        "SkyBox",
+        "SolidEntities",
+        "TranslucentSurfaces",
+        "TranslucentEntities",
+        "Particles",
+        "DLights",
+        "FlushDrawCmds",
+        "Lightmaps",
+    };
+    static_assert(ArrayLength(s_stage_names) == kTimedStageCount, "Update this if the enum changes!");
+
+    MRQ2_ASSERT(stage >= 0 && stage < kTimedStageCount);
+    return s_stage_names[stage];
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -530,10 +991,12 @@ void ViewRenderer::SetLightLevel(const FrameData & frame_data) const
 void ViewRenderer::RenderViewSetup(FrameData & frame_data)
 {
     OPTICK_EVENT();
+    ScopedStageTimer timer{ frame_data.stage_times, kStage_ViewSetup };
 
     ++m_frame_count;
 
     PushDLights(frame_data);
+    UpdateLightstyles(frame_data);
 
     // Find current view clusters
     SetUpViewClusters(frame_data);
@@ -564,105 +1027,88 @@ void ViewRenderer::RenderViewSetup(FrameData & frame_data)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-// This function will recursively mark all surfaces that should
-// be drawn and add them to the appropriate draw chain, so the
-// next call to DrawTextureChains() will actually render what
-// was marked for draw in here.
-void ViewRenderer::RecursiveWorldNode(FrameData & frame_data, const ModelInstance & world_mdl, const ModelNode * const node)
+// The world traversal functions below will recursively mark all surfaces
+// that should be drawn and add them to the appropriate draw list, so the
+// next call to DrawWorldSurfaces() will actually render what was marked
+// for draw in here.
+bool ViewRenderer::IsWorldNodeVisible(const FrameData & frame_data, const ModelNode * const node, int & nodes_culled) const
 {
-    OPTICK_EVENT();
-    MRQ2_ASSERT(node != nullptr);
-
     if (node->contents == CONTENTS_SOLID)
     {
-        return;
+        return false;
     }
     if (node->vis_frame != m_vis_frame_count)
     {
-        return;
+        return false;
     }
     if (!frame_data.frustum.TestAabb(node->minmaxs, node->minmaxs + 3))
     {
-        frame_data.world_nodes_culled++;
-        return;
-    }
-
-    if (node->num_surfaces > 0 && Config::r_draw_world_bounds.IsSet())
-    {
-        DebugDraw::AddAABB(node->minmaxs, node->minmaxs + 3, ColorRGBA32{ 0xFFFF00FF }); // pink
+        nodes_culled++;
+        return false;
     }
+    return true;
+}
 
-    const refdef_t & view_def = frame_data.view_def;
+///////////////////////////////////////////////////////////////////////////////
 
-    // If a leaf node, it can draw if visible.
-    if (node->contents != -1)
+void ViewRenderer::MarkLeafSurfaces(const refdef_t & view_def, const ModelLeaf * const leaf) const
+{
+    // Check for door connected areas:
+    if (view_def.areabits)
     {
-        auto * leaf = reinterpret_cast<const ModelLeaf *>(node);
-
-        // Check for door connected areas:
-        if (view_def.areabits)
+        if (!(view_def.areabits[leaf->area >> 3] & (1 << (leaf->area & 7))))
         {
-            if (!(view_def.areabits[leaf->area >> 3] & (1 << (leaf->area & 7))))
-            {
-                return; // Not visible.
-            }
+            return; // Not visible.
         }
+    }
 
-        ModelSurface ** mark = leaf->first_mark_surface;
-        int num_surfs = leaf->num_mark_surfaces;
-        if (num_surfs)
+    // NOTE: With the parallel traversal, surfaces of the split nodes can be marked by leafs
+    // of different subtrees at the same time. That's fine since they all store the same value.
+    ModelSurface ** mark = leaf->first_mark_surface;
+    int num_surfs = leaf->num_mark_surfaces;
+    if (num_surfs)
+    {
+        do
         {
-            do
-            {
-                (*mark)->vis_frame = m_frame_count;
-                ++mark;
-            } while (--num_surfs);
-        }
-
-        return;
+            (*mark)->vis_frame = m_frame_count;
+            ++mark;
+        } while (--num_surfs);
     }
+}
 
-    //
-    // Node is just a decision point, so go down the appropriate sides:
-    //
+///////////////////////////////////////////////////////////////////////////////
 
+static int WorldNodeSide(const vec3_t vieworg, const cplane_t * const plane)
+{
     float dot;
-    const cplane_t * const plane = node->plane;
 
     // Find which side of the node we are on:
     switch (plane->type)
     {
     case PLANE_X:
-        dot = view_def.vieworg[0] - plane->dist;
+        dot = vieworg[0] - plane->dist;
         break;
     case PLANE_Y:
-        dot = view_def.vieworg[1] - plane->dist;
+        dot = vieworg[1] - plane->dist;
         break;
     case PLANE_Z:
-        dot = view_def.vieworg[2] - plane->dist;
+        dot = vieworg[2] - plane->dist;
         break;
     default:
-        dot = Vec3Dot(view_def.vieworg, plane->normal) - plane->dist;
+        dot = Vec3Dot(vieworg, plane->normal) - plane->dist;
         break;
     } // switch (plane->type)
 
-    int side, sidebit;
-    if (dot >= 0.0f)
-    {
-        side    = 0;
-        sidebit = 0;
-    }
-    else
-    {
-        side    = 1;
-        sidebit = kSurf_PlaneBack;
-    }
+    return (dot >= 0.0f) ? 0 : 1;
+}
 
-    // Recurse down the children, front side first:
-    RecursiveWorldNode(frame_data, world_mdl, node->children[side]);
+///////////////////////////////////////////////////////////////////////////////
 
+void ViewRenderer::AddWorldNodeSurfaces(const ModelInstance & world_mdl, const ModelNode * const node,
+                                        const int sidebit, WorldTraversalContext * const ctx)
+{
     //
-    // Add stuff to the draw lists:
+    // Add stuff to the draw lists of the thread's context:
     //
     ModelSurface * surf = world_mdl.data.surfaces + node->first_surface;
     for (int i = 0; i < node->num_surfaces; ++i, ++surf)
@@ -678,27 +1124,278 @@ void ViewRenderer::RecursiveWorldNode(FrameData & frame_data, const ModelInstanc
 
         if (surf->texinfo->flags & SURF_SKY)
         {
-            // Just adds to visible sky bounds.
-            m_skybox.AddSkySurface(*surf, frame_data.view_def.vieworg);
+            // Just adds to visible sky bounds (after the traversal).
+            surf->texture_chain = ctx->sky_surfaces;
+            ctx->sky_surfaces = surf;
         }
         else if (surf->texinfo->flags & (SURF_TRANS33 | SURF_TRANS66 | SURF_WARP))
         {
             // Add to the translucent draw chain.
-            surf->texture_chain = m_alpha_world_surfaces;
-            m_alpha_world_surfaces = surf;
+            surf->texture_chain = ctx->alpha_head;
+            if (ctx->alpha_head == nullptr)
+            {
+                ctx->alpha_tail = surf;
+            }
+            ctx->alpha_head = surf;
         }
-        else // Opaque texture chain
+        else // Opaque surface, sorted by DrawWorldSurfaces
         {
-            const TextureImage * image = TextureAnimation(surf->texinfo, static_cast<int>(frame_data.view_def.time * 2.0f));
-            MRQ2_ASSERT(image != nullptr);
-
-            surf->texture_chain = image->DrawChainPtr();
-            image->SetDrawChainPtr(surf);
+            MRQ2_ASSERT(ctx->num_opaque_surfaces < m_world_surfaces_capacity);
+            ctx->opaque_surfaces[ctx->num_opaque_surfaces++] = surf;
         }
     }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::RecursiveWorldNode(FrameData & frame_data, const ModelInstance & world_mdl, const ModelNode * const node, WorldTraversalContext * const ctx)
+{
+    OPTICK_EVENT();
+    MRQ2_ASSERT(node != nullptr);
+    MRQ2_ASSERT(ctx != nullptr);
+
+    if (!IsWorldNodeVisible(frame_data, node, ctx->nodes_culled))
+    {
+        return;
+    }
+
+    // Not thread safe, only allowed in the serial traversal.
+    if (node->num_surfaces > 0 && Config::r_draw_world_bounds.IsSet())
+    {
+        DebugDraw::AddAABB(node->minmaxs, node->minmaxs + 3, ColorRGBA32{ 0xFFFF00FF }); // pink
+    }
+
+    // If a leaf node, it can draw if visible.
+    if (node->contents != -1)
+    {
+        MarkLeafSurfaces(frame_data.view_def, reinterpret_cast<const ModelLeaf *>(node));
+        return;
+    }
+
+    //
+    // Node is just a decision point, so go down the appropriate sides:
+    //
+
+    const int side    = WorldNodeSide(frame_data.view_def.vieworg, node->plane);
+    const int sidebit = (side == 0) ? 0 : kSurf_PlaneBack;
+
+    // Recurse down the children, front side first:
+    RecursiveWorldNode(frame_data, world_mdl, node->children[side], ctx);
+
+    AddWorldNodeSurfaces(world_mdl, node, sidebit, ctx);
 
     // Finally recurse down the back side:
-    RecursiveWorldNode(frame_data, world_mdl, node->children[!side]);
+    RecursiveWorldNode(frame_data, world_mdl, node->children[!side], ctx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::WorldTraversalContext::Reset()
+{
+    num_opaque_surfaces = 0;
+    alpha_head   = nullptr;
+    alpha_tail   = nullptr;
+    sky_surfaces = nullptr;
+    nodes_culled = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::ReserveWorldSurfaceLists(const int num_surfaces)
+{
+    if (num_surfaces <= m_world_surfaces_capacity)
+    {
+        return;
+    }
+
+    FreeWorldSurfaceLists();
+
+    for (int t = 0; t < m_num_world_contexts; ++t)
+    {
+        m_world_contexts[t].opaque_surfaces = new(MemTag::kRenderer) const ModelSurface *[num_surfaces];
+    }
+
+    m_world_draw_items      = new(MemTag::kRenderer) WorldDrawItem[num_surfaces];
+    m_world_draw_items_temp = new(MemTag::kRenderer) WorldDrawItem[num_surfaces];
+    m_world_surfaces_capacity = num_surfaces;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::FreeWorldSurfaceLists()
+{
+    for (int t = 0; t < m_num_world_contexts; ++t)
+    {
+        DeleteArray(m_world_contexts[t].opaque_surfaces, m_world_surfaces_capacity, MemTag::kRenderer);
+        m_world_contexts[t].opaque_surfaces = nullptr;
+        m_world_contexts[t].num_opaque_surfaces = 0;
+    }
+
+    DeleteArray(m_world_draw_items, m_world_surfaces_capacity, MemTag::kRenderer);
+    DeleteArray(m_world_draw_items_temp, m_world_surfaces_capacity, MemTag::kRenderer);
+
+    m_world_draw_items        = nullptr;
+    m_world_draw_items_temp   = nullptr;
+    m_num_world_draw_items    = 0;
+    m_world_surfaces_capacity = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::SerialWorldTraversal(FrameData & frame_data, const ModelInstance & world_mdl)
+{
+    WorldTraversalContext & ctx = m_world_contexts[0];
+    ctx.Reset();
+
+    RecursiveWorldNode(frame_data, world_mdl, world_mdl.data.nodes, &ctx);
+
+    if (ctx.alpha_head != nullptr)
+    {
+        ctx.alpha_tail->texture_chain = m_alpha_world_surfaces;
+        m_alpha_world_surfaces = ctx.alpha_head;
+    }
+
+    MergeWorldTraversalContexts(frame_data, 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::CollectWorldSubtrees(FrameData & frame_data, const ModelNode * const node, const int depth)
+{
+    if (!IsWorldNodeVisible(frame_data, node, frame_data.world_nodes_culled))
+    {
+        return;
+    }
+
+    if (node->contents != -1 || depth == kWorldSplitDepth)
+    {
+        m_world_subtree_jobs.push_back(int(m_world_split_items.size()));
+        m_world_split_items.push_back({ node, 0, true, nullptr, nullptr });
+        return;
+    }
+
+    // Same front to back order as RecursiveWorldNode.
+    const int side = WorldNodeSide(frame_data.view_def.vieworg, node->plane);
+
+    CollectWorldSubtrees(frame_data, node->children[side], depth + 1);
+    m_world_split_items.push_back({ node, (side == 0) ? 0 : kSurf_PlaneBack, false, nullptr, nullptr });
+    CollectWorldSubtrees(frame_data, node->children[!side], depth + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::ParallelWorldTraversal(FrameData & frame_data, const ModelInstance & world_mdl)
+{
+    OPTICK_EVENT();
+    MRQ2_ASSERT(m_num_world_contexts >= JobSystem::NumThreads());
+
+    m_world_split_items.clear();
+    m_world_subtree_jobs.clear();
+    CollectWorldSubtrees(frame_data, world_mdl.data.nodes, 0);
+
+    for (int t = 0; t < m_num_world_contexts; ++t)
+    {
+        m_world_contexts[t].Reset();
+    }
+
+    struct JobArgs
+    {
+        ViewRenderer *        renderer;
+        FrameData *           frame_data;
+        const ModelInstance * world_mdl;
+    } job_args{ this, &frame_data, &world_mdl };
+
+    JobSystem::ParallelFor(int(m_world_subtree_jobs.size()), [](void * user_data, const int job_index, const int thread_index)
+    {
+        const auto & args = *static_cast<const JobArgs *>(user_data);
+        ViewRenderer & renderer = *args.renderer;
+
+        WorldTraversalContext & ctx = renderer.m_world_contexts[thread_index];
+        WorldSplitItem & item = renderer.m_world_split_items[renderer.m_world_subtree_jobs[job_index]];
+
+        ctx.alpha_head = nullptr;
+        ctx.alpha_tail = nullptr;
+
+        renderer.RecursiveWorldNode(*args.frame_data, *args.world_mdl, item.node, &ctx);
+
+        item.alpha_head = ctx.alpha_head;
+        item.alpha_tail = ctx.alpha_tail;
+    }, &job_args);
+
+    // Rebuild the translucent chain and add the split node surfaces in the same order as the serial traversal.
+    WorldTraversalContext & main_ctx = m_world_contexts[0];
+    for (const WorldSplitItem & item : m_world_split_items)
+    {
+        if (item.is_subtree)
+        {
+            if (item.alpha_head != nullptr)
+            {
+                item.alpha_tail->texture_chain = m_alpha_world_surfaces;
+                m_alpha_world_surfaces = item.alpha_head;
+            }
+        }
+        else
+        {
+            main_ctx.alpha_head = nullptr;
+            main_ctx.alpha_tail = nullptr;
+
+            AddWorldNodeSurfaces(world_mdl, item.node, item.sidebit, &main_ctx);
+
+            if (main_ctx.alpha_head != nullptr)
+            {
+                main_ctx.alpha_tail->texture_chain = m_alpha_world_surfaces;
+                m_alpha_world_surfaces = main_ctx.alpha_head;
+            }
+        }
+    }
+
+    MergeWorldTraversalContexts(frame_data, m_num_world_contexts);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::MergeWorldTraversalContexts(FrameData & frame_data, const int num_contexts)
+{
+    OPTICK_EVENT();
+
+    // Surface lightmaps are updated here, so the keys must be built on the main thread.
+    const int tex_frame = static_cast<int>(frame_data.view_def.time * 2.0f);
+    int num_items = 0;
+
+    for (int t = 0; t < num_contexts; ++t)
+    {
+        const WorldTraversalContext & ctx = m_world_contexts[t];
+
+        for (int s = 0; s < ctx.num_opaque_surfaces; ++s)
+        {
+            const ModelSurface * surf = ctx.opaque_surfaces[s];
+            const ModelPoly * poly = surf->polys;
+            if (poly == nullptr || poly->num_verts < 3) // Need at least one triangle.
+            {
+                continue;
+            }
+
+            const ModelTexInfo * texinfo = TextureAnimationFrame(surf->texinfo, tex_frame);
+            const int lightmap_page = LightmapPage(*surf, GetSurfaceLightmap(frame_data.view_def, *surf), m_tex_white2x2);
+
+            MRQ2_ASSERT(num_items < m_world_surfaces_capacity);
+            m_world_draw_items[num_items++] = { MakeWorldDrawKey(texinfo->texture_id, lightmap_page, poly->index_buffer.first_index), surf };
+        }
+
+        for (const ModelSurface * surf = ctx.sky_surfaces; surf != nullptr; surf = surf->texture_chain)
+        {
+            m_skybox.AddSkySurface(*surf, frame_data.view_def.vieworg);
+        }
+
+        frame_data.world_nodes_culled += ctx.nodes_culled;
+    }
+
+    m_num_world_draw_items = num_items;
+
+    if (RadixSortByKey(m_world_draw_items, m_world_draw_items_temp, num_items) != m_world_draw_items)
+    {
+        std::swap(m_world_draw_items, m_world_draw_items_temp);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -729,54 +1426,130 @@ void ViewRenderer::MarkLeaves(ModelInstance & world_mdl)
         {
             world_mdl.data.nodes[i].vis_frame = m_vis_frame_count;
         }
+        m_leafs_marked = world_mdl.data.num_leafs;
         return;
     }
 
-    alignas(16) std::uint8_t temp_vis_pvs[MAX_MAP_LEAFS / 8] = {0};
-    alignas(16) std::uint8_t combined_vis_pvs[MAX_MAP_LEAFS / 8] = {0};
+    alignas(16) std::uint8_t combined_vis_pvs[MAX_MAP_LEAFS / 8];
 
-    const std::uint8_t * vis_pvs = GetClusterPVS(temp_vis_pvs, m_view_cluster, world_mdl);
+    const std::uint8_t * vis_pvs = m_pvs_cache.Get(m_view_cluster, world_mdl);
+    const int num_words = m_pvs_cache.RowBytes() / 4;
 
     // May have to combine two clusters because of solid water boundaries:
     if (m_view_cluster2 != m_view_cluster)
     {
-        std::memcpy(combined_vis_pvs, vis_pvs, (world_mdl.data.num_leafs + 7) / 8);
-        vis_pvs = GetClusterPVS(temp_vis_pvs, m_view_cluster2, world_mdl);
-
-        const int c = (world_mdl.data.num_leafs + 31) / 32;
-        MRQ2_ASSERT(unsigned(c) < (ArrayLength(combined_vis_pvs) / sizeof(std::uint32_t)));
+        // Copy first, the second lookup might evict the first cluster from the cache.
+        MRQ2_ASSERT(unsigned(m_pvs_cache.RowBytes()) <= sizeof(combined_vis_pvs));
+        std::memcpy(combined_vis_pvs, vis_pvs, m_pvs_cache.RowBytes());
+        vis_pvs = m_pvs_cache.Get(m_view_cluster2, world_mdl);
 
-        for (int i = 0; i < c; ++i)
+        for (int i = 0; i < num_words; ++i)
         {
             reinterpret_cast<std::uint32_t *>(combined_vis_pvs)[i] |= reinterpret_cast<const std::uint32_t *>(vis_pvs)[i];
         }
         vis_pvs = combined_vis_pvs;
     }
 
-    ModelLeaf * leaf = world_mdl.data.leafs;
-    for (int i = 0; i < world_mdl.data.num_leafs; ++i, ++leaf)
+    // Only visit the leafs of visible clusters, 32 clusters at a time.
+    const int num_clusters = world_mdl.data.vis->numclusters;
+    const int * const cluster_leaf_offsets = world_mdl.data.cluster_leaf_offsets;
+    ModelLeaf * const * const cluster_leafs = world_mdl.data.cluster_leafs;
+    MRQ2_ASSERT(cluster_leaf_offsets != nullptr && cluster_leafs != nullptr);
+
+    int leafs_marked = 0;
+    for (int w = 0; w < num_words; ++w)
     {
-        const int cluster = leaf->cluster;
-        if (cluster == -1)
-        {
-            continue;
-        }
+        unsigned long bits = reinterpret_cast<const std::uint32_t *>(vis_pvs)[w];
+        unsigned long bit_index;
 
-        if (vis_pvs[cluster >> 3] & (1 << (cluster & 7)))
+        while (_BitScanForward(&bit_index, bits))
         {
-            auto * node = reinterpret_cast<ModelNode *>(leaf);
-            do
+            bits &= bits - 1;
+
+            const int cluster = (w * 32) + int(bit_index);
+            if (cluster >= num_clusters)
             {
-                if (node->vis_frame == m_vis_frame_count)
+                break;
+            }
+
+            for (int l = cluster_leaf_offsets[cluster]; l < cluster_leaf_offsets[cluster + 1]; ++l)
+            {
+                auto * node = reinterpret_cast<ModelNode *>(cluster_leafs[l]);
+                do
                 {
-                    break;
-                }
+                    if (node->vis_frame == m_vis_frame_count)
+                    {
+                        break;
+                    }
+
+                    node->vis_frame = m_vis_frame_count;
+                    node = node->parent;
+                } while (node);
+            }
 
-                node->vis_frame = m_vis_frame_count;
-                node = node->parent;
-            } while (node);
+            leafs_marked += cluster_leaf_offsets[cluster + 1] - cluster_leaf_offsets[cluster];
         }
     }
+
+    m_leafs_marked = leafs_marked;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int FirstDirtyLightstyleSlot(const ModelSurface & surf, const lightstyle_t * lightstyles)
+{
+    for (int lmap = 0; lmap < kMaxLightmaps && surf.styles[lmap] != 255; ++lmap)
+    {
+        if (lightstyles[surf.styles[lmap]].white != surf.cached_light[lmap])
+        {
+            return lmap;
+        }
+    }
+    return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::UpdateLightstyles(FrameData & frame_data)
+{
+    OPTICK_EVENT();
+
+    m_lightstyles_changed = 0;
+    m_lightstyle_surfaces_updated = 0;
+
+    const lightstyle_t * const lightstyles = frame_data.view_def.lightstyles;
+    const auto & world_data = frame_data.world_model.data;
+
+    if ((frame_data.view_def.rdflags & RDF_NOWORLDMODEL) || lightstyles == nullptr || world_data.style_surface_offsets == nullptr)
+    {
+        return;
+    }
+
+    // Diff the styles against the previous frame and only revisit the surfaces
+    // of the ones that changed. Their dirty_style_slot stays valid until then,
+    // since cached_light only changes when the surface lightmap is rebuilt.
+    for (int style = 0; style < MAX_LIGHTSTYLES; ++style)
+    {
+        const float white = lightstyles[style].white;
+        if (m_lightstyles_valid && white == m_lightstyle_white[style])
+        {
+            continue;
+        }
+
+        m_lightstyle_white[style] = white;
+        ++m_lightstyles_changed;
+
+        const int first = world_data.style_surface_offsets[style];
+        const int last  = world_data.style_surface_offsets[style + 1];
+        for (int i = first; i < last; ++i)
+        {
+            ModelSurface * surf = world_data.style_surfaces[i];
+            surf->dirty_style_slot = static_cast<std::int8_t>(FirstDirtyLightstyleSlot(*surf, lightstyles));
+        }
+        m_lightstyle_surfaces_updated += last - first;
+    }
+
+    m_lightstyles_valid = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -799,18 +1572,16 @@ const TextureImage * ViewRenderer::GetSurfaceLightmap(const refdef_t & view_def,
     constexpr int kNoLightmapSurfaceFlags = (SURF_SKY | SURF_TRANS33 | SURF_TRANS66 | SURF_WARP);
 
     bool is_dynamic = false;
-    int lmap = 0;
 
-    // See if we need to update the dynamic lightmap
-    for (; lmap < kMaxLightmaps && surf.styles[lmap] != 255; ++lmap)
+    // See if we need to update the dynamic lightmap.
+    // UpdateLightstyles() already found the first style that differs from the cached lighting.
+    const int lmap = surf.dirty_style_slot;
+    if (lmap >= 0)
     {
-        if (view_def.lightstyles[surf.styles[lmap]].white != surf.cached_light[lmap])
+        MRQ2_ASSERT(view_def.lightstyles[surf.styles[lmap]].white != surf.cached_light[lmap]);
+        if (!(surf.texinfo->flags & kNoLightmapSurfaceFlags))
         {
-            if (!(surf.texinfo->flags & kNoLightmapSurfaceFlags))
-            {
-                is_dynamic = true;
-            }
-            break;
+            is_dynamic = true;
         }
     }
 
@@ -834,7 +1605,7 @@ const TextureImage * ViewRenderer::GetSurfaceLightmap(const refdef_t & view_def,
         bool dynamic_lightmap;
 
         // Update existing surface lightmap
-        if ((surf.styles[lmap] >= 32 || surf.styles[lmap] == 0) && (surf.dlight_frame != m_frame_count))
+        if (lmap >= 0 && (surf.styles[lmap] >= 32 || surf.styles[lmap] == 0) && (surf.dlight_frame != m_frame_count))
         {
             update_surf_cache = true;
             dynamic_lightmap  = false;
@@ -859,12 +1630,14 @@ const TextureImage * ViewRenderer::GetSurfaceLightmap(const refdef_t & view_def,
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void ViewRenderer::DrawTextureChains(FrameData & frame_data)
+void ViewRenderer::DrawWorldSurfaces(FrameData & frame_data)
 {
     OPTICK_EVENT();
 
-    const bool do_draw   = !Config::r_skip_draw_texture_chains.IsSet();
-    const bool use_vb_ib = Config::r_use_vertex_index_buffers.IsSet();
+    if (Config::r_skip_draw_texture_chains.IsSet() || m_num_world_draw_items == 0)
+    {
+        return;
+    }
 
     auto & context  = frame_data.context;
     auto & cbuffers = frame_data.cbuffers;
@@ -874,13 +1647,14 @@ void ViewRenderer::DrawTextureChains(FrameData & frame_data)
     batch_args.topology     = PrimitiveTopology::kTriangleList;
     batch_args.depth_hack   = false;
 
-    if (use_vb_ib)
+    frame_data.world_surfaces_drawn += m_num_world_draw_items;
+
+    if (Config::r_use_vertex_index_buffers.IsSet()) // Use the prebaked vertex and index buffers
     {
-        MRQ2_PUSH_GPU_MARKER(context, "DrawTextureChains");
+        MRQ2_PUSH_GPU_MARKER(context, "DrawWorldSurfaces");
 
         context.SetPipelineState(m_pipeline_solid_geometry);
         context.SetVertexBuffer(frame_data.world_model.vb);
-        context.SetIndexBuffer(frame_data.world_model.ib);
         context.SetPrimitiveTopology(batch_args.topology);
 
         uint32_t cbuffer_slot = 0;
@@ -892,86 +1666,177 @@ void ViewRenderer::DrawTextureChains(FrameData & frame_data)
         PerDrawShaderConstants consts;
         consts.model_matrix = batch_args.model_matrix;
         context.SetAndUpdateConstantBufferForDraw(m_per_draw_shader_consts, cbuffer_slot, consts);
+
+        // Falls back to the static index buffer if the merged indexes don't fit.
+        if (!Config::r_world_merged_indexes.IsSet() || !DrawWorldSurfacesMerged(frame_data))
+        {
+            DrawWorldSurfaceRanges(frame_data);
+        }
+
+        MRQ2_POP_GPU_MARKER(context);
+    }
+    else // Immediate mode emulation
+    {
+        const ModelInstance & world_mdl = frame_data.world_model;
+        const WorldDrawItem * const items = m_world_draw_items;
+        const int num_items = m_num_world_draw_items;
+
+        int i = 0;
+        while (i < num_items)
+        {
+            const std::uint64_t state = WorldDrawKeyState(items[i].key);
+
+            batch_args.diffuse_tex  = world_mdl.data.textures[WorldDrawKeyTextureId(items[i].key)];
+            batch_args.lightmap_tex = LightmapForPage(WorldDrawKeyLightmapPage(items[i].key), m_tex_white2x2);
+
+            MiniImBatch batch = BeginBatch(batch_args);
+            for (; i < num_items && WorldDrawKeyState(items[i].key) == state; ++i)
+            {
+                batch.PushModelSurface(*items[i].surf);
+            }
+            EndBatch(batch);
+        }
     }
+}
 
-    // Draw with sorting by texture:
-    for (const TextureImage * tex : frame_data.tex_store)
+///////////////////////////////////////////////////////////////////////////////
+
+// Draws the sorted surfaces with the model's static index buffer, one draw per run of adjacent index ranges.
+void ViewRenderer::DrawWorldSurfaceRanges(FrameData & frame_data)
+{
+    OPTICK_EVENT();
+
+    auto & context = frame_data.context;
+    context.SetIndexBuffer(frame_data.world_model.ib);
+
+    const ModelInstance & world_mdl = frame_data.world_model;
+    const WorldDrawItem * const items = m_world_draw_items;
+    const int num_items = m_num_world_draw_items;
+
+    int current_tex  = -1;
+    int current_page = -1;
+
+    int i = 0;
+    while (i < num_items)
     {
-        MRQ2_ASSERT(tex->Width() > 0 && tex->Height() > 0);
-        MRQ2_ASSERT(tex->Type() != TextureType::kCount);
+        const std::uint64_t state = WorldDrawKeyState(items[i].key);
+        const int tex_id = WorldDrawKeyTextureId(items[i].key);
+        const int page   = WorldDrawKeyLightmapPage(items[i].key);
 
-        if (tex->DrawChainPtr() == nullptr)
+        if (tex_id != current_tex)
         {
-            continue;
+            const TextureImage * tex = world_mdl.data.textures[tex_id];
+            MRQ2_ASSERT(tex->Width() > 0 && tex->Height() > 0);
+            context.SetTexture(tex->BackendTexture(), kDiffuseTextureSlot);
+            current_tex = tex_id;
+        }
+        if (page != current_page)
+        {
+            context.SetTexture(LightmapForPage(page, m_tex_white2x2)->BackendTexture(), kLightmapTextureSlot);
+            current_page = page;
         }
 
-        if (do_draw)
+        // Merge the following surfaces with the same state and adjacent index ranges into a single draw.
+        const auto first_range = items[i].surf->polys->index_buffer;
+        MRQ2_ASSERT(first_range.first_index >= 0 && first_range.index_count > 0 && first_range.base_vertex >= 0);
+
+        int index_count = first_range.index_count;
+        for (++i; i < num_items && WorldDrawKeyState(items[i].key) == state; ++i)
         {
-            if (use_vb_ib) // Use the prebaked vertex and index buffers
+            const auto range = items[i].surf->polys->index_buffer;
+            if (range.base_vertex != first_range.base_vertex || range.first_index != first_range.first_index + index_count)
             {
-                for (const ModelSurface * surf = tex->DrawChainPtr(); surf; surf = surf->texture_chain)
-                {
-                    if (const ModelPoly * poly = surf->polys)
-                    {
-                        if (poly->num_verts >= 3) // Need at least one triangle.
-                        {
-                            const auto range = poly->index_buffer;
-                            MRQ2_ASSERT(range.first_index >= 0 && range.index_count > 0 && range.base_vertex >= 0);
+                break;
+            }
+            index_count += range.index_count;
+        }
 
-                            auto * lightmap_tex = GetSurfaceLightmap(frame_data.view_def, *surf);
+        context.DrawIndexed(first_range.first_index, index_count, first_range.base_vertex);
+        ++frame_data.world_draw_calls;
+    }
+}
 
-                            context.SetTexture(tex->BackendTexture(), kDiffuseTextureSlot);
-                            context.SetTexture(lightmap_tex->BackendTexture(), kLightmapTextureSlot);
+///////////////////////////////////////////////////////////////////////////////
 
-                            context.DrawIndexed(range.first_index, range.index_count, range.base_vertex);
-                        }
-                    }
-                }
-            }
-            else // Immediate mode emulation
-            {
-                batch_args.diffuse_tex  = tex;
-                batch_args.lightmap_tex = nullptr;
+// Draws the sorted surfaces from a per-frame index buffer, a single draw per (diffuse, lightmap) pair.
+bool ViewRenderer::DrawWorldSurfacesMerged(FrameData & frame_data)
+{
+    OPTICK_EVENT();
+
+    const WorldDrawItem * const items = m_world_draw_items;
+    const int num_items = m_num_world_draw_items;
+
+    std::uint32_t total_indexes = 0;
+    for (int i = 0; i < num_items; ++i)
+    {
+        total_indexes += items[i].surf->polys->index_buffer.index_count;
+    }
+    if (total_indexes > m_world_index_buffers.BufferSize())
+    {
+        return false;
+    }
+
+    auto & context = frame_data.context;
+    context.SetIndexBuffer(BuildMergedWorldIndexes(frame_data.world_model));
+
+    const ModelInstance & world_mdl = frame_data.world_model;
+    std::uint32_t first_index = 0;
+
+    int i = 0;
+    while (i < num_items)
+    {
+        const std::uint64_t state = WorldDrawKeyState(items[i].key);
+        const TextureImage * tex = world_mdl.data.textures[WorldDrawKeyTextureId(items[i].key)];
+        const TextureImage * lightmap_tex = LightmapForPage(WorldDrawKeyLightmapPage(items[i].key), m_tex_white2x2);
+
+        std::uint32_t index_count = 0;
+        for (; i < num_items && WorldDrawKeyState(items[i].key) == state; ++i)
+        {
+            index_count += items[i].surf->polys->index_buffer.index_count;
+        }
+
+        MRQ2_ASSERT(tex->Width() > 0 && tex->Height() > 0);
+        context.SetTexture(tex->BackendTexture(), kDiffuseTextureSlot);
+        context.SetTexture(lightmap_tex->BackendTexture(), kLightmapTextureSlot);
+
+        // Indexes are absolute, so base vertex is always zero.
+        context.DrawIndexed(first_index, index_count, 0);
+        ++frame_data.world_draw_calls;
+
+        first_index += index_count;
+    }
+
+    MRQ2_ASSERT(first_index == total_indexes);
+    return true;
+}
 
-                MiniImBatch batch = BeginBatch(batch_args);
+///////////////////////////////////////////////////////////////////////////////
 
-                for (const ModelSurface * surf = tex->DrawChainPtr(); surf; surf = surf->texture_chain)
-                {
-                    if (surf->lightmap_texture_num >= 0)
-                    {
-                        auto * lightmap_tex = GetSurfaceLightmap(frame_data.view_def, *surf);
+// Writes the index ranges of the sorted world surfaces into the next per-frame index buffer.
+const IndexBuffer & ViewRenderer::BuildMergedWorldIndexes(const ModelInstance & world_mdl)
+{
+    OPTICK_EVENT();
+    MRQ2_ASSERT(world_mdl.data.indexes != nullptr);
 
-                        if (lightmap_tex != batch_args.lightmap_tex)
-                        {
-                            batch_args.lightmap_tex = lightmap_tex;
+    std::uint32_t * out_indexes = m_world_index_buffers.Map();
 
-                            // Lightmap texture has changed, close the current batch and start a new one.
-                            EndBatch(batch);
-                            batch = BeginBatch(batch_args);
-                        }
-                    }
+    for (int i = 0; i < m_num_world_draw_items; ++i)
+    {
+        const auto range = m_world_draw_items[i].surf->polys->index_buffer;
+        MRQ2_ASSERT(range.first_index >= 0 && range.index_count > 0 && range.base_vertex >= 0);
+        MRQ2_ASSERT(range.first_index + range.index_count <= world_mdl.data.num_indexes);
 
-                    if (const ModelPoly * poly = surf->polys)
-                    {
-                        if (poly->num_verts >= 3) // Need at least one triangle.
-                        {
-                            batch.PushModelSurface(*surf);
-                        }
-                    }
-                }
+        const std::uint16_t * const src_indexes = world_mdl.data.indexes + range.first_index;
+        const std::uint32_t base_vertex = range.base_vertex;
 
-                EndBatch(batch);
-            }
+        for (int n = 0; n < range.index_count; ++n)
+        {
+            out_indexes[n] = base_vertex + src_indexes[n];
         }
-
-        // All world geometry using this texture has been drawn, clear for the next frame.
-        tex->SetDrawChainPtr(nullptr);
+        out_indexes += range.index_count;
     }
 
-    if (use_vb_ib)
-    {
-        MRQ2_POP_GPU_MARKER(context);
-    }
+    return m_world_index_buffers.Unmap();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1061,6 +1926,17 @@ void ViewRenderer::RenderTranslucentEntities(FrameData & frame_data)
 
     const bool force_null_entity_models = Config::r_force_null_entity_models.IsSet();
 
+    m_alias_draw_items.clear();
+    for (const entity_t * entity : frame_data.translucent_entities)
+    {
+        if ((entity->flags & RF_TRANSLUCENT) && !(entity->flags & RF_BEAM) && IsAliasMD2Entity(*entity))
+        {
+            AddAliasMD2DrawItem(*entity);
+        }
+    }
+    PrepareAliasMD2Models(frame_data);
+
+    uint32_t alias_item = 0;
     for (const entity_t * entity : frame_data.translucent_entities)
     {
         if (!(entity->flags & RF_TRANSLUCENT))
@@ -1086,7 +1962,11 @@ void ViewRenderer::RenderTranslucentEntities(FrameData & frame_data)
         {
         case ModelType::kBrush    : { DrawBrushModel(frame_data, *entity);    break; }
         case ModelType::kSprite   : { DrawSpriteModel(frame_data, *entity);   break; }
-        case ModelType::kAliasMD2 : { DrawAliasMD2Model(frame_data, *entity); break; }
+        case ModelType::kAliasMD2 : {
+            MRQ2_ASSERT(m_alias_draw_items[alias_item].entity == entity);
+            DrawAliasMD2Model(frame_data, m_alias_draw_items[alias_item++]);
+            break;
+        }
         default : GameInterface::Errorf("RenderTranslucentEntities: Bad model type for '%s'!", model->name.CStr());
         } // switch
     }
@@ -1321,7 +2201,7 @@ void ViewRenderer::RenderDLights(const FrameData & frame_data)
                 const float a = i / 16.0f * M_PI * 2.0f;
                 for (int j = 0; j < 3; ++j)
                 {
-                    vert.position[j] = light->origin[j] + frame_data.right_vec[j] * std::cosf(a) * radius + frame_data.up_vec[j] * std::sinf(a) * radius;
+                    vert.position[j] = light->origin[j] + frame_data.right_vec[j] * std::cos(a) * radius + frame_data.up_vec[j] * std::sin(a) * radius;
                 }
 
                 batch.PushVertex(vert);
@@ -1493,7 +2373,8 @@ void ViewRenderer::RenderWorldModel(FrameData & frame_data)
     OPTICK_EVENT();
 
     m_alpha_world_surfaces = nullptr;
-    m_skybox.Clear(); // RecursiveWorldNode adds to the sky bounds
+    m_skybox.Clear(); // MergeWorldTraversalContexts adds to the sky bounds
+    m_num_world_draw_items = 0;
 
     if ((frame_data.view_def.rdflags & RDF_NOWORLDMODEL) || Config::r_skip_draw_world.IsSet())
     {
@@ -1501,8 +2382,18 @@ void ViewRenderer::RenderWorldModel(FrameData & frame_data)
     }
 
     MarkLeaves(frame_data.world_model);
-    RecursiveWorldNode(frame_data, frame_data.world_model, frame_data.world_model.data.nodes);
-    DrawTextureChains(frame_data);
+    ReserveWorldSurfaceLists(frame_data.world_model.data.num_surfaces);
+
+    // Debug bounds drawing is not thread safe, so it forces the serial path.
+    if (Config::r_world_parallel.IsSet() && JobSystem::NumThreads() > 1 && !Config::r_draw_world_bounds.IsSet())
+    {
+        ParallelWorldTraversal(frame_data, frame_data.world_model);
+    }
+    else
+    {
+        SerialWorldTraversal(frame_data, frame_data.world_model);
+    }
+    DrawWorldSurfaces(frame_data);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1562,6 +2453,18 @@ void ViewRenderer::RenderSolidEntities(FrameData & frame_data)
     const entity_t * const entities_list = frame_data.view_def.entities;
     const bool force_null_entity_models = Config::r_force_null_entity_models.IsSet();
 
+    // Cull, shade and lerp all the alias models first, so it can be spread over the worker threads.
+    m_alias_draw_items.clear();
+    for (int e = 0; e < num_entities; ++e)
+    {
+        if (!(entities_list[e].flags & RF_TRANSLUCENT) && IsAliasMD2Entity(entities_list[e]))
+        {
+            AddAliasMD2DrawItem(entities_list[e]);
+        }
+    }
+    PrepareAliasMD2Models(frame_data);
+
+    uint32_t alias_item = 0;
     for (int e = 0; e < num_entities; ++e)
     {
         const entity_t & entity = entities_list[e];
@@ -1587,7 +2490,11 @@ void ViewRenderer::RenderSolidEntities(FrameData & frame_data)
         {
         case ModelType::kBrush    : { DrawBrushModel(frame_data, entity);    break; }
         case ModelType::kSprite   : { DrawSpriteModel(frame_data, entity);   break; }
-        case ModelType::kAliasMD2 : { DrawAliasMD2Model(frame_data, entity); break; }
+        case ModelType::kAliasMD2 : {
+            MRQ2_ASSERT(m_alias_draw_items[alias_item].entity == &entity);
+            DrawAliasMD2Model(frame_data, m_alias_draw_items[alias_item++]);
+            break;
+        }
         default : GameInterface::Errorf("RenderSolidEntities: Bad model type for '%s'!", model->name.CStr());
         } // switch
     }
@@ -1846,36 +2753,227 @@ void ViewRenderer::DrawSpriteModel(const FrameData & frame_data, const entity_t
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void ViewRenderer::DrawAliasMD2Model(FrameData & frame_data, const entity_t & entity)
+bool ViewRenderer::IsAliasMD2Entity(const entity_t & entity)
+{
+    const auto * model = reinterpret_cast<const ModelInstance *>(entity.model);
+    return model != nullptr && model->type == ModelType::kAliasMD2 && !Config::r_force_null_entity_models.IsSet();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::AddAliasMD2DrawItem(const entity_t & entity)
+{
+    const auto * model = reinterpret_cast<const ModelInstance *>(entity.model);
+    const AliasMD2Mesh * mesh = model->data.alias_mesh;
+    MRQ2_ASSERT(mesh != nullptr);
+
+    // Validated here since the items are prepared on the worker threads, which can't raise errors.
+    if ((entity.frame >= mesh->num_frames) || (entity.frame < 0))
+    {
+        GameInterface::Errorf("AddAliasMD2DrawItem %s: no such frame %d", model->name.CStr(), entity.frame);
+    }
+    if ((entity.oldframe >= mesh->num_frames) || (entity.oldframe < 0))
+    {
+        GameInterface::Errorf("AddAliasMD2DrawItem %s: no such oldframe %d", model->name.CStr(), entity.oldframe);
+    }
+
+    AliasMD2DrawItem item = {};
+    item.entity = &entity;
+    item.model  = model;
+    m_alias_draw_items.push_back(item);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::PrepareAliasMD2Models(const FrameData & frame_data)
 {
+    if (m_alias_draw_items.empty())
+    {
+        return;
+    }
+
     OPTICK_EVENT();
+    MRQ2_ASSERT(m_num_alias_scratch_threads >= JobSystem::NumThreads());
 
-    if (!(entity.flags & RF_WEAPONMODEL))
+    // Vertexes of the visible items are sub-allocated from the remainder of the current vertex buffer.
+    struct JobArgs
+    {
+        ViewRenderer *          renderer;
+        const FrameData *       frame_data;
+        DrawVertex3D *          base_verts;
+        uint32_t                base_position;
+        uint32_t                max_verts;
+        std::atomic<uint32_t>   used_verts;
+    } job_args{ this, &frame_data, m_vertex_buffers.CurrentVertexPtr(), m_vertex_buffers.CurrentPosition(), m_vertex_buffers.NumVertsRemaining(), { 0 } };
+
+    const JobSystem::JobFunc prepare_item = [](void * user_data, const int job_index, const int thread_index)
     {
-        vec3_t bbox[8] = {};
-        const bool cull = ShouldCullAliasMD2Model(frame_data.frustum, entity, bbox);
-        if (cull)
+        auto & args = *static_cast<JobArgs *>(user_data);
+        ViewRenderer & renderer = *args.renderer;
+        AliasMD2DrawItem & item = renderer.m_alias_draw_items[job_index];
+
+        renderer.PrepareAliasMD2Item(*args.frame_data, item);
+        if (item.culled)
         {
-            frame_data.alias_models_culled++;
             return;
         }
 
-        if (Config::r_draw_model_bounds.IsSet())
+        const uint32_t num_verts = item.model->data.alias_mesh->num_draw_verts * (item.draw_shadow ? 2 : 1);
+        const uint32_t offset = args.used_verts.fetch_add(num_verts);
+        if (offset + num_verts > args.max_verts)
+        {
+            return; // Overflowed, reported below.
+        }
+
+        item.verts      = args.base_verts + offset;
+        item.first_vert = args.base_position + offset;
+
+        float * const scratch = renderer.m_alias_scratch_positions + std::size_t(thread_index) * 3 * MAX_VERTS;
+        float * const positions[3] = { scratch, scratch + MAX_VERTS, scratch + MAX_VERTS * 2 };
+        BuildAliasMD2Verts(item, positions);
+    };
+
+    const int num_items = int(m_alias_draw_items.size());
+    if (Config::r_entities_parallel.IsSet() && JobSystem::NumThreads() > 1 && num_items > 1)
+    {
+        JobSystem::ParallelFor(num_items, prepare_item, &job_args);
+    }
+    else
+    {
+        for (int i = 0; i < num_items; ++i)
         {
-            DebugDraw::AddAABB(bbox, ColorRGBA32{ 0xFF0000FF }); // red
+            prepare_item(&job_args, i, 0);
         }
     }
 
-    vec4_t shade_light = { 1.0f, 1.0f, 1.0f, 1.0f };
-    vec3_t light_spot  = {};
+    // Commit the vertexes written by the jobs. Errors out if they didn't fit.
+    const uint32_t used_verts = job_args.used_verts.load();
+    if (used_verts > 0)
+    {
+        m_vertex_buffers.Increment(used_verts);
+    }
+
+    if (Config::r_instanced_entities.IsSet())
+    {
+        BuildAliasMD2Instances();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Groups the visible instanced items by model and skin. Each group with more than one item is drawn
+// by its first item with the indexes of all the members, offset to their vertexes in the vertex buffer.
+void ViewRenderer::BuildAliasMD2Instances()
+{
+    OPTICK_EVENT();
+
+    auto IsCandidate = [](const AliasMD2DrawItem & item)
+    {
+        return item.instanced && !item.culled && !item.merged && item.verts != nullptr;
+    };
+
+    auto SameGroup = [](const AliasMD2DrawItem & a, const AliasMD2DrawItem & b)
+    {
+        return a.model == b.model && a.skin == b.skin && a.draw_shadow == b.draw_shadow &&
+               (a.entity->flags & RF_DEPTHHACK) == (b.entity->flags & RF_DEPTHHACK);
+    };
+
+    m_alias_instance_indexes = nullptr;
+
+    const int num_items = int(m_alias_draw_items.size());
+    std::uint32_t * out_indexes = nullptr;
+    std::uint32_t num_indexes = 0;
+
+    FixedSizeArray<int, MAX_ENTITIES> members;
+
+    for (int i = 0; i < num_items; ++i)
+    {
+        AliasMD2DrawItem & leader = m_alias_draw_items[i];
+        if (!IsCandidate(leader))
+        {
+            continue;
+        }
+
+        members.clear();
+        members.push_back(i);
+        for (int j = i + 1; j < num_items; ++j)
+        {
+            if (IsCandidate(m_alias_draw_items[j]) && SameGroup(leader, m_alias_draw_items[j]))
+            {
+                members.push_back(j);
+            }
+        }
+
+        const AliasMD2Mesh & mesh = *leader.model->data.alias_mesh;
+        const int num_passes = leader.draw_shadow ? 2 : 1;
+        const std::uint32_t group_indexes = std::uint32_t(mesh.num_indexes) * members.size() * num_passes;
+
+        if (members.size() < 2 || num_indexes + group_indexes > m_entity_index_buffers.BufferSize())
+        {
+            continue; // Drawn one at a time.
+        }
+
+        if (out_indexes == nullptr)
+        {
+            out_indexes = m_entity_index_buffers.Map();
+        }
+
+        leader.num_instances      = int(members.size());
+        leader.first_index        = num_indexes;
+        leader.index_count        = std::uint32_t(mesh.num_indexes) * members.size();
+        leader.shadow_index_count = leader.draw_shadow ? leader.index_count : 0;
+
+        // Model indexes of every member, then their shadow indexes (the shadow vertexes follow the model's).
+        for (int pass = 0; pass < num_passes; ++pass)
+        {
+            for (const int m : members)
+            {
+                const std::uint32_t base_vertex = m_alias_draw_items[m].first_vert + pass * mesh.num_draw_verts;
+                for (int n = 0; n < mesh.num_indexes; ++n)
+                {
+                    out_indexes[num_indexes + n] = base_vertex + mesh.indexes[n];
+                }
+                num_indexes += mesh.num_indexes;
+            }
+        }
+
+        for (std::uint32_t m = 1; m < members.size(); ++m)
+        {
+            m_alias_draw_items[members[m]].merged = true;
+        }
+    }
+
+    if (out_indexes != nullptr)
+    {
+        m_alias_instance_indexes = &m_entity_index_buffers.Unmap();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ViewRenderer::PrepareAliasMD2Item(const FrameData & frame_data, AliasMD2DrawItem & item) const
+{
+    const entity_t & entity = *item.entity;
+
+    if (!(entity.flags & RF_WEAPONMODEL))
+    {
+        if (ShouldCullAliasMD2Model(frame_data.frustum, entity, item.bbox))
+        {
+            item.culled = true;
+            return;
+        }
+    }
 
-    ShadeAliasMD2Model(frame_data, entity, shade_light, light_spot);
+    item.shade_light[0] = item.shade_light[1] = item.shade_light[2] = item.shade_light[3] = 1.0f;
+    Vec3Zero(item.light_spot);
 
-    const float  backlerp = (Config::r_lerp_entity_models.IsSet() ? entity.backlerp : 0.0f);
-    const auto   mdl_mtx  = MakeEntityModelMatrix(entity, /* flipUpV = */false);
-    const auto * model    = reinterpret_cast<const ModelInstance *>(entity.model);
+    ShadeAliasMD2Model(frame_data, item);
+
+    item.backlerp     = (Config::r_lerp_entity_models.IsSet() ? entity.backlerp : 0.0f);
+    item.model_matrix = MakeEntityModelMatrix(entity, /* flipUpV = */false);
 
     // Select skin texture:
+    const ModelInstance * model = item.model;
     const TextureImage * skin = nullptr;
     if (entity.skin != nullptr)
     {
@@ -1901,20 +2999,100 @@ void ViewRenderer::DrawAliasMD2Model(FrameData & frame_data, const entity_t & en
     {
         skin = m_tex_white2x2; // fallback...
     }
-
-    // Draw interpolated frame:
-    DrawAliasMD2FrameLerp(entity, model->hunk.ViewBaseAs<dmdl_t>(), backlerp, shade_light, mdl_mtx, skin);
+    item.skin = skin;
 
     // Simple projected shadow:
-    const bool draw_shadows = Config::r_alias_shadows.IsSet();
-    if (draw_shadows && !(entity.flags & (RF_TRANSLUCENT | RF_WEAPONMODEL)))
+    item.draw_shadow = Config::r_alias_shadows.IsSet() && !(entity.flags & (RF_TRANSLUCENT | RF_WEAPONMODEL));
+
+    // Translucent models keep their own draws, merging would break the back to front order.
+    item.instanced = Config::r_instanced_entities.IsSet() && !(entity.flags & RF_TRANSLUCENT);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Appends the draws of an item built by PrepareAliasMD2Models().
+void ViewRenderer::DrawAliasMD2Model(FrameData & frame_data, const AliasMD2DrawItem & item)
+{
+    const entity_t & entity = *item.entity;
+
+    if (item.culled)
+    {
+        frame_data.alias_models_culled++;
+        return;
+    }
+
+    if (Config::r_draw_model_bounds.IsSet() && !(entity.flags & RF_WEAPONMODEL))
+    {
+        DebugDraw::AddAABB(item.bbox, ColorRGBA32{ 0xFF0000FF }); // red
+    }
+
+    // The cache is only read by the prepare jobs, so new samples are added here on the main thread.
+    if (item.light_cache_miss)
+    {
+        m_light_cache.Insert(item.light_cache_key, item.light_sample);
+        frame_data.light_cache_misses++;
+    }
+    else if (item.light_cache_hit)
+    {
+        frame_data.light_cache_hits++;
+    }
+
+    if (item.merged)
+    {
+        frame_data.alias_instances_merged++;
+        return; // Part of an earlier draw.
+    }
+
+    MRQ2_ASSERT(item.verts != nullptr);
+    const AliasMD2Mesh & mesh = *item.model->data.alias_mesh;
+
+    // Interpolated frame, drawn with the model's static indexes:
+    BeginBatchArgs batch_args;
+    batch_args.model_matrix = item.instanced ? RenderMatrix{ RenderMatrix::kIdentity } : item.model_matrix;
+    batch_args.diffuse_tex  = item.skin;
+    batch_args.lightmap_tex = nullptr;
+    batch_args.topology     = PrimitiveTopology::kTriangleList;
+    batch_args.depth_hack   = (entity.flags & RF_DEPTHHACK) != 0;
+    batch_args.index_buffer = &item.model->ib;
+    batch_args.index_count  = mesh.num_indexes;
+
+    uint32_t first_vert = item.first_vert;
+    uint32_t num_verts  = mesh.num_draw_verts;
+
+    // Group of instances, the indexes are absolute.
+    if (item.num_instances > 1)
+    {
+        MRQ2_ASSERT(m_alias_instance_indexes != nullptr);
+        batch_args.index_buffer = m_alias_instance_indexes;
+        batch_args.first_index  = item.first_index;
+        batch_args.index_count  = item.index_count;
+        first_vert = 0;
+        num_verts *= item.num_instances;
+    }
+
+    AddDrawCmd(batch_args, first_vert, num_verts);
+
+    if (item.draw_shadow)
     {
         // Switch to projected shadows mode then back to previous render mode.
         // We want alpha blending to be enabled for the shadows.
         const auto prev_pass = m_current_pass;
         m_current_pass = kPass_TranslucentEntities;
 
-        DrawAliasMD2Shadow(entity, model->hunk.ViewBaseAs<dmdl_t>(), mdl_mtx, light_spot);
+        batch_args.diffuse_tex = nullptr;
+        batch_args.depth_hack  = false;
+
+        if (item.num_instances > 1)
+        {
+            batch_args.first_index = item.first_index + item.index_count;
+            batch_args.index_count = item.shadow_index_count;
+        }
+        else
+        {
+            first_vert += mesh.num_draw_verts;
+        }
+
+        AddDrawCmd(batch_args, first_vert, num_verts);
 
         m_current_pass = prev_pass;
     }
@@ -2027,7 +3205,7 @@ void ViewRenderer::DrawNullModel(const FrameData & frame_data, const entity_t &
                                           {color[0], color[1], color[2], color[3]} });
         for (int i = 0, j = 0; i <= 4; ++i)
         {
-            batch.PushVertex({ {16.0f * std::cosf(i * M_PI / 2.0f), 16.0f * std::sinf(i * M_PI / 2.0f), 0.0f},
+            batch.PushVertex({ {16.0f * std::cos(float(i * M_PI / 2.0f)), 16.0f * std::sin(float(i * M_PI / 2.0f)), 0.0f},
                                {uvs[j][0], uvs[j][1]}, {0.0f, 0.0f}, {color[0], color[1], color[2], color[3]} });
             if (++j > 2) j = 1;
         }
@@ -2037,7 +3215,7 @@ void ViewRenderer::DrawNullModel(const FrameData & frame_data, const entity_t &
                                           {color[0], color[1], color[2], color[3]} });
         for (int i = 4, j = 0; i >= 0; --i)
         {
-            batch.PushVertex({ {16.0f * std::cosf(i * M_PI / 2.0f), 16.0f * std::sinf(i * M_PI / 2.0f), 0.0f},
+            batch.PushVertex({ {16.0f * std::cos(float(i * M_PI / 2.0f)), 16.0f * std::sin(float(i * M_PI / 2.0f)), 0.0f},
                                {uvs[j][0], uvs[j][1]}, {0.0f, 0.0f}, {color[0], color[1], color[2], color[3]} });
             if (++j > 2) j = 1;
         }
@@ -2052,14 +3230,9 @@ bool ViewRenderer::ShouldCullAliasMD2Model(const Frustum & frustum, const entity
     const auto   * model     = reinterpret_cast<const ModelInstance *>(entity.model);
     const dmdl_t * paliashdr = model->hunk.ViewBaseAs<const dmdl_t>();
 
-    if ((entity.frame >= paliashdr->num_frames) || (entity.frame < 0))
-    {
-        GameInterface::Errorf("ShouldCullAliasMD2Model %s: no such frame", model->name.CStr(), entity.frame);
-    }
-    if ((entity.oldframe >= paliashdr->num_frames) || (entity.oldframe < 0))
-    {
-        GameInterface::Errorf("ShouldCullAliasMD2Model %s: no such oldframe", model->name.CStr(), entity.oldframe);
-    }
+    // Frame indexes are validated by AddAliasMD2DrawItem().
+    MRQ2_ASSERT(entity.frame    >= 0 && entity.frame    < paliashdr->num_frames);
+    MRQ2_ASSERT(entity.oldframe >= 0 && entity.oldframe < paliashdr->num_frames);
 
     auto * pframe    = reinterpret_cast<const daliasframe_t *>((const uint8_t *)paliashdr + paliashdr->ofs_frames + entity.frame    * paliashdr->framesize);
     auto * poldframe = reinterpret_cast<const daliasframe_t *>((const uint8_t *)paliashdr + paliashdr->ofs_frames + entity.oldframe * paliashdr->framesize);
@@ -2154,8 +3327,12 @@ bool ViewRenderer::ShouldCullAliasMD2Model(const Frustum & frustum, const entity
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void ViewRenderer::ShadeAliasMD2Model(const FrameData & frame_data, const entity_t & entity, vec4_t out_shade_light_color, vec3_t out_light_spot) const
+void ViewRenderer::ShadeAliasMD2Model(const FrameData & frame_data, AliasMD2DrawItem & item) const
 {
+    const entity_t & entity = *item.entity;
+    float * const out_shade_light_color = item.shade_light;
+    float * const out_light_spot = item.light_spot;
+
     //
     // Hacks for the original Quake2 ref_gl follow
     //
@@ -2223,6 +3400,23 @@ void ViewRenderer::ShadeAliasMD2Model(const FrameData & frame_data, const entity
         for (int i = 0; i < 4; ++i)
             out_shade_light_color[i] = 1.0f;
     }
+    else if (Config::r_light_cache.IsSet())
+    {
+        item.light_cache_key = PointLightCache::MakeKey(entity.origin);
+        if (m_light_cache.Find(item.light_cache_key, item.light_sample))
+        {
+            item.light_cache_hit = true;
+        }
+        else
+        {
+            // Sampled at the entity and not the cell center, which can be below the floor the entity rests on.
+            SamplePointLight(frame_data, entity.origin, item.light_sample);
+            item.light_cache_miss = true;
+        }
+
+        PointLightColor(frame_data, item.light_sample, entity.origin, out_shade_light_color);
+        Vec3Copy(item.light_sample.light_spot, out_light_spot);
+    }
     else
     {
         CalcPointLightColor(frame_data, entity.origin, out_shade_light_color, out_light_spot);
@@ -2248,7 +3442,7 @@ void ViewRenderer::ShadeAliasMD2Model(const FrameData & frame_data, const entity
     {
         // bonus items will pulse with time
         float min;
-        const float scale = 0.1f * std::sinf(frame_data.view_def.time * 7.0f);
+        const float scale = 0.1f * std::sin(frame_data.view_def.time * 7.0f);
         for (int i = 0; i < 3; ++i)
         {
             min = out_shade_light_color[i] * 0.8f;
@@ -2270,11 +3464,9 @@ void ViewRenderer::ShadeAliasMD2Model(const FrameData & frame_data, const entity
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static int RecursiveLightPoint(const ModelInstance & world_mdl, const ModelNode * node, const lightstyle_t * lightstyles,
-                               const vec3_t start, const vec3_t end, vec3_t out_point_color, vec3_t out_light_spot)
+static int RecursiveLightPoint(const ModelInstance & world_mdl, const ModelNode * node, const vec3_t start, const vec3_t end, PointLightSample & out_sample)
 {
     MRQ2_ASSERT(node != nullptr);
-    MRQ2_ASSERT(lightstyles != nullptr);
 
     if (node->contents != -1)
     {
@@ -2289,7 +3481,7 @@ static int RecursiveLightPoint(const ModelInstance & world_mdl, const ModelNode
 
     if ((back < 0.0f) == side)
     {
-        return RecursiveLightPoint(world_mdl, node->children[side], lightstyles, start, end, out_point_color, out_light_spot);
+        return RecursiveLightPoint(world_mdl, node->children[side], start, end, out_sample);
     }
 
     const float frac = front / (front - back);
@@ -2300,7 +3492,7 @@ static int RecursiveLightPoint(const ModelInstance & world_mdl, const ModelNode
     mid[2] = start[2] + (end[2] - start[2]) * frac;
 
     // Go down front side
-    const int r = RecursiveLightPoint(world_mdl, node->children[side], lightstyles, start, mid, out_point_color, out_light_spot);
+    const int r = RecursiveLightPoint(world_mdl, node->children[side], start, mid, out_sample);
     if (r >= 0)
     {
         return r; // Hit something
@@ -2310,10 +3502,9 @@ static int RecursiveLightPoint(const ModelInstance & world_mdl, const ModelNode
         return -1; // Didn't hit anything
     }
 
-    Vec3Copy(mid, out_light_spot);
+    Vec3Copy(mid, out_sample.light_spot);
 
     // Check for impact on this node
-    const float lightmap_intensity = Config::r_lightmap_intensity.AsFloat();
     const ModelSurface * surf = world_mdl.data.surfaces + node->first_surface;
 
     for (int i = 0; i < node->num_surfaces; ++i, ++surf)
@@ -2341,6 +3532,8 @@ static int RecursiveLightPoint(const ModelInstance & world_mdl, const ModelNode
             continue;
         }
 
+        out_sample.surf = surf;
+
         if (surf->samples == nullptr)
         {
             return 0;
@@ -2349,62 +3542,92 @@ static int RecursiveLightPoint(const ModelInstance & world_mdl, const ModelNode
         ds >>= 4;
         dt >>= 4;
 
-        Vec3Zero(out_point_color);
-
-        const std::uint8_t * lightmap = surf->samples;
-        lightmap += 3 * (dt * ((surf->extents[0] >> 4) + 1) + ds);
-
-        for (int lmap = 0; lmap < kMaxLightmaps && surf->styles[lmap] != 255; ++lmap)
-        {
-            vec3_t scale;
-            for (int v = 0; v < 3; ++v)
-            {
-                scale[v] = lightmap_intensity * lightstyles[surf->styles[lmap]].rgb[v];
-            }
-
-            out_point_color[0] += lightmap[0] * scale[0] * (1.0f / 255.0f);
-            out_point_color[1] += lightmap[1] * scale[1] * (1.0f / 255.0f);
-            out_point_color[2] += lightmap[2] * scale[2] * (1.0f / 255.0f);
-
-            lightmap += 3 * ((surf->extents[0] >> 4) + 1) * ((surf->extents[1] >> 4) + 1);
-        }
-
+        out_sample.lightmap = surf->samples + 3 * (dt * ((surf->extents[0] >> 4) + 1) + ds);
         return 1;
     }
 
     // Go down back side
-    return RecursiveLightPoint(world_mdl, node->children[!side], lightstyles, mid, end, out_point_color, out_light_spot);
+    return RecursiveLightPoint(world_mdl, node->children[!side], mid, end, out_sample);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void ViewRenderer::CalcPointLightColor(const FrameData & frame_data, const vec3_t point, vec4_t out_shade_light_color, vec3_t out_light_spot) const
+{
+    PointLightSample sample;
+    SamplePointLight(frame_data, point, sample);
+    PointLightColor(frame_data, sample, point, out_shade_light_color);
+
+    if (frame_data.world_model.data.light_data != nullptr)
+    {
+        Vec3Copy(sample.light_spot, out_light_spot);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Traces down from the point to the lightmapped surface below it.
+void ViewRenderer::SamplePointLight(const FrameData & frame_data, const vec3_t point, PointLightSample & out_sample) const
 {
     const ModelInstance & world_mdl = frame_data.world_model;
 
+    out_sample.surf     = nullptr;
+    out_sample.lightmap = nullptr;
+    out_sample.result   = -1;
+    Vec3Zero(out_sample.light_spot);
+
     if (world_mdl.data.light_data == nullptr) // fullbright
     {
-        out_shade_light_color[0] = 1.0f;
-        out_shade_light_color[1] = 1.0f;
-        out_shade_light_color[2] = 1.0f;
-        out_shade_light_color[3] = 1.0f;
         return;
     }
 
     const vec3_t end_point = { point[0], point[1], point[2] - 2048.0f };
+    out_sample.result = RecursiveLightPoint(world_mdl, world_mdl.data.nodes, point, end_point, out_sample);
+}
 
-    vec3_t out_point_color = {};
-    const int r = RecursiveLightPoint(world_mdl, world_mdl.data.nodes, frame_data.view_def.lightstyles, point, end_point, out_point_color, out_light_spot);
+///////////////////////////////////////////////////////////////////////////////
 
-    if (r == -1)
+// Applies the current lightstyles to the sampled luxel and adds the dynamic lights around the point.
+void ViewRenderer::PointLightColor(const FrameData & frame_data, const PointLightSample & sample, const vec3_t point, vec4_t out_shade_light_color) const
+{
+    if (frame_data.world_model.data.light_data == nullptr) // fullbright
     {
-        Vec3Zero(out_shade_light_color);
+        out_shade_light_color[0] = 1.0f;
+        out_shade_light_color[1] = 1.0f;
+        out_shade_light_color[2] = 1.0f;
+        out_shade_light_color[3] = 1.0f;
+        return;
     }
-    else
+
+    Vec3Zero(out_shade_light_color);
+    out_shade_light_color[3] = 1.0f;
+
+    if (sample.result == 1)
     {
-        Vec3Copy(out_point_color, out_shade_light_color);
+        MRQ2_ASSERT(sample.surf != nullptr && sample.lightmap != nullptr);
+
+        const ModelSurface * surf = sample.surf;
+        const lightstyle_t * lightstyles = frame_data.view_def.lightstyles;
+        MRQ2_ASSERT(lightstyles != nullptr);
+
+        const float lightmap_intensity = Config::r_lightmap_intensity.AsFloat();
+        const std::uint8_t * lightmap = sample.lightmap;
+
+        for (int lmap = 0; lmap < kMaxLightmaps && surf->styles[lmap] != 255; ++lmap)
+        {
+            vec3_t scale;
+            for (int v = 0; v < 3; ++v)
+            {
+                scale[v] = lightmap_intensity * lightstyles[surf->styles[lmap]].rgb[v];
+            }
+
+            out_shade_light_color[0] += lightmap[0] * scale[0] * (1.0f / 255.0f);
+            out_shade_light_color[1] += lightmap[1] * scale[1] * (1.0f / 255.0f);
+            out_shade_light_color[2] += lightmap[2] * scale[2] * (1.0f / 255.0f);
+
+            lightmap += 3 * ((surf->extents[0] >> 4) + 1) * ((surf->extents[1] >> 4) + 1);
+        }
     }
-    out_shade_light_color[3] = 1.0f;
 
     // Add dynamic lights:
     const dlight_t * dl = frame_data.view_def.dlights;
@@ -19,6 +19,127 @@ namespace MrQ2
 
 using ViewConstBuffers = ArrayBase<const ConstantBuffer *>;
 
+/*
+===============================================================================
+
+    ClusterPVSCache
+
+===============================================================================
+*/
+class ClusterPVSCache final
+{
+public:
+
+    // Upper bound for r_pvs_cache_size.
+    static constexpr int kMaxEntries = 256;
+
+    ClusterPVSCache() = default;
+    ~ClusterPVSCache() { Reset(); }
+
+    // Disallow copy.
+    ClusterPVSCache(const ClusterPVSCache &) = delete;
+    ClusterPVSCache & operator=(const ClusterPVSCache &) = delete;
+
+    // Frees the cached bitsets. Must be called when a new map is loaded.
+    void Reset();
+
+    // Decompressed PVS of the cluster, padded to RowBytes() (a multiple of 4).
+    // Decompresses on a miss, evicting the least recently used entry if full.
+    // Pointer is valid until the next call to Get().
+    const std::uint8_t * Get(const int cluster, const ModelInstance & world_mdl);
+
+    int RowBytes()   const { return m_row_bytes; }
+    int NumEntries() const { return m_num_entries; }
+    int Capacity()   const { return m_capacity; }
+    int Hits()       const { return m_hits; }
+    int Misses()     const { return m_misses; }
+
+private:
+
+    void Allocate(const ModelInstance & world_mdl);
+
+    struct Entry
+    {
+        int           cluster;
+        std::uint32_t last_used;
+    };
+
+    std::uint8_t * m_bitsets{ nullptr };          // [m_capacity + 1] rows, last one is all visible.
+    std::int16_t * m_cluster_to_entry{ nullptr }; // [m_num_clusters], -1 if not cached.
+    std::uint32_t  m_use_counter{ 0 };
+    int            m_num_clusters{ 0 };
+    int            m_row_bytes{ 0 };
+    int            m_capacity{ 0 };
+    int            m_num_entries{ 0 };
+    int            m_hits{ 0 };
+    int            m_misses{ 0 };
+    Entry          m_entries[kMaxEntries];
+};
+
+/*
+===============================================================================
+
+    PointLightCache
+
+===============================================================================
+*/
+
+// Result of the BSP descent in CalcPointLightColor(), before the lightstyles and dynamic lights are applied.
+struct PointLightSample
+{
+    const ModelSurface * surf;       // Surface hit below the point, if any.
+    const std::uint8_t * lightmap;   // Luxel in the first lightmap of surf.
+    vec3_t               light_spot;
+    int                  result;     // -1: nothing hit, 0: surface without lightmap, 1: lightmap sampled.
+};
+
+// Memoizes the light samples of alias models by position, quantized to kCellSize units.
+// Only the hit luxel is cached, so lightstyle animations are still applied on every lookup.
+// The sample of the first entity seen in a cell is reused for the others in it.
+class PointLightCache final
+{
+public:
+
+    static constexpr int   kNumEntries = 4096; // Direct mapped, must be a power of two.
+    static constexpr float kCellSize   = 4.0f;
+
+    struct Key
+    {
+        std::int32_t cell[3];
+        std::uint32_t slot;
+    };
+
+    PointLightCache() = default;
+
+    // Disallow copy.
+    PointLightCache(const PointLightCache &) = delete;
+    PointLightCache & operator=(const PointLightCache &) = delete;
+
+    // Clears all entries. Must be called when a new map is loaded.
+    void Reset();
+
+    static Key MakeKey(const vec3_t point);
+
+    // Read only, safe to call from the JobSystem threads as long as there are no Insert()s.
+    bool Find(const Key & key, PointLightSample & out_sample) const;
+    void Insert(const Key & key, const PointLightSample & sample);
+
+    int NumEntries() const { return m_num_entries; }
+    static constexpr int Capacity() { return kNumEntries; }
+
+private:
+
+    struct Entry
+    {
+        PointLightSample sample;
+        std::int32_t     cell[3];
+        bool             valid;
+    };
+
+    int   m_num_entries{ 0 };
+    Entry m_entries[kNumEntries] = {};
+};
+
 /*
 ===============================================================================
 
@@ -33,6 +154,30 @@ public:
     // Max per RenderView
     static constexpr uint32_t kMaxTranslucentEntities = 128;
 
+    // Stages of RenderViewSetup/DoRenderView that can be individually timed.
+    enum TimedStage : int
+    {
+        kStage_ViewSetup = 0,
+        kStage_WorldModel,
+        kStage_SkyBox,
+        kStage_SolidEntities,
+        kStage_TranslucentSurfaces,
+        kStage_TranslucentEntities,
+        kStage_Particles,
+        kStage_DLights,
+        kStage_FlushDrawCmds,
+        kStage_Lightmaps,
+
+        kTimedStageCount
+    };
+
+    static const char * TimedStageName(const int stage);
+
+    struct StageTimes
+    {
+        std::uint64_t microseconds[kTimedStageCount];
+    };
+
     struct FrameData
     {
         FrameData(TextureStore & texstore, ModelInstance & world, const refdef_t & view, GraphicsContext & cx, const ViewConstBuffers & cbs)
@@ -73,6 +218,14 @@ public:
         int alias_models_culled{ 0 };
         int brush_models_culled{ 0 };
         int world_nodes_culled{ 0 };
+        int world_draw_calls{ 0 };
+        int world_surfaces_drawn{ 0 };
+        int light_cache_hits{ 0 };
+        int light_cache_misses{ 0 };
+        int alias_instances_merged{ 0 };
+
+        // Optional CPU timings for each stage (view_replay benchmark). Only measured if not null.
+        StageTimes * stage_times{ nullptr };
     };
 
     ViewRenderer() = default;
@@ -95,6 +248,18 @@ public:
     // Assignable ref
     SkyBox & Sky() { return m_skybox; }
 
+    // Debug counters for the overlay.
+    const ClusterPVSCache & PVSCache() const { return m_pvs_cache; }
+    const PointLightCache & LightCache() const { return m_light_cache; }
+    int LeafsMarked() const { return m_leafs_marked; }
+    int LightstylesChanged() const { return m_lightstyles_changed; }
+    int LightstyleSurfacesUpdated() const { return m_lightstyle_surfaces_updated; }
+    int DrawCmdsSubmitted() const { return m_draw_cmds_submitted; }
+    int DrawCmdsMerged() const { return m_draw_cmds_merged; }
+
+    // Times the MD2 vertex generation for num_instances animated models (alias_bench command). Defined in DrawAliasMD2.cpp.
+    static void BenchmarkAliasMD2(const ModelStore & model_store, int num_instances, int iterations);
+
 private:
 
     struct BeginBatchArgs
@@ -104,11 +269,23 @@ private:
         const TextureImage * lightmap_tex; // optional
         PrimitiveTopology    topology;
         bool                 depth_hack;
+
+        // Optional static indexes into the batch vertexes (kTriangleList only).
+        const IndexBuffer *  index_buffer{ nullptr };
+        uint32_t             first_index{ 0 };
+        uint32_t             index_count{ 0 };
     };
 
     MiniImBatch BeginBatch(const BeginBatchArgs & args);
     void EndBatch(MiniImBatch & batch);
 
+    // Draw of vertexes already written to the vertex buffer (see PrepareAliasMD2Models).
+    void AddDrawCmd(const BeginBatchArgs & args, uint32_t first_vert, uint32_t vertex_count);
+
+    struct DrawCmd;
+    void PushDrawCmd(const DrawCmd & cmd);
+    static bool CanMergeDrawCmds(const DrawCmd & prev, const DrawCmd & next);
+
     enum RenderPass : int
     {
         kPass_SolidGeometry = 0,
@@ -138,29 +315,50 @@ private:
     void SetLightLevel(const FrameData & frame_data) const;
 
     // World rendering:
-    void RecursiveWorldNode(FrameData & frame_data, const ModelInstance & world_mdl, const ModelNode * node);
+    struct WorldTraversalContext;
+    bool IsWorldNodeVisible(const FrameData & frame_data, const ModelNode * node, int & nodes_culled) const;
+    void MarkLeafSurfaces(const refdef_t & view_def, const ModelLeaf * leaf) const;
+    void AddWorldNodeSurfaces(const ModelInstance & world_mdl, const ModelNode * node, int sidebit, WorldTraversalContext * ctx);
+    void RecursiveWorldNode(FrameData & frame_data, const ModelInstance & world_mdl, const ModelNode * node, WorldTraversalContext * ctx);
+    void CollectWorldSubtrees(FrameData & frame_data, const ModelNode * node, int depth);
+    void ParallelWorldTraversal(FrameData & frame_data, const ModelInstance & world_mdl);
+    void SerialWorldTraversal(FrameData & frame_data, const ModelInstance & world_mdl);
+    void MergeWorldTraversalContexts(FrameData & frame_data, int num_contexts);
+    void ReserveWorldSurfaceLists(int num_surfaces);
+    void FreeWorldSurfaceLists();
     void MarkLeaves(ModelInstance & world_mdl);
+    void UpdateLightstyles(FrameData & frame_data);
     const TextureImage * GetSurfaceLightmap(const refdef_t & view_def, const ModelSurface & surf) const;
-    void DrawTextureChains(FrameData & frame_data);
+    void DrawWorldSurfaces(FrameData & frame_data);
+    void DrawWorldSurfaceRanges(FrameData & frame_data);
+    bool DrawWorldSurfacesMerged(FrameData & frame_data);
+    const IndexBuffer & BuildMergedWorldIndexes(const ModelInstance & world_mdl);
     void DrawAnimatedWaterPolys(const refdef_t & view_def, const ModelSurface & surf, float frame_time, const vec4_t color);
 
     // Entity rendering:
     void DrawBrushModel(FrameData & frame_data, const entity_t & entity);
     void DrawSpriteModel(const FrameData & frame_data, const entity_t & entity);
-    void DrawAliasMD2Model(FrameData & frame_data, const entity_t & entity);
+    struct AliasMD2DrawItem;
+    void DrawAliasMD2Model(FrameData & frame_data, const AliasMD2DrawItem & item);
     void DrawBeamModel(const FrameData & frame_data, const entity_t & entity);
     void DrawNullModel(const FrameData & frame_data, const entity_t & entity);
 
     // Lighting/shading:
     bool ShouldCullAliasMD2Model(const Frustum & frustum, const entity_t & entity, vec3_t bbox[8]) const;
-    void ShadeAliasMD2Model(const FrameData & frame_data, const entity_t & entity, vec4_t out_shade_light_color, vec3_t out_light_spot) const;
+    void ShadeAliasMD2Model(const FrameData & frame_data, AliasMD2DrawItem & item) const;
     void CalcPointLightColor(const FrameData & frame_data, const vec3_t point, vec4_t out_shade_light_color, vec3_t out_light_spot) const;
+    void SamplePointLight(const FrameData & frame_data, const vec3_t point, PointLightSample & out_sample) const;
+    void PointLightColor(const FrameData & frame_data, const PointLightSample & sample, const vec3_t point, vec4_t out_shade_light_color) const;
+
+    // Alias model preparation:
+    static bool IsAliasMD2Entity(const entity_t & entity);
+    void AddAliasMD2DrawItem(const entity_t & entity);
+    void PrepareAliasMD2Models(const FrameData & frame_data);
+    void PrepareAliasMD2Item(const FrameData & frame_data, AliasMD2DrawItem & item) const;
+    void BuildAliasMD2Instances();
 
     // Defined in DrawAliasMD2.cpp
-    void DrawAliasMD2FrameLerp(const entity_t & entity, const dmdl_t * const alias_header, const float backlerp,
-                               const vec3_t shade_light, const RenderMatrix & model_matrix, const TextureImage * const model_skin);
-    void DrawAliasMD2Shadow(const entity_t & entity, const dmdl_t * const alias_header,
-                            const RenderMatrix & model_matrix, const vec3_t light_spot);
+    static void BuildAliasMD2Verts(const AliasMD2DrawItem & item, float * const scratch_positions[3]);
 
 private:
 
@@ -177,9 +375,128 @@ private:
     int m_old_view_cluster{ -1 };
     int m_old_view_cluster2{ -1 };
 
+    // Decompressed PVS bitsets of recently visited clusters.
+    ClusterPVSCache m_pvs_cache;
+
+    // Light samples of alias model positions (r_light_cache).
+    PointLightCache m_light_cache;
+
+    // Leafs touched by the last MarkLeaves() update.
+    int m_leafs_marked{ 0 };
+
+    // Lightstyle values seen by the last UpdateLightstyles(), used to find the styles that
+    // changed this frame. Invalidated by BeginRegistration() so a new map refreshes every surface.
+    float m_lightstyle_white[MAX_LIGHTSTYLES] = {};
+    bool  m_lightstyles_valid{ false };
+    int   m_lightstyles_changed{ 0 };
+    int   m_lightstyle_surfaces_updated{ 0 };
+
     // Chain of world surfaces that draw with transparency (water/glass).
     const ModelSurface * m_alpha_world_surfaces{ nullptr };
 
+    //
+    // Multithreaded world traversal (r_world_parallel).
+    // The top kWorldSplitDepth levels of the BSP are walked on the main thread, splitting it into
+    // subtrees that are traversed by the JobSystem. Each thread collects the visible surfaces into
+    // its own WorldTraversalContext, which are merged into the world draw list afterwards.
+    //
+
+    static constexpr int kWorldSplitDepth    = 5;
+    static constexpr int kMaxWorldSubtrees   = (1 << kWorldSplitDepth);
+    static constexpr int kMaxWorldSplitItems = (kMaxWorldSubtrees * 2);
+
+    struct WorldTraversalContext
+    {
+        // Visible opaque surfaces, sized for all the surfaces in the world.
+        const ModelSurface ** opaque_surfaces;
+        int num_opaque_surfaces;
+
+        // Translucent surfaces of the subtree being traversed by this thread.
+        ModelSurface * alpha_head;
+        ModelSurface * alpha_tail;
+
+        // Sky surfaces, linked by texture_chain. Added to the SkyBox bounds when merging.
+        const ModelSurface * sky_surfaces;
+
+        int nodes_culled;
+
+        void Reset();
+    };
+
+    // Subtree (traversed by a job) or a node above the split level (surfaces added on the main thread).
+    // Kept in front to back order, which is needed to rebuild the translucent chain in the serial order.
+    struct WorldSplitItem
+    {
+        const ModelNode * node;
+        int               sidebit;    // For split nodes
+        bool              is_subtree;
+        ModelSurface *    alpha_head; // For subtrees
+        ModelSurface *    alpha_tail;
+    };
+
+    FixedSizeArray<WorldSplitItem, kMaxWorldSplitItems> m_world_split_items;
+    FixedSizeArray<int, kMaxWorldSubtrees>              m_world_subtree_jobs; // Index into m_world_split_items
+    WorldTraversalContext *                             m_world_contexts{ nullptr }; // One per JobSystem thread
+    int                                                 m_num_world_contexts{ 0 };
+
+    //
+    // Opaque world surfaces are drawn from a list of 64 bits sort keys, see MakeWorldDrawKey().
+    // Sorting groups the surfaces by state and orders the index buffer ranges so that
+    // contiguous ranges can be merged into a single draw.
+    //
+
+    struct WorldDrawItem
+    {
+        std::uint64_t        key;
+        const ModelSurface * surf;
+    };
+
+    WorldDrawItem * m_world_draw_items{ nullptr };      // Sorted list for the current frame
+    WorldDrawItem * m_world_draw_items_temp{ nullptr }; // Radix sort scratch buffer
+    int             m_num_world_draw_items{ 0 };
+    int             m_world_surfaces_capacity{ 0 };     // Size of the above and WorldTraversalContext::opaque_surfaces
+
+    //
+    // Parallel alias model preparation (r_entities_parallel).
+    // The MD2 entities of a pass are gathered into m_alias_draw_items, then culled, shaded and lerped
+    // by the JobSystem. Each visible item claims a range of the mapped vertex buffer with an atomic
+    // counter and writes its vertexes (and shadow) there, so the main thread only appends the DrawCmds.
+    //
+
+    struct AliasMD2DrawItem
+    {
+        RenderMatrix          model_matrix;
+        const entity_t *      entity;
+        const ModelInstance * model;
+        const TextureImage *  skin;
+        vec4_t                shade_light;
+        vec3_t                light_spot;
+        vec3_t                bbox[8];        // For r_draw_model_bounds
+        float                 backlerp;
+        PointLightSample      light_sample;
+        PointLightCache::Key  light_cache_key;
+        bool                  light_cache_hit;
+        bool                  light_cache_miss;   // light_sample goes into m_light_cache when the draw is added
+        DrawVertex3D *        verts;          // Model vertexes, followed by the shadow vertexes if draw_shadow
+        uint32_t              first_vert;
+        bool                  culled;
+        bool                  draw_shadow;
+
+        // Instancing (r_instanced_entities): the vertexes are in world space and the item draws with an identity matrix.
+        // Repeated model+skin items are merged into the draw of the first one, with indexes written to m_entity_index_buffers.
+        bool                  instanced;
+        bool                  merged;             // Drawn by its group leader
+        int                   num_instances;      // Leader only, including itself. Zero if not merged.
+        uint32_t              first_index;        // Leader only, model indexes followed by the shadow indexes
+        uint32_t              index_count;
+        uint32_t              shadow_index_count;
+    };
+
+    FixedSizeArray<AliasMD2DrawItem, MAX_ENTITIES> m_alias_draw_items;
+    const IndexBuffer * m_alias_instance_indexes{ nullptr };  // From BuildAliasMD2Instances()
+    float *             m_alias_scratch_positions{ nullptr }; // [JobSystem::NumThreads()][3][MAX_VERTS], SoA lerped frame of each thread
+    int                 m_num_alias_scratch_threads{ 0 };
+
     // SkyBox rendering helper
     SkyBox m_skybox;
 
@@ -199,12 +516,22 @@ private:
         const TextureImage *   lightmap_tex;
         uint32_t               first_vert;
         uint32_t               vertex_count;
+        const IndexBuffer *    index_buffer; // Optional, first_vert is the base vertex
+        uint32_t               first_index;
+        uint32_t               index_count;
         PrimitiveTopology      topology;
         bool                   depth_hack;
     };
 
     using DrawCmdList = FixedSizeArray<DrawCmd, 4096>;
     using VBuffers    = VertexBuffers<DrawVertex3D>;
+    using IBuffers    = IndexBuffers<std::uint32_t>;
+
+    // Max indexes for the r_world_merged_indexes path. Frames with more visible world indexes fall back to the per-range draws.
+    static constexpr uint32_t kWorldMergedIndexBufferSize = 512 * 1024;
+
+    // Max indexes of merged alias model instances per frame. Groups that don't fit are drawn one instance at a time.
+    static constexpr uint32_t kEntityIndexBufferSize = 128 * 1024;
 
     PipelineState        m_pipeline_solid_geometry;
     PipelineState        m_pipeline_translucent_world_geometry;
@@ -215,9 +542,13 @@ private:
     const TextureImage * m_tex_white2x2{ nullptr };
     bool                 m_batch_open{ false };
     VBuffers             m_vertex_buffers{};
+    IBuffers             m_world_index_buffers{};
+    IBuffers             m_entity_index_buffers{};
     RenderPass           m_current_pass{ kPass_Invalid };
     DrawCmd              m_current_draw_cmd{};
     DrawCmdList          m_draw_cmds[kRenderPassCount]{};
+    int                  m_draw_cmds_submitted{ 0 };
+    int                  m_draw_cmds_merged{ 0 };
 };
 
 } // MrQ2
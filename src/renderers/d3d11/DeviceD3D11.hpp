@@ -27,6 +27,7 @@ public:
 
     uint32_t MultisampleQualityLevel(const DXGI_FORMAT fmt) const;
     bool DebugValidationEnabled() const { return m_debug_validation; }
+    bool SupportsBlockCompression() const { return true; } // BC1-BC3 are required since D3D10
 
     ID3D11Device * Device() const { return m_device; }
     ID3D11DeviceContext * DeviceContext() const { return m_context; }
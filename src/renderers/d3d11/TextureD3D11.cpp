@@ -11,7 +11,7 @@ namespace MrQ2
 
 void TextureD3D11::Init(const DeviceD3D11 & device, const TextureType type, const bool is_scrap,
                         const ColorRGBA32 * mip_init_data[], const Vec2u16 mip_dimensions[],
-                        const uint32_t num_mip_levels, const char * const debug_name)
+                        const uint32_t num_mip_levels, const TextureFormat format, const char * const debug_name)
 {
     MRQ2_ASSERT(num_mip_levels >= 1 && num_mip_levels <= TextureImage::kMaxMipLevels);
     MRQ2_ASSERT((mip_dimensions[0].x + mip_dimensions[0].y) != 0);
@@ -27,12 +27,13 @@ void TextureD3D11::Init(const DeviceD3D11 & device, const TextureType type, cons
     if (max_anisotropy < 1)
         max_anisotropy = 1;
 
-    const uint32_t ms_quality_levels = device.MultisampleQualityLevel(DXGI_FORMAT_R8G8B8A8_UNORM);
+    const DXGI_FORMAT dxgi_format = FormatForTexture(format);
+    const uint32_t ms_quality_levels = (format == TextureFormat::kRGBA8) ? device.MultisampleQualityLevel(dxgi_format) : 1;
 
     D3D11_TEXTURE2D_DESC tex2d_desc  = {};
     tex2d_desc.Usage                 = (is_scrap ? D3D11_USAGE_DEFAULT : D3D11_USAGE_IMMUTABLE);
     tex2d_desc.BindFlags             = D3D11_BIND_SHADER_RESOURCE;
-    tex2d_desc.Format                = DXGI_FORMAT_R8G8B8A8_UNORM;
+    tex2d_desc.Format                = dxgi_format;
     tex2d_desc.Width                 = mip_dimensions[0].x;
     tex2d_desc.Height                = mip_dimensions[0].y;
     tex2d_desc.MipLevels             = num_mip_levels;
@@ -55,7 +56,7 @@ void TextureD3D11::Init(const DeviceD3D11 & device, const TextureType type, cons
     for (uint32_t mip = 0; mip < num_mip_levels; ++mip)
     {
         res_data[mip].pSysMem = mip_init_data[mip];
-        res_data[mip].SysMemPitch = mip_dimensions[mip].x * TextureImage::kBytesPerPixel;
+        res_data[mip].SysMemPitch = TextureRowPitch(format, mip_dimensions[mip].x);
     }
 
     auto * device11 = device.Device();
@@ -86,6 +87,23 @@ void TextureD3D11::Shutdown()
     m_srv      = nullptr;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Texture format selection:
+///////////////////////////////////////////////////////////////////////////////
+
+DXGI_FORMAT TextureD3D11::FormatForTexture(const TextureFormat format)
+{
+    static const DXGI_FORMAT dxgi_formats[] = {
+        DXGI_FORMAT_R8G8B8A8_UNORM, // kRGBA8
+        DXGI_FORMAT_BC1_UNORM,      // kBC1
+        DXGI_FORMAT_BC3_UNORM,      // kBC3
+    };
+    static_assert(ArrayLength(dxgi_formats) == unsigned(TextureFormat::kCount), "Update this if the enum changes!");
+
+    MRQ2_ASSERT(format < TextureFormat::kCount);
+    return dxgi_formats[unsigned(format)];
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Texture filtering selection:
 ///////////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,7 @@ namespace MrQ2
 
 class DeviceD3D11;
 enum class TextureType : std::uint8_t;
+enum class TextureFormat : std::uint8_t;
 
 class TextureD3D11 final
 {
@@ -26,7 +27,7 @@ public:
 
     void Init(const DeviceD3D11 & device, const TextureType type, const bool is_scrap,
               const ColorRGBA32 * mip_init_data[], const Vec2u16 mip_dimensions[],
-              const uint32_t num_mip_levels, const char * const debug_name);
+              const uint32_t num_mip_levels, const TextureFormat format, const char * const debug_name);
 
     // Init from existing texture sharing the resource and sampler/SRV (for the scrap texture)
     void Init(const TextureD3D11 & other);
@@ -41,6 +42,7 @@ private:
     D11ComPtr<ID3D11ShaderResourceView> m_srv;
 
     static D3D11_FILTER FilterForTextureType(const TextureType type);
+    static DXGI_FORMAT FormatForTexture(const TextureFormat format);
 };
 
 } // MrQ2
@@ -31,6 +31,27 @@ void UploadContextD3D11::UploadTexture(const TextureUploadD3D11 & upload_info)
 
     auto * texture_resource = upload_info.texture->m_resource.Get();
 
+    if (upload_info.HasRegion())
+    {
+        MRQ2_ASSERT(upload_info.is_scrap && upload_info.mipmaps.num_mip_levels == 1);
+
+        const uint32_t row_pitch = upload_info.mipmaps.mip_dimensions[0].x * TextureImage::kBytesPerPixel;
+        const auto * data = reinterpret_cast<const std::uint8_t *>(upload_info.mipmaps.mip_init_data[0]) +
+                            (upload_info.region.y * row_pitch) + (upload_info.region.x * TextureImage::kBytesPerPixel);
+
+        D3D11_BOX box;
+        box.left   = upload_info.region.x;
+        box.top    = upload_info.region.y;
+        box.front  = 0;
+        box.right  = upload_info.region.x + upload_info.region.width;
+        box.bottom = upload_info.region.y + upload_info.region.height;
+        box.back   = 1;
+
+        m_device->DeviceContext()->UpdateSubresource(texture_resource, 0, &box, data, row_pitch, 0);
+        return;
+    }
+
+    // Only dynamic textures are updated through here, which are never compressed.
     for (uint32_t mip = 0; mip < upload_info.mipmaps.num_mip_levels; ++mip)
     {
         const uint32_t row_pitch = upload_info.mipmaps.mip_dimensions[mip].x * TextureImage::kBytesPerPixel;
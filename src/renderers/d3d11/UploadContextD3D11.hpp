@@ -21,6 +21,15 @@ struct TextureUploadD3D11 final
         const ColorRGBA32 ** mip_init_data;
         const Vec2u16 *      mip_dimensions;
     } mipmaps;
+
+    // Optional sub-rectangle of mip level 0 to update in an existing texture (is_scrap uploads with a single mip).
+    // mip_init_data[0] still points to the whole level 0 image. Whole texture is updated if width or height is zero.
+    struct {
+        uint32_t x, y;
+        uint32_t width, height;
+    } region;
+
+    bool HasRegion() const { return region.width != 0 && region.height != 0; }
 };
 
 class UploadContextD3D11 final
@@ -32,6 +32,7 @@ public:
     void Shutdown();
 
     bool DebugValidationEnabled() const { return m_debug_validation; }
+    bool SupportsBlockCompression() const { return true; } // BC1-BC3 are required since D3D10
     ID3D12Device5 * Device() const { return m_device.Get(); }
 
     // Public to renderers/common
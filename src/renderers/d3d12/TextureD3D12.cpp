@@ -12,7 +12,7 @@ namespace MrQ2
 
 void TextureD3D12::Init(const DeviceD3D12 & device, const TextureType type, const bool is_scrap,
                         const ColorRGBA32 * mip_init_data[], const Vec2u16 mip_dimensions[],
-                        const uint32_t num_mip_levels, const char * const debug_name)
+                        const uint32_t num_mip_levels, const TextureFormat format, const char * const debug_name)
 {
     MRQ2_ASSERT(num_mip_levels >= 1 && num_mip_levels <= TextureImage::kMaxMipLevels);
     MRQ2_ASSERT((mip_dimensions[0].x + mip_dimensions[0].y) != 0);
@@ -37,7 +37,7 @@ void TextureD3D12::Init(const DeviceD3D12 & device, const TextureType type, cons
     res_desc.Height                  = mip_dimensions[0].y;
     res_desc.DepthOrArraySize        = 1;
     res_desc.MipLevels               = static_cast<uint16_t>(num_mip_levels);
-    res_desc.Format                  = DXGI_FORMAT_R8G8B8A8_UNORM;
+    res_desc.Format                  = FormatForTexture(format);
     res_desc.SampleDesc.Count        = 1;
     res_desc.SampleDesc.Quality      = 0;
     res_desc.Layout                  = D3D12_TEXTURE_LAYOUT_UNKNOWN;
@@ -62,11 +62,12 @@ void TextureD3D12::Init(const DeviceD3D12 & device, const TextureType type, cons
     upload_info.mipmaps.num_mip_levels = num_mip_levels;
     upload_info.mipmaps.mip_init_data  = mip_init_data;
     upload_info.mipmaps.mip_dimensions = mip_dimensions;
+    upload_info.mipmaps.format         = format;
     device.UploadContext().CreateTexture(upload_info);
 
     // Create texture view:
     D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
-    srv_desc.Format                          = DXGI_FORMAT_R8G8B8A8_UNORM;
+    srv_desc.Format                          = res_desc.Format;
     srv_desc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
     srv_desc.Texture2D.MipLevels             = num_mip_levels;
     srv_desc.Texture2D.MostDetailedMip       = 0;
@@ -132,6 +133,23 @@ void TextureD3D12::Shutdown()
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Texture format selection:
+///////////////////////////////////////////////////////////////////////////////
+
+DXGI_FORMAT TextureD3D12::FormatForTexture(const TextureFormat format)
+{
+    static const DXGI_FORMAT dxgi_formats[] = {
+        DXGI_FORMAT_R8G8B8A8_UNORM, // kRGBA8
+        DXGI_FORMAT_BC1_UNORM,      // kBC1
+        DXGI_FORMAT_BC3_UNORM,      // kBC3
+    };
+    static_assert(ArrayLength(dxgi_formats) == unsigned(TextureFormat::kCount), "Update this if the enum changes!");
+
+    MRQ2_ASSERT(format < TextureFormat::kCount);
+    return dxgi_formats[unsigned(format)];
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Texture filtering selection:
 ///////////////////////////////////////////////////////////////////////////////
@@ -246,7 +246,7 @@ static ID3D12Resource * CreateUploadBuffer(const TextureUploadD3D12 & upload_inf
     for (uint32_t mip = 0; mip < num_mip_levels; ++mip)
     {
         sub_res_data[mip].pData    = upload_info.mipmaps.mip_init_data[mip];
-        sub_res_data[mip].RowPitch = upload_info.mipmaps.mip_dimensions[mip].x * TextureImage::kBytesPerPixel;
+        sub_res_data[mip].RowPitch = TextureRowPitch(upload_info.mipmaps.format, upload_info.mipmaps.mip_dimensions[mip].x);
     }
 
     // Texture is a temp scrap already created and in PIXEL_SHADER_RESOURCE state.
@@ -280,6 +280,85 @@ static ID3D12Resource * CreateUploadBuffer(const TextureUploadD3D12 & upload_inf
     return upload_buffer;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// CreateRegionUploadBuffer()
+//  Same as above but only copies a sub-rectangle of mip level 0 of a scrap
+//  texture (upload_info.region), which is already in PIXEL_SHADER_RESOURCE state.
+///////////////////////////////////////////////////////////////////////////////
+
+static ID3D12Resource * CreateRegionUploadBuffer(const TextureUploadD3D12 & upload_info, ID3D12Resource * tex_resource, ID3D12Device * device, ID3D12GraphicsCommandList * command_list)
+{
+    MRQ2_ASSERT(upload_info.is_scrap && upload_info.mipmaps.num_mip_levels == 1);
+    MRQ2_ASSERT(upload_info.mipmaps.mip_init_data[0] != nullptr);
+
+    const auto & region = upload_info.region;
+    const uint32_t src_row_pitch = upload_info.mipmaps.mip_dimensions[0].x * TextureImage::kBytesPerPixel;
+    const uint32_t row_size      = region.width * TextureImage::kBytesPerPixel;
+    const uint32_t dst_row_pitch = (row_size + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+
+    D3D12_RESOURCE_DESC res_desc     = {};
+    res_desc.Dimension               = D3D12_RESOURCE_DIMENSION_BUFFER;
+    res_desc.Alignment               = 0;
+    res_desc.Width                   = uint64_t(dst_row_pitch) * region.height;
+    res_desc.Height                  = 1;
+    res_desc.DepthOrArraySize        = 1;
+    res_desc.MipLevels               = 1;
+    res_desc.Format                  = DXGI_FORMAT_UNKNOWN;
+    res_desc.SampleDesc.Count        = 1;
+    res_desc.SampleDesc.Quality      = 0;
+    res_desc.Layout                  = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    res_desc.Flags                   = D3D12_RESOURCE_FLAG_NONE;
+
+    D3D12_HEAP_PROPERTIES heap_props = {};
+    heap_props.Type                  = D3D12_HEAP_TYPE_UPLOAD;
+    heap_props.CPUPageProperty       = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heap_props.MemoryPoolPreference  = D3D12_MEMORY_POOL_UNKNOWN;
+
+    ID3D12Resource * upload_buffer = nullptr;
+    D12CHECK(device->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &res_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&upload_buffer)));
+    D12SetDebugName(upload_buffer, L"TextureRegionUploadBuffer");
+
+    // Copy the rows of the region into the upload buffer:
+    uint8_t * dest_pixels = nullptr;
+    D12CHECK(upload_buffer->Map(0, nullptr, reinterpret_cast<void **>(&dest_pixels)));
+
+    const auto * src_pixels = reinterpret_cast<const uint8_t *>(upload_info.mipmaps.mip_init_data[0]) +
+                              (region.y * src_row_pitch) + (region.x * TextureImage::kBytesPerPixel);
+    for (uint32_t y = 0; y < region.height; ++y)
+    {
+        std::memcpy(dest_pixels + y * dst_row_pitch, src_pixels + y * src_row_pitch, row_size);
+    }
+    upload_buffer->Unmap(0, nullptr);
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource   = tex_resource;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_COPY_DEST;
+    command_list->ResourceBarrier(1, &barrier);
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    footprint.Offset             = 0;
+    footprint.Footprint.Format   = tex_resource->GetDesc().Format;
+    footprint.Footprint.Width    = region.width;
+    footprint.Footprint.Height   = region.height;
+    footprint.Footprint.Depth    = 1;
+    footprint.Footprint.RowPitch = dst_row_pitch;
+
+    const TextureCopyLocationD3D12 dst{ tex_resource, 0 };
+    const TextureCopyLocationD3D12 src{ upload_buffer, footprint };
+    command_list->CopyTextureRegion(&dst, region.x, region.y, 0, &src, nullptr);
+
+    // Transition back to PIXEL_SHADER_RESOURCE.
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    command_list->ResourceBarrier(1, &barrier);
+
+    return upload_buffer;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void UploadContextD3D12::UploadTexture(const TextureUploadD3D12 & upload_info)
@@ -313,7 +392,14 @@ void UploadContextD3D12::UploadTexture(const TextureUploadD3D12 & upload_info)
     auto * swap_chain = m_device->m_swap_chain;
     auto * gfx_command_list = swap_chain->CmdList();
 
-    free_entry->upload_buffer = CreateUploadBuffer(upload_info, upload_info.texture->m_resource.Get(), m_device->m_device.Get(), gfx_command_list);
+    if (upload_info.HasRegion())
+    {
+        free_entry->upload_buffer = CreateRegionUploadBuffer(upload_info, upload_info.texture->m_resource.Get(), m_device->m_device.Get(), gfx_command_list);
+    }
+    else
+    {
+        free_entry->upload_buffer = CreateUploadBuffer(upload_info, upload_info.texture->m_resource.Get(), m_device->m_device.Get(), gfx_command_list);
+    }
 
     free_entry->cmd_list_executed_fence = swap_chain->CurrentCmdListExecutedFence();
     free_entry->cmd_list_executed_value = swap_chain->CurrentCmdListExecutedFenceValue();
@@ -10,6 +10,7 @@ namespace MrQ2
 
 class DeviceD3D12;
 class TextureD3D12;
+enum class TextureFormat : std::uint8_t;
 
 struct TextureUploadD3D12 final
 {
@@ -20,7 +21,17 @@ struct TextureUploadD3D12 final
         uint32_t             num_mip_levels;
         const ColorRGBA32 ** mip_init_data;
         const Vec2u16 *      mip_dimensions;
+        TextureFormat        format;         // kRGBA8 (zero) unless creating a compressed texture.
     } mipmaps;
+
+    // Optional sub-rectangle of mip level 0 to update in an existing texture (is_scrap uploads with a single mip).
+    // mip_init_data[0] still points to the whole level 0 image. Whole texture is updated if width or height is zero.
+    struct {
+        uint32_t x, y;
+        uint32_t width, height;
+    } region;
+
+    bool HasRegion() const { return region.width != 0 && region.height != 0; }
 };
 
 class UploadContextD3D12 final
@@ -0,0 +1,114 @@
+//
+// BufferNull.cpp
+//
+
+#include "BufferNull.hpp"
+#include "DeviceNull.hpp"
+#include "../common/Memory.hpp"
+
+namespace MrQ2
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// BufferNull
+///////////////////////////////////////////////////////////////////////////////
+
+BufferNull::~BufferNull()
+{
+    Shutdown();
+}
+
+void BufferNull::InitBufferInternal(const DeviceNull & device, const uint32_t buffer_size_in_bytes)
+{
+    MRQ2_ASSERT(m_device == nullptr); // Shutdown first
+    MRQ2_ASSERT(buffer_size_in_bytes != 0);
+
+    m_memory      = static_cast<uint8_t *>(MemAllocTracked(buffer_size_in_bytes, MemTag::kRenderer));
+    m_memory_size = buffer_size_in_bytes;
+    m_device      = &device;
+}
+
+void BufferNull::Shutdown()
+{
+    MRQ2_ASSERT(!m_is_mapped);
+
+    if (m_memory != nullptr)
+    {
+        MemFreeTracked(m_memory, m_memory_size, MemTag::kRenderer);
+    }
+
+    m_device      = nullptr;
+    m_memory      = nullptr;
+    m_memory_size = 0;
+}
+
+void * BufferNull::Map()
+{
+    MRQ2_ASSERT(m_device != nullptr);
+    MRQ2_ASSERT(!m_is_mapped);
+
+    m_is_mapped = true;
+    m_device->CurrentFrameStats().buffer_maps++;
+
+    return m_memory;
+}
+
+void BufferNull::Unmap()
+{
+    MRQ2_ASSERT(m_device != nullptr);
+    MRQ2_ASSERT(m_is_mapped);
+    m_is_mapped = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VertexBufferNull
+///////////////////////////////////////////////////////////////////////////////
+
+bool VertexBufferNull::Init(const DeviceNull & device, const uint32_t buffer_size_in_bytes, const uint32_t vertex_stride_in_bytes)
+{
+    MRQ2_ASSERT(buffer_size_in_bytes   != 0);
+    MRQ2_ASSERT(vertex_stride_in_bytes != 0);
+
+    InitBufferInternal(device, buffer_size_in_bytes);
+
+    m_size_in_bytes   = buffer_size_in_bytes;
+    m_stride_in_bytes = vertex_stride_in_bytes;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// IndexBufferNull
+///////////////////////////////////////////////////////////////////////////////
+
+bool IndexBufferNull::Init(const DeviceNull & device, const uint32_t buffer_size_in_bytes, const IndexFormat format)
+{
+    MRQ2_ASSERT(buffer_size_in_bytes != 0);
+
+    InitBufferInternal(device, buffer_size_in_bytes);
+
+    m_size_in_bytes = buffer_size_in_bytes;
+    m_index_format  = format;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ConstantBufferNull
+///////////////////////////////////////////////////////////////////////////////
+
+bool ConstantBufferNull::Init(const DeviceNull & device, const uint32_t buffer_size_in_bytes, const Flags flags)
+{
+    MRQ2_ASSERT(buffer_size_in_bytes != 0);
+
+    InitBufferInternal(device, buffer_size_in_bytes);
+
+    m_size_in_bytes = buffer_size_in_bytes;
+    m_flags         = flags;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // MrQ2
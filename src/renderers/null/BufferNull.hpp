@@ -0,0 +1,157 @@
+//
+// BufferNull.hpp
+//
+#pragma once
+
+#include "UtilsNull.hpp"
+
+namespace MrQ2
+{
+
+class DeviceNull;
+class GraphicsContextNull;
+
+///////////////////////////////////////////////////////////////////////////////
+
+class BufferNull
+{
+public:
+
+    BufferNull() = default;
+
+    // Disallow copy.
+    BufferNull(const BufferNull &) = delete;
+    BufferNull & operator=(const BufferNull &) = delete;
+
+    void Shutdown();
+    void * Map();
+    void Unmap();
+
+protected:
+
+    ~BufferNull();
+    void InitBufferInternal(const DeviceNull & device, const uint32_t buffer_size_in_bytes);
+
+    const DeviceNull * m_device{ nullptr };
+    uint8_t *          m_memory{ nullptr };
+    uint32_t           m_memory_size{ 0 };
+    bool               m_is_mapped{ false };
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class VertexBufferNull final : public BufferNull
+{
+    friend GraphicsContextNull;
+
+public:
+
+    bool Init(const DeviceNull & device, const uint32_t buffer_size_in_bytes, const uint32_t vertex_stride_in_bytes);
+
+    uint32_t SizeInBytes()   const { return m_size_in_bytes; }
+    uint32_t StrideInBytes() const { return m_stride_in_bytes; }
+
+private:
+
+    uint32_t m_size_in_bytes{ 0 };
+    uint32_t m_stride_in_bytes{ 0 };
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class IndexBufferNull final : public BufferNull
+{
+    friend GraphicsContextNull;
+
+public:
+
+    enum IndexFormat : uint32_t
+    {
+        kFormatUInt16,
+        kFormatUInt32,
+    };
+
+    bool Init(const DeviceNull & device, const uint32_t buffer_size_in_bytes, const IndexFormat format);
+
+    uint32_t    SizeInBytes()   const { return m_size_in_bytes; }
+    uint32_t    StrideInBytes() const { return (m_index_format == kFormatUInt16) ? sizeof(uint16_t) : sizeof(uint32_t); }
+    IndexFormat Format()        const { return m_index_format; }
+
+private:
+
+    uint32_t    m_size_in_bytes{ 0 };
+    IndexFormat m_index_format{};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ConstantBufferNull final : public BufferNull
+{
+    friend GraphicsContextNull;
+
+public:
+
+    // Buffer is updated, used for a single draw call then discarded (PerDrawShaderConstants).
+    enum Flags : uint32_t { kNoFlags = 0, kOptimizeForSingleDraw = (1 << 1) };
+
+    bool Init(const DeviceNull & device, const uint32_t buffer_size_in_bytes, const Flags flags = kNoFlags);
+
+    template<typename T>
+    void WriteStruct(const T & cbuffer_data)
+    {
+        MRQ2_ASSERT(sizeof(T) <= SizeInBytes());
+        void * cbuffer_upload_mem = Map();
+        std::memcpy(cbuffer_upload_mem, &cbuffer_data, sizeof(T));
+        Unmap();
+    }
+
+    uint32_t SizeInBytes() const { return m_size_in_bytes; }
+
+private:
+
+    uint32_t m_size_in_bytes{ 0 };
+    Flags    m_flags{ kNoFlags };
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ScratchConstantBuffersNull final
+{
+public:
+
+    void Init(const DeviceNull & device, const uint32_t buffer_size_in_bytes)
+    {
+        for (auto & cbuf : m_cbuffers)
+        {
+            const bool buffer_ok = cbuf.Init(device, buffer_size_in_bytes);
+            MRQ2_ASSERT(buffer_ok);
+        }
+    }
+
+    void Shutdown()
+    {
+        m_current_buffer = 0;
+        for (auto & cbuf : m_cbuffers)
+        {
+            cbuf.Shutdown();
+        }
+    }
+
+    ConstantBufferNull & CurrentBuffer()
+    {
+        MRQ2_ASSERT(m_current_buffer < ArrayLength(m_cbuffers));
+        return m_cbuffers[m_current_buffer];
+    }
+
+    void MoveToNextFrame()
+    {
+        m_current_buffer = (m_current_buffer + 1) % kNullNumFrameBuffers;
+    }
+
+private:
+
+    uint32_t m_current_buffer{ 0 };
+    ConstantBufferNull m_cbuffers[kNullNumFrameBuffers];
+};
+
+} // MrQ2
@@ -0,0 +1,24 @@
+//
+// DeviceNull.cpp
+//
+
+#include "DeviceNull.hpp"
+
+namespace MrQ2
+{
+
+void DeviceNull::Init(UploadContextNull & up_ctx, GraphicsContextNull & gfx_ctx, const bool debug)
+{
+    m_upload_ctx       = &up_ctx;
+    m_graphics_ctx     = &gfx_ctx;
+    m_debug_validation = debug;
+    m_frame_stats.Clear();
+}
+
+void DeviceNull::Shutdown()
+{
+    m_upload_ctx   = nullptr;
+    m_graphics_ctx = nullptr;
+}
+
+} // MrQ2
@@ -0,0 +1,46 @@
+//
+// DeviceNull.hpp
+//
+#pragma once
+
+#include "UtilsNull.hpp"
+
+namespace MrQ2
+{
+
+class UploadContextNull;
+class GraphicsContextNull;
+
+class DeviceNull final
+{
+public:
+
+    DeviceNull() = default;
+
+    // Disallow copy.
+    DeviceNull(const DeviceNull &) = delete;
+    DeviceNull & operator=(const DeviceNull &) = delete;
+
+    void Init(UploadContextNull & up_ctx, GraphicsContextNull & gfx_ctx, const bool debug);
+    void Shutdown();
+
+    bool DebugValidationEnabled() const { return m_debug_validation; }
+    bool SupportsBlockCompression() const { return true; } // Blocks are just stored
+
+    // Stats for the frame currently being recorded. Mutable since the contexts
+    // and buffers only hold a const reference to the device.
+    FrameStatsNull & CurrentFrameStats() const { return m_frame_stats; }
+
+    // Public to renderers/common
+    UploadContextNull   & UploadContext()   const { return *m_upload_ctx;   }
+    GraphicsContextNull & GraphicsContext() const { return *m_graphics_ctx; }
+
+private:
+
+    UploadContextNull *    m_upload_ctx{ nullptr };
+    GraphicsContextNull *  m_graphics_ctx{ nullptr };
+    mutable FrameStatsNull m_frame_stats{};
+    bool                   m_debug_validation{ false };
+};
+
+} // MrQ2
@@ -0,0 +1,235 @@
+//
+// GraphicsContextNull.cpp
+//
+
+#include "GraphicsContextNull.hpp"
+#include "DeviceNull.hpp"
+#include "BufferNull.hpp"
+#include "TextureNull.hpp"
+#include "PipelineStateNull.hpp"
+#include "ShaderProgramNull.hpp"
+
+namespace MrQ2
+{
+
+void GraphicsContextNull::Init(const DeviceNull & device)
+{
+    MRQ2_ASSERT(m_device == nullptr);
+    m_device = &device;
+
+    m_current_viewport.min_depth = 0.0f;
+    m_current_viewport.max_depth = 1.0f;
+}
+
+void GraphicsContextNull::Shutdown()
+{
+    m_device = nullptr;
+}
+
+void GraphicsContextNull::BeginFrame(const float clear_color[4], const float clear_depth, const uint8_t clear_stencil)
+{
+    MRQ2_ASSERT(m_device != nullptr);
+    (void)clear_color;
+    (void)clear_depth;
+    (void)clear_stencil;
+}
+
+void GraphicsContextNull::EndFrame()
+{
+    MRQ2_ASSERT(m_marker_depth == 0); // Unbalanced Push/PopMarker
+
+    m_current_pipeline_state = nullptr;
+    m_current_vb             = nullptr;
+    m_current_ib             = nullptr;
+    m_current_viewport       = {};
+    m_current_topology       = PrimitiveTopologyNull::kCount;
+    m_depth_range_changed    = false;
+
+    for (auto & cb : m_current_cb)
+        cb = nullptr;
+
+    for (auto & tex : m_current_texture)
+        tex = nullptr;
+
+    m_current_viewport.min_depth = 0.0f;
+    m_current_viewport.max_depth = 1.0f;
+}
+
+void GraphicsContextNull::SetViewport(const int x, const int y, const int width, const int height)
+{
+    m_current_viewport.x      = x;
+    m_current_viewport.y      = y;
+    m_current_viewport.width  = width;
+    m_current_viewport.height = height;
+}
+
+void GraphicsContextNull::SetScissorRect(const int x, const int y, const int width, const int height)
+{
+    (void)x; (void)y; (void)width; (void)height;
+}
+
+void GraphicsContextNull::SetDepthRange(const float near_val, const float far_val)
+{
+    m_current_viewport.min_depth = near_val;
+    m_current_viewport.max_depth = far_val;
+    m_depth_range_changed = true;
+}
+
+void GraphicsContextNull::RestoreDepthRange()
+{
+    if (m_depth_range_changed)
+    {
+        m_current_viewport.min_depth = 0.0f;
+        m_current_viewport.max_depth = 1.0f;
+        m_depth_range_changed = false;
+    }
+}
+
+void GraphicsContextNull::SetVertexBuffer(const VertexBufferNull & vb)
+{
+    if (m_current_vb != &vb)
+    {
+        m_current_vb = &vb;
+        m_device->CurrentFrameStats().vertex_buffer_changes++;
+    }
+}
+
+void GraphicsContextNull::SetIndexBuffer(const IndexBufferNull & ib)
+{
+    if (m_current_ib != &ib)
+    {
+        m_current_ib = &ib;
+        m_device->CurrentFrameStats().index_buffer_changes++;
+    }
+}
+
+void GraphicsContextNull::SetConstantBuffer(const ConstantBufferNull & cb, const uint32_t slot)
+{
+    MRQ2_ASSERT(slot < kCBufferCount);
+
+    if (m_current_cb[slot] != &cb)
+    {
+        m_current_cb[slot] = &cb;
+        m_device->CurrentFrameStats().constant_buffer_changes++;
+    }
+}
+
+void GraphicsContextNull::SetTexture(const TextureNull & texture, const uint32_t slot)
+{
+    MRQ2_ASSERT(slot < kTextureCount);
+
+    // Compare the memory block rather than the object so textures sharing the scrap count as the same binding.
+    if (m_current_texture[slot] == nullptr || m_current_texture[slot]->m_memory != texture.m_memory)
+    {
+        m_current_texture[slot] = &texture;
+        m_device->CurrentFrameStats().texture_changes++;
+    }
+}
+
+void GraphicsContextNull::SetPipelineState(const PipelineStateNull & pipeline_state)
+{
+    if (m_current_pipeline_state != &pipeline_state)
+    {
+        if (!pipeline_state.IsFinalized())
+        {
+            pipeline_state.Finalize();
+        }
+
+        m_current_pipeline_state = &pipeline_state;
+        m_device->CurrentFrameStats().pipeline_changes++;
+
+        SetPrimitiveTopology(m_current_pipeline_state->m_topology);
+
+        auto * shader = m_current_pipeline_state->m_shader_prog;
+        MRQ2_ASSERT(shader != nullptr && shader->IsLoaded());
+        (void)shader;
+    }
+}
+
+void GraphicsContextNull::SetPrimitiveTopology(const PrimitiveTopologyNull topology)
+{
+    MRQ2_ASSERT(topology < PrimitiveTopologyNull::kCount);
+
+    if (m_current_topology != topology)
+    {
+        m_current_topology = topology;
+        m_device->CurrentFrameStats().topology_changes++;
+    }
+}
+
+uint32_t GraphicsContextNull::PrimitiveCount(const PrimitiveTopologyNull topology, const uint32_t vertex_count)
+{
+    switch (topology)
+    {
+    case PrimitiveTopologyNull::kTriangleList  : return vertex_count / 3;
+    case PrimitiveTopologyNull::kTriangleStrip : return (vertex_count >= 3) ? (vertex_count - 2) : 0;
+    case PrimitiveTopologyNull::kTriangleFan   : return vertex_count / 3; // Converted by the front-end
+    case PrimitiveTopologyNull::kLineList      : return vertex_count / 2;
+    default : GameInterface::Errorf("Bad PrimitiveTopology enum!");
+    } // switch
+}
+
+void GraphicsContextNull::ValidateDrawState() const
+{
+    MRQ2_ASSERT(m_current_pipeline_state != nullptr);
+    MRQ2_ASSERT(m_current_pipeline_state->IsFinalized());
+    MRQ2_ASSERT(m_current_topology != PrimitiveTopologyNull::kCount);
+    MRQ2_ASSERT(m_current_vb != nullptr && !m_current_vb->m_is_mapped);
+}
+
+void GraphicsContextNull::Draw(const uint32_t first_vertex, const uint32_t vertex_count)
+{
+    ValidateDrawState();
+    MRQ2_ASSERT((first_vertex + vertex_count) * m_current_vb->StrideInBytes() <= m_current_vb->SizeInBytes());
+
+    FrameStatsNull & stats = m_device->CurrentFrameStats();
+    stats.draw_calls++;
+    stats.vertices_drawn   += vertex_count;
+    stats.primitives_drawn += PrimitiveCount(m_current_topology, vertex_count);
+}
+
+void GraphicsContextNull::DrawIndexed(const uint32_t first_index, const uint32_t index_count, const uint32_t base_vertex)
+{
+    ValidateDrawState();
+    MRQ2_ASSERT(m_current_ib != nullptr && !m_current_ib->m_is_mapped);
+    MRQ2_ASSERT((first_index + index_count) * m_current_ib->StrideInBytes() <= m_current_ib->SizeInBytes());
+    MRQ2_ASSERT(base_vertex * m_current_vb->StrideInBytes() < m_current_vb->SizeInBytes());
+    (void)first_index;
+    (void)base_vertex;
+
+    FrameStatsNull & stats = m_device->CurrentFrameStats();
+    stats.draw_indexed_calls++;
+    stats.indices_drawn    += index_count;
+    stats.primitives_drawn += PrimitiveCount(m_current_topology, index_count);
+}
+
+void GraphicsContextNull::SetAndUpdateConstantBuffer_Internal(const ConstantBufferNull & cb, const uint32_t slot, const void * data, const uint32_t data_size)
+{
+    MRQ2_ASSERT(slot < kCBufferCount);
+    MRQ2_ASSERT(data != nullptr && data_size != 0);
+    MRQ2_ASSERT(data_size >= cb.SizeInBytes());
+
+    // Same as an UpdateSubresource: the whole buffer is replaced.
+    std::memcpy(cb.m_memory, data, cb.SizeInBytes());
+    (void)data_size;
+
+    FrameStatsNull & stats = m_device->CurrentFrameStats();
+    stats.constant_buffer_updates++;
+    stats.constant_buffer_bytes += cb.SizeInBytes();
+
+    SetConstantBuffer(cb, slot);
+}
+
+void GraphicsContextNull::PushMarker(const wchar_t * name)
+{
+    (void)name;
+    ++m_marker_depth;
+}
+
+void GraphicsContextNull::PopMarker()
+{
+    MRQ2_ASSERT(m_marker_depth > 0);
+    --m_marker_depth;
+}
+
+} // MrQ2
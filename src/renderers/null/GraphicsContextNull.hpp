@@ -0,0 +1,122 @@
+//
+// GraphicsContextNull.hpp
+//
+#pragma once
+
+#include "UtilsNull.hpp"
+
+namespace MrQ2
+{
+
+class DeviceNull;
+class TextureNull;
+class VertexBufferNull;
+class IndexBufferNull;
+class ConstantBufferNull;
+class PipelineStateNull;
+
+//
+// Records render state changes and draw calls into the Device's FrameStatsNull.
+// No rasterization is performed; draws are only validated against the bound state.
+//
+class GraphicsContextNull final
+{
+public:
+
+    GraphicsContextNull() = default;
+
+    // Disallow copy.
+    GraphicsContextNull(const GraphicsContextNull &) = delete;
+    GraphicsContextNull & operator=(const GraphicsContextNull &) = delete;
+
+    void Init(const DeviceNull & device);
+    void Shutdown();
+
+    // Frame start/end
+    void BeginFrame(const float clear_color[4], const float clear_depth, const uint8_t clear_stencil);
+    void EndFrame();
+
+    // Render states
+    void SetViewport(const int x, const int y, const int width, const int height);
+    void SetScissorRect(const int x, const int y, const int width, const int height);
+    void SetDepthRange(const float near_val, const float far_val);
+    void RestoreDepthRange();
+    void SetVertexBuffer(const VertexBufferNull & vb);
+    void SetIndexBuffer(const IndexBufferNull & ib);
+    void SetConstantBuffer(const ConstantBufferNull & cb, const uint32_t slot);
+    void SetTexture(const TextureNull & texture, const uint32_t slot);
+    void SetPipelineState(const PipelineStateNull & pipeline_state);
+    void SetPrimitiveTopology(const PrimitiveTopologyNull topology);
+
+    template<typename T>
+    void SetAndUpdateConstantBufferForDraw(const ConstantBufferNull & cb, const uint32_t slot, const T & data)
+    {
+        SetAndUpdateConstantBuffer_Internal(cb, slot, &data, sizeof(T));
+    }
+
+    // Draw calls
+    void Draw(const uint32_t first_vertex, const uint32_t vertex_count);
+    void DrawIndexed(const uint32_t first_index, const uint32_t index_count, const uint32_t base_vertex);
+
+    // Debug markers
+    void PushMarker(const wchar_t * name);
+    void PopMarker();
+
+private:
+
+    enum ShaderBindings : uint32_t
+    {
+        kCBufferCount = 3, // PerFrame, PerView and PerDraw constants
+        kTextureCount = 2, // BaseTexture and Lightmap
+    };
+
+    struct Viewport
+    {
+        int   x, y, width, height;
+        float min_depth, max_depth;
+    };
+
+    const DeviceNull *         m_device{ nullptr };
+
+    // Cached states:
+    const PipelineStateNull *  m_current_pipeline_state{ nullptr };
+    const VertexBufferNull *   m_current_vb{ nullptr };
+    const IndexBufferNull *    m_current_ib{ nullptr };
+    const ConstantBufferNull * m_current_cb[kCBufferCount] = {};
+    const TextureNull *        m_current_texture[kTextureCount] = {};
+    Viewport                   m_current_viewport{};
+    PrimitiveTopologyNull      m_current_topology{ PrimitiveTopologyNull::kCount };
+    bool                       m_depth_range_changed{ false };
+    int                        m_marker_depth{ 0 };
+
+    void SetAndUpdateConstantBuffer_Internal(const ConstantBufferNull & cb, const uint32_t slot, const void * data, const uint32_t data_size);
+    void ValidateDrawState() const;
+    static uint32_t PrimitiveCount(const PrimitiveTopologyNull topology, const uint32_t vertex_count);
+};
+
+//
+// Debug markers:
+//
+struct ScopedGpuMarkerNull final
+{
+    GraphicsContextNull & m_context;
+
+    ScopedGpuMarkerNull(GraphicsContextNull & ctx, const wchar_t * name)
+        : m_context{ ctx }
+    {
+        m_context.PushMarker(name);
+    }
+
+    ~ScopedGpuMarkerNull()
+    {
+        m_context.PopMarker();
+    }
+};
+
+#define MRQ2_SCOPED_GPU_MARKER(context, name) MrQ2::ScopedGpuMarkerNull MRQ2_CAT_TOKEN(gpu_scope_marker_, __LINE__){ context, MRQ2_MAKE_WIDE_STR(name) }
+#define MRQ2_FUNCTION_GPU_MARKER(context)     MrQ2::ScopedGpuMarkerNull MRQ2_CAT_TOKEN(gpu_funct_marker_, __LINE__){ context, MRQ2_MAKE_WIDE_STR(__FUNCTION__) }
+
+#define MRQ2_PUSH_GPU_MARKER(context, name)   context.PushMarker(MRQ2_MAKE_WIDE_STR(name))
+#define MRQ2_POP_GPU_MARKER(context)          context.PopMarker()
+
+} // MrQ2
@@ -0,0 +1,122 @@
+//
+// PipelineStateNull.cpp
+//
+
+#include "PipelineStateNull.hpp"
+#include "ShaderProgramNull.hpp"
+#include "DeviceNull.hpp"
+
+namespace MrQ2
+{
+
+void PipelineStateNull::Init(const DeviceNull & device)
+{
+    MRQ2_ASSERT(m_device == nullptr);
+    m_device = &device;
+
+    // Same defaults as the GPU back-ends:
+    //  Blending: Alpha blending OFF
+    //  Rasterizer state: Backface cull ON
+    //  Depth-stencil state: Depth test ON, depth write ON, stencil OFF
+    SetFlags(kDepthTestEnabled | kDepthWriteEnabled | kCullEnabled);
+}
+
+void PipelineStateNull::Shutdown()
+{
+    m_device      = nullptr;
+    m_shader_prog = nullptr;
+    m_flags       = kNoFlags;
+}
+
+void PipelineStateNull::SetPrimitiveTopology(const PrimitiveTopologyNull topology)
+{
+    m_topology = topology;
+}
+
+void PipelineStateNull::SetShaderProgram(const ShaderProgramNull & shader_prog)
+{
+    if (!shader_prog.IsLoaded())
+    {
+        GameInterface::Errorf("PipelineStateNull: Trying to set an invalid shader program.");
+    }
+    m_shader_prog = &shader_prog;
+}
+
+void PipelineStateNull::SetDepthTestEnabled(const bool enabled)
+{
+    if (enabled)
+    {
+        SetFlags(m_flags | kDepthTestEnabled);
+    }
+    else
+    {
+        SetFlags(m_flags & ~kDepthTestEnabled);
+    }
+}
+
+void PipelineStateNull::SetDepthWritesEnabled(const bool enabled)
+{
+    if (enabled)
+    {
+        SetFlags(m_flags | kDepthWriteEnabled);
+    }
+    else
+    {
+        SetFlags(m_flags & ~kDepthWriteEnabled);
+    }
+}
+
+void PipelineStateNull::SetAlphaBlendingEnabled(const bool enabled)
+{
+    if (enabled)
+    {
+        SetFlags(m_flags | kAlphaBlendEnabled);
+    }
+    else
+    {
+        SetFlags(m_flags & ~kAlphaBlendEnabled);
+    }
+}
+
+void PipelineStateNull::SetAdditiveBlending(const bool enabled)
+{
+    if (enabled)
+    {
+        SetFlags(m_flags | kAdditiveBlending);
+    }
+    else
+    {
+        SetFlags(m_flags & ~kAdditiveBlending);
+    }
+}
+
+void PipelineStateNull::SetCullEnabled(const bool enabled)
+{
+    if (enabled)
+    {
+        SetFlags(m_flags | kCullEnabled);
+    }
+    else
+    {
+        SetFlags(m_flags & ~kCullEnabled);
+    }
+}
+
+void PipelineStateNull::Finalize() const
+{
+    if (IsFinalized())
+    {
+        return;
+    }
+
+    MRQ2_ASSERT(m_device != nullptr);
+    if (m_shader_prog == nullptr)
+    {
+        GameInterface::Errorf("PipelineStateNull: No shader program has been set!");
+    }
+
+    // Nothing to create, state objects only exist in the GPU back-ends.
+    SetFlags(m_flags | kFinalized);
+}
+
+} // MrQ2
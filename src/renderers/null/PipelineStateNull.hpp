@@ -0,0 +1,62 @@
+//
+// PipelineStateNull.hpp
+//
+#pragma once
+
+#include "UtilsNull.hpp"
+
+namespace MrQ2
+{
+
+class DeviceNull;
+class ShaderProgramNull;
+
+class PipelineStateNull final
+{
+    friend class GraphicsContextNull;
+
+public:
+
+    PipelineStateNull() = default;
+
+    // Disallow copy.
+    PipelineStateNull(const PipelineStateNull &) = delete;
+    PipelineStateNull & operator=(const PipelineStateNull &) = delete;
+
+    void Init(const DeviceNull & device);
+    void Shutdown();
+
+    void SetPrimitiveTopology(const PrimitiveTopologyNull topology);
+    void SetShaderProgram(const ShaderProgramNull & shader_prog);
+
+    void SetDepthTestEnabled(const bool enabled);
+    void SetDepthWritesEnabled(const bool enabled);
+    void SetAlphaBlendingEnabled(const bool enabled);
+    void SetAdditiveBlending(const bool enabled);
+    void SetCullEnabled(const bool enabled);
+
+    void Finalize() const;
+    bool IsFinalized() const { return (m_flags & kFinalized) != 0; }
+
+private:
+
+    enum Flags : uint32_t
+    {
+        kNoFlags           = 0,
+        kFinalized         = (1 << 1),
+        kDepthTestEnabled  = (1 << 2),
+        kDepthWriteEnabled = (1 << 3),
+        kAlphaBlendEnabled = (1 << 4),
+        kAdditiveBlending  = (1 << 5),
+        kCullEnabled       = (1 << 6),
+    };
+
+    void SetFlags(const uint32_t newFlags) const { m_flags = Flags(newFlags); }
+
+    const DeviceNull *        m_device{ nullptr };
+    const ShaderProgramNull * m_shader_prog{ nullptr };
+    mutable Flags             m_flags{ kNoFlags };
+    PrimitiveTopologyNull     m_topology{ PrimitiveTopologyNull::kTriangleList };
+};
+
+} // MrQ2
@@ -0,0 +1,64 @@
+//
+// RenderInterfaceNull.cpp
+//
+
+#include "RenderInterfaceNull.hpp"
+
+namespace MrQ2
+{
+
+void RenderInterfaceNull::Init(HINSTANCE hInst, WNDPROC wndProc, const int width, const int height, const bool fullscreen, const bool debug)
+{
+    GameInterface::Printf("**** RenderInterfaceNull::Init ****");
+
+    // No window or swap-chain, just remember the size for the viewport.
+    (void)hInst;
+    (void)wndProc;
+    (void)fullscreen;
+
+    MRQ2_ASSERT(width > 0 && height > 0);
+    m_render_width  = width;
+    m_render_height = height;
+
+    m_device.Init(m_upload_ctx, m_graphics_ctx, debug);
+    m_upload_ctx.Init(m_device);
+    m_graphics_ctx.Init(m_device);
+
+    m_last_frame_stats.Clear();
+}
+
+void RenderInterfaceNull::Shutdown()
+{
+    GameInterface::Printf("**** RenderInterfaceNull::Shutdown ****");
+
+    m_graphics_ctx.Shutdown();
+    m_upload_ctx.Shutdown();
+    m_device.Shutdown();
+
+    m_render_width  = 0;
+    m_render_height = 0;
+}
+
+void RenderInterfaceNull::BeginFrame(const float clear_color[4], const float clear_depth, const uint8_t clear_stencil)
+{
+    MRQ2_ASSERT(!m_frame_started);
+    m_frame_started = true;
+
+    // Texture uploads done outside the frame (registration) are not counted.
+    m_device.CurrentFrameStats().Clear();
+
+    m_graphics_ctx.BeginFrame(clear_color, clear_depth, clear_stencil);
+    m_graphics_ctx.SetViewport(0, 0, RenderWidth(), RenderHeight());
+    m_graphics_ctx.SetScissorRect(0, 0, RenderWidth(), RenderHeight());
+}
+
+void RenderInterfaceNull::EndFrame()
+{
+    MRQ2_ASSERT(m_frame_started);
+    m_frame_started = false;
+
+    m_graphics_ctx.EndFrame();
+    m_last_frame_stats = m_device.CurrentFrameStats();
+}
+
+} // MrQ2
@@ -0,0 +1,106 @@
+//
+// RenderInterfaceNull.hpp
+//  Main header for the headless "null" back-end.
+//  Implements the back-end interface with plain CPU memory and no window or GPU,
+//  so the common renderer code can be profiled in isolation. Draw calls and state
+//  changes are validated and counted in a FrameStatsNull.
+//
+#pragma once
+
+#include "BufferNull.hpp"
+#include "TextureNull.hpp"
+#include "ShaderProgramNull.hpp"
+#include "PipelineStateNull.hpp"
+#include "GraphicsContextNull.hpp"
+#include "UploadContextNull.hpp"
+#include "DeviceNull.hpp"
+
+namespace MrQ2
+{
+
+class RenderInterfaceNull final
+{
+public:
+
+    static constexpr uint32_t kNumFrameBuffers = kNullNumFrameBuffers;
+
+    RenderInterfaceNull() = default;
+
+    // Disallow copy.
+    RenderInterfaceNull(const RenderInterfaceNull &) = delete;
+    RenderInterfaceNull & operator=(const RenderInterfaceNull &) = delete;
+
+    void Init(HINSTANCE hInst, WNDPROC wndProc, const int width, const int height, const bool fullscreen, const bool debug);
+    void Shutdown();
+
+    void BeginFrame(const float clear_color[4], const float clear_depth, const uint8_t clear_stencil);
+    void EndFrame();
+    void WaitForGpu() {} // Not required for this backend.
+
+    int RenderWidth() const;
+    int RenderHeight() const;
+    bool IsFrameStarted() const;
+    const DeviceNull & Device() const;
+
+    // Counters of the last completed frame (between BeginFrame/EndFrame).
+    const FrameStatsNull & LastFrameStats() const;
+
+private:
+
+    DeviceNull          m_device;
+    UploadContextNull   m_upload_ctx;
+    GraphicsContextNull m_graphics_ctx;
+    FrameStatsNull      m_last_frame_stats{};
+    int                 m_render_width{ 0 };
+    int                 m_render_height{ 0 };
+    bool                m_frame_started{ false };
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+inline int RenderInterfaceNull::RenderWidth() const
+{
+    return m_render_width;
+}
+
+inline int RenderInterfaceNull::RenderHeight() const
+{
+    return m_render_height;
+}
+
+inline bool RenderInterfaceNull::IsFrameStarted() const
+{
+    return m_frame_started;
+}
+
+inline const DeviceNull & RenderInterfaceNull::Device() const
+{
+    return m_device;
+}
+
+inline const FrameStatsNull & RenderInterfaceNull::LastFrameStats() const
+{
+    return m_last_frame_stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+using Buffer                 = BufferNull;
+using VertexBuffer           = VertexBufferNull;
+using IndexBuffer            = IndexBufferNull;
+using ConstantBuffer         = ConstantBufferNull;
+using ScratchConstantBuffers = ScratchConstantBuffersNull;
+using Texture                = TextureNull;
+using TextureUpload          = TextureUploadNull;
+using UploadContext          = UploadContextNull;
+using VertexInputLayout      = VertexInputLayoutNull;
+using ShaderProgram          = ShaderProgramNull;
+using PrimitiveTopology      = PrimitiveTopologyNull;
+using PipelineState          = PipelineStateNull;
+using GraphicsContext        = GraphicsContextNull;
+using RenderDevice           = DeviceNull;
+using RenderInterface        = RenderInterfaceNull;
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // MrQ2
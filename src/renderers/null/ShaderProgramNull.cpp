@@ -0,0 +1,53 @@
+//
+// ShaderProgramNull.cpp
+//
+
+#include "ShaderProgramNull.hpp"
+#include "DeviceNull.hpp"
+
+namespace MrQ2
+{
+
+bool ShaderProgramNull::LoadFromFile(const DeviceNull & device, const VertexInputLayoutNull & input_layout, const char * filename)
+{
+    return LoadFromFile(device, input_layout, filename, "VS_main", "PS_main", device.DebugValidationEnabled());
+}
+
+bool ShaderProgramNull::LoadFromFile(const DeviceNull & device, const VertexInputLayoutNull & input_layout, const char * filename,
+                                     const char * vs_entry, const char * ps_entry, const bool debug)
+{
+    MRQ2_ASSERT(m_device == nullptr); // Shutdown first
+    MRQ2_ASSERT(filename != nullptr && filename[0] != '\0');
+    MRQ2_ASSERT(vs_entry != nullptr && ps_entry != nullptr);
+    (void)debug;
+
+    // Same validation the other back-ends do when creating the input layout.
+    for (const auto & element : input_layout.elements)
+    {
+        if (element.type == VertexInputLayoutNull::kInvalidElementType)
+        {
+            break;
+        }
+
+        if (element.format <= VertexInputLayoutNull::kInvalidElementFormat ||
+            element.format >= VertexInputLayoutNull::kElementFormatCount)
+        {
+            GameInterface::Errorf("Invalid vertex element format for shader '%s'", filename);
+        }
+    }
+
+    m_device       = &device;
+    m_input_layout = input_layout;
+    m_is_loaded    = true;
+
+    return true;
+}
+
+void ShaderProgramNull::Shutdown()
+{
+    m_device       = nullptr;
+    m_input_layout = {};
+    m_is_loaded    = false;
+}
+
+} // MrQ2
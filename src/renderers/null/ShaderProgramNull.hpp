@@ -0,0 +1,88 @@
+//
+// ShaderProgramNull.hpp
+//
+#pragma once
+
+#include "UtilsNull.hpp"
+
+namespace MrQ2
+{
+
+class DeviceNull;
+class PipelineStateNull;
+class GraphicsContextNull;
+
+struct VertexInputLayoutNull final
+{
+    enum ElementType : uint8_t
+    {
+        kInvalidElementType = 0,
+
+        kVertexPosition,
+        kVertexTexCoords,
+        kVertexLmCoords,
+        kVertexColor,
+
+        kElementTypeCount
+    };
+
+    enum ElementFormat : uint8_t
+    {
+        kInvalidElementFormat = 0,
+
+        kFormatFloat2,
+        kFormatFloat3,
+        kFormatFloat4,
+
+        kElementFormatCount
+    };
+
+    static constexpr uint32_t kMaxVertexElements = 4;
+
+    struct VertexElement
+    {
+        ElementType   type;
+        ElementFormat format;
+        uint32_t      offset;
+    } elements[kMaxVertexElements];
+};
+
+//
+// No shader compilation happens in the null back-end, we only
+// validate and keep the vertex layout so draws can be checked.
+//
+class ShaderProgramNull final
+{
+    friend PipelineStateNull;
+    friend GraphicsContextNull;
+
+public:
+
+    ShaderProgramNull() = default;
+
+    // Disallow copy.
+    ShaderProgramNull(const ShaderProgramNull &) = delete;
+    ShaderProgramNull & operator=(const ShaderProgramNull &) = delete;
+
+    bool LoadFromFile(const DeviceNull & device,
+                      const VertexInputLayoutNull & input_layout,
+                      const char * filename);
+
+    bool LoadFromFile(const DeviceNull & device,
+                      const VertexInputLayoutNull & input_layout,
+                      const char * filename,
+                      const char * vs_entry, const char * ps_entry,
+                      const bool debug);
+
+    void Shutdown();
+
+    bool IsLoaded() const { return m_is_loaded; }
+
+private:
+
+    const DeviceNull *    m_device{ nullptr };
+    VertexInputLayoutNull m_input_layout{};
+    bool                  m_is_loaded{ false };
+};
+
+} // MrQ2
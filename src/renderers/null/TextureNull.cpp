@@ -0,0 +1,83 @@
+//
+// TextureNull.cpp
+//
+
+#include "../common/TextureStore.hpp"
+#include "TextureNull.hpp"
+#include "DeviceNull.hpp"
+
+namespace MrQ2
+{
+
+static_assert(TextureNull::kMaxMipLevels == TextureImage::kMaxMipLevels, "Keep these in sync!");
+
+void TextureNull::Init(const DeviceNull & device, const TextureType type, const bool is_scrap,
+                       const ColorRGBA32 * mip_init_data[], const Vec2u16 mip_dimensions[],
+                       const uint32_t num_mip_levels, const TextureFormat format, const char * const debug_name)
+{
+    MRQ2_ASSERT(num_mip_levels >= 1 && num_mip_levels <= TextureImage::kMaxMipLevels);
+    MRQ2_ASSERT((mip_dimensions[0].x + mip_dimensions[0].y) != 0);
+    MRQ2_ASSERT(mip_init_data[0] != nullptr);
+    MRQ2_ASSERT(m_device == nullptr); // Shutdown first
+    (void)debug_name; // unused
+    (void)type;       // no samplers
+
+    uint32_t total_size = 0;
+    for (uint32_t mip = 0; mip < num_mip_levels; ++mip)
+    {
+        m_mip_offsets[mip]    = total_size;
+        m_mip_dimensions[mip] = mip_dimensions[mip];
+        total_size += TextureLevelSize(format, mip_dimensions[mip].x, mip_dimensions[mip].y);
+    }
+
+    m_memory         = static_cast<uint8_t *>(MemAllocTracked(total_size, MemTag::kRenderer));
+    m_memory_size    = total_size;
+    m_num_mip_levels = num_mip_levels;
+    m_format         = format;
+    m_is_scrap       = is_scrap;
+    m_owns_memory    = true;
+    m_device         = &device;
+
+    // Same as the initial data upload done by the GPU back-ends.
+    for (uint32_t mip = 0; mip < num_mip_levels; ++mip)
+    {
+        if (mip_init_data[mip] != nullptr)
+        {
+            const uint32_t mip_size = TextureLevelSize(format, mip_dimensions[mip].x, mip_dimensions[mip].y);
+            std::memcpy(m_memory + m_mip_offsets[mip], mip_init_data[mip], mip_size);
+        }
+    }
+}
+
+void TextureNull::Init(const TextureNull & other)
+{
+    MRQ2_ASSERT(m_device == nullptr); // Shutdown first
+    MRQ2_ASSERT(other.m_device != nullptr);
+
+    m_device         = other.m_device;
+    m_memory         = other.m_memory;
+    m_memory_size    = other.m_memory_size;
+    m_num_mip_levels = other.m_num_mip_levels;
+    m_format         = other.m_format;
+    m_is_scrap       = other.m_is_scrap;
+    m_owns_memory    = false;
+
+    std::memcpy(m_mip_offsets, other.m_mip_offsets, sizeof(m_mip_offsets));
+    std::memcpy(m_mip_dimensions, other.m_mip_dimensions, sizeof(m_mip_dimensions));
+}
+
+void TextureNull::Shutdown()
+{
+    if (m_owns_memory && m_memory != nullptr)
+    {
+        MemFreeTracked(m_memory, m_memory_size, MemTag::kRenderer);
+    }
+
+    m_device         = nullptr;
+    m_memory         = nullptr;
+    m_memory_size    = 0;
+    m_num_mip_levels = 0;
+    m_owns_memory    = false;
+}
+
+} // MrQ2
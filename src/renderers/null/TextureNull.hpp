@@ -0,0 +1,56 @@
+//
+// TextureNull.hpp
+//
+#pragma once
+
+#include "UtilsNull.hpp"
+
+namespace MrQ2
+{
+
+class DeviceNull;
+enum class TextureType : std::uint8_t;
+enum class TextureFormat : std::uint8_t;
+
+//
+// Texture backed by a plain CPU memory block holding all mip levels (RGBA8 or BC blocks).
+//
+class TextureNull final
+{
+    friend class UploadContextNull;
+    friend class GraphicsContextNull;
+
+public:
+
+    static constexpr uint32_t kMaxMipLevels = 8; // Same as TextureImage::kMaxMipLevels
+
+    TextureNull() = default;
+    ~TextureNull() { Shutdown(); }
+
+    // Disallow copy.
+    TextureNull(const TextureNull &) = delete;
+    TextureNull & operator=(const TextureNull &) = delete;
+
+    void Init(const DeviceNull & device, const TextureType type, const bool is_scrap,
+              const ColorRGBA32 * mip_init_data[], const Vec2u16 mip_dimensions[],
+              const uint32_t num_mip_levels, const TextureFormat format, const char * const debug_name);
+
+    // Init from existing texture sharing the pixel memory (for the scrap texture)
+    void Init(const TextureNull & other);
+
+    void Shutdown();
+
+private:
+
+    const DeviceNull * m_device{ nullptr };
+    uint8_t *          m_memory{ nullptr };
+    uint32_t           m_memory_size{ 0 };
+    uint32_t           m_num_mip_levels{ 0 };
+    TextureFormat      m_format{};
+    uint32_t           m_mip_offsets[kMaxMipLevels] = {};
+    Vec2u16            m_mip_dimensions[kMaxMipLevels] = {};
+    bool               m_is_scrap{ false };
+    bool               m_owns_memory{ false };
+};
+
+} // MrQ2
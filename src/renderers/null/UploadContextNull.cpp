@@ -0,0 +1,74 @@
+//
+// UploadContextNull.cpp
+//
+
+#include "../common/TextureStore.hpp"
+#include "UploadContextNull.hpp"
+#include "TextureNull.hpp"
+#include "DeviceNull.hpp"
+
+namespace MrQ2
+{
+
+void UploadContextNull::Init(const DeviceNull & device)
+{
+    MRQ2_ASSERT(m_device == nullptr);
+    m_device = &device;
+}
+
+void UploadContextNull::Shutdown()
+{
+    m_device = nullptr;
+}
+
+void UploadContextNull::UploadTexture(const TextureUploadNull & upload_info)
+{
+    MRQ2_ASSERT(m_device != nullptr);
+    MRQ2_ASSERT(upload_info.texture->m_memory != nullptr);
+    MRQ2_ASSERT(upload_info.mipmaps.mip_dimensions[0].x != 0);
+    MRQ2_ASSERT(upload_info.mipmaps.mip_init_data[0] != nullptr);
+    MRQ2_ASSERT(upload_info.mipmaps.num_mip_levels >= 1 && upload_info.mipmaps.num_mip_levels <= upload_info.texture->m_num_mip_levels);
+
+    const TextureNull * texture = upload_info.texture;
+    FrameStatsNull & stats = m_device->CurrentFrameStats();
+
+    if (upload_info.HasRegion())
+    {
+        MRQ2_ASSERT(upload_info.is_scrap && upload_info.mipmaps.num_mip_levels == 1);
+        MRQ2_ASSERT(texture->m_format == TextureFormat::kRGBA8);
+        MRQ2_ASSERT(upload_info.region.x + upload_info.region.width  <= texture->m_mip_dimensions[0].x);
+        MRQ2_ASSERT(upload_info.region.y + upload_info.region.height <= texture->m_mip_dimensions[0].y);
+
+        const uint32_t row_pitch  = texture->m_mip_dimensions[0].x * TextureImage::kBytesPerPixel;
+        const uint32_t row_offset = (upload_info.region.y * texture->m_mip_dimensions[0].x + upload_info.region.x) * TextureImage::kBytesPerPixel;
+        const uint32_t row_size   = upload_info.region.width * TextureImage::kBytesPerPixel;
+
+        const auto * src_pixels = reinterpret_cast<const std::uint8_t *>(upload_info.mipmaps.mip_init_data[0]) + row_offset;
+        auto * dest_pixels = texture->m_memory + texture->m_mip_offsets[0] + row_offset;
+
+        for (uint32_t y = 0; y < upload_info.region.height; ++y)
+        {
+            std::memcpy(dest_pixels + y * row_pitch, src_pixels + y * row_pitch, row_size);
+        }
+
+        stats.texture_bytes_uploaded += row_size * upload_info.region.height;
+        stats.texture_uploads++;
+        return;
+    }
+
+    // Texture memory is logically owned by the "GPU", so writing to it from a const texture is fine here.
+    for (uint32_t mip = 0; mip < upload_info.mipmaps.num_mip_levels; ++mip)
+    {
+        MRQ2_ASSERT(upload_info.mipmaps.mip_dimensions[mip].x == texture->m_mip_dimensions[mip].x);
+        MRQ2_ASSERT(upload_info.mipmaps.mip_dimensions[mip].y == texture->m_mip_dimensions[mip].y);
+
+        const uint32_t mip_size = TextureLevelSize(texture->m_format, upload_info.mipmaps.mip_dimensions[mip].x, upload_info.mipmaps.mip_dimensions[mip].y);
+        std::memcpy(texture->m_memory + texture->m_mip_offsets[mip], upload_info.mipmaps.mip_init_data[mip], mip_size);
+
+        stats.texture_bytes_uploaded += mip_size;
+    }
+
+    stats.texture_uploads++;
+}
+
+} // MrQ2
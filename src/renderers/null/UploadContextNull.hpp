@@ -0,0 +1,55 @@
+//
+// UploadContextNull.hpp
+//
+#pragma once
+
+#include "UtilsNull.hpp"
+
+namespace MrQ2
+{
+
+class DeviceNull;
+class TextureNull;
+
+struct TextureUploadNull final
+{
+    const TextureNull * texture;
+    bool is_scrap;
+
+    struct {
+        uint32_t             num_mip_levels;
+        const ColorRGBA32 ** mip_init_data;
+        const Vec2u16 *      mip_dimensions;
+    } mipmaps;
+
+    // Optional sub-rectangle of mip level 0 to update in an existing texture (is_scrap uploads with a single mip).
+    // mip_init_data[0] still points to the whole level 0 image. Whole texture is updated if width or height is zero.
+    struct {
+        uint32_t x, y;
+        uint32_t width, height;
+    } region;
+
+    bool HasRegion() const { return region.width != 0 && region.height != 0; }
+};
+
+class UploadContextNull final
+{
+public:
+
+    UploadContextNull() = default;
+
+    // Disallow copy.
+    UploadContextNull(const UploadContextNull &) = delete;
+    UploadContextNull & operator=(const UploadContextNull &) = delete;
+
+    void Init(const DeviceNull & device);
+    void Shutdown();
+
+    void UploadTexture(const TextureUploadNull & upload_info);
+
+private:
+
+    const DeviceNull * m_device{ nullptr };
+};
+
+} // MrQ2
@@ -0,0 +1,65 @@
+//
+// UtilsNull.hpp
+//
+#pragma once
+
+#include "../common/Common.hpp"
+
+#if defined(_WIN32)
+    #define NOIME
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else // !_WIN32
+    // The null back-end never creates a window, these are just
+    // placeholders so RenderInterfaceNull::Init matches the other back-ends.
+    using HINSTANCE = void *;
+    using WNDPROC   = void *;
+#endif // _WIN32
+
+namespace MrQ2
+{
+
+// Triple-buffering (only affects the ScratchConstantBuffers rotation)
+constexpr uint32_t kNullNumFrameBuffers = 3;
+
+enum class PrimitiveTopologyNull : uint8_t
+{
+    kTriangleList,
+    kTriangleStrip,
+    kTriangleFan,
+    kLineList,
+
+    kCount
+};
+
+//
+// Counters accumulated by the GraphicsContext and UploadContext during a frame.
+// The null back-end has no GPU, so these are the only output it produces.
+//
+struct FrameStatsNull final
+{
+    uint32_t draw_calls;
+    uint32_t draw_indexed_calls;
+    uint32_t vertices_drawn;
+    uint32_t indices_drawn;
+    uint32_t primitives_drawn;
+
+    uint32_t pipeline_changes;
+    uint32_t topology_changes;
+    uint32_t vertex_buffer_changes;
+    uint32_t index_buffer_changes;
+    uint32_t constant_buffer_changes;
+    uint32_t texture_changes;
+
+    uint32_t buffer_maps;
+    uint32_t constant_buffer_updates;
+    uint32_t constant_buffer_bytes;
+
+    uint32_t texture_uploads;
+    uint32_t texture_bytes_uploaded;
+
+    void Clear() { std::memset(this, 0, sizeof(*this)); }
+};
+
+} // MrQ2
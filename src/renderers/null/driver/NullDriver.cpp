@@ -0,0 +1,705 @@
+//
+// NullDriver.cpp
+//  Headless host for the Null renderer. Implements the refimport_t
+//  callbacks normally provided by the Quake executable (console, cvars,
+//  commands and a minimal pak/loose file system) so the common renderer
+//  can be run and profiled on machines without a GPU or a window system.
+//
+//  Usage: mrq2_null_driver [-basedir <dir>] [-game <dir>] [+command args ...]
+//  (options must come before the commands)
+//
+//  '+set' commands run before the renderer is initialized, the others run
+//  afterwards, in order. Besides the renderer commands (view_replay,
+//  lightmap_bench, alias_bench, etc) the driver adds:
+//
+//   map <name>                  - Registers maps/<name>.bsp.
+//   frames <count> [x y z yaw]  - Renders frames and prints the frame times.
+//
+//  Without any '+' commands it just runs 'frames 60', drawing only 2D.
+//
+
+#include "game/q_shared.h"
+#include "common/q_common.h"
+#include "common/q_files.h"
+#include "client/ref.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+extern "C" refexport_t GetRefAPI(refimport_t ri);
+
+// Namespaced to not clash with the engine's declarations in q_common.h
+namespace NullDriver
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// Console
+///////////////////////////////////////////////////////////////////////////////
+
+constexpr int kMaxPrintMsg = 4096;
+
+static void Con_Printf(print_level_t print_level, const char * fmt, ...)
+{
+    (void)print_level;
+
+    va_list argptr;
+    char msg[kMaxPrintMsg];
+
+    va_start(argptr, fmt);
+    std::vsnprintf(msg, sizeof(msg), fmt, argptr);
+    va_end(argptr);
+
+    // Flushed right away since Errorf() aborts the process.
+    std::fputs(msg, stdout);
+    std::fflush(stdout);
+}
+
+static void Sys_Error(error_level_t err_level, const char * fmt, ...)
+{
+    (void)err_level;
+
+    va_list argptr;
+    char msg[kMaxPrintMsg];
+
+    va_start(argptr, fmt);
+    std::vsnprintf(msg, sizeof(msg), fmt, argptr);
+    va_end(argptr);
+
+    std::fprintf(stderr, "Sys_Error: %s\n", msg);
+    std::exit(EXIT_FAILURE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Cvars
+///////////////////////////////////////////////////////////////////////////////
+
+// Cvars are never freed, the renderer holds on to the pointers.
+static cvar_t * s_cvar_vars = nullptr;
+
+static char * CopyString(const char * str)
+{
+    const std::size_t len = std::strlen(str);
+    char * copy = static_cast<char *>(std::malloc(len + 1));
+    std::memcpy(copy, str, len + 1);
+    return copy;
+}
+
+static cvar_t * Cvar_Find(const char * name)
+{
+    for (cvar_t * var = s_cvar_vars; var != nullptr; var = var->next)
+    {
+        if (std::strcmp(var->name, name) == 0)
+        {
+            return var;
+        }
+    }
+    return nullptr;
+}
+
+static cvar_t * Cvar_Get(const char * name, const char * value, int flags)
+{
+    cvar_t * var = Cvar_Find(name);
+    if (var != nullptr)
+    {
+        var->flags |= flags;
+        return var;
+    }
+
+    if (value == nullptr)
+    {
+        return nullptr;
+    }
+
+    var = static_cast<cvar_t *>(std::calloc(1, sizeof(cvar_t)));
+    var->name     = CopyString(name);
+    var->string   = CopyString(value);
+    var->value    = float(std::atof(value));
+    var->flags    = flags;
+    var->modified = true;
+    var->next     = s_cvar_vars;
+    s_cvar_vars   = var;
+    return var;
+}
+
+static cvar_t * Cvar_Set(const char * name, const char * value)
+{
+    cvar_t * var = Cvar_Find(name);
+    if (var == nullptr)
+    {
+        return Cvar_Get(name, value, 0);
+    }
+
+    std::free(var->string);
+    var->string   = CopyString(value);
+    var->value    = float(std::atof(value));
+    var->modified = true;
+    return var;
+}
+
+static void Cvar_SetValue(const char * name, float value)
+{
+    char str[64];
+    if (value == float(int(value)))
+    {
+        std::snprintf(str, sizeof(str), "%i", int(value));
+    }
+    else
+    {
+        std::snprintf(str, sizeof(str), "%f", value);
+    }
+    Cvar_Set(name, str);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Commands
+///////////////////////////////////////////////////////////////////////////////
+
+struct DriverCmd
+{
+    std::string name;
+    void (*func)();
+};
+
+static std::vector<DriverCmd>   s_cmds;
+static std::vector<std::string> s_cmd_argv;
+
+static void Cmd_AddCommand(const char * name, void (*cmd)())
+{
+    for (const DriverCmd & c : s_cmds)
+    {
+        if (c.name == name)
+        {
+            Con_Printf(PRINT_ALL, "Cmd_AddCommand: %s already defined\n", name);
+            return;
+        }
+    }
+    s_cmds.push_back({ name, cmd });
+}
+
+static void Cmd_RemoveCommand(const char * name)
+{
+    s_cmds.erase(std::remove_if(s_cmds.begin(), s_cmds.end(),
+                                [name](const DriverCmd & c) { return c.name == name; }),
+                 s_cmds.end());
+}
+
+static int Cmd_Argc()
+{
+    return int(s_cmd_argv.size());
+}
+
+static const char * Cmd_Argv(int i)
+{
+    return (i >= 0 && i < int(s_cmd_argv.size())) ? s_cmd_argv[i].c_str() : "";
+}
+
+static void Cmd_ExecuteArgv(std::vector<std::string> argv)
+{
+    if (argv.empty())
+    {
+        return;
+    }
+
+    s_cmd_argv = std::move(argv);
+
+    for (const DriverCmd & c : s_cmds)
+    {
+        if (c.name == s_cmd_argv[0])
+        {
+            c.func();
+            return;
+        }
+    }
+
+    // Setting a cvar by name, like the Quake console does.
+    if (cvar_t * var = Cvar_Find(s_cmd_argv[0].c_str()))
+    {
+        if (s_cmd_argv.size() >= 2)
+        {
+            Cvar_Set(var->name, s_cmd_argv[1].c_str());
+        }
+        Con_Printf(PRINT_ALL, "\"%s\" is \"%s\"\n", var->name, var->string);
+        return;
+    }
+
+    Con_Printf(PRINT_ALL, "Unknown command \"%s\"\n", s_cmd_argv[0].c_str());
+}
+
+// Splits the text on newlines and semicolons and runs each command immediately.
+static void Cmd_ExecuteText(cmd_exec_when_t exec_when, const char * text)
+{
+    (void)exec_when;
+
+    std::vector<std::string> argv;
+    std::string token;
+    bool quoted = false;
+
+    for (const char * p = text; ; ++p)
+    {
+        const char c = *p;
+        if (c == '"')
+        {
+            quoted = !quoted;
+            continue;
+        }
+
+        const bool end_of_cmd = (c == '\0' || c == '\n' || (c == ';' && !quoted));
+        if (end_of_cmd || (!quoted && (c == ' ' || c == '\t' || c == '\r')))
+        {
+            if (!token.empty())
+            {
+                argv.push_back(std::move(token));
+                token.clear();
+            }
+            if (end_of_cmd)
+            {
+                Cmd_ExecuteArgv(std::move(argv));
+                argv.clear();
+            }
+            if (c == '\0')
+            {
+                break;
+            }
+            continue;
+        }
+
+        token += c;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// File system
+///////////////////////////////////////////////////////////////////////////////
+
+struct PakFile
+{
+    std::string              path;
+    std::vector<dpackfile_t> files;
+};
+
+static std::string          s_game_dir;
+static std::vector<PakFile> s_pak_files;
+
+static void FS_AddPakFile(const std::string & path)
+{
+    FILE * file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    dpackheader_t header{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || header.ident != IDPAKHEADER)
+    {
+        Con_Printf(PRINT_ALL, "%s is not a packfile\n", path.c_str());
+        std::fclose(file);
+        return;
+    }
+
+    const int num_files = header.dirlen / int(sizeof(dpackfile_t));
+    if (num_files <= 0 || num_files > MAX_FILES_IN_PACK)
+    {
+        Con_Printf(PRINT_ALL, "%s has %i files\n", path.c_str(), num_files);
+        std::fclose(file);
+        return;
+    }
+
+    PakFile pak;
+    pak.path = path;
+    pak.files.resize(num_files);
+
+    std::fseek(file, header.dirofs, SEEK_SET);
+    const bool ok = (std::fread(pak.files.data(), sizeof(dpackfile_t), num_files, file) == std::size_t(num_files));
+    std::fclose(file);
+
+    if (ok)
+    {
+        Con_Printf(PRINT_ALL, "Added packfile %s (%i files)\n", path.c_str(), num_files);
+        s_pak_files.push_back(std::move(pak));
+    }
+}
+
+static void FS_Init(const std::string & base_dir, const std::string & game)
+{
+    s_game_dir = base_dir + "/" + game;
+
+    // Higher numbered paks override the lower ones, so they are searched first.
+    for (int i = 9; i >= 0; --i)
+    {
+        FS_AddPakFile(s_game_dir + "/pak" + std::to_string(i) + ".pak");
+    }
+}
+
+// Finds the file in the game dir or in one of the paks and opens it at the start of the file data.
+static FILE * FS_OpenFile(const char * name, int * out_length)
+{
+    const std::string loose_path = s_game_dir + "/" + name;
+    if (FILE * file = std::fopen(loose_path.c_str(), "rb"))
+    {
+        std::fseek(file, 0, SEEK_END);
+        *out_length = int(std::ftell(file));
+        std::fseek(file, 0, SEEK_SET);
+        return file;
+    }
+
+    for (const PakFile & pak : s_pak_files)
+    {
+        for (const dpackfile_t & entry : pak.files)
+        {
+            if (std::strncmp(entry.name, name, sizeof(entry.name)) == 0)
+            {
+                FILE * file = std::fopen(pak.path.c_str(), "rb");
+                if (file == nullptr)
+                {
+                    return nullptr;
+                }
+                std::fseek(file, entry.filepos, SEEK_SET);
+                *out_length = entry.filelen;
+                return file;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+static int FS_LoadFile(const char * name, void ** buf)
+{
+    int length = -1;
+    FILE * file = FS_OpenFile(name, &length);
+    if (file == nullptr)
+    {
+        if (buf != nullptr)
+        {
+            *buf = nullptr;
+        }
+        return -1;
+    }
+
+    if (buf == nullptr)
+    {
+        std::fclose(file);
+        return length;
+    }
+
+    void * data = std::malloc(std::max(length, 1));
+    if (std::fread(data, 1, length, file) != std::size_t(length))
+    {
+        Sys_Error(ERR_FATAL, "FS_LoadFile: short read on %s", name);
+    }
+    std::fclose(file);
+
+    *buf = data;
+    return length;
+}
+
+static void FS_FreeFile(void * buf)
+{
+    std::free(buf);
+}
+
+static int FS_LoadFilePortion(const char * path, void * dest_buffer, int num_bytes_to_read)
+{
+    int length = -1;
+    FILE * file = FS_OpenFile(path, &length);
+    if (file == nullptr)
+    {
+        return 0;
+    }
+
+    const bool ok = (length >= num_bytes_to_read) &&
+                    (std::fread(dest_buffer, 1, num_bytes_to_read, file) == std::size_t(num_bytes_to_read));
+    std::fclose(file);
+    return ok ? 1 : 0;
+}
+
+// Creates all the directories leading up to the file name.
+static void FS_CreatePath(char * path)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path{ path }.parent_path(), ec);
+}
+
+static char * FS_Gamedir()
+{
+    return const_cast<char *>(s_game_dir.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Video & system
+///////////////////////////////////////////////////////////////////////////////
+
+struct VidMode
+{
+    int width, height;
+};
+
+// Same mode list as vid_win.c
+static const VidMode s_vid_modes[] = {
+    { 320,  240  },
+    { 400,  300  },
+    { 512,  384  },
+    { 640,  480  },
+    { 800,  600  },
+    { 960,  720  },
+    { 1024, 768  },
+    { 1152, 864  },
+    { 1280, 960  },
+    { 1600, 1200 }
+};
+
+static int Vid_GetModeInfo(int * width, int * height, int mode)
+{
+    if (mode < 0 || mode >= int(sizeof(s_vid_modes) / sizeof(s_vid_modes[0])))
+    {
+        return false;
+    }
+
+    *width  = s_vid_modes[mode].width;
+    *height = s_vid_modes[mode].height;
+    return true;
+}
+
+static void Vid_MenuInit()
+{
+}
+
+static void Vid_NewWindow(int width, int height)
+{
+    (void)width;
+    (void)height;
+}
+
+// The driver has no game module, so there's no game memory to report.
+static void Sys_SetMemoryHooks(void (*alloc_hook)(void *, size_t, game_memtag_t),
+                               void (*free_hook) (void *, size_t, game_memtag_t))
+{
+    (void)alloc_hook;
+    (void)free_hook;
+}
+
+static const auto s_start_time = std::chrono::steady_clock::now();
+
+static int Sys_Milliseconds()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - s_start_time;
+    return int(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Driver commands
+///////////////////////////////////////////////////////////////////////////////
+
+static refexport_t s_re;
+static bool        s_map_loaded = false;
+
+static void SetCmd()
+{
+    if (Cmd_Argc() < 3)
+    {
+        Con_Printf(PRINT_ALL, "Usage: set <variable> <value>\n");
+        return;
+    }
+    Cvar_Set(Cmd_Argv(1), Cmd_Argv(2));
+}
+
+static void MapCmd()
+{
+    if (Cmd_Argc() < 2)
+    {
+        Con_Printf(PRINT_ALL, "Usage: map <name>\n");
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    s_re.BeginRegistration(Cmd_Argv(1));
+    s_re.EndRegistration();
+    s_map_loaded = true;
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    Con_Printf(PRINT_ALL, "map %s registered in %.2f ms\n", Cmd_Argv(1), elapsed.count());
+}
+
+static void FramesCmd()
+{
+    const int num_frames = (Cmd_Argc() >= 2) ? std::max(std::atoi(Cmd_Argv(1)), 1) : 60;
+
+    int width = 0, height = 0;
+    if (!Vid_GetModeInfo(&width, &height, int(Cvar_Get("vid_mode", "6", 0)->value)))
+    {
+        width  = int(Cvar_Get("vid_width", "1024", 0)->value);
+        height = int(Cvar_Get("vid_height", "768", 0)->value);
+    }
+
+    lightstyle_t lightstyles[MAX_LIGHTSTYLES];
+    for (lightstyle_t & ls : lightstyles)
+    {
+        ls.rgb[0] = ls.rgb[1] = ls.rgb[2] = 1.0f;
+        ls.white  = 3.0f;
+    }
+
+    refdef_t view_def{};
+    view_def.width       = width;
+    view_def.height      = height;
+    view_def.fov_x       = 90.0f;
+    view_def.fov_y       = 73.74f;
+    view_def.lightstyles = lightstyles;
+    for (int i = 0; i < 3 && (2 + i) < Cmd_Argc(); ++i)
+    {
+        view_def.vieworg[i] = float(std::atof(Cmd_Argv(2 + i)));
+    }
+    const float start_yaw = (Cmd_Argc() >= 6) ? float(std::atof(Cmd_Argv(5))) : 0.0f;
+
+    std::vector<double> frame_ms(num_frames);
+
+    for (int f = 0; f < num_frames; ++f)
+    {
+        // Full turn around the view origin over the run.
+        view_def.viewangles[YAW] = start_yaw + (360.0f * f) / num_frames;
+        view_def.time = f * (1.0f / 60.0f);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        s_re.BeginFrame(0.0f);
+        if (s_map_loaded) // Without a map only the 2D overlay is drawn.
+        {
+            s_re.RenderFrame(&view_def);
+        }
+        s_re.DrawFill(8, 8, 128, 16, 0);
+        for (int c = 0; c < 16; ++c)
+        {
+            s_re.DrawChar(8 + c * 8, 12, 'A' + c);
+        }
+        s_re.EndFrame();
+
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        frame_ms[f] = elapsed.count();
+    }
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+
+    double total_ms = 0.0;
+    for (const double ms : frame_ms)
+    {
+        total_ms += ms;
+    }
+
+    Con_Printf(PRINT_ALL, "frames: %d frames at %dx%d, avg %.3f ms, min %.3f ms, median %.3f ms, max %.3f ms\n",
+               num_frames, width, height, total_ms / num_frames, frame_ms.front(), frame_ms[num_frames / 2], frame_ms.back());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Run()
+///////////////////////////////////////////////////////////////////////////////
+
+static int Run(int argc, const char * argv[])
+{
+    std::string base_dir = ".";
+    std::string game     = BASEDIRNAME;
+
+    // Group the '+' commands with their arguments.
+    std::vector<std::vector<std::string>> early_cmds;
+    std::vector<std::vector<std::string>> cmds;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-basedir") == 0 && (i + 1) < argc)
+        {
+            base_dir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-game") == 0 && (i + 1) < argc)
+        {
+            game = argv[++i];
+        }
+        else if (argv[i][0] == '+')
+        {
+            std::vector<std::string> cmd{ argv[i] + 1 };
+            while ((i + 1) < argc && argv[i + 1][0] != '+')
+            {
+                cmd.push_back(argv[++i]);
+            }
+            (cmd[0] == "set" ? early_cmds : cmds).push_back(std::move(cmd));
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [-basedir <dir>] [-game <dir>] [+command args ...]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (cmds.empty())
+    {
+        cmds.push_back({ "frames", "60" });
+    }
+
+    FS_Init(base_dir, game);
+
+    Cmd_AddCommand("set", &SetCmd);
+    Cmd_AddCommand("map", &MapCmd);
+    Cmd_AddCommand("frames", &FramesCmd);
+
+    for (auto & cmd : early_cmds)
+    {
+        Cmd_ExecuteArgv(std::move(cmd));
+    }
+
+    refimport_t ri{};
+    ri.Sys_Error          = &Sys_Error;
+    ri.Con_Printf         = &Con_Printf;
+    ri.Cmd_AddCommand     = &Cmd_AddCommand;
+    ri.Cmd_RemoveCommand  = &Cmd_RemoveCommand;
+    ri.Cmd_ExecuteText    = &Cmd_ExecuteText;
+    ri.Cmd_Argc           = &Cmd_Argc;
+    ri.Cmd_Argv           = &Cmd_Argv;
+    ri.FS_LoadFile        = &FS_LoadFile;
+    ri.FS_FreeFile        = &FS_FreeFile;
+    ri.FS_LoadFilePortion = &FS_LoadFilePortion;
+    ri.FS_CreatePath      = &FS_CreatePath;
+    ri.FS_Gamedir         = &FS_Gamedir;
+    ri.Cvar_Get           = &Cvar_Get;
+    ri.Cvar_Set           = &Cvar_Set;
+    ri.Cvar_SetValue      = &Cvar_SetValue;
+    ri.Vid_MenuInit       = &Vid_MenuInit;
+    ri.Vid_NewWindow      = &Vid_NewWindow;
+    ri.Vid_GetModeInfo    = &Vid_GetModeInfo;
+    ri.Sys_SetMemoryHooks = &Sys_SetMemoryHooks;
+    ri.Sys_Milliseconds   = &Sys_Milliseconds;
+
+    s_re = GetRefAPI(ri);
+    if (s_re.api_version != REF_API_VERSION)
+    {
+        std::fprintf(stderr, "Null renderer has version %d, not %d\n", s_re.api_version, REF_API_VERSION);
+        return EXIT_FAILURE;
+    }
+
+    if (!s_re.Init(nullptr, nullptr, /*fullscreen =*/false))
+    {
+        std::fprintf(stderr, "Failed to initialize the Null renderer\n");
+        return EXIT_FAILURE;
+    }
+
+    for (auto & cmd : cmds)
+    {
+        Cmd_ExecuteArgv(std::move(cmd));
+    }
+
+    s_re.Shutdown();
+    return EXIT_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // NullDriver
+
+int main(int argc, const char * argv[])
+{
+    return NullDriver::Run(argc, argv);
+}
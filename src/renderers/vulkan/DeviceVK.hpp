@@ -33,6 +33,7 @@ public:
     GraphicsContextVK &        GraphicsContext()        const { return *m_graphics_ctx; }
     SwapChainRenderTargetsVK & ScRenderTargets()        const { return *m_render_targets; }
     bool                       DebugValidationEnabled() const { return m_debug_validation; }
+    bool                       SupportsBlockCompression() const { return m_device_info.features2.features.textureCompressionBC != VK_FALSE; }
 
     // VK public handles
     VkDevice         Handle()              const { return m_device_handle; }
@@ -69,13 +69,30 @@ static void FilterForTextureType(const TextureType type, VkSamplerCreateInfo * s
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Texture format selection:
+///////////////////////////////////////////////////////////////////////////////
+
+static VkFormat FormatForTexture(const TextureFormat format)
+{
+    static const VkFormat s_vk_formats[] = {
+        VK_FORMAT_R8G8B8A8_UNORM,       // kRGBA8
+        VK_FORMAT_BC1_RGBA_UNORM_BLOCK, // kBC1
+        VK_FORMAT_BC3_UNORM_BLOCK,      // kBC3
+    };
+    static_assert(ArrayLength(s_vk_formats) == unsigned(TextureFormat::kCount), "Update this if the enum changes!");
+
+    MRQ2_ASSERT(format < TextureFormat::kCount);
+    return s_vk_formats[unsigned(format)];
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // TextureVK:
 ///////////////////////////////////////////////////////////////////////////////
 
 void TextureVK::Init(const DeviceVK & device, const TextureType type, const bool is_scrap,
                      const ColorRGBA32 * mip_init_data[], const Vec2u16 mip_dimensions[],
-                     const uint32_t num_mip_levels, const char * const debug_name)
+                     const uint32_t num_mip_levels, const TextureFormat format, const char * const debug_name)
 {
     MRQ2_ASSERT(num_mip_levels >= 1 && num_mip_levels <= TextureImage::kMaxMipLevels);
     MRQ2_ASSERT((mip_dimensions[0].x + mip_dimensions[0].y) != 0);
@@ -91,7 +108,7 @@ void TextureVK::Init(const DeviceVK & device, const TextureType type, const bool
     VkImageCreateInfo image_info{};
     image_info.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     image_info.imageType     = VK_IMAGE_TYPE_2D;
-    image_info.format        = VK_FORMAT_R8G8B8A8_UNORM;
+    image_info.format        = FormatForTexture(format);
     image_info.extent.width  = mip_dimensions[0].x;
     image_info.extent.height = mip_dimensions[0].y;
     image_info.extent.depth  = 1;
@@ -111,7 +128,7 @@ void TextureVK::Init(const DeviceVK & device, const TextureType type, const bool
     view_info.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     view_info.image                           = m_image_handle;
     view_info.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
-    view_info.format                          = VK_FORMAT_R8G8B8A8_UNORM;
+    view_info.format                          = image_info.format;
     view_info.components.r                    = VK_COMPONENT_SWIZZLE_R;
     view_info.components.g                    = VK_COMPONENT_SWIZZLE_G;
     view_info.components.b                    = VK_COMPONENT_SWIZZLE_B;
@@ -150,6 +167,7 @@ void TextureVK::Init(const DeviceVK & device, const TextureType type, const bool
     upload_info.mipmaps.num_mip_levels = num_mip_levels;
     upload_info.mipmaps.mip_init_data  = mip_init_data;
     upload_info.mipmaps.mip_dimensions = mip_dimensions;
+    upload_info.mipmaps.format         = format;
     device.UploadContext().CreateTexture(upload_info);
 
     m_owns_resources = true;
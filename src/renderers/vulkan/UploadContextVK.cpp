@@ -174,10 +174,21 @@ void UploadContextVK::CreateUploadBuffer(const TextureUploadVK & upload_info, Co
     MRQ2_ASSERT(mipmaps.mip_dimensions[0].x != 0 && mipmaps.mip_dimensions[0].y != 0);
     MRQ2_ASSERT(num_mips >= 1 && num_mips <= TextureImage::kMaxMipLevels);
 
+    // Sub-rectangle update of an existing texture, staging buffer only holds the region's rows.
+    const bool has_region = upload_info.HasRegion();
+    MRQ2_ASSERT(!has_region || (upload_info.is_scrap && num_mips == 1));
+
     uint32_t buffer_size_in_bytes = 0;
-    for (uint32_t mip = 0; mip < num_mips; ++mip)
+    if (has_region)
+    {
+        buffer_size_in_bytes = upload_info.region.width * upload_info.region.height * TextureImage::kBytesPerPixel;
+    }
+    else
     {
-        buffer_size_in_bytes += mipmaps.mip_dimensions[mip].x * mipmaps.mip_dimensions[mip].y * TextureImage::kBytesPerPixel;
+        for (uint32_t mip = 0; mip < num_mips; ++mip)
+        {
+            buffer_size_in_bytes += TextureLevelSize(mipmaps.format, mipmaps.mip_dimensions[mip].x, mipmaps.mip_dimensions[mip].y);
+        }
     }
 
     // Create a host-visible staging buffer that will contain the raw image data:
@@ -185,13 +196,29 @@ void UploadContextVK::CreateUploadBuffer(const TextureUploadVK & upload_info, Co
 
     // Copy texture data into the staging buffer:
     auto * dest_pixels = static_cast<std::uint8_t *>(out_upload_buff->Map());
-    for (uint32_t mip = 0; mip < num_mips; ++mip)
+    if (has_region)
+    {
+        const auto &   region        = upload_info.region;
+        const uint32_t src_row_pitch = mipmaps.mip_dimensions[0].x * TextureImage::kBytesPerPixel;
+        const uint32_t row_size      = region.width * TextureImage::kBytesPerPixel;
+        const auto *   src_pixels    = reinterpret_cast<const std::uint8_t *>(mipmaps.mip_init_data[0]) +
+                                       (region.y * src_row_pitch) + (region.x * TextureImage::kBytesPerPixel);
+
+        for (uint32_t y = 0; y < region.height; ++y)
+        {
+            std::memcpy(dest_pixels + y * row_size, src_pixels + y * src_row_pitch, row_size);
+        }
+    }
+    else
     {
-        const auto * mip_pixels = mipmaps.mip_init_data[mip];
-        const size_t mip_size   = mipmaps.mip_dimensions[mip].x * mipmaps.mip_dimensions[mip].y * TextureImage::kBytesPerPixel;
+        for (uint32_t mip = 0; mip < num_mips; ++mip)
+        {
+            const auto * mip_pixels = mipmaps.mip_init_data[mip];
+            const size_t mip_size   = TextureLevelSize(mipmaps.format, mipmaps.mip_dimensions[mip].x, mipmaps.mip_dimensions[mip].y);
 
-        std::memcpy(dest_pixels, mip_pixels, mip_size);
-        dest_pixels += mip_size;
+            std::memcpy(dest_pixels, mip_pixels, mip_size);
+            dest_pixels += mip_size;
+        }
     }
     out_upload_buff->Unmap();
 
@@ -210,9 +237,18 @@ void UploadContextVK::CreateUploadBuffer(const TextureUploadVK & upload_info, Co
         copy_region.imageExtent.height              = mipmaps.mip_dimensions[mip].y;
         copy_region.imageExtent.depth               = 1;
         copy_region.bufferOffset                    = buffer_offset;
+
+        if (has_region)
+        {
+            copy_region.imageOffset.x      = static_cast<int32_t>(upload_info.region.x);
+            copy_region.imageOffset.y      = static_cast<int32_t>(upload_info.region.y);
+            copy_region.imageExtent.width  = upload_info.region.width;
+            copy_region.imageExtent.height = upload_info.region.height;
+        }
+
         texture_copy_regions.push_back(copy_region);
 
-        buffer_offset += mipmaps.mip_dimensions[mip].x * mipmaps.mip_dimensions[mip].y * TextureImage::kBytesPerPixel;
+        buffer_offset += TextureLevelSize(mipmaps.format, mipmaps.mip_dimensions[mip].x, mipmaps.mip_dimensions[mip].y);
     }
 
     VkImageLayout old_image_layout, new_image_layout;
@@ -201,6 +201,7 @@ extern cvar_t * sv_paused;
 extern cvar_t * sv_noreload;      // don't reload level state when reentering
 extern cvar_t * sv_airaccelerate; // don't reload level state when reentering
                                   // development tool
+extern cvar_t * sv_tracecache;
 extern client_t * sv_client;
 extern edict_t * sv_player;
 
@@ -322,6 +323,10 @@ int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t ** list, int maxcount, int a
 // returns the number of pointers filled in
 // ??? does this always return the world?
 
+void SV_AreaBench_f(void);
+// area_bench console command, times SV_LinkEdict style moves and
+// SV_AreaEdicts style queries on thousands of boxes
+
 //===================================================================
 
 //
@@ -334,6 +339,12 @@ int SV_PointContents(vec3_t p);
 trace_t SV_Trace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t * passedict, int contentmask);
 // mins and maxs are relative
 
+void SV_TraceBatch(const traceray_t * rays, int num_rays, edict_t * passedict, int contentmask, trace_t * results);
+// SV_Trace for num_rays rays at once, all sharing passedict and contentmask
+
+void SV_InvalidateTraceCache(void);
+// drops all the SV_Trace results remembered with sv_tracecache
+
 // if the entire move stays in a solid volume, trace.allsolid will be set,
 // trace.startsolid will be set, and trace.fraction will be 0
 
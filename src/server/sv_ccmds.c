@@ -1037,4 +1037,6 @@ void SV_InitOperatorCommands(void)
     Cmd_AddCommand("load", SV_Loadgame_f);
     Cmd_AddCommand("killserver", SV_KillServer_f);
     Cmd_AddCommand("sv", SV_ServerCommand_f);
+
+    Cmd_AddCommand("area_bench", SV_AreaBench_f);
 }
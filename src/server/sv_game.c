@@ -361,6 +361,7 @@ void SV_InitGameProgs(void)
     import.unlinkentity = SV_UnlinkEdict;
     import.BoxEdicts = SV_AreaEdicts;
     import.trace = SV_Trace;
+    import.tracebatch = SV_TraceBatch;
     import.pointcontents = SV_PointContents;
     import.setmodel = PF_setmodel;
     import.inPVS = PF_inPVS;
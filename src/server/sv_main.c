@@ -42,6 +42,7 @@ cvar_t * sv_showclamp;
 cvar_t * hostname;
 cvar_t * public_server;      // should heartbeats be sent
 cvar_t * sv_reconnect_limit; // minimum seconds between connect messages
+cvar_t * sv_tracecache;      // memoize identical SV_Trace calls within a frame
 
 void Master_Shutdown(void);
 
@@ -717,6 +718,9 @@ void SV_RunGameFrame(void)
     sv.framenum++;
     sv.time = sv.framenum * 100;
 
+    // cached traces only live for one frame
+    SV_InvalidateTraceCache();
+
     // don't run if paused
     if (!sv_paused->value || maxclients->value > 1)
     {
@@ -972,6 +976,7 @@ void SV_Init(void)
     sv_airaccelerate = Cvar_Get("sv_airaccelerate", "0", CVAR_LATCH);
     public_server = Cvar_Get("public", "0", 0);
     sv_reconnect_limit = Cvar_Get("sv_reconnect_limit", "3", CVAR_ARCHIVE);
+    sv_tracecache = Cvar_Get("sv_tracecache", "0", 0);
 
     SZ_Init(&net_message, net_message_buffer, sizeof(net_message_buffer));
 }
@@ -30,101 +30,434 @@ FIXME: this use of "area" is different from the bsp file use
 ===============================================================================
 */
 
-// (type *)STRUCT_FROM_LINK(link_t *link, type, member)
-// ent = STRUCT_FROM_LINK(link,entity_t,order)
-// FIXME: remove this mess!
-#define STRUCT_FROM_LINK(l, t, m) ((t *)((qbyte *)l - (quptr)&(((t *)0)->m)))
+/*
+The edicts are kept in two dynamic AABB trees, one for the solid edicts
+and one for the triggers. Every linked edict is a leaf holding its
+absmin/absmax grown by AREA_TREE_MARGIN, so small moves only need the
+new box checked against the leaf. When an edict leaves its fat box the
+leaf is taken out and reinserted where it adds the least surface area,
+and the nodes on the way back up are rotated to keep their boxes tight
+and the height bounded.
+Unlike a fixed subdivision of the world, nothing stays stuck on a big
+node because it straddles a split plane.
+*/
 
-#define EDICT_FROM_AREA(l) STRUCT_FROM_LINK(l, edict_t, area)
+enum
+{
+    AREA_TREE_NODES         = MAX_EDICTS * 2, // a tree with N leaves uses 2N-1 nodes
+    AREA_TREE_MARGIN        = 16,             // fat box padding, about a frame of player movement
+    AREA_TREE_STACK         = 128,
+    AREA_TREE_MAX_IMBALANCE = 4               // allowed height difference of two siblings
+};
 
-typedef struct areanode_s
+typedef struct
 {
-    int axis; // -1 = leaf node
-    float dist;
-    struct areanode_s * children[2];
-    link_t trigger_edicts;
-    link_t solid_edicts;
-} areanode_t;
+    vec3_t mins; // union of the children, or the fat box of a leaf
+    vec3_t maxs;
+    int parent;      // next free node when on the free list
+    int children[2]; // -1 for leaves
+    int height;      // 0 for leaves, -1 for free nodes
+    int id;          // edict number of a leaf
+} areatreenode_t;
 
-enum
+typedef struct
 {
-    AREA_DEPTH = 4,
-    AREA_NODES = 32
-};
+    areatreenode_t * nodes;
+    int num_nodes;
+    int root;
+    int free_list;
+} areatree_t;
+
+// returns false to stop the query
+typedef qboolean (*areatreevisit_t)(void * param, int id);
+
+static areatreenode_t sv_areatree_nodes[2][AREA_TREE_NODES];
+static areatree_t sv_areatrees[2]; // AREA_SOLID - 1 and AREA_TRIGGERS - 1
 
-areanode_t sv_areanodes[AREA_NODES];
-int sv_numareanodes;
-float *area_mins, *area_maxs;
-edict_t ** area_list;
-int area_count, area_maxcount;
-int area_type;
+// leaf of each edict and the tree it is in, -1 if not linked
+static int sv_area_leafs[MAX_EDICTS];
+static qbyte sv_area_trees[MAX_EDICTS];
 
 int SV_HullForEntity(edict_t * ent);
 
-// ClearLink is used for new headnodes
-void ClearLink(link_t * l)
+static void SV_AreaTreeInit(areatree_t * tree, areatreenode_t * nodes, int num_nodes)
 {
-    l->prev = l->next = l;
+    int i;
+
+    tree->nodes = nodes;
+    tree->num_nodes = num_nodes;
+    tree->root = -1;
+    tree->free_list = 0;
+
+    for (i = 0; i < num_nodes; i++)
+    {
+        nodes[i].parent = (i + 1 < num_nodes) ? i + 1 : -1;
+        nodes[i].height = -1;
+    }
 }
 
-void RemoveLink(link_t * l)
+static int SV_AreaTreeAllocNode(areatree_t * tree)
 {
-    l->next->prev = l->prev;
-    l->prev->next = l->next;
+    areatreenode_t * node;
+    int index;
+
+    index = tree->free_list;
+    if (index == -1)
+        Com_Error(ERR_DROP, "SV_AreaTreeAllocNode: out of nodes");
+
+    node = &tree->nodes[index];
+    tree->free_list = node->parent;
+    node->parent = -1;
+    node->children[0] = node->children[1] = -1;
+    node->height = 0;
+    node->id = -1;
+    return index;
 }
 
-void InsertLinkBefore(link_t * l, link_t * before)
+static void SV_AreaTreeFreeNode(areatree_t * tree, int index)
 {
-    l->next = before;
-    l->prev = before->prev;
-    l->prev->next = l;
-    l->next->prev = l;
+    tree->nodes[index].parent = tree->free_list;
+    tree->nodes[index].height = -1;
+    tree->free_list = index;
+}
+
+static float SV_AreaTreeCost(const vec3_t mins, const vec3_t maxs)
+{
+    float x = maxs[0] - mins[0];
+    float y = maxs[1] - mins[1];
+    float z = maxs[2] - mins[2];
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+static void SV_AreaTreeUnion(const areatreenode_t * a, const areatreenode_t * b, vec3_t mins, vec3_t maxs)
+{
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        mins[i] = (a->mins[i] < b->mins[i]) ? a->mins[i] : b->mins[i];
+        maxs[i] = (a->maxs[i] > b->maxs[i]) ? a->maxs[i] : b->maxs[i];
+    }
+}
+
+static void SV_AreaTreeRefit(areatree_t * tree, int index)
+{
+    areatreenode_t * node = &tree->nodes[index];
+    const areatreenode_t * child0 = &tree->nodes[node->children[0]];
+    const areatreenode_t * child1 = &tree->nodes[node->children[1]];
+
+    SV_AreaTreeUnion(child0, child1, node->mins, node->maxs);
+    node->height = 1 + ((child0->height > child1->height) ? child0->height : child1->height);
+}
+
+static void SV_AreaTreeReplaceChild(areatree_t * tree, int parent, int old_child, int new_child)
+{
+    if (parent == -1)
+        tree->root = new_child;
+    else if (tree->nodes[parent].children[0] == old_child)
+        tree->nodes[parent].children[0] = new_child;
+    else
+        tree->nodes[parent].children[1] = new_child;
 }
 
 /*
 ===============
-SV_CreateAreaNode
+SV_AreaTreeRotate
 
-Builds a uniformly subdivided tree for the given world size
+Swaps a child of node A with a grandchild on the other side if that
+shrinks the child box. Keeps the tree tight as leaves move around.
 ===============
 */
-areanode_t * SV_CreateAreaNode(int depth, vec3_t mins, vec3_t maxs)
+static void SV_AreaTreeRotate(areatree_t * tree, int ia)
 {
-    areanode_t * anode;
-    vec3_t size;
-    vec3_t mins1, maxs1, mins2, maxs2;
+    areatreenode_t * a = &tree->nodes[ia];
+    vec3_t mins, maxs;
+    float gain, best_gain = 0.0f;
+    int side, k, best_side = -1, best_k = -1;
+
+    if (a->height < 2)
+        return;
 
-    anode = &sv_areanodes[sv_numareanodes];
-    sv_numareanodes++;
+    for (side = 0; side < 2; side++)
+    {
+        const areatreenode_t * sibling = &tree->nodes[a->children[side]];
+        const areatreenode_t * other = &tree->nodes[a->children[side ^ 1]];
 
-    ClearLink(&anode->trigger_edicts);
-    ClearLink(&anode->solid_edicts);
+        if (other->height == 0)
+            continue;
 
-    if (depth == AREA_DEPTH)
+        // sibling goes down into other, in place of its child k
+        for (k = 0; k < 2; k++)
+        {
+            SV_AreaTreeUnion(sibling, &tree->nodes[other->children[k ^ 1]], mins, maxs);
+            gain = SV_AreaTreeCost(other->mins, other->maxs) - SV_AreaTreeCost(mins, maxs);
+            if (gain > best_gain)
+            {
+                best_gain = gain;
+                best_side = side;
+                best_k = k;
+            }
+        }
+    }
+
+    if (best_side != -1)
     {
-        anode->axis = -1;
-        anode->children[0] = anode->children[1] = NULL;
-        return anode;
+        const int isibling = a->children[best_side];
+        const int iother = a->children[best_side ^ 1];
+        const int iup = tree->nodes[iother].children[best_k];
+
+        a->children[best_side] = iup;
+        tree->nodes[iup].parent = ia;
+        tree->nodes[iother].children[best_k] = isibling;
+        tree->nodes[isibling].parent = iother;
+        SV_AreaTreeRefit(tree, iother);
     }
+}
 
-    VectorSubtract(maxs, mins, size);
-    if (size[0] > size[1])
-        anode->axis = 0;
-    else
-        anode->axis = 1;
+/*
+===============
+SV_AreaTreeBalance
+
+If one side of node A is more than AREA_TREE_MAX_IMBALANCE levels deeper
+than the other, rotates the deeper child up in place of A. This bounds
+the tree height when leaves come in sorted order. Returns the new
+subtree root.
+===============
+*/
+static int SV_AreaTreeBalance(areatree_t * tree, int ia)
+{
+    areatreenode_t * a = &tree->nodes[ia];
+    int ib, ic, balance;
+
+    if (a->height < 2)
+        return ia;
+
+    ib = a->children[0];
+    ic = a->children[1];
+    balance = tree->nodes[ic].height - tree->nodes[ib].height;
+
+    if (balance > AREA_TREE_MAX_IMBALANCE || balance < -AREA_TREE_MAX_IMBALANCE)
+    {
+        // rotate the deeper child (up) over A, then hang its shallower
+        // grandchild (low) off A and keep the deeper one (high) on up
+        const int side = (balance > 0) ? 1 : 0;
+        const int iup = a->children[side];
+        areatreenode_t * up = &tree->nodes[iup];
+        int ihigh = up->children[0];
+        int ilow = up->children[1];
+
+        if (tree->nodes[ihigh].height < tree->nodes[ilow].height)
+        {
+            ihigh = up->children[1];
+            ilow = up->children[0];
+        }
+
+        up->children[0] = ia;
+        up->children[1] = ihigh;
+        up->parent = a->parent;
+        a->parent = iup;
+        SV_AreaTreeReplaceChild(tree, up->parent, ia, iup);
+
+        a->children[side] = ilow;
+        tree->nodes[ilow].parent = ia;
 
-    anode->dist = 0.5 * (maxs[anode->axis] + mins[anode->axis]);
-    VectorCopy(mins, mins1);
-    VectorCopy(mins, mins2);
-    VectorCopy(maxs, maxs1);
-    VectorCopy(maxs, maxs2);
+        SV_AreaTreeRefit(tree, ia);
+        SV_AreaTreeRefit(tree, iup);
+        return iup;
+    }
+
+    return ia;
+}
+
+static void SV_AreaTreeInsertLeaf(areatree_t * tree, int leaf)
+{
+    areatreenode_t * nodes = tree->nodes;
+    vec3_t mins, maxs;
+    int index, sibling, old_parent, new_parent, i;
+
+    if (tree->root == -1)
+    {
+        tree->root = leaf;
+        nodes[leaf].parent = -1;
+        return;
+    }
+
+    // find the sibling that grows the tree surface the least
+    index = tree->root;
+    while (nodes[index].height > 0)
+    {
+        float area, combined, cost, inherited, child_cost[2];
+
+        area = SV_AreaTreeCost(nodes[index].mins, nodes[index].maxs);
+        SV_AreaTreeUnion(&nodes[index], &nodes[leaf], mins, maxs);
+        combined = SV_AreaTreeCost(mins, maxs);
+
+        // cost of making a new parent for this node and the leaf
+        cost = 2.0f * combined;
+        // cost pushed down to the children
+        inherited = 2.0f * (combined - area);
 
-    maxs1[anode->axis] = mins2[anode->axis] = anode->dist;
+        for (i = 0; i < 2; i++)
+        {
+            const areatreenode_t * child = &nodes[nodes[index].children[i]];
+            SV_AreaTreeUnion(child, &nodes[leaf], mins, maxs);
+            child_cost[i] = SV_AreaTreeCost(mins, maxs) + inherited;
+            if (child->height > 0)
+                child_cost[i] -= SV_AreaTreeCost(child->mins, child->maxs);
+        }
 
-    anode->children[0] = SV_CreateAreaNode(depth + 1, mins2, maxs2);
-    anode->children[1] = SV_CreateAreaNode(depth + 1, mins1, maxs1);
+        if (cost < child_cost[0] && cost < child_cost[1])
+            break;
 
-    return anode;
+        index = nodes[index].children[(child_cost[0] < child_cost[1]) ? 0 : 1];
+    }
+    sibling = index;
+
+    // new parent for the sibling and the leaf
+    old_parent = nodes[sibling].parent;
+    new_parent = SV_AreaTreeAllocNode(tree);
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].children[0] = sibling;
+    nodes[new_parent].children[1] = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+    SV_AreaTreeReplaceChild(tree, old_parent, sibling, new_parent);
+    SV_AreaTreeRefit(tree, new_parent);
+
+    // fix up the boxes and heights on the way back to the root
+    for (index = new_parent; index != -1; index = nodes[index].parent)
+    {
+        index = SV_AreaTreeBalance(tree, index);
+        SV_AreaTreeRotate(tree, index);
+        SV_AreaTreeRefit(tree, index);
+    }
+}
+
+static void SV_AreaTreeRemoveLeaf(areatree_t * tree, int leaf)
+{
+    areatreenode_t * nodes = tree->nodes;
+    int parent, grand_parent, sibling, index;
+
+    if (leaf == tree->root)
+    {
+        tree->root = -1;
+        return;
+    }
+
+    parent = nodes[leaf].parent;
+    grand_parent = nodes[parent].parent;
+    sibling = (nodes[parent].children[0] == leaf) ? nodes[parent].children[1] : nodes[parent].children[0];
+
+    // the sibling takes the place of the parent
+    SV_AreaTreeReplaceChild(tree, grand_parent, parent, sibling);
+    nodes[sibling].parent = grand_parent;
+    SV_AreaTreeFreeNode(tree, parent);
+
+    for (index = grand_parent; index != -1; index = nodes[index].parent)
+    {
+        index = SV_AreaTreeBalance(tree, index);
+        SV_AreaTreeRotate(tree, index);
+        SV_AreaTreeRefit(tree, index);
+    }
+}
+
+static void SV_AreaTreeSetFatBox(areatreenode_t * node, const vec3_t mins, const vec3_t maxs)
+{
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        node->mins[i] = mins[i] - AREA_TREE_MARGIN;
+        node->maxs[i] = maxs[i] + AREA_TREE_MARGIN;
+    }
+}
+
+/*
+===============
+SV_AreaTreeInsert
+
+Adds a leaf for the box and returns it.
+===============
+*/
+static int SV_AreaTreeInsert(areatree_t * tree, int id, const vec3_t mins, const vec3_t maxs)
+{
+    int leaf = SV_AreaTreeAllocNode(tree);
+
+    tree->nodes[leaf].id = id;
+    SV_AreaTreeSetFatBox(&tree->nodes[leaf], mins, maxs);
+    SV_AreaTreeInsertLeaf(tree, leaf);
+    return leaf;
+}
+
+static void SV_AreaTreeRemove(areatree_t * tree, int leaf)
+{
+    SV_AreaTreeRemoveLeaf(tree, leaf);
+    SV_AreaTreeFreeNode(tree, leaf);
+}
+
+/*
+===============
+SV_AreaTreeMove
+
+Only touches the tree when the new box is not inside the fat box of the leaf.
+===============
+*/
+static void SV_AreaTreeMove(areatree_t * tree, int leaf, const vec3_t mins, const vec3_t maxs)
+{
+    areatreenode_t * node = &tree->nodes[leaf];
+
+    if (mins[0] >= node->mins[0] && mins[1] >= node->mins[1] && mins[2] >= node->mins[2] &&
+        maxs[0] <= node->maxs[0] && maxs[1] <= node->maxs[1] && maxs[2] <= node->maxs[2])
+        return;
+
+    SV_AreaTreeRemoveLeaf(tree, leaf);
+    SV_AreaTreeSetFatBox(node, mins, maxs);
+    SV_AreaTreeInsertLeaf(tree, leaf);
+}
+
+/*
+===============
+SV_AreaTreeQuery
+
+Calls visit for every leaf whose fat box touches mins/maxs.
+===============
+*/
+static void SV_AreaTreeQuery(const areatree_t * tree, const vec3_t mins, const vec3_t maxs,
+                             areatreevisit_t visit, void * param)
+{
+    int stack[AREA_TREE_STACK];
+    int sp = 0;
+
+    if (tree->root == -1)
+        return;
+
+    stack[sp++] = tree->root;
+    while (sp > 0)
+    {
+        const areatreenode_t * node = &tree->nodes[stack[--sp]];
+
+        if (node->mins[0] > maxs[0] || node->mins[1] > maxs[1] || node->mins[2] > maxs[2] ||
+            node->maxs[0] < mins[0] || node->maxs[1] < mins[1] || node->maxs[2] < mins[2])
+            continue; // not touching
+
+        if (node->height == 0)
+        {
+            if (!visit(param, node->id))
+                return;
+            continue;
+        }
+
+        if (sp + 2 > AREA_TREE_STACK)
+            Com_Error(ERR_DROP, "SV_AreaTreeQuery: stack overflow");
+
+        stack[sp++] = node->children[1];
+        stack[sp++] = node->children[0];
+    }
+}
+
+static int SV_AreaTreeHeight(const areatree_t * tree)
+{
+    return (tree->root == -1) ? 0 : tree->nodes[tree->root].height;
 }
 
 /*
@@ -135,9 +468,18 @@ SV_ClearWorld
 */
 void SV_ClearWorld(void)
 {
-    memset(sv_areanodes, 0, sizeof(sv_areanodes));
-    sv_numareanodes = 0;
-    SV_CreateAreaNode(0, sv.models[1]->mins, sv.models[1]->maxs);
+    int i;
+
+    SV_InvalidateTraceCache();
+
+    SV_AreaTreeInit(&sv_areatrees[0], sv_areatree_nodes[0], AREA_TREE_NODES);
+    SV_AreaTreeInit(&sv_areatrees[1], sv_areatree_nodes[1], AREA_TREE_NODES);
+
+    for (i = 0; i < MAX_EDICTS; i++)
+    {
+        sv_area_leafs[i] = -1;
+        sv_area_trees[i] = 0;
+    }
 }
 
 /*
@@ -148,9 +490,13 @@ SV_UnlinkEdict
 */
 void SV_UnlinkEdict(edict_t * ent)
 {
-    if (!ent->area.prev)
+    int e = NUM_FOR_EDICT(ent);
+
+    if (sv_area_leafs[e] == -1)
         return; // not linked in anywhere
-    RemoveLink(&ent->area);
+    SV_InvalidateTraceCache();
+    SV_AreaTreeRemove(&sv_areatrees[sv_area_trees[e]], sv_area_leafs[e]);
+    sv_area_leafs[e] = -1;
     ent->area.prev = ent->area.next = NULL;
 }
 
@@ -167,22 +513,21 @@ void SV_LinkEdict(edict_t * ent)
         MAX_TOTAL_ENT_LEAFS = 128
     };
 
-    areanode_t * node;
     int leafs[MAX_TOTAL_ENT_LEAFS];
     int clusters[MAX_TOTAL_ENT_LEAFS];
     int num_leafs;
     int j, k;
     int area;
     int topnode;
+    int e, tree;
 
-    if (ent->area.prev)
-        SV_UnlinkEdict(ent); // unlink from old position
+    SV_InvalidateTraceCache(); // the edict may have moved, even if it wasn't linked before
 
-    if (ent == ge->edicts)
-        return; // don't add the world
-
-    if (!ent->inuse)
+    if (ent == ge->edicts || !ent->inuse)
+    { // don't add the world
+        SV_UnlinkEdict(ent);
         return;
+    }
 
     // set the size
     VectorSubtract(ent->maxs, ent->mins, ent->size);
@@ -323,78 +668,69 @@ void SV_LinkEdict(edict_t * ent)
     ent->linkcount++;
 
     if (ent->solid == SOLID_NOT)
+    {
+        SV_UnlinkEdict(ent);
         return;
+    }
 
-    // find the first node that the ent's box crosses
-    node = sv_areanodes;
-    while (1)
+    // move the leaf, or put it in the other tree if the solid type changed
+    e = NUM_FOR_EDICT(ent);
+    tree = (ent->solid == SOLID_TRIGGER) ? AREA_TRIGGERS - 1 : AREA_SOLID - 1;
+    if (sv_area_leafs[e] != -1 && sv_area_trees[e] != tree)
     {
-        if (node->axis == -1)
-            break;
-        if (ent->absmin[node->axis] > node->dist)
-            node = node->children[0];
-        else if (ent->absmax[node->axis] < node->dist)
-            node = node->children[1];
-        else
-            break; // crosses the node
+        SV_AreaTreeRemove(&sv_areatrees[sv_area_trees[e]], sv_area_leafs[e]);
+        sv_area_leafs[e] = -1;
     }
 
-    // link it in
-    if (ent->solid == SOLID_TRIGGER)
-        InsertLinkBefore(&ent->area, &node->trigger_edicts);
+    if (sv_area_leafs[e] == -1)
+    {
+        sv_area_leafs[e] = SV_AreaTreeInsert(&sv_areatrees[tree], e, ent->absmin, ent->absmax);
+        sv_area_trees[e] = tree;
+    }
     else
-        InsertLinkBefore(&ent->area, &node->solid_edicts);
+    {
+        SV_AreaTreeMove(&sv_areatrees[tree], sv_area_leafs[e], ent->absmin, ent->absmax);
+    }
+
+    // the game checks area.prev to tell if an edict is linked
+    ent->area.prev = ent->area.next = &ent->area;
 }
 
 /*
 ====================
-SV_AreaEdicts_r
+SV_AreaEdictsVisit
 
 ====================
 */
-void SV_AreaEdicts_r(areanode_t * node)
+typedef struct
 {
-    link_t *l, *next, *start;
-    edict_t * check;
+    const float * mins;
+    const float * maxs;
+    edict_t ** list;
     int count;
+    int maxcount;
+} areaquery_t;
 
-    count = 0;
-
-    // touch linked edicts
-    if (area_type == AREA_SOLID)
-        start = &node->solid_edicts;
-    else
-        start = &node->trigger_edicts;
-
-    for (l = start->next; l != start; l = next)
-    {
-        next = l->next;
-        check = EDICT_FROM_AREA(l);
+static qboolean SV_AreaEdictsVisit(void * param, int id)
+{
+    areaquery_t * query = (areaquery_t *)param;
+    edict_t * check = EDICT_NUM(id);
 
-        if (check->solid == SOLID_NOT)
-            continue; // deactivated
+    if (check->solid == SOLID_NOT)
+        return true; // deactivated
 
-        if (check->absmin[0] > area_maxs[0] || check->absmin[1] > area_maxs[1] || check->absmin[2] > area_maxs[2] || check->absmax[0] < area_mins[0] || check->absmax[1] < area_mins[1] || check->absmax[2] < area_mins[2])
-            continue; // not touching
+    if (check->absmin[0] > query->maxs[0] || check->absmin[1] > query->maxs[1] || check->absmin[2] > query->maxs[2] || check->absmax[0] < query->mins[0] || check->absmax[1] < query->mins[1] || check->absmax[2] < query->mins[2])
+        return true; // not touching
 
-        if (area_count == area_maxcount)
-        {
-            Com_Printf("SV_AreaEdicts: MAXCOUNT\n");
-            return;
-        }
-
-        area_list[area_count] = check;
-        area_count++;
+    if (query->count == query->maxcount)
+    {
+        Com_Printf("SV_AreaEdicts: MAXCOUNT\n");
+        return false;
     }
 
-    if (node->axis == -1)
-        return; // terminal node
-
-    // recurse down both sides
-    if (area_maxs[node->axis] > node->dist)
-        SV_AreaEdicts_r(node->children[0]);
-    if (area_mins[node->axis] < node->dist)
-        SV_AreaEdicts_r(node->children[1]);
+    query->list[query->count] = check;
+    query->count++;
+    return true;
 }
 
 /*
@@ -405,16 +741,186 @@ SV_AreaEdicts
 int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t ** list,
                   int maxcount, int areatype)
 {
-    area_mins = mins;
-    area_maxs = maxs;
-    area_list = list;
-    area_count = 0;
-    area_maxcount = maxcount;
-    area_type = areatype;
+    areaquery_t query;
+
+    query.mins = mins;
+    query.maxs = maxs;
+    query.list = list;
+    query.count = 0;
+    query.maxcount = maxcount;
 
-    SV_AreaEdicts_r(sv_areanodes);
+    SV_AreaTreeQuery(&sv_areatrees[(areatype == AREA_SOLID) ? AREA_SOLID - 1 : AREA_TRIGGERS - 1],
+                     mins, maxs, &SV_AreaEdictsVisit, &query);
 
-    return area_count;
+    return query.count;
+}
+
+/*
+================
+SV_AreaBench_f
+
+area_bench [num_entities] [num_frames]
+
+Links num_entities random boxes inside the map bounds in a scratch tree,
+then each frame moves all of them a little and runs one query around
+every box, like G_TouchTriggers and SV_ClipMoveToEntities do. The last
+frame is checked against a brute force test of every pair.
+================
+*/
+typedef struct
+{
+    vec3_t mins;
+    vec3_t maxs;
+    const vec3_t * box_mins;
+    const vec3_t * box_maxs;
+    int count;
+} areabench_t;
+
+static qboolean SV_AreaBenchVisit(void * param, int id)
+{
+    areabench_t * bench = (areabench_t *)param;
+
+    if (bench->box_mins[id][0] > bench->maxs[0] || bench->box_mins[id][1] > bench->maxs[1] || bench->box_mins[id][2] > bench->maxs[2] || bench->box_maxs[id][0] < bench->mins[0] || bench->box_maxs[id][1] < bench->mins[1] || bench->box_maxs[id][2] < bench->mins[2])
+        return true; // not touching
+
+    bench->count++;
+    return true;
+}
+
+static float SV_AreaBenchRandom(unsigned * seed, float lo, float hi)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((*seed >> 8) * (1.0f / 16777216.0f));
+}
+
+void SV_AreaBench_f(void)
+{
+    static const vec3_t default_mins = { -4096, -4096, -4096 };
+    static const vec3_t default_maxs = { 4096, 4096, 4096 };
+
+    areatree_t tree;
+    areatreenode_t * nodes;
+    areabench_t bench;
+    vec3_t *box_mins, *box_maxs, *velocities;
+    int *leafs, *counts;
+    const float *world_mins, *world_maxs;
+    unsigned seed = 1234;
+    int num_entities, num_frames, num_found, mismatches;
+    int i, j, t, frame, time_start, time_link, time_move, time_query, time_brute;
+
+    num_entities = (Cmd_Argc() > 1) ? atoi(Cmd_Argv(1)) : 4096;
+    num_frames = (Cmd_Argc() > 2) ? atoi(Cmd_Argv(2)) : 100;
+    num_entities = num_entities < 1 ? 1 : num_entities;
+    num_frames = num_frames < 1 ? 1 : num_frames;
+
+    if (sv.state != ss_dead && sv.models[1])
+    {
+        world_mins = sv.models[1]->mins;
+        world_maxs = sv.models[1]->maxs;
+    }
+    else
+    {
+        world_mins = default_mins;
+        world_maxs = default_maxs;
+    }
+
+    nodes = (areatreenode_t *)Z_Malloc(num_entities * 2 * sizeof(areatreenode_t));
+    box_mins = (vec3_t *)Z_Malloc(num_entities * sizeof(vec3_t));
+    box_maxs = (vec3_t *)Z_Malloc(num_entities * sizeof(vec3_t));
+    velocities = (vec3_t *)Z_Malloc(num_entities * sizeof(vec3_t));
+    leafs = (int *)Z_Malloc(num_entities * sizeof(int));
+    counts = (int *)Z_Malloc(num_entities * sizeof(int));
+
+    SV_AreaTreeInit(&tree, nodes, num_entities * 2);
+
+    // player to monster sized boxes, a few big ones like doors and triggers
+    for (i = 0; i < num_entities; i++)
+    {
+        const float size = ((i & 15) == 15) ? 128 : 16;
+        for (t = 0; t < 3; t++)
+        {
+            const float center = SV_AreaBenchRandom(&seed, world_mins[t], world_maxs[t]);
+            const float half = SV_AreaBenchRandom(&seed, size * 0.5f, size);
+            box_mins[i][t] = center - half;
+            box_maxs[i][t] = center + half;
+            velocities[i][t] = ((i & 3) == 0) ? 0 : SV_AreaBenchRandom(&seed, -20, 20);
+        }
+    }
+
+    time_start = Sys_Milliseconds();
+    for (i = 0; i < num_entities; i++)
+        leafs[i] = SV_AreaTreeInsert(&tree, i, box_mins[i], box_maxs[i]);
+    time_link = Sys_Milliseconds() - time_start;
+
+    time_move = time_query = 0;
+    num_found = 0;
+    for (frame = 0; frame < num_frames; frame++)
+    {
+        time_start = Sys_Milliseconds();
+        for (i = 0; i < num_entities; i++)
+        {
+            for (t = 0; t < 3; t++)
+            {
+                if (box_mins[i][t] + velocities[i][t] < world_mins[t] || box_maxs[i][t] + velocities[i][t] > world_maxs[t])
+                    velocities[i][t] = -velocities[i][t];
+                box_mins[i][t] += velocities[i][t];
+                box_maxs[i][t] += velocities[i][t];
+            }
+            SV_AreaTreeMove(&tree, leafs[i], box_mins[i], box_maxs[i]);
+        }
+        time_move += Sys_Milliseconds() - time_start;
+
+        time_start = Sys_Milliseconds();
+        bench.box_mins = box_mins;
+        bench.box_maxs = box_maxs;
+        for (i = 0; i < num_entities; i++)
+        {
+            for (t = 0; t < 3; t++)
+            {
+                bench.mins[t] = box_mins[i][t] - 32;
+                bench.maxs[t] = box_maxs[i][t] + 32;
+            }
+            bench.count = 0;
+            SV_AreaTreeQuery(&tree, bench.mins, bench.maxs, &SV_AreaBenchVisit, &bench);
+            counts[i] = bench.count;
+            num_found += bench.count;
+        }
+        time_query += Sys_Milliseconds() - time_start;
+    }
+
+    // brute force reference for the last frame
+    time_start = Sys_Milliseconds();
+    mismatches = 0;
+    for (i = 0; i < num_entities; i++)
+    {
+        for (t = 0; t < 3; t++)
+        {
+            bench.mins[t] = box_mins[i][t] - 32;
+            bench.maxs[t] = box_maxs[i][t] + 32;
+        }
+        bench.count = 0;
+        for (j = 0; j < num_entities; j++)
+            SV_AreaBenchVisit(&bench, j);
+        if (bench.count != counts[i])
+            mismatches++;
+    }
+    time_brute = Sys_Milliseconds() - time_start;
+
+    Com_Printf("area_bench: %i entities, tree height %i, link: %i ms\n",
+               num_entities, SV_AreaTreeHeight(&tree), time_link);
+    Com_Printf("area_bench: %i frames, move: %.2f ms/frame, query: %.2f ms/frame (%.1f hits/query)\n",
+               num_frames, (float)time_move / num_frames, (float)time_query / num_frames,
+               (float)num_found / ((float)num_frames * num_entities));
+    Com_Printf("area_bench: brute force query: %i ms/frame\n", time_brute);
+    if (mismatches)
+        Com_Printf("area_bench: WARNING: %i queries differ from the brute force test!\n", mismatches);
+
+    Z_Free(counts);
+    Z_Free(leafs);
+    Z_Free(velocities);
+    Z_Free(box_maxs);
+    Z_Free(box_mins);
+    Z_Free(nodes);
 }
 
 //===========================================================================
@@ -599,25 +1105,85 @@ boxmaxs[0] = boxmaxs[1] = boxmaxs[2] = 9999;
 #endif
 }
 
+/*
+===============================================================================
+
+TRACE CACHE
+
+Monster AI traces the same start/end pairs several times per frame. With
+sv_tracecache set, SV_Trace remembers its results until the next game frame
+or until any edict is linked or unlinked. Game code is expected to relink an
+edict after changing its origin, size or solidity, traces made before it does
+may see a stale result, so the cache is off by default.
+
+===============================================================================
+*/
+
+enum
+{
+    TRACE_CACHE_SIZE = 1024 // power of two
+};
+
+typedef struct
+{
+    vec3_t start;
+    vec3_t end;
+    vec3_t mins;
+    vec3_t maxs;
+    edict_t * passedict;
+    int contentmask;
+} tracekey_t;
+
+typedef struct
+{
+    tracekey_t key;
+    trace_t trace;
+    int generation; // entry is valid if it matches sv_tracecache_generation
+} tracecacheentry_t;
+
+static tracecacheentry_t sv_tracecache_entries[TRACE_CACHE_SIZE];
+static int sv_tracecache_generation = 1;
+
+// These counters are referenced by Qcommon_Frame().
+int c_trace_cache_hits;
+int c_trace_cache_misses;
+
 /*
 ==================
-SV_Trace
+SV_InvalidateTraceCache
+==================
+*/
+void SV_InvalidateTraceCache(void)
+{
+    sv_tracecache_generation++;
+}
 
-Moves the given mins/maxs volume through the world from start to end.
+static tracecacheentry_t * SV_TraceCacheEntry(const tracekey_t * key)
+{
+    // FNV-1a
+    const qbyte * bytes = (const qbyte *)key;
+    unsigned hash = 2166136261u;
+    int i;
 
-Passedict and edicts owned by passedict are explicitly not checked.
+    for (i = 0; i < (int)sizeof(tracekey_t); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return &sv_tracecache_entries[hash & (TRACE_CACHE_SIZE - 1)];
+}
+
+/*
+==================
+SV_ClipTrace
 
+SV_Trace without the cache.
 ==================
 */
-trace_t SV_Trace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t * passedict, int contentmask)
+static trace_t SV_ClipTrace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t * passedict, int contentmask)
 {
     moveclip_t clip;
 
-    if (!mins)
-        mins = vec3_origin;
-    if (!maxs)
-        maxs = vec3_origin;
-
     memset(&clip, 0, sizeof(moveclip_t));
 
     // clip to world
@@ -644,3 +1210,95 @@ trace_t SV_Trace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t * p
 
     return clip.trace;
 }
+
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+
+Passedict and edicts owned by passedict are explicitly not checked.
+
+==================
+*/
+trace_t SV_Trace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t * passedict, int contentmask)
+{
+    tracekey_t key;
+    tracecacheentry_t * entry;
+
+    if (!mins)
+        mins = vec3_origin;
+    if (!maxs)
+        maxs = vec3_origin;
+
+    if (!sv_tracecache->value)
+        return SV_ClipTrace(start, mins, maxs, end, passedict, contentmask);
+
+    memset(&key, 0, sizeof(key)); // clear the padding, keys are compared with memcmp
+    VectorCopy(start, key.start);
+    VectorCopy(end, key.end);
+    VectorCopy(mins, key.mins);
+    VectorCopy(maxs, key.maxs);
+    key.passedict = passedict;
+    key.contentmask = contentmask;
+
+    entry = SV_TraceCacheEntry(&key);
+    if (entry->generation == sv_tracecache_generation && !memcmp(&entry->key, &key, sizeof(key)))
+    {
+        c_trace_cache_hits++;
+        return entry->trace;
+    }
+
+    c_trace_cache_misses++;
+
+    entry->key = key;
+    entry->trace = SV_ClipTrace(start, mins, maxs, end, passedict, contentmask);
+    entry->generation = sv_tracecache_generation;
+    return entry->trace;
+}
+
+/*
+==================
+SV_TraceBatch
+
+Same as calling SV_Trace on each ray, but the rays are clipped to the world
+together with CM_BoxTraceBatch. All rays share passedict and contentmask.
+
+==================
+*/
+void SV_TraceBatch(const traceray_t * rays, int num_rays, edict_t * passedict, int contentmask, trace_t * results)
+{
+    moveclip_t clip;
+    int i;
+
+    // clip to world
+    CM_BoxTraceBatch(rays, num_rays, 0, contentmask, results);
+
+    for (i = 0; i < num_rays; i++)
+    {
+        results[i].ent = ge->edicts;
+        if (results[i].fraction == 0)
+            continue; // blocked by the world
+
+        memset(&clip, 0, sizeof(moveclip_t));
+
+        clip.trace = results[i];
+        clip.contentmask = contentmask;
+        clip.start = (float *)rays[i].start;
+        clip.end = (float *)rays[i].end;
+        clip.mins = (float *)rays[i].mins;
+        clip.maxs = (float *)rays[i].maxs;
+        clip.passedict = passedict;
+
+        VectorCopy(rays[i].mins, clip.mins2);
+        VectorCopy(rays[i].maxs, clip.maxs2);
+
+        // create the bounding box of the entire move
+        SV_TraceBounds(clip.start, clip.mins2, clip.maxs2, clip.end, clip.boxmins, clip.boxmaxs);
+
+        // clip to other solid entities
+        SV_ClipMoveToEntities(&clip);
+
+        results[i] = clip.trace;
+    }
+}
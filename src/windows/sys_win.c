@@ -194,6 +194,69 @@ char * Sys_GetClipboardData(void)
     return data;
 }
 
+/*
+================
+Sys_NumCPUs
+================
+*/
+int Sys_NumCPUs(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+/*
+================
+Sys_RunThreads
+================
+*/
+#define SYS_MAX_THREADS 64
+
+typedef struct
+{
+    void (*func)(void * param, int thread_index);
+    void * param;
+    int thread_index;
+} sys_thread_t;
+
+static DWORD WINAPI Sys_ThreadProc(LPVOID arg)
+{
+    sys_thread_t * t = (sys_thread_t *)arg;
+    t->func(t->param, t->thread_index);
+    return 0;
+}
+
+void Sys_RunThreads(int num_threads, void (*func)(void * param, int thread_index), void * param)
+{
+    sys_thread_t threads[SYS_MAX_THREADS];
+    HANDLE handles[SYS_MAX_THREADS];
+    int i;
+
+    if (num_threads > SYS_MAX_THREADS)
+        num_threads = SYS_MAX_THREADS;
+
+    // thread 0 runs on the calling thread
+    for (i = 1; i < num_threads; i++)
+    {
+        threads[i].func = func;
+        threads[i].param = param;
+        threads[i].thread_index = i;
+        handles[i] = CreateThread(NULL, 0, &Sys_ThreadProc, &threads[i], 0, NULL);
+        if (!handles[i])
+            Sys_Error("Sys_RunThreads: CreateThread failed");
+    }
+
+    func(param, 0);
+
+    if (num_threads > 1)
+    {
+        WaitForMultipleObjects(num_threads - 1, &handles[1], TRUE, INFINITE);
+        for (i = 1; i < num_threads; i++)
+            CloseHandle(handles[i]);
+    }
+}
+
 /*
 ================
 Sys_SendKeyEvents